@@ -0,0 +1,179 @@
+#include <stdint.h>
+#include <stddef.h>
+
+#include "spsc_ring.h"
+
+// #pragma mark - Private Functions -
+
+// acquire: the data written before the other side published its index is visible after loading it
+static inline uint32_t load_acquire(volatile uint32_t* index)
+{
+	return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+}
+
+// release: all data written before is visible before the new index is
+static inline void store_release(volatile uint32_t* index, uint32_t value)
+{
+	__atomic_store_n(index, value, __ATOMIC_RELEASE);
+}
+
+// both rings: the size has to be a power of 2
+static inline bool valid_size(const void* buffer, uint32_t size)
+{
+	return (buffer != NULL) && (size != 0) && ((size & (size - 1)) == 0);
+}
+
+// producer of both rings: false and an overrun when the ring is full, fill is the number of samples in the ring
+static inline bool has_space(uint32_t head, volatile uint32_t* tail, uint32_t size, volatile uint32_t* overrun_count, uint32_t* fill)
+{
+	*fill = head - load_acquire(tail);
+	if(*fill >= size)
+	{
+		(*overrun_count)++;
+		return false;
+	}
+	return true;
+}
+
+// consumer of both rings: the number of samples it can take, at most n
+static inline uint32_t available(volatile uint32_t* head, uint32_t tail, uint32_t n)
+{
+	uint32_t count = load_acquire(head) - tail;
+	return (n > count) ? count : n;
+}
+
+// #pragma mark - APIs -
+
+bool spsc_ring_init(spsc_ring_handle_t me, float* buffer, uint32_t size)
+{
+	if(!valid_size(buffer, size))
+	{
+		return false;
+	}
+
+	me->buffer = buffer;
+	me->size = size;
+	me->mask = size - 1;
+	spsc_ring_reset(me);
+
+	return true;
+}
+
+void spsc_ring_reset(spsc_ring_handle_t me)
+{
+	me->head = 0;
+	me->tail = 0;
+	me->overrun_count = 0;
+	me->max_fill = 0;
+}
+
+bool spsc_ring_put(spsc_ring_handle_t me, float data)
+{
+	uint32_t head = me->head;
+	uint32_t fill;
+
+	if(!has_space(head, &me->tail, me->size, &me->overrun_count, &fill))
+	{
+		return false;
+	}
+
+	me->buffer[head & me->mask] = data;
+	store_release(&me->head, head + 1);
+
+	if(fill + 1 > me->max_fill)
+	{
+		me->max_fill = fill + 1;
+	}
+	return true;
+}
+
+uint32_t spsc_ring_read(spsc_ring_handle_t me, float* data, uint32_t n)
+{
+	uint32_t tail = me->tail;
+	n = available(&me->head, tail, n);
+
+	for(uint32_t i = 0; i < n; i++)
+	{
+		data[i] = me->buffer[(tail + i) & me->mask];
+	}
+	store_release(&me->tail, tail + n);
+
+	return n;
+}
+
+uint32_t spsc_ring_count(spsc_ring_handle_t me)
+{
+	return load_acquire(&me->head) - load_acquire(&me->tail);
+}
+
+uint32_t spsc_ring_overrun_count(spsc_ring_handle_t me)
+{
+	return me->overrun_count;
+}
+
+bool spsc_ring_i16_init(spsc_ring_i16_handle_t me, int16_t* buffer, uint32_t size)
+{
+	if(!valid_size(buffer, size))
+	{
+		return false;
+	}
+
+	me->buffer = buffer;
+	me->size = size;
+	me->mask = size - 1;
+	spsc_ring_i16_reset(me);
+
+	return true;
+}
+
+void spsc_ring_i16_reset(spsc_ring_i16_handle_t me)
+{
+	me->head = 0;
+	me->tail = 0;
+	me->overrun_count = 0;
+	me->max_fill = 0;
+}
+
+bool spsc_ring_i16_put(spsc_ring_i16_handle_t me, int16_t data)
+{
+	uint32_t head = me->head;
+	uint32_t fill;
+
+	if(!has_space(head, &me->tail, me->size, &me->overrun_count, &fill))
+	{
+		return false;
+	}
+
+	me->buffer[head & me->mask] = data;
+	store_release(&me->head, head + 1);
+
+	if(fill + 1 > me->max_fill)
+	{
+		me->max_fill = fill + 1;
+	}
+	return true;
+}
+
+uint32_t spsc_ring_i16_read(spsc_ring_i16_handle_t me, int16_t* data, uint32_t n)
+{
+	uint32_t tail = me->tail;
+	n = available(&me->head, tail, n);
+
+	for(uint32_t i = 0; i < n; i++)
+	{
+		data[i] = me->buffer[(tail + i) & me->mask];
+	}
+	store_release(&me->tail, tail + n);
+
+	return n;
+}
+
+uint32_t spsc_ring_i16_count(spsc_ring_i16_handle_t me)
+{
+	return load_acquire(&me->head) - load_acquire(&me->tail);
+}
+
+uint32_t spsc_ring_i16_overrun_count(spsc_ring_i16_handle_t me)
+{
+	return me->overrun_count;
+}
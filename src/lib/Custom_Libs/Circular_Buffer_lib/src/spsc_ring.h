@@ -0,0 +1,91 @@
+#ifndef SPSC_RING_H_
+#define SPSC_RING_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/////////
+// Lock free single producer / single consumer ring buffer for float32 samples.
+// The producer (e.g. an ISR) only writes head, the consumer (a task) only writes tail,
+// so no critical sections are required as long as there is exactly one of each.
+// head and tail are free running counters, the size has to be a power of 2.
+// When the ring is full new samples are dropped and counted, the consumer's data is never overwritten.
+// spsc_ring_i16 is the same ring for 16 bit samples (ADC counts or q15), at half the memory.
+/////////
+
+typedef struct spsc_ring_f32_t
+{
+	float* buffer;
+	uint32_t size;
+	uint32_t mask;
+	// only written by the producer
+	volatile uint32_t head;
+	// only written by the consumer
+	volatile uint32_t tail;
+	// number of samples dropped because the ring was full (written by the producer)
+	volatile uint32_t overrun_count;
+	// highest number of samples stored in the ring at once (written by the producer)
+	volatile uint32_t max_fill;
+}spsc_ring_f32_t;
+
+typedef spsc_ring_f32_t* spsc_ring_handle_t;
+
+/// Pass in a storage buffer and its size
+/// Requires: buffer is not NULL, size is a power of 2
+/// Returns false if the size is not a power of 2
+bool spsc_ring_init(spsc_ring_handle_t me, float* buffer, uint32_t size);
+
+/// Empties the ring, only call when neither the producer nor the consumer is running
+void spsc_ring_reset(spsc_ring_handle_t me);
+
+/// Producer: adds a single sample, safe to call from ISR context
+/// Returns false if the ring is full, the sample is dropped and counted as overrun
+bool spsc_ring_put(spsc_ring_handle_t me, float data);
+
+/// Consumer: removes up to n samples from the ring
+/// Returns the number of samples copied to data
+uint32_t spsc_ring_read(spsc_ring_handle_t me, float* data, uint32_t n);
+
+/// Returns the number of samples that can be read
+uint32_t spsc_ring_count(spsc_ring_handle_t me);
+
+/// Returns the number of samples dropped because the ring was full
+uint32_t spsc_ring_overrun_count(spsc_ring_handle_t me);
+
+typedef struct spsc_ring_i16_t
+{
+	int16_t* buffer;
+	uint32_t size;
+	uint32_t mask;
+	// only written by the producer
+	volatile uint32_t head;
+	// only written by the consumer
+	volatile uint32_t tail;
+	// number of samples dropped because the ring was full (written by the producer)
+	volatile uint32_t overrun_count;
+	// highest number of samples stored in the ring at once (written by the producer)
+	volatile uint32_t max_fill;
+}spsc_ring_i16_t;
+
+typedef spsc_ring_i16_t* spsc_ring_i16_handle_t;
+
+/// Same as spsc_ring_init for 16 bit samples
+bool spsc_ring_i16_init(spsc_ring_i16_handle_t me, int16_t* buffer, uint32_t size);
+
+/// Same as spsc_ring_reset for 16 bit samples
+void spsc_ring_i16_reset(spsc_ring_i16_handle_t me);
+
+/// Same as spsc_ring_put for 16 bit samples
+bool spsc_ring_i16_put(spsc_ring_i16_handle_t me, int16_t data);
+
+/// Same as spsc_ring_read for 16 bit samples
+uint32_t spsc_ring_i16_read(spsc_ring_i16_handle_t me, int16_t* data, uint32_t n);
+
+/// Same as spsc_ring_count for 16 bit samples
+uint32_t spsc_ring_i16_count(spsc_ring_i16_handle_t me);
+
+/// Same as spsc_ring_overrun_count for 16 bit samples
+uint32_t spsc_ring_i16_overrun_count(spsc_ring_i16_handle_t me);
+
+#endif //SPSC_RING_H_
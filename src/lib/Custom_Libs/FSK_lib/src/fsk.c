@@ -4,11 +4,11 @@
 /*
     this file is in charge of the FSK communication protocol.
     It consists of 2 main functions: 
-    FSK_tick() and FSK_update()
+    FSK_wait_for_samples() and FSK_update()
 
-    FSK_tick() is called every 1ms and is in charge of
-        reading the ADC values and placing them in the FSK buffers.
-    FSK_update() is called at a lower priority and is in charge of
+    FSK_wait_for_samples() blocks till the timer triggered ADC + DMA has sampled
+        a half buffer and places the samples in the FSK buffers.
+    FSK_update() is called after every new buffer and is in charge of
         processing the FSK buffers and performing the FFT.
         If a byte is found it processes the byte and passes the 
         information to the VLC motion commander.
@@ -30,6 +30,8 @@
 
 //Crazyflie
 #include "debug.h"
+#include "FreeRTOS.h"
+#include "task.h"
 
 //logging usin crazyflie lib:
 #include "log.h"
@@ -37,9 +39,47 @@
 //filtering
 #include "digital_filters.h"
 
-//FSK frequencies
-#define FSK_F0 125
-#define FSK_F1 156
+//timer triggered ADC sampling
+#include "fsk_adc_dma.h"
+#include "spsc_ring.h"
+
+//noise reference bin of the detector, see fsk_tones.h
+#ifdef CONFIG_FSK_MULTI_CHANNEL
+#define FSK_NOISE_REF_F FSK_MULTI_CHANNEL_NOISE_REF_F
+#else
+#define FSK_NOISE_REF_F FSK_SINGLE_CHANNEL_NOISE_REF_F
+#endif
+
+//forward error correction of every channel after init, can be changed per channel with FSK_set_fec_mode
+#if defined(CONFIG_FSK_FEC_HAMMING74)
+#define FSK_FEC_MODE vlc_fec_hamming74
+#elif defined(CONFIG_FSK_FEC_CONV_K7)
+#define FSK_FEC_MODE vlc_fec_conv_k7
+#else
+#define FSK_FEC_MODE vlc_fec_none
+#endif
+
+//minimum magnitude of a detected frequency bin
+//based on data (notion) this should remove the noise frequency detections
+#define FSK_NOISE_FLOOR 400
+
+//spike removal: EWMA factor of the mean and the maximum deviation from the mean in ADC counts
+#define FSK_SPIKE_EWMA_ALPHA 0.015f
+#define FSK_SPIKE_ERROR_MARGIN 650 //based on drone measurements
+
+//adaptive front end:
+//spike margin in mean absolute deviations (a sine peaks at 1.6) and its lower bound in ADC counts
+#define FSK_SPIKE_DEVIATION_K 6.0f
+#define FSK_SPIKE_MIN_MARGIN 100.0f
+//AGC: EWMA factor per window, standard deviation of a scaled window and the maximum gain
+#define FSK_AGC_ALPHA 0.1f
+#define FSK_AGC_TARGET 256.0f
+#define FSK_AGC_MAX_GAIN 8.0f
+//CFAR: EWMA factor of the noise per window, tone to noise power ratio (9 dB)
+#define FSK_CFAR_ALPHA 0.05f
+#define FSK_CFAR_RATIO 8.0f
+//lower bound of the noise magnitude |X[k]| of a scaled window, white noise at the AGC target gives ~2000
+#define FSK_CFAR_MIN_MAGNITUDE 1000.0f
 
 //to print individual bits using DEBUG_PRINT:
 //source: https://stackoverflow.com/questions/111928/is-there-a-printf-converter-to-print-in-binary-format
@@ -58,17 +98,29 @@
 typedef struct Fsk_loggers{
     float32_t read_value;
     uint8_t last_recieved_byte;
+    //framed packets with a valid crc and frames that were dropped (all channels)
+    uint32_t packets_recieved;
+    uint32_t packet_errors;
+    uint32_t fec_corrected_bits;
+    //adaptive front end state
+    float32_t spike_margin;
+    float32_t agc_gain;
 
 }Fsk_logger;
 
-//this is because we need acces to the last recieved frequency for the preamble counter
-//proper way would be to have a peek function that looks in the cirular buffer but don't have time for debugging atm
-static uint16_t last_recieved_frequency = 0;
+//circular DMA buffer, the DMA fills one half while the interrupt copies the other to the sample ring
+static uint16_t adc_dma_buffer[2 * FSK_SAMPLES];
 
-//Circular buffer to save the recently detected frequencies
-uint16_t buffer_f[FSK_RECENT_FREQUENCY_BUFFER_SIZE]  = {0};
-circular_buf_t cbufFR;
-cbuf_handle_t cbuf_freq_recent = &cbufFR;
+//lock free ring of ADC samples, filled by the DMA interrupt and emptied by the FSK task
+#ifdef CONFIG_FSK_FIXED_POINT
+static int16_t sample_ring_buffer[FSK_SAMPLE_RING_SIZE];
+static spsc_ring_i16_t sample_ring;
+#define FSK_sample_ring_count spsc_ring_i16_count
+#else
+static float32_t sample_ring_buffer[FSK_SAMPLE_RING_SIZE];
+static spsc_ring_f32_t sample_ring;
+#define FSK_sample_ring_count spsc_ring_count
+#endif
 
 //logging
 Fsk_logger fsk_log;
@@ -91,51 +143,42 @@ enum frequency{
 void generate_complex_sine_wave(FSK_instance* fsk, float32_t output[], int buf_len, int fs){
     //Create input signal
     for(int i=0; i< buf_len; i+=2){
-        output[i] = 0.5f + 0.5f*arm_sin_f32(2*PI*fsk->f0*(i/2)/fs);
+        output[i] = 0.5f + 0.5f*arm_sin_f32(2*PI*fsk->channel[FSK_CHANNEL].f0*(i/2)/fs);
         output[i+1] = 0.0f;
     }
 }
 
+#ifndef CONFIG_FSK_DETECTOR_GOERTZEL
 /**
- * Returns the current peak frequency found
+ * Returns the current peak frequency found using the real FFT over all bins
  * Peak locations are based on number of samples and and sampling frequency
  * NOTE: Sets the DC part to 0
  * Removes Noise floor
+ * NOTE: the input is used as scratch by the FFT
  */
-uint16_t get_current_frequency(FSK_instance* fsk, float32_t Input[]){
+uint16_t get_current_frequency_fft(FSK_instance* fsk, float32_t Input[]){
     if(fsk->isInit){
-        //output array
-        float32_t Output[FSK_SAMPLE_BUFFER_SIZE/2];
+        FSK_fft_plan* P = &fsk->P;
 
         //values that we are interested in
         float32_t maxValue = 0;
         uint32_t maxIndex = 0;
         uint16_t peakFrequency = 0;
 
-        // DEBUG_PRINT("Bef FFT: %f\n", (double)Input[0]);
-        /* Initialize the CFFT/CIFFT module, intFlag = 0, doBitReverse = 1 */
-        //arm_cfft_radix4_init_q15
-        arm_cfft_radix4_init_f32(&fsk->S, FFT_SIZE, 0, 1);
+        /* Process the data through the real FFT, the plan is initialized once in FSK_init */
+        arm_rfft_fast_f32(&P->rfft, Input, P->spectrum, 0);
 
-        /* Process the data through the CFFT/CIFFT module */
-        arm_cfft_radix4_f32(&fsk->S, Input);
-        
         /* Process the data through the Complex Magniture Module for calculating the magnitude at each bin */
-        arm_cmplx_mag_f32(Input, Output, FFT_SIZE);
-        
-        //set the DC component to 0 and the mirror components
-        Output[0] = 0;
-        for (int i = (FFT_SIZE/2); i < FFT_SIZE; i++)
-        {
-            Output[i] = 0.0f;
-        }
+        arm_cmplx_mag_f32(P->spectrum, P->magnitude, FFT_SIZE/2);
+
+        //set the DC component to 0 (bin 0 holds the DC and nyquist parts)
+        P->magnitude[0] = 0;
 
         /* Calculates maxValue and returns corresponding value */
-        arm_max_f32(Output, FFT_SIZE, &maxValue, &maxIndex);
+        arm_max_f32(P->magnitude, FFT_SIZE/2, &maxValue, &maxIndex);
 
         /*set a noise floor*/
-        //based on data (notion) a noise floor of 200 should remove the noise frequency detections:
-        if (maxValue < 400){
+        if (maxValue < FSK_NOISE_FLOOR){
             // we return a DC value as this is never the frequency we are looking for.
             return 0;
         }
@@ -144,58 +187,146 @@ uint16_t get_current_frequency(FSK_instance* fsk, float32_t Input[]){
         peakFrequency = (uint16_t)(maxIndex * FSK_SAMPLINGFREQ / FSK_SAMPLES);
 
         //Debug print
-        // DEBUG_PRINT("V: %.2f, %.2f, %.2f, %.2f, %.2f, %.2f, %.2f, %.2f]\n",
-        // (double)(Output[0]), (double)(Output[1]), (double)(Output[2]), (double)(Output[3]),
-        // (double)(Output[4]), (double)(Output[5]), (double)(Output[6]), (double)(Output[7])
-        // );
         // DEBUG_PRINT("Pf %d, Mv [%ld]:%f \n\n", peakFrequency, maxIndex, (double)maxValue);
         return peakFrequency;
     }
     return 0.0f;
 }
 
+#endif //CONFIG_FSK_DETECTOR_GOERTZEL
+
 /**
- * clears the buffer content
- * Requires the ID and a pointer to the buffer
+ * Returns the current frequency found in the sample buffer
+ * - FFT: the peak frequency over all bins
+ * - Goertzel: the strongest of the 2 FSK tones
+ * - multi channel: the strongest of the 2 tones of this drone's channel
+ * 0 is returned if nothing rises above the noise floor
+ */
+uint16_t get_current_frequency(FSK_instance* fsk, float32_t Input[]){
+    if(fsk->isInit){
+#ifdef CONFIG_FSK_MULTI_CHANNEL
+        //the strongest tone of the channel of this drone
+        FSK_goertzel_bank_process(&fsk->B, Input);
+        return FSK_goertzel_bank_detect_pair(&fsk->B, 2 * FSK_CHANNEL, (2 * FSK_CHANNEL) + 1, 2 * FSK_NUM_OF_CHANNELS, FSK_NOISE_FLOOR);
+#elif defined(CONFIG_FSK_DETECTOR_GOERTZEL)
+        return FSK_goertzel_detect(&fsk->G, Input, FSK_NOISE_FLOOR);
+#else
+        return get_current_frequency_fft(fsk, Input);
+#endif
+    }
+    return 0;
+}
+
+/**
+ * Takes FSK_SAMPLES samples from the sample ring and places them in the window after removing the spikes.
+ * @return false if the ring does not contain a full window yet
 */
-void FSK_buff_clear(FSK_instance* fsk, uint8_t ID){
-    if(ID == 0){
-        fsk->buff.entries_buf0 = 0;
-        fsk->buff.buff0_status = empty;
+bool FSK_read_window(FSK_instance* fsk){
+    if (FSK_sample_ring_count(&sample_ring) < FSK_SAMPLES){
+        return false;
+    }
+#ifdef CONFIG_FSK_FIXED_POINT
+    int16_t raw[FSK_SAMPLES];
+    spsc_ring_i16_read(&sample_ring, raw, FSK_SAMPLES);
+
+    //For debugging we log the first raw sample of every window
+    fsk_log.read_value = (float32_t)raw[0];
+
+    //spike removal and DC removal in fixed point
+    for (int i = 0; i < FSK_SAMPLES; i++)
+    {
+        fsk->window_q15[i] = FSK_q15_spike_filter_process(&fsk->spike_filter, (uint16_t)raw[i]);
+    }
+#else
+    spsc_ring_read(&sample_ring, fsk->window, FSK_SAMPLES);
+
+    //For debugging we log the first raw sample of every window
+    fsk_log.read_value = fsk->window[0];
+
+#ifdef CONFIG_FSK_ADAPTIVE_FRONT_END
+    //the spike margin follows the deviation of the samples, the spike filter has to see the samples in order
+    for (int i = 0; i < FSK_SAMPLES; i++)
+    {
+        fsk->window[i] = FSK_adaptive_spike_filter_process(&fsk->spike, fsk->window[i]);
     }
-    else if (ID == 1){
-        fsk->buff.entries_buf1 = 0;
-        fsk->buff.buff1_status = empty;
+    //normalise the window so the tone powers do not depend on the distance to the projector
+    FSK_agc_process(&fsk->agc, fsk->window, FSK_SAMPLES);
+    fsk_log.spike_margin = FSK_adaptive_spike_filter_margin(&fsk->spike);
+    fsk_log.agc_gain = fsk->agc.gain;
+#else
+    //the spike filter has to see the samples in order
+    for (int i = 0; i < FSK_SAMPLES; i++)
+    {
+        fsk->window[i] = FSK_spike_filter_process(&fsk->spike_fixed, fsk->window[i]);
     }
+#endif //CONFIG_FSK_ADAPTIVE_FRONT_END
+#endif //CONFIG_FSK_FIXED_POINT
+
+    //sample time advances by a full window
+    fsk->FSK_tick_count += FSK_SAMPLES;
+    return true;
+}
+
+void FSK_channel_save_frequency(FSK_channel* ch, uint16_t found_freq){
+    //put found frequency in cicular buffer
+    circular_buf_put(ch->recent_frequencies, found_freq);
+    ch->last_recieved_frequency = found_freq;
+}
+
+#ifdef CONFIG_FSK_ADAPTIVE_FRONT_END
+/**
+ * Detects the tones of every channel in the window with the CFAR detector,
+ * then updates the noise estimates of the bins without a tone.
+*/
+void FSK_detect_window_cfar(FSK_instance* fsk){
+#ifdef CONFIG_FSK_MULTI_CHANNEL
+    FSK_goertzel_bank_process(&fsk->B, fsk->window);
+    const float32_t* power = fsk->B.power;
+    const uint8_t noise_bin = 2 * FSK_NUM_OF_CHANNELS;
+#else
+    FSK_goertzel_process(&fsk->G, fsk->window);
+    const float32_t* power = fsk->G.power;
+    const uint8_t noise_bin = goertzel_bin_noise;
+#endif
+    //the tone pair of channel c is in bins 2c and 2c+1 (goertzel_bin_f0 and goertzel_bin_f1 for a single channel)
+    uint16_t detected_bins = 0;
+    for (uint8_t c = 0; c < FSK_NUM_OF_CHANNELS; c++)
+    {
+        FSK_channel* ch = &fsk->channel[c];
+        uint16_t found_freq = FSK_cfar_detect_pair(&fsk->cfar, power, 2 * c, (2 * c) + 1, noise_bin, ch->f0, ch->f1, &detected_bins);
+        FSK_channel_save_frequency(ch, found_freq);
+    }
+    FSK_cfar_update(&fsk->cfar, power, detected_bins);
 }
+#endif //CONFIG_FSK_ADAPTIVE_FRONT_END
 
 /**
- * Reads from the FSK buffers if they are full with N samples.
+ * Reads a window of samples from the sample ring.
  * Then determines the current frequency based on the measurements
  * finally saves the found frequency in the ciruclar buffer.
  * Discarts the found frequencies if they are not the frequency we are looking for
 */
 bool Read_and_save_new_FSK_frequency_if_avaiable(FSK_instance* fsk){
-    if (fsk->buff.buff0_status == full){
-        //perform an FFT to get the current frequency from the sample fsk buffer.
-        int found_freq = get_current_frequency(fsk, fsk->buff.buff_0);
-        //put found frequency in cicular buffer
-        circular_buf_put(cbuf_freq_recent, found_freq);
-        //mark sample buffer clear for re-use
-        FSK_buff_clear(fsk, 0);
-        //save in global variable
-        last_recieved_frequency = found_freq;
-
-        return true;
-    }else if(fsk->buff.buff1_status == full){
-        //perform an FFT to get the current frequency from the sample fsk buffer.
-        int found_freq = (uint16_t) get_current_frequency(fsk, fsk->buff.buff_1);
-        //put found frequency in cicular buffer
-        circular_buf_put(cbuf_freq_recent, found_freq);
-        //mark sample buffer clear for re-use
-        FSK_buff_clear(fsk, 1);
-        //save in global variable
-        last_recieved_frequency = found_freq;
+    if (FSK_read_window(fsk)){
+#if defined(CONFIG_FSK_ADAPTIVE_FRONT_END)
+        //thresholds relative to the tracked noise of every bin
+        FSK_detect_window_cfar(fsk);
+#elif defined(CONFIG_FSK_MULTI_CHANNEL)
+        //a single pass over the window gives the tone powers of every channel
+        FSK_goertzel_bank_process(&fsk->B, fsk->window);
+        const uint8_t noise_bin = 2 * FSK_NUM_OF_CHANNELS;
+        for (uint8_t c = 0; c < FSK_NUM_OF_CHANNELS; c++)
+        {
+            uint16_t found_freq = FSK_goertzel_bank_detect_pair(&fsk->B, 2 * c, (2 * c) + 1, noise_bin, FSK_NOISE_FLOOR);
+            FSK_channel_save_frequency(&fsk->channel[c], found_freq);
+        }
+#elif defined(CONFIG_FSK_FIXED_POINT)
+        //correlate the q15 window with the tone bins
+        FSK_channel_save_frequency(&fsk->channel[0], FSK_q15_detect(&fsk->Q, fsk->window_q15, FSK_NOISE_FLOOR));
+#else
+        //perform an FFT to get the current frequency from the sample window.
+        FSK_channel_save_frequency(&fsk->channel[0], get_current_frequency(fsk, fsk->window));
+#endif
         return true;
     }
     return false;
@@ -248,110 +379,20 @@ int16_t obtain_majority_frequency_from_cBuf(cbuf_handle_t cbuf){
 }
 
 /**
- * Adds a value to the FSK buffer depending on the current write active buffer.
-*/
-void FSK_buff_add_value(FSK_buffer *buff, float32_t value, uint8_t ID){
-    if(ID == 0){
-        buff->buff_0[buff->entries_buf0] = value;
-        buff->entries_buf0++;
-        buff->buff_0[buff->entries_buf0] = 0;
-        buff->entries_buf0++;
-    }else{
-        buff->buff_1[buff->entries_buf1] = value;
-        buff->entries_buf1++;
-        buff->buff_1[buff->entries_buf1] = 0;
-        buff->entries_buf1++;
-    }
-}
-
-/**
- * puts the found value into the FSK buffer depending on the current active write buffer
- * - changes and adjusts the status and current active buffer indicator
- * - Checks if the buffer is full and if so changes the buffer status
- * NOTE a Debug error is returned once an invalid buffer state is reached
+ * Waits till the DMA interrupt has added new samples to the sample ring
+ * @return true if new samples have arrived
 */
-bool FSK_buffer_put(FSK_buffer *buff, float32_t value){
-    //buffers are empty
-    if((buff->current_buffer == 0)&&(buff->buff0_status == empty)){
-        buff->entries_buf0 = 0;
-        buff->buff0_status = filling;
-        FSK_buff_add_value(buff, value, 0);
-        return 1;
-    }
-    else if((buff->current_buffer == 1)&&(buff->buff1_status == empty)){
-        buff->entries_buf1 = 0;
-        buff->buff1_status = filling;
-        FSK_buff_add_value(buff, value, 1);
-        return 1;
-    }
-    //*Buffers are filling 
-    //Buff0
-    else if((buff->current_buffer == 0)&&(buff->buff0_status == filling)){
-        FSK_buff_add_value(buff, value, 0);
-        //check if full
-        if (buff->entries_buf0 == FSK_SAMPLE_BUFFER_SIZE){
-            buff->current_buffer = 1;
-            buff->buff0_status = full;
-            return 1;
-        }
-        return 1;
-    }
-    //Buff1
-    else if((buff->current_buffer == 1)&&(buff->buff1_status == filling)){
-        FSK_buff_add_value(buff, value, 1);
-        //check if full
-        if (buff->entries_buf1 == FSK_SAMPLE_BUFFER_SIZE){
-            buff->current_buffer = 0;
-            buff->buff1_status = full;
-            return 1;
-        }
-        return 1;
-    }
-    else{
-        DEBUG_PRINT("FSK found an unsuported buffer filling state!");
-        DEBUG_PRINT("%d, %d, %d", buff->current_buffer, buff->buff0_status, buff->buff1_status);
+bool FSK_wait_for_samples(FSK_instance* fsk, uint32_t timeout_ms){
+    if(!fsk->isInit){
+        //nothing is sampling, don't keep the caller spinning
+        vTaskDelay(M2T(timeout_ms));
         return false;
     }
-    return true;
+    return FSK_adc_dma_wait_for_samples(M2T(timeout_ms));
 }
 
-
-/**
- * Reads the ADC values and places then in the FSK buffers
- * - uses a low pass filter to remove noise spikes caused by the IR beacons
-*/
-void FSK_read_ADC_value_and_put_in_buffer(FSK_instance* fsk){
-    static  int counter = 0;
-    static float32_t y_average_1 = 0;
-    const float32_t alpha = 0.015f;
-
-    if(fsk->isInit){
-        //we read the analoge values
-        float32_t y_raw = (float32_t)analogRead(FSK_ANALOGE_READ_PIN);
-
-        float32_t y_average_0 = low_pass_EWMA_f32(y_raw, y_average_1, alpha);
-        float32_t error_margin = 650; //based on drone measurements
-        
-        // removes excessive large spikes form the measurements, by setting them to the mean value
-        // these spikes are caused by the IR beacons used by the lighthosue system. they mess up the communication protocal.
-        float32_t y_corrected = y_raw;
-        if((y_raw> y_average_0 + error_margin) || (y_raw < y_average_0 -error_margin)){
-            y_corrected = y_average_0;
-        }
-
-        // DEBUG_PRINT("Analog read: raw: %f, EWMA_average: %f, Filtered: %f \n", (double)y_raw, (double)y_average_0, (double) y_corrected);
-        // //set the t-1 output value. for the EWMA
-        y_average_1 = y_average_0;
-
-        //save the result in the buffers
-        FSK_buffer_put(&fsk->buff, y_corrected);
-
-        //For debugging we read form this buffer
-        if (counter == 10){
-            fsk_log.read_value = y_raw;
-        }
-
-    }
+bool FSK_samples_available(FSK_instance* fsk){
+    return fsk->isInit && (FSK_sample_ring_count(&sample_ring) >= FSK_SAMPLES);
 }
 
 /**
@@ -360,23 +401,83 @@ void FSK_read_ADC_value_and_put_in_buffer(FSK_instance* fsk){
 */
 void FSK_init(FSK_instance* fsk){
     //FSK struct initialization
-    fsk->f0 = FSK_F0;
-    fsk->f1 = FSK_F1;
-    fsk->buff.buff0_status = empty;
-    fsk->buff.buff1_status = empty;
-    fsk->buff.current_buffer = 0; //ensures we start at buffer 0
-    fsk->data_byte = 0; //sets the data buffer to 0;
-    fsk->bit_count = 0; // no bit have been written to the data byte yet
-    fsk->tick_time_since_last_bit = 0;
+    for (uint8_t c = 0; c < FSK_NUM_OF_CHANNELS; c++)
+    {
+        FSK_channel* ch = &fsk->channel[c];
+        ch->f0 = fsk_channel_tones[c][0];
+        ch->f1 = fsk_channel_tones[c][1];
+        ch->data_byte = 0; //sets the data buffer to 0;
+        ch->bit_count = 0; // no bit have been written to the data byte yet
+        ch->tick_time_since_last_bit = 0;
+        ch->last_recieved_frequency = 0;
+        ch->window_count = 0;
+        ch->preamble_count = 0;
+        //Init the circular buffer for the detected frequencies
+        ch->recent_frequencies = circular_buf_init(ch->recent_frequency_buffer, FSK_RECENT_FREQUENCY_BUFFER_SIZE, &ch->recent_frequency_cbuf);
+#ifdef CONFIG_VLC_PACKET_FRAMING
+        vlc_packet_rx_init(&ch->rx);
+#endif
+        vlc_fec_decoder_init(&ch->fec, FSK_FEC_MODE);
+    }
     fsk->FSK_tick_count = 0;
 
+#ifdef CONFIG_FSK_MULTI_CHANNEL
+    //bins {f0 ch0, f1 ch0, f0 ch1, f1 ch1 ... noise reference}
+    uint16_t bank_frequencies[FSK_GOERTZEL_BANK_MAX_BINS];
+    for (uint8_t c = 0; c < FSK_NUM_OF_CHANNELS; c++)
+    {
+        bank_frequencies[2 * c] = fsk->channel[c].f0;
+        bank_frequencies[(2 * c) + 1] = fsk->channel[c].f1;
+    }
+    bank_frequencies[2 * FSK_NUM_OF_CHANNELS] = FSK_NOISE_REF_F;
+    if(!FSK_goertzel_bank_init(&fsk->B, bank_frequencies, (2 * FSK_NUM_OF_CHANNELS) + 1, FSK_SAMPLINGFREQ, FSK_SAMPLES)){
+        DEBUG_PRINT("ERROR: too many FSK channels\n");
+        return;
+    }
+#elif defined(CONFIG_FSK_DETECTOR_GOERTZEL)
+    //precompute the goertzel coefficients of the tone and noise bins
+    FSK_goertzel_init(&fsk->G, FSK_F0, FSK_F1, FSK_NOISE_REF_F, FSK_SAMPLINGFREQ, FSK_SAMPLES);
+#else
+    //precompute the twiddle factors and bit reverse tables of the real FFT
+    if(arm_rfft_fast_init_f32(&fsk->P.rfft, FFT_SIZE) != ARM_MATH_SUCCESS){
+        DEBUG_PRINT("ERROR: FFT size %d not supported\n", FFT_SIZE);
+        return;
+    }
+#endif
+#ifdef CONFIG_FSK_ADAPTIVE_FRONT_END
+    //starts at the fixed margin and adapts from there
+    FSK_adaptive_spike_filter_init(&fsk->spike, FSK_SPIKE_EWMA_ALPHA, FSK_SPIKE_DEVIATION_K, FSK_SPIKE_MIN_MARGIN, FSK_SPIKE_ERROR_MARGIN);
+    FSK_agc_init(&fsk->agc, FSK_AGC_ALPHA, FSK_AGC_TARGET, FSK_AGC_MAX_GAIN);
+    //the tone pairs of all channels and the noise reference bin
+    FSK_cfar_init(&fsk->cfar, (2 * FSK_NUM_OF_CHANNELS) + 1, FSK_CFAR_ALPHA, FSK_CFAR_RATIO, FSK_CFAR_MIN_MAGNITUDE * FSK_CFAR_MIN_MAGNITUDE);
+#endif
+#if !defined(CONFIG_FSK_FIXED_POINT) && !defined(CONFIG_FSK_ADAPTIVE_FRONT_END)
+    FSK_spike_filter_init(&fsk->spike_fixed, FSK_SPIKE_EWMA_ALPHA, FSK_SPIKE_ERROR_MARGIN, 0.0f);
+#endif
+#ifdef CONFIG_FSK_FIXED_POINT
+    //the mean starts at 0 like the float spike filter
+    FSK_q15_spike_filter_init(&fsk->spike_filter, FSK_SPIKE_EWMA_ALPHA, FSK_SPIKE_ERROR_MARGIN, 0.0f);
+    FSK_q15_detector_init(&fsk->Q, FSK_F0, FSK_F1, FSK_NOISE_REF_F, FSK_SAMPLINGFREQ, FSK_SAMPLES);
+#endif
+#ifdef CONFIG_FSK_STREAMING_DEMODULATOR
+    //a bit is send for FSK_RECENT_FREQUENCY_BUFFER_SIZE windows
+    FSK_sdft_demod_init(&fsk->D, FSK_F0, FSK_F1, FSK_SAMPLINGFREQ, FSK_SAMPLES, FSK_SAMPLES * FSK_RECENT_FREQUENCY_BUFFER_SIZE, FSK_NOISE_FLOOR);
+    fsk->preamble_found = false;
+#endif
+
+    //ring between the ADC interrupt and this task
+#ifdef CONFIG_FSK_FIXED_POINT
+    spsc_ring_i16_init(&sample_ring, sample_ring_buffer, FSK_SAMPLE_RING_SIZE);
+#else
+    spsc_ring_init(&sample_ring, sample_ring_buffer, FSK_SAMPLE_RING_SIZE);
+#endif
+
+    //start the timer triggered ADC sampling, the DMA interrupt adds the samples to the sample ring
+    if(!FSK_adc_dma_init(FSK_ANALOGE_READ_PIN, FSK_SAMPLINGFREQ, adc_dma_buffer, FSK_SAMPLES, &sample_ring)){
+        DEBUG_PRINT("ERROR: FSK pin has no ADC channel\n");
+        return;
+    }
 
-    //INIT the adc readout posibility
-    adcInit();
-
-    //Init the circular buffer for the detected frequencies
-    cbuf_freq_recent = circular_buf_init(buffer_f, FSK_RECENT_FREQUENCY_BUFFER_SIZE, cbuf_freq_recent);
-    
     //we are inited
     DEBUG_PRINT("FSK init succesfull. \n");
     fsk->isInit = true;
@@ -439,6 +540,20 @@ bool check_parity_validity(uint8_t data_byte){
     }
 }
 
+#ifdef CONFIG_FSK_MULTI_CHANNEL
+/**
+ * Check the channel the data byte was recieved on
+ * @return True if the channel is the channel of this drone (or the broadcast channel when enabled)
+*/
+bool parce_packet_channel(uint8_t channel){
+#ifdef CONFIG_FSK_BROADCAST_CHANNEL
+    if(channel == 0){
+        return true;
+    }
+#endif
+    return (channel == FSK_CHANNEL);
+}
+#else
 /**
  * Check the ID send in the data byte
  * @return True of the ID matches the drone ID, False if it does not match
@@ -451,16 +566,18 @@ bool parce_packet_ID(uint8_t data_byte){
         return false;
     }
 }
+#endif //CONFIG_FSK_MULTI_CHANNEL
 
 /**
  * isolates the command bits provided in the data byte
  * @param data_byte, the recieved data byte. 
  * @return command bits in byte format shifted to the right
  * eg. in: 10-10101-0 ->  out: 000-10101
+ * without ID bits (multi channel): in: 1010101-0 -> out: 0-1010101
 */
 uint8_t isolate_packet_command(uint8_t data_byte){
     //removes the ID bits
-    uint8_t output = data_byte << NUM_OF_ID_BITS;
+    uint8_t output = (uint8_t)(data_byte << NUM_OF_ID_BITS);
     //shifts back and removes the parity bit 
     //setting leaving only the command bytes
     output = (output >> (NUM_OF_ID_BITS + 1));
@@ -477,8 +594,9 @@ void queue_command(uint8_t command, void( *callback_process_command)(uint8_t)){
 /**
  * recieves the data byte, checks the content and ID, and parces the information if required
  * Finnaly stores the recieved command packet in a buffer to be executed later.
+ * @param channel the channel (tone pair) the byte was recieved on
 */
-void parse_data_byte(uint8_t data_byte){
+void parse_data_byte(uint8_t channel, uint8_t data_byte){
     fsk_log.last_recieved_byte = data_byte;
     //check validity first
     if(!check_parity_validity(data_byte)){
@@ -486,7 +604,11 @@ void parse_data_byte(uint8_t data_byte){
         return; //invalid packet recieved
     }
     //check if the packet is intended for this drone
+#ifdef CONFIG_FSK_MULTI_CHANNEL
+    if(!parce_packet_channel(channel)){
+#else
     if(!parce_packet_ID(data_byte)){
+#endif
         DEBUG_PRINT("Packet recieved but not inteded for this drone\n");
         return; //this packet was valid but not intended for this drone
     }
@@ -497,29 +619,20 @@ void parse_data_byte(uint8_t data_byte){
     queue_command(command_recieved, &vlc_motion_commander_parce_command_byte);
 }
 
-/**
- * places adc data in the FSK buffers
- * Needs to be called every sampling frequency at high(est) priority
- * Essential to be on time else the sampling time will be off resulting in a wrong FFT.
-*/
-void FSK_tick(FSK_instance* fsk){
-    if(fsk->isInit){
-        FSK_read_ADC_value_and_put_in_buffer(fsk);
-        //increase the local tick counter by 1
-        fsk->FSK_tick_count = fsk->FSK_tick_count + 1;
-    }
-}
-
 /**
  * Resets the FSK byte read if the timeout has passed
  * @return true if the timeout has passed and the byte has been reset
 */
-bool fsk_byte_timeout_reset(FSK_instance* fsk){
-    if (fsk->FSK_tick_count > (fsk->tick_time_since_last_bit + FSK_BIT_RECIEVE_TIMEOUT)){
-        fsk->data_byte = 0;
-        fsk->bit_count = 0;
+bool fsk_byte_timeout_reset(FSK_instance* fsk, FSK_channel* ch){
+    if (fsk->FSK_tick_count > (ch->tick_time_since_last_bit + FSK_BIT_RECIEVE_TIMEOUT)){
+        ch->data_byte = 0;
+        ch->bit_count = 0;
+        vlc_fec_decoder_reset(&ch->fec);
+#ifdef CONFIG_VLC_PACKET_FRAMING
+        vlc_packet_rx_reset(&ch->rx);
+#endif
         //this way we are not looping this function verry fast when the time has passed
-        fsk->tick_time_since_last_bit = fsk->FSK_tick_count;
+        ch->tick_time_since_last_bit = fsk->FSK_tick_count;
         // DEBUG_PRINT("TIMEOUT Reset \n");
         return true;
     }
@@ -529,25 +642,25 @@ bool fsk_byte_timeout_reset(FSK_instance* fsk){
 /**
  * Processes the found majority frequency and saves the bit processes the byte if the buffer is full
 */
-bool FSK_process_found_majority_frequency_and_save_byte_if_full(FSK_instance* fsk, int16_t majority_frequency){
+bool FSK_process_found_majority_frequency_and_save_byte_if_full(FSK_instance* fsk, FSK_channel* ch, int16_t majority_frequency){
     //check if the found majority frequency matches one of the 2 expected frequencies
-    if(majority_frequency == fsk->f0){
+    if(majority_frequency == ch->f0){
         //save the found data bit LSB first
-        fsk->data_byte = modifyBit(fsk->data_byte, fsk->bit_count, f0);
-        // DEBUG_PRINT("MF0: %d at location %d \n", majority_frequency, fsk->bit_count);
-        fsk->bit_count++;
+        ch->data_byte = modifyBit(ch->data_byte, ch->bit_count, f0);
+        // DEBUG_PRINT("MF0: %d at location %d \n", majority_frequency, ch->bit_count);
+        ch->bit_count++;
         //save the last time we recieved a valid new bit for the timeout
-        fsk->tick_time_since_last_bit = fsk->FSK_tick_count;
+        ch->tick_time_since_last_bit = fsk->FSK_tick_count;
         //valid frequency found
         return true;
     }
-    else if(majority_frequency == fsk->f1){
+    else if(majority_frequency == ch->f1){
         //save the found data bit LSB first
-        fsk->data_byte = modifyBit(fsk->data_byte, fsk->bit_count, f1);
-        // DEBUG_PRINT("MF1: %d at location %d \n", majority_frequency, fsk->bit_count);
-        fsk->bit_count++;
+        ch->data_byte = modifyBit(ch->data_byte, ch->bit_count, f1);
+        // DEBUG_PRINT("MF1: %d at location %d \n", majority_frequency, ch->bit_count);
+        ch->bit_count++;
         //save the last time we recieved a valid new bit for the timeout
-        fsk->tick_time_since_last_bit = fsk->FSK_tick_count;
+        ch->tick_time_since_last_bit = fsk->FSK_tick_count;
         //valid found
         return true;
     }
@@ -557,11 +670,15 @@ bool FSK_process_found_majority_frequency_and_save_byte_if_full(FSK_instance* fs
         // for (int i = 0; i < FSK_RECENT_FREQUENCY_BUFFER_SIZE; i++)
         // {
         //     uint16_t temp;
-        //     circular_buf_peek(cbuf_freq_recent, &temp, i);
+        //     circular_buf_peek(ch->recent_frequencies, &temp, i);
         //     DEBUG_PRINT("F Found: %d\n", temp);
         // }
-        fsk->data_byte = 0;
-        fsk->bit_count = 0;
+        ch->data_byte = 0;
+        ch->bit_count = 0;
+        vlc_fec_decoder_reset(&ch->fec);
+#ifdef CONFIG_VLC_PACKET_FRAMING
+        vlc_packet_rx_reset(&ch->rx);
+#endif
         //no valid frequency found resetting system and waiting for new preamble
         return false;
     }
@@ -570,84 +687,241 @@ bool FSK_process_found_majority_frequency_and_save_byte_if_full(FSK_instance* fs
 /**
 * Processes the full byte if completed
 */
-bool process_byte_if_complete(FSK_instance* fsk){
+bool process_byte_if_complete(FSK_instance* fsk, FSK_channel* ch){
     //process if the byte is full
-    if(fsk->bit_count == 8){
+    if(ch->bit_count == 8){
         //process byte
-        DEBUG_PRINT("byte found!:  "BYTE_TO_BINARY_PATTERN "\n", BYTE_TO_BINARY(fsk->data_byte)); 
-        parse_data_byte(fsk->data_byte);           
+        DEBUG_PRINT("byte found!:  "BYTE_TO_BINARY_PATTERN "\n", BYTE_TO_BINARY(ch->data_byte)); 
+        parse_data_byte((uint8_t)(ch - fsk->channel), ch->data_byte);           
         //for now we reset it again.
-        fsk->data_byte = 0;
-        fsk->bit_count = 0;
+        ch->data_byte = 0;
+        ch->bit_count = 0;
         return true;
     }
     return false;
 }
 
+#ifdef CONFIG_VLC_PACKET_FRAMING
 /**
- * Is called as an update low priority background task.
+ * Checks the address of a recieved packet and passes it to the motion commander queue
+ * @param channel the channel (tone pair) the packet was recieved on
 */
-void FSK_update(FSK_instance* fsk){
-    //keeps track of the number of FFTs performed on the buffers with adc samples.
-    static uint16_t FFT_count = 0;
-    static uint16_t FFT_preamble_count = 0;
-    
-    //Contains the last found majority frequency found in the buffer
-    int16_t majority_frequency = -1;
-    if(fsk->isInit){
-        //we wait till sufficient preambles have arrived, 
-        //the moment sufficient have arrived we start scanning the packet
-        if(Read_and_save_new_FSK_frequency_if_avaiable(fsk)){
-            if(FFT_preamble_count < PREAMBLE_SIZE){ //0,1,2
-                if(last_recieved_frequency == FSK_F1){
-                    FFT_preamble_count++;
-                    DEBUG_PRINT("preamble: %d \n", FFT_preamble_count);
-                }
-                else{
-                    FFT_preamble_count = 0;
-                    FFT_count = 0;
-                }
-                FFT_count = 0;
-            }
-            else{
-            //increment a counter when a succesfull frequency read is performed
-                FFT_count++;
-                // DEBUG_PRINT("V");
+void parse_packet(uint8_t channel, const vlc_packet_t* packet){
+#ifdef CONFIG_FSK_MULTI_CHANNEL
+    if(!parce_packet_channel(channel)){
+        return;
+    }
+#endif
+    //check if the packet is intended for this drone
+    if((packet->address != DRONE_ID) && (packet->address != VLC_PACKET_BROADCAST_ADDRESS)){
+        DEBUG_PRINT("Packet recieved but not inteded for this drone\n");
+        return;
+    }
+    if(!vlc_motion_commander_enqueue_packet(packet)){
+        DEBUG_PRINT("Packet queue full, packet dropped\n");
+    }
+}
 
-            }
-        }else{
-        //   DEBUG_PRINT("IV \n");  
+/**
+ * Passes the last recieved bit to the packet deframer of the channel
+ * @return true if the frame has ended (packet recieved or dropped) and the next preamble has to be awaited
+*/
+bool process_packet_bit(FSK_instance* fsk, FSK_channel* ch){
+    if(ch->bit_count == 0){
+        return false;
+    }
+    uint8_t bit = (ch->data_byte >> (ch->bit_count - 1)) & 0x01;
+    ch->data_byte = 0;
+    ch->bit_count = 0;
+
+    switch (vlc_packet_rx_push_bit(&ch->rx, bit)){
+    case vlc_rx_packet_ready:
+        DEBUG_PRINT("packet found! type: %d length: %d\n", ch->rx.packet.type, ch->rx.packet.length);
+        fsk_log.packets_recieved++;
+        parse_packet((uint8_t)(ch - fsk->channel), &ch->rx.packet);
+        return true;
+    case vlc_rx_error:
+        fsk_log.packet_errors++;
+        return true;
+    default:
+        return false;
+    }
+}
+#endif //CONFIG_VLC_PACKET_FRAMING
+
+/**
+ * Processes a newly added data bit, as part of a single byte or of a framed packet
+ * @return true if the byte or frame has ended and the next preamble has to be awaited
+*/
+bool process_data_bit(FSK_instance* fsk, FSK_channel* ch){
+#ifdef CONFIG_VLC_PACKET_FRAMING
+    return process_packet_bit(fsk, ch);
+#else
+    return process_byte_if_complete(fsk, ch);
+#endif
+}
+
+/**
+ * Processes a newly recieved bit. Without FEC it is a data bit,
+ * otherwise it is a coded bit that is replaced by the data bits once its block is decoded.
+ * @return true if the byte or frame has ended and the next preamble has to be awaited
+*/
+bool process_recieved_bit(FSK_instance* fsk, FSK_channel* ch){
+    if(ch->fec.mode == vlc_fec_none){
+        return process_data_bit(fsk, ch);
+    }
+    //take the coded bit back out of the byte
+    uint8_t data = 0;
+    const uint32_t corrected_before = ch->fec.corrected_bits;
+    uint8_t num_of_data_bits = vlc_fec_decoder_pop_bit(&ch->fec, &ch->data_byte, &ch->bit_count, &data);
+    fsk_log.fec_corrected_bits += ch->fec.corrected_bits - corrected_before;
+    for (uint8_t i = 0; i < num_of_data_bits; i++)
+    {
+        //save the decoded data bit LSB first
+        ch->data_byte = modifyBit(ch->data_byte, ch->bit_count, (data >> i) & 0x01);
+        ch->bit_count++;
+        if(process_data_bit(fsk, ch)){
+            //the rest of the block is not part of this byte or frame
+            vlc_fec_decoder_reset(&ch->fec);
+            return true;
+        }
+    }
+    return false;
+}
+
+void FSK_set_fec_mode(FSK_instance* fsk, uint8_t channel, vlc_fec_mode mode){
+    if(channel < FSK_NUM_OF_CHANNELS){
+        vlc_fec_decoder_init(&fsk->channel[channel].fec, mode);
+    }
+}
+
+#ifdef CONFIG_FSK_STREAMING_DEMODULATOR
+/**
+ * Runs every sample of a window through the streaming demodulator.
+ * Bits are decided per sample by the demodulator and its symbol clock, the preamble is a single f1 bit.
+*/
+void FSK_update_streaming(FSK_instance* fsk){
+    FSK_channel* ch = &fsk->channel[0];
+
+    if (!FSK_read_window(fsk)){
+        return;
+    }
+
+    for (int i = 0; i < FSK_SAMPLES; i++)
+    {
+        FSK_sdft_symbol symbol = FSK_sdft_demod_push(&fsk->D, fsk->window[i]);
+        if (symbol == sdft_symbol_none){
+            continue;
+        }
+        //the signal is gone, everything recieved so far is incomplete
+        if (symbol == sdft_symbol_lost){
+            ch->data_byte = 0;
+            ch->bit_count = 0;
+            fsk->preamble_found = false;
+            continue;
         }
-        /** 
-        * Do this every FSK_RECENT_FREQUENCY_BUFFER_SIZE succesfull frequency samples.
-        * A single bit will be send as FSK_RECENT_FREQUENCY_BUFFER_SIZE time intervals each of length FSK_SAMPLES
-        * Therefore a majority will always occur even if the window of 5x sampling does not precicly allign
-        */
-        if (FFT_count == FSK_RECENT_FREQUENCY_BUFFER_SIZE){
-            //get the majority frequency
-            majority_frequency = obtain_majority_frequency_from_cBuf(cbuf_freq_recent);
-            FFT_count = 0;
-
-            // DEBUG_PRINT("MF: %d" );
-
-            //process the found majority frequency if false result reset and wait for preamble
-            if(!FSK_process_found_majority_frequency_and_save_byte_if_full(fsk, majority_frequency)){
-                FFT_preamble_count = 0;
-                DEBUG_PRINT("preamble zero no majority found \n");
 
+        uint16_t frequency = (symbol == sdft_symbol_f1) ? ch->f1 : ch->f0;
+        ch->last_recieved_frequency = frequency;
+
+        if (!fsk->preamble_found){
+            if (frequency == ch->f1){
+                fsk->preamble_found = true;
+                DEBUG_PRINT("preamble found \n");
             }
+            continue;
+        }
 
-            //process if the byte is full reset and wait for preamble
-            if(process_byte_if_complete(fsk)){
-                FFT_preamble_count = 0;
-                DEBUG_PRINT("preamble zero byte full\n");
+        //process the found bit if false result reset and wait for preamble
+        if(!FSK_process_found_majority_frequency_and_save_byte_if_full(fsk, ch, frequency)){
+            fsk->preamble_found = false;
+        }
+        //process if the byte or frame is complete reset and wait for preamble, only a stored bit can complete it
+        else if(process_recieved_bit(fsk, ch)){
+            fsk->preamble_found = false;
+        }
+    }
+    //Reset the byte read if we have an interrupt in the signal
+    if(fsk_byte_timeout_reset(fsk, ch)){
+        fsk->preamble_found = false;
+    }
+}
+#endif //CONFIG_FSK_STREAMING_DEMODULATOR
+
+/**
+ * Runs the preamble detection and bit decisions of a single channel.
+ * @param new_frequency true if a new frequency was saved in the channel after the last call
+*/
+void FSK_update_channel(FSK_instance* fsk, FSK_channel* ch, bool new_frequency){
+    //Contains the last found majority frequency found in the buffer
+    int16_t majority_frequency = -1;
+
+    //we wait till sufficient preambles have arrived, 
+    //the moment sufficient have arrived we start scanning the packet
+    if(new_frequency){
+        if(ch->preamble_count < PREAMBLE_SIZE){ //0,1,2
+            if(ch->last_recieved_frequency == ch->f1){
+                ch->preamble_count++;
+                DEBUG_PRINT("preamble: %d \n", ch->preamble_count);
             }
+            else{
+                ch->preamble_count = 0;
+            }
+            ch->window_count = 0;
+        }
+        else{
+        //increment a counter when a succesfull frequency read is performed
+            ch->window_count++;
+        }
+    }
+    /** 
+    * Do this every FSK_RECENT_FREQUENCY_BUFFER_SIZE succesfull frequency samples.
+    * A single bit will be send as FSK_RECENT_FREQUENCY_BUFFER_SIZE time intervals each of length FSK_SAMPLES
+    * Therefore a majority will always occur even if the window of 5x sampling does not precicly allign
+    */
+    if (ch->window_count == FSK_RECENT_FREQUENCY_BUFFER_SIZE){
+        //get the majority frequency
+        majority_frequency = obtain_majority_frequency_from_cBuf(ch->recent_frequencies);
+        ch->window_count = 0;
+
+        //process the found majority frequency if false result reset and wait for preamble
+        if(!FSK_process_found_majority_frequency_and_save_byte_if_full(fsk, ch, majority_frequency)){
+            ch->preamble_count = 0;
+            DEBUG_PRINT("preamble zero no majority found \n");
+        }
+        //process if the byte or frame is complete reset and wait for preamble, only a stored bit can complete it
+        else if(process_recieved_bit(fsk, ch)){
+            ch->preamble_count = 0;
+            DEBUG_PRINT("preamble zero byte full\n");
         }
-        //Reset the byte read if we have an interrupt in the signal
-        //Wait again for preamble
-        if(fsk_byte_timeout_reset(fsk)){
-            // FFT_preamble_count = 0;
-            // DEBUG_PRINT("Preamble_0: False_frequency_found\n");
+    }
+    //Reset the byte read if we have an interrupt in the signal
+    if(fsk_byte_timeout_reset(fsk, ch)){
+#ifdef CONFIG_VLC_PACKET_FRAMING
+        //the frame is lost, wait for the preamble of the next one
+        if(ch->preamble_count >= PREAMBLE_SIZE){
+            ch->preamble_count = 0;
+        }
+#endif
+    }
+}
+
+/**
+ * Is called as an update low priority background task.
+*/
+void FSK_update(FSK_instance* fsk){
+#ifdef CONFIG_FSK_STREAMING_DEMODULATOR
+    if(fsk->isInit){
+        FSK_update_streaming(fsk);
+    }
+    return;
+#endif
+    if(fsk->isInit){
+        //a window is detected once for all channels, every channel then assembles its own bytes
+        bool new_frequency = Read_and_save_new_FSK_frequency_if_avaiable(fsk);
+        for (uint8_t c = 0; c < FSK_NUM_OF_CHANNELS; c++)
+        {
+            FSK_update_channel(fsk, &fsk->channel[c], new_frequency);
         }
     }
 }
@@ -656,4 +930,16 @@ LOG_GROUP_START(FSKLOGGING)
                 //the raw RGB values of the sensors
                 LOG_ADD_CORE(LOG_FLOAT, value, &fsk_log.read_value)
                 LOG_ADD_CORE(LOG_UINT8, B0, &fsk_log.last_recieved_byte)
+                //framed packets recieved and dropped
+                LOG_ADD_CORE(LOG_UINT32, pktOk, &fsk_log.packets_recieved)
+                LOG_ADD_CORE(LOG_UINT32, pktErr, &fsk_log.packet_errors)
+                //coded bits corrected by the FEC of all channels
+                LOG_ADD_CORE(LOG_UINT32, fecFix, &fsk_log.fec_corrected_bits)
+                //adaptive spike margin in ADC counts and gain of the AGC
+                LOG_ADD_CORE(LOG_FLOAT, spikeMargin, &fsk_log.spike_margin)
+                LOG_ADD_CORE(LOG_FLOAT, agcGain, &fsk_log.agc_gain)
+                //samples dropped because the FSK task did not keep up with the sample ring
+                LOG_ADD_CORE(LOG_UINT32, ringOverrun, &sample_ring.overrun_count)
+                //highest number of samples waiting in the sample ring
+                LOG_ADD_CORE(LOG_UINT32, ringMaxFill, &sample_ring.max_fill)
 LOG_GROUP_STOP(FSKLOGGING)
\ No newline at end of file
@@ -9,13 +9,52 @@
 //deck gpio parameters
 #include "deck.h"
 
+//build configuration (FSK detector selection)
+#include "autoconf.h"
+//tone plan of the channels (FSK_MAX_CHANNELS)
+#include "fsk_tones.h"
+
+#ifdef CONFIG_FSK_DETECTOR_GOERTZEL
+#include "fsk_goertzel.h"
+#endif
+#ifdef CONFIG_FSK_STREAMING_DEMODULATOR
+#include "fsk_sdft.h"
+#endif
+#ifdef CONFIG_FSK_FIXED_POINT
+#include "fsk_q15.h"
+#endif
+//spike filters and the adaptive front end
+#include "fsk_agc.h"
+
+//recently found frequencies of a channel
+#include "circular_buffer.h"
+//framed packets
+#include "vlc_packet.h"
+//forward error correction
+#include "vlc_fec.h"
+
 //motion commander
 #include "crazyflie_vlc_motion_commander.h"
 
-//The command id this drone will listen to
+//The command id this drone will listen to (ID bits of a byte and address of a packet)
 #define DRONE_ID 0
+
+#ifdef CONFIG_FSK_MULTI_CHANNEL
+//every drone is addressed by its own tone pair, so all 7 data bits of a byte are command bits
+#define FSK_NUM_OF_CHANNELS CONFIG_FSK_NUM_OF_CHANNELS
+//The channel (tone pair) this drone will listen to
+#define FSK_CHANNEL CONFIG_FSK_CHANNEL
+//the first few bits used in a data byte for identification
+#define NUM_OF_ID_BITS 0
+#else
+#define FSK_NUM_OF_CHANNELS 1
+#define FSK_CHANNEL 0
 //the first few bits used in a data byte for identification
 #define NUM_OF_ID_BITS 2
+#endif
+#if (FSK_NUM_OF_CHANNELS > FSK_MAX_CHANNELS) || (FSK_CHANNEL >= FSK_NUM_OF_CHANNELS)
+#error "FSK_CHANNEL has to be one of the FSK_NUM_OF_CHANNELS channels"
+#endif
 //number of frequency samples to recieve before we can determine a bit
 #define FSK_RECENT_FREQUENCY_BUFFER_SIZE 3
 
@@ -29,65 +68,131 @@
 
 
 //The numbers of samples used every FFT conversion
-#define FSK_SAMPLES 64 //only 16, 64, 256, 1024. are supported
-//Because the crazyflie only supports the complex fft arm functions we need to use a buffer twice the size
-#define FSK_SAMPLE_BUFFER_SIZE 2*FSK_SAMPLES
+#define FSK_SAMPLES 64 //powers of 2 from 32 up to 4096 are supported by the real FFT
+//Both the goertzel detector and the real FFT work on the real valued samples directly
+#define FSK_SAMPLE_BUFFER_SIZE FSK_SAMPLES
 //the ARM fft implementation requires a size to be given
 #define FFT_SIZE FSK_SAMPLES
 //a sample every ms
 #define FSK_SAMPLINGFREQ 2000
-
-
-
-typedef enum{
-    empty = 0,
-    filling = 1, 
-    full = 2
-}FSK_buffer_status;
-
-typedef struct FSK_Buffers{
-    //we will be writing in a seperate task to these buffers and don't want to read and write from the same buffer.
-    FSK_buffer_status buff0_status;
-    FSK_buffer_status buff1_status;
-    uint8_t entries_buf0;
-    uint8_t entries_buf1;
-    float32_t buff_0[FSK_SAMPLE_BUFFER_SIZE];
-    float32_t buff_1[FSK_SAMPLE_BUFFER_SIZE];
-    //Keeps track of the last used buffer
-    uint8_t current_buffer;
-}FSK_buffer;
-
-typedef struct FSK_instances
-{
-    //Only true if init is called
-    bool isInit;
-    //The dual storage buffer
-    FSK_buffer buff;
+//number of samples the ring between the ADC interrupt and the FSK task can hold (power of 2)
+//8 windows gives the FSK task 256 ms to catch up before samples are dropped
+//the fixed point chain stores the ADC counts as 16 bit integers, the float chain as float32
+#define FSK_SAMPLE_RING_SIZE (8 * FSK_SAMPLES)
+
+
+
+#ifndef CONFIG_FSK_DETECTOR_GOERTZEL
+//Everything the FFT needs, set up once in FSK_init so a window only runs the transform
+typedef struct FSK_fft_plans{
+    //precomputed twiddle factors and bit reverse tables of the real FFT
+    arm_rfft_fast_instance_f32 rfft;
+    //real FFT output {DC, nyquist, R1, I1, R2, I2 ...}
+    float32_t spectrum[FFT_SIZE] __attribute__((aligned(8)));
+    //magnitude of the bins 0 up to FFT_SIZE/2
+    float32_t magnitude[FFT_SIZE/2] __attribute__((aligned(8)));
+}FSK_fft_plan;
+#endif
+
+//Reception state of a single tone pair
+typedef struct FSK_channels{
     //Frequencies we are looking for (aslo used to generate example sine waves.)
     uint16_t f0;
-    uint16_t f1; 
-
-    //arm  cfft instance
-    arm_cfft_radix4_instance_f32 S;    /* ARM CFFT module */
+    uint16_t f1;
 
     //current data byte
     uint8_t data_byte;
     //keeps track howmany of the bit of the data byte have been written
     uint8_t bit_count;
+    uint32_t tick_time_since_last_bit;
 
-    //tracks the number of ticks passed (every ms)
+    //the recently detected frequencies, a bit is the majority of these
+    uint16_t recent_frequency_buffer[FSK_RECENT_FREQUENCY_BUFFER_SIZE];
+    circular_buf_t recent_frequency_cbuf;
+    cbuf_handle_t recent_frequencies;
+    //the last detected frequency, needed for the preamble counter
+    uint16_t last_recieved_frequency;
+    //windows processed since the last bit and number of preamble windows found
+    uint16_t window_count;
+    uint16_t preamble_count;
+    //forward error correction of the bits after the preamble
+    vlc_fec_decoder fec;
+#ifdef CONFIG_VLC_PACKET_FRAMING
+    //packet deframer, gets every bit after the preamble
+    vlc_packet_rx rx;
+#endif
+}FSK_channel;
+
+typedef struct FSK_instances
+{
+    //Only true if init is called
+    bool isInit;
+#ifdef CONFIG_FSK_FIXED_POINT
+    //window of DC free q15 samples taken from the sample ring that is being processed
+    q15_t window_q15[FSK_SAMPLES];
+    //fixed point spike rejection, DC removal and tone detection
+    FSK_q15_spike_filter spike_filter;
+    FSK_q15_detector Q;
+#else
+    //window of samples taken from the sample ring that is being processed
+    float32_t window[FSK_SAMPLE_BUFFER_SIZE];
+#ifndef CONFIG_FSK_ADAPTIVE_FRONT_END
+    //removes the spikes with a fixed margin
+    FSK_spike_filter spike_fixed;
+#endif
+#endif
+    //one tone pair per channel, FSK_CHANNEL is the channel of this drone
+    FSK_channel channel[FSK_NUM_OF_CHANNELS];
+
+#ifdef CONFIG_FSK_MULTI_CHANNEL
+    //the tone pairs of all channels and a noise reference bin, processed in one pass
+    FSK_goertzel_bank B;
+#elif defined(CONFIG_FSK_DETECTOR_GOERTZEL)
+    //two tone detector (f0, f1 and a noise reference bin)
+    FSK_goertzel G;
+#else
+    //real FFT setup and scratch buffers
+    FSK_fft_plan P;
+#endif
+#ifdef CONFIG_FSK_STREAMING_DEMODULATOR
+    //per sample demodulator with symbol timing recovery
+    FSK_sdft_demod D;
+    //true after the f1 preamble bit, the following bits are data
+    bool preamble_found;
+#endif
+#ifdef CONFIG_FSK_ADAPTIVE_FRONT_END
+    //adaptive spike margin, gain normalisation and per bin noise thresholds
+    FSK_adaptive_spike_filter spike;
+    FSK_agc agc;
+    FSK_cfar cfar;
+#endif
+
+    //tracks the number of samples taken (advances a full buffer at a time)
     uint32_t FSK_tick_count;
-    uint32_t tick_time_since_last_bit;
 
 }FSK_instance;
 
 void FSK_init(FSK_instance* fsk);
 
-void FSK_tick(FSK_instance* fsk);
+/**
+ * Waits till the ADC interrupt has added new samples to the sample ring
+ * @param timeout_ms maximum time to wait
+ * @return true if new samples have arrived
+*/
+bool FSK_wait_for_samples(FSK_instance* fsk, uint32_t timeout_ms);
+
+/**
+ * @return true if a full window of samples is waiting to be processed by FSK_update
+*/
+bool FSK_samples_available(FSK_instance* fsk);
 
 void FSK_update(FSK_instance* fsk);
 
-// void FSK_read_ADC_value_and_put_in_buffer(FSK_instance* fsk);
+/**
+ * Selects the forward error correction of a channel, the default is set in Kconfig
+ * @param channel the channel (tone pair), 0 if there is a single channel
+*/
+void FSK_set_fec_mode(FSK_instance* fsk, uint8_t channel, vlc_fec_mode mode);
 
 void generate_complex_sine_wave(FSK_instance* fsk, float32_t output[], int buf_len, int fs);
 
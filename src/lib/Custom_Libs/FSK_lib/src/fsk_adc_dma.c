@@ -0,0 +1,217 @@
+#include "fsk_adc_dma.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "stm32fxxx.h"
+#include "nvicconf.h"
+
+//Hardware
+#define FSK_ADC                     ADC1
+#define FSK_ADC_CLK                 RCC_APB2Periph_ADC1
+#define FSK_ADC_TRIGGER             ADC_ExternalTrigConv_T8_TRGO
+
+#define FSK_TIM                     TIM8
+#define FSK_TIM_CLK                 RCC_APB2Periph_TIM8
+//the timer counts at 1 MHz, the sampling period is set in us
+#define FSK_TIM_COUNTER_FREQ        1000000
+
+#define FSK_DMA_CLK                 RCC_AHB1Periph_DMA2
+#define FSK_DMA_STREAM              DMA2_Stream4
+#define FSK_DMA_CHANNEL             DMA_Channel_0
+#define FSK_DMA_IRQ                 DMA2_Stream4_IRQn
+#define FSK_DMA_IRQHandler          DMA2_Stream4_IRQHandler
+#define FSK_DMA_IT_HTIF             DMA_IT_HTIF4
+#define FSK_DMA_IT_TCIF             DMA_IT_TCIF4
+
+//calls FreeRTOS functions so has to be below configMAX_SYSCALL_INTERRUPT_PRIORITY
+#define FSK_DMA_IRQ_PRIO            NVIC_ADC_PRI
+
+static TaskHandle_t fsk_task_handle = NULL;
+static uint16_t* dma_buffer = NULL;
+static uint16_t dma_half_size = 0;
+static FSK_sample_ring_handle sample_ring = NULL;
+
+/**
+ * TIM8 generates an update event (TRGO) every sampling period, this starts a single ADC conversion.
+ */
+static void FSK_adc_dma_timer_init(uint32_t fs){
+    TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+    RCC_ClocksTypeDef clocks;
+
+    RCC_APB2PeriphClockCmd(FSK_TIM_CLK, ENABLE);
+
+    //APB2 timers run at twice the APB2 clock when the APB2 prescaler is not 1
+    RCC_GetClocksFreq(&clocks);
+    uint32_t timer_clock = 2 * clocks.PCLK2_Frequency;
+
+    TIM_TimeBaseStructInit(&TIM_TimeBaseStructure);
+    TIM_TimeBaseStructure.TIM_Prescaler = (uint16_t)((timer_clock / FSK_TIM_COUNTER_FREQ) - 1);
+    TIM_TimeBaseStructure.TIM_Period = (FSK_TIM_COUNTER_FREQ / fs) - 1;
+    TIM_TimeBaseStructure.TIM_ClockDivision = TIM_CKD_DIV1;
+    TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+    TIM_TimeBaseStructure.TIM_RepetitionCounter = 0;
+    TIM_TimeBaseInit(FSK_TIM, &TIM_TimeBaseStructure);
+
+    TIM_SelectOutputTrigger(FSK_TIM, TIM_TRGOSource_Update);
+}
+
+/**
+ * ADC1 converts a single channel on every rising edge of the timer trigger and requests a DMA transfer.
+ */
+static void FSK_adc_dma_adc_init(uint8_t channel){
+    ADC_InitTypeDef ADC_InitStructure;
+    ADC_CommonInitTypeDef ADC_CommonInitStructure;
+
+    RCC_APB2PeriphClockCmd(FSK_ADC_CLK, ENABLE);
+
+    //same common settings as adcInit() so analogRead on ADC2 is not affected
+    ADC_CommonStructInit(&ADC_CommonInitStructure);
+    ADC_CommonInitStructure.ADC_Mode = ADC_Mode_Independent;
+    ADC_CommonInitStructure.ADC_Prescaler = ADC_Prescaler_Div2;
+    ADC_CommonInitStructure.ADC_DMAAccessMode = ADC_DMAAccessMode_Disabled;
+    ADC_CommonInitStructure.ADC_TwoSamplingDelay = ADC_TwoSamplingDelay_5Cycles;
+    ADC_CommonInit(&ADC_CommonInitStructure);
+
+    ADC_StructInit(&ADC_InitStructure);
+    ADC_InitStructure.ADC_Resolution = ADC_Resolution_12b;
+    ADC_InitStructure.ADC_ScanConvMode = DISABLE;
+    ADC_InitStructure.ADC_ContinuousConvMode = DISABLE;
+    ADC_InitStructure.ADC_ExternalTrigConvEdge = ADC_ExternalTrigConvEdge_Rising;
+    ADC_InitStructure.ADC_ExternalTrigConv = FSK_ADC_TRIGGER;
+    ADC_InitStructure.ADC_DataAlign = ADC_DataAlign_Right;
+    ADC_InitStructure.ADC_NbrOfConversion = 1;
+    ADC_Init(FSK_ADC, &ADC_InitStructure);
+
+    //According to datasheet, minimum sampling time for 12-bit conversion is 15 cycles.
+    ADC_RegularChannelConfig(FSK_ADC, channel, 1, ADC_SampleTime_15Cycles);
+
+    //keep requesting DMA transfers after the first buffer
+    ADC_DMARequestAfterLastTransferCmd(FSK_ADC, ENABLE);
+    ADC_DMACmd(FSK_ADC, ENABLE);
+    ADC_Cmd(FSK_ADC, ENABLE);
+}
+
+/**
+ * Circular DMA from the ADC data register to the buffer, with an interrupt at half and full transfer.
+ */
+static void FSK_adc_dma_dma_init(void){
+    DMA_InitTypeDef DMA_InitStructure;
+    NVIC_InitTypeDef NVIC_InitStructure;
+
+    RCC_AHB1PeriphClockCmd(FSK_DMA_CLK, ENABLE);
+
+    DMA_Cmd(FSK_DMA_STREAM, DISABLE);
+    DMA_DeInit(FSK_DMA_STREAM);
+
+    DMA_StructInit(&DMA_InitStructure);
+    DMA_InitStructure.DMA_Channel = FSK_DMA_CHANNEL;
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)(&(FSK_ADC->DR));
+    DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)dma_buffer;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralToMemory;
+    DMA_InitStructure.DMA_BufferSize = 2 * dma_half_size;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+    DMA_InitStructure.DMA_FIFOMode = DMA_FIFOMode_Disable;
+    DMA_InitStructure.DMA_FIFOThreshold = DMA_FIFOThreshold_1QuarterFull;
+    DMA_InitStructure.DMA_MemoryBurst = DMA_MemoryBurst_Single;
+    DMA_InitStructure.DMA_PeripheralBurst = DMA_PeripheralBurst_Single;
+    DMA_Init(FSK_DMA_STREAM, &DMA_InitStructure);
+
+    DMA_ITConfig(FSK_DMA_STREAM, DMA_IT_HT | DMA_IT_TC, ENABLE);
+
+    NVIC_InitStructure.NVIC_IRQChannel = FSK_DMA_IRQ;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = FSK_DMA_IRQ_PRIO;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+
+    DMA_Cmd(FSK_DMA_STREAM, ENABLE);
+}
+
+bool FSK_adc_dma_init(const deckPin_t pin, uint32_t fs, uint16_t buffer[], uint16_t half_size, FSK_sample_ring_handle ring){
+    GPIO_InitTypeDef GPIO_InitStructure;
+
+    if (deckGPIOMapping[pin.id].adcCh < 0){
+        return false;
+    }
+
+    fsk_task_handle = xTaskGetCurrentTaskHandle();
+    dma_buffer = buffer;
+    dma_half_size = half_size;
+    sample_ring = ring;
+
+    //set the pin to analog mode
+    RCC_AHB1PeriphClockCmd(deckGPIOMapping[pin.id].periph, ENABLE);
+    GPIO_StructInit(&GPIO_InitStructure);
+    GPIO_InitStructure.GPIO_Pin = deckGPIOMapping[pin.id].pin;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AN;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_25MHz;
+    GPIO_InitStructure.GPIO_PuPd = GPIO_PuPd_NOPULL;
+    GPIO_Init(deckGPIOMapping[pin.id].port, &GPIO_InitStructure);
+
+    FSK_adc_dma_timer_init(fs);
+    FSK_adc_dma_adc_init((uint8_t)deckGPIOMapping[pin.id].adcCh);
+    FSK_adc_dma_dma_init();
+
+    //the first trigger starts the sampling
+    TIM_Cmd(FSK_TIM, ENABLE);
+    return true;
+}
+
+bool FSK_adc_dma_wait_for_samples(TickType_t timeout){
+    return ulTaskNotifyTake(pdTRUE, timeout) > 0;
+}
+
+//moves a completed half of the DMA buffer into the sample ring
+static void FSK_adc_dma_put_half(const uint16_t* half){
+    //samples that do not fit are counted as overrun by the ring
+    for (uint16_t i = 0; i < dma_half_size; i++)
+    {
+#ifdef CONFIG_FSK_FIXED_POINT
+        spsc_ring_i16_put(sample_ring, (int16_t)half[i]);
+#else
+        spsc_ring_put(sample_ring, (float)half[i]);
+#endif
+    }
+}
+
+void __attribute__((used)) FSK_DMA_IRQHandler(void){
+    portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+
+    //after a late interrupt both halves can be complete, both flags are handled in the same call
+    bool half_transfer = (DMA_GetITStatus(FSK_DMA_STREAM, FSK_DMA_IT_HTIF) != RESET);
+    bool transfer_complete = (DMA_GetITStatus(FSK_DMA_STREAM, FSK_DMA_IT_TCIF) != RESET);
+    if (half_transfer){
+        DMA_ClearITPendingBit(FSK_DMA_STREAM, FSK_DMA_IT_HTIF);
+    }
+    if (transfer_complete){
+        DMA_ClearITPendingBit(FSK_DMA_STREAM, FSK_DMA_IT_TCIF);
+    }
+
+    if ((half_transfer || transfer_complete) && (sample_ring != NULL)){
+        //the half the DMA is writing now was completed first, the samples go in the ring oldest first
+        bool dma_in_first_half = (DMA_GetCurrDataCounter(FSK_DMA_STREAM) > dma_half_size);
+        if (half_transfer && transfer_complete && !dma_in_first_half){
+            FSK_adc_dma_put_half(&dma_buffer[dma_half_size]);
+            FSK_adc_dma_put_half(&dma_buffer[0]);
+        }else{
+            if (half_transfer){
+                FSK_adc_dma_put_half(&dma_buffer[0]);
+            }
+            if (transfer_complete){
+                FSK_adc_dma_put_half(&dma_buffer[dma_half_size]);
+            }
+        }
+        vTaskNotifyGiveFromISR(fsk_task_handle, &xHigherPriorityTaskWoken);
+    }
+
+    if (xHigherPriorityTaskWoken)
+    {
+        portYIELD();
+    }
+}
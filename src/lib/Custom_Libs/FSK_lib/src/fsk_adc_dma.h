@@ -0,0 +1,56 @@
+#ifndef FSK_ADC_DMA_H
+#define FSK_ADC_DMA_H
+
+/*
+    DMA based ADC acquisition for the FSK link.
+    A hardware timer triggers every ADC conversion, so the sampling moment no longer depends on interrupt latency.
+    The DMA writes the conversions in a circular buffer that consists of 2 halves:
+    - while the DMA fills one half the interrupt moves the other into the sample ring.
+    - the FSK task is woken with a task notification once a half is in the ring.
+    There is no interrupt per sample, only a single interrupt per half buffer.
+    The sample ring holds several halves, so the FSK task can fall behind for a while without losing samples.
+
+    Hardware used (not used by any other crazyflie driver):
+    - TIM8 update event (TRGO) triggers the conversions
+    - ADC1, ADC2 stays available for analogRead()
+    - DMA2 stream 4 channel 0
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+
+//deck gpio parameters
+#include "deck.h"
+
+//sample ring between the interrupt and the FSK task
+#include "spsc_ring.h"
+
+#ifdef CONFIG_FSK_FIXED_POINT
+//the fixed point chain takes the ADC counts as 16 bit integers, half the memory of float samples
+typedef spsc_ring_i16_handle_t FSK_sample_ring_handle;
+#else
+typedef spsc_ring_handle_t FSK_sample_ring_handle;
+#endif
+
+/**
+ * Configures the timer, ADC and DMA and starts sampling.
+ * The calling task is the task that will be notified, call this from the task that processes the samples.
+ * @param pin deck pin with an analog input
+ * @param fs sampling frequency in Hz
+ * @param buffer circular DMA buffer of 2*half_size samples, has to stay valid while sampling
+ * @param half_size number of samples in a half buffer
+ * @param ring every completed half is added to this ring (in ADC counts)
+ * @return false if the pin has no ADC channel
+ */
+bool FSK_adc_dma_init(const deckPin_t pin, uint32_t fs, uint16_t buffer[], uint16_t half_size, FSK_sample_ring_handle ring);
+
+/**
+ * Blocks until the DMA added a half buffer to the sample ring.
+ * @param timeout maximum time to wait in ticks
+ * @return false on a timeout
+ */
+bool FSK_adc_dma_wait_for_samples(TickType_t timeout);
+
+#endif //FSK_ADC_DMA_H
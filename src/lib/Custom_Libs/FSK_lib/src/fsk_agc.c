@@ -0,0 +1,121 @@
+/*
+    Spike filters, AGC and CFAR detector of the FSK link, see fsk_agc.h.
+    CFAR source: https://en.wikipedia.org/wiki/Constant_false_alarm_rate
+*/
+
+#include "fsk_agc.h"
+
+//filtering
+#include "digital_filters.h"
+
+void FSK_spike_filter_init(FSK_spike_filter* f, float32_t alpha, float32_t margin, float32_t initial_mean){
+    f->mean = initial_mean;
+    f->alpha = alpha;
+    f->margin = margin;
+}
+
+float32_t FSK_spike_filter_process(FSK_spike_filter* f, float32_t x){
+    f->mean = low_pass_EWMA_f32(x, f->mean, f->alpha);
+
+    // removes excessive large spikes form the measurements, by setting them to the mean value
+    if ((x > f->mean + f->margin) || (x < f->mean - f->margin)){
+        return f->mean;
+    }
+    return x;
+}
+
+//k deviations, at least the minimum margin
+static float32_t FSK_adaptive_spike_margin(const FSK_adaptive_spike_filter* f){
+    float32_t margin = f->k * f->deviation;
+    return (margin > f->min_margin) ? margin : f->min_margin;
+}
+
+void FSK_adaptive_spike_filter_init(FSK_adaptive_spike_filter* f, float32_t alpha, float32_t k, float32_t min_margin, float32_t initial_margin){
+    f->k = k;
+    f->min_margin = min_margin;
+    f->deviation = initial_margin / k;
+    FSK_spike_filter_init(&f->spike, alpha, FSK_adaptive_spike_margin(f), 0.0f);
+}
+
+float32_t FSK_adaptive_spike_filter_margin(const FSK_adaptive_spike_filter* f){
+    return f->spike.margin;
+}
+
+float32_t FSK_adaptive_spike_filter_process(FSK_adaptive_spike_filter* f, float32_t x){
+    float32_t y = FSK_spike_filter_process(&f->spike, x);
+    //a spike is replaced by the mean, which is further than the margin from it, spikes do not widen the margin
+    if (y != x){
+        return y;
+    }
+    f->deviation = low_pass_EWMA_f32(fabsf(x - f->spike.mean), f->deviation, f->spike.alpha);
+    f->spike.margin = FSK_adaptive_spike_margin(f);
+    return x;
+}
+
+void FSK_agc_init(FSK_agc* agc, float32_t alpha, float32_t target, float32_t max_gain){
+    agc->alpha = alpha;
+    agc->target = target;
+    agc->max_gain = max_gain;
+    agc->envelope = target;
+    agc->gain = 1.0f;
+}
+
+void FSK_agc_process(FSK_agc* agc, float32_t window[], uint16_t N){
+    float32_t std;
+    arm_std_f32(window, N, &std);
+    agc->envelope = low_pass_EWMA_f32(std, agc->envelope, agc->alpha);
+
+    float32_t gain = agc->target / ((agc->envelope > 1e-3f) ? agc->envelope : 1e-3f);
+    if (gain > agc->max_gain){
+        gain = agc->max_gain;
+    }
+    if (gain < (1.0f / agc->max_gain)){
+        gain = 1.0f / agc->max_gain;
+    }
+    agc->gain = gain;
+    //the goertzel bins are orthogonal to DC, so the mean does not have to be removed first
+    arm_scale_f32(window, gain, window, N);
+}
+
+bool FSK_cfar_init(FSK_cfar* c, uint8_t num_of_bins, float32_t alpha, float32_t ratio, float32_t min_power){
+    if (num_of_bins > FSK_CFAR_MAX_BINS){
+        return false;
+    }
+    c->num_of_bins = num_of_bins;
+    c->alpha = alpha;
+    c->ratio = ratio;
+    c->min_power = min_power;
+    for (uint8_t i = 0; i < num_of_bins; i++)
+    {
+        c->noise[i] = min_power;
+    }
+    return true;
+}
+
+uint16_t FSK_cfar_detect_pair(const FSK_cfar* c, const float32_t power[], uint8_t f0_bin, uint8_t f1_bin, uint8_t noise_bin,
+                              uint16_t f0, uint16_t f1, uint16_t* detected_bins){
+    const uint8_t bin = (power[f1_bin] > power[f0_bin]) ? f1_bin : f0_bin;
+    const float32_t p = power[bin];
+    const float32_t noise = (c->noise[bin] > c->min_power) ? c->noise[bin] : c->min_power;
+
+    if (p < (c->ratio * noise)){
+        return 0;
+    }
+    //broadband noise (or another light source) is as strong as the tone
+    if (p <= power[noise_bin]){
+        return 0;
+    }
+    *detected_bins |= (uint16_t)(1 << bin);
+    return (bin == f1_bin) ? f1 : f0;
+}
+
+void FSK_cfar_update(FSK_cfar* c, const float32_t power[], uint16_t detected_bins){
+    for (uint8_t i = 0; i < c->num_of_bins; i++)
+    {
+        //a bin carrying a tone would raise its own threshold
+        if (detected_bins & (1 << i)){
+            continue;
+        }
+        c->noise[i] = low_pass_EWMA_f32(power[i], c->noise[i], c->alpha);
+    }
+}
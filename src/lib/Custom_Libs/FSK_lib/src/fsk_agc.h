@@ -0,0 +1,128 @@
+#ifndef FSK_AGC_H
+#define FSK_AGC_H
+
+/*
+    Front end of the FSK detector.
+    The fixed spike filter replaces the samples further than a fixed number of ADC counts from their EWMA by the EWMA.
+    The adaptive front end replaces the fixed thresholds measured on a single setup:
+    - spike filter: the fixed spike filter with a margin that follows the mean absolute deviation of the samples
+      instead of a fixed number of ADC counts.
+    - AGC: scales every window so its standard deviation (signal envelope) is kept at a target level,
+      the gain follows slowly so the tone powers of consecutive windows stay comparable.
+    - CFAR: the noise power of every bin is tracked while it does not carry a detected tone,
+      a tone is detected when its power is a fixed ratio above the noise of its own bin.
+*/
+
+#include "arm_math.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+//maximum number of bins tracked by the CFAR detector
+#define FSK_CFAR_MAX_BINS 9
+
+typedef struct FSK_spike_filters{
+    //EWMA of the samples
+    float32_t mean;
+    float32_t alpha;
+    //a sample deviating more than margin from the mean is a spike (ADC counts)
+    float32_t margin;
+}FSK_spike_filter;
+
+typedef struct FSK_adaptive_spike_filters{
+    //mean of the samples, its margin is set from the deviation
+    FSK_spike_filter spike;
+    //EWMA of |x - mean| of the samples that are not spikes
+    float32_t deviation;
+    //a sample deviating more than k * deviation from the mean is a spike
+    float32_t k;
+    //the margin never drops below this (ADC counts)
+    float32_t min_margin;
+}FSK_adaptive_spike_filter;
+
+typedef struct FSK_agcs{
+    //EWMA of the standard deviation of the windows
+    float32_t envelope;
+    float32_t alpha;
+    //standard deviation a window is scaled to
+    float32_t target;
+    float32_t max_gain;
+    //gain applied to the last window
+    float32_t gain;
+}FSK_agc;
+
+typedef struct FSK_cfars{
+    //EWMA of the power of every bin while it does not carry a detected tone
+    float32_t noise[FSK_CFAR_MAX_BINS];
+    uint8_t num_of_bins;
+    float32_t alpha;
+    //a tone has to be this many times stronger than the noise of its bin
+    float32_t ratio;
+    //lower bound of the noise estimates, keeps the detector from triggering on a silent input
+    float32_t min_power;
+}FSK_cfar;
+
+/**
+ * @param alpha EWMA factor of the mean (same as low_pass_EWMA_f32)
+ * @param margin spike margin in ADC counts
+ * @param initial_mean starting value of the mean in ADC counts
+ */
+void FSK_spike_filter_init(FSK_spike_filter* f, float32_t alpha, float32_t margin, float32_t initial_mean);
+
+/**
+ * Removes the spikes caused by the IR beacons of the lighthouse system.
+ * @return the sample, or the mean if the sample is a spike
+ */
+float32_t FSK_spike_filter_process(FSK_spike_filter* f, float32_t x);
+
+/**
+ * @param alpha EWMA factor of the mean and deviation (same as low_pass_EWMA_f32)
+ * @param k spike margin in mean absolute deviations
+ * @param min_margin minimum spike margin in ADC counts
+ * @param initial_margin margin used until the deviation has settled
+ */
+void FSK_adaptive_spike_filter_init(FSK_adaptive_spike_filter* f, float32_t alpha, float32_t k, float32_t min_margin, float32_t initial_margin);
+
+/**
+ * @return the sample, or the mean if the sample is a spike
+ */
+float32_t FSK_adaptive_spike_filter_process(FSK_adaptive_spike_filter* f, float32_t x);
+
+/**
+ * @return the current spike margin in ADC counts
+ */
+float32_t FSK_adaptive_spike_filter_margin(const FSK_adaptive_spike_filter* f);
+
+/**
+ * @param alpha EWMA factor of the envelope per window
+ * @param target standard deviation of a window after scaling
+ * @param max_gain maximum gain (and 1/max_gain is the minimum gain)
+ */
+void FSK_agc_init(FSK_agc* agc, float32_t alpha, float32_t target, float32_t max_gain);
+
+/**
+ * Updates the envelope with a window and scales the window in place.
+ */
+void FSK_agc_process(FSK_agc* agc, float32_t window[], uint16_t N);
+
+/**
+ * @param alpha EWMA factor of the noise estimates per window
+ * @param ratio detection threshold as tone power / noise power
+ * @param min_power lower bound of the noise power estimates
+ */
+bool FSK_cfar_init(FSK_cfar* c, uint8_t num_of_bins, float32_t alpha, float32_t ratio, float32_t min_power);
+
+/**
+ * Decides which tone of a pair is present.
+ * The strongest tone has to exceed ratio times the noise of its bin and the current power of the noise reference bin.
+ * @param detected_bins bit mask, the bit of the detected bin is set
+ * @return the frequency of the detected tone, 0 if there is none
+ */
+uint16_t FSK_cfar_detect_pair(const FSK_cfar* c, const float32_t power[], uint8_t f0_bin, uint8_t f1_bin, uint8_t noise_bin,
+                              uint16_t f0, uint16_t f1, uint16_t* detected_bins);
+
+/**
+ * Updates the noise estimates of all bins that did not carry a detected tone in this window.
+ */
+void FSK_cfar_update(FSK_cfar* c, const float32_t power[], uint16_t detected_bins);
+
+#endif //FSK_AGC_H
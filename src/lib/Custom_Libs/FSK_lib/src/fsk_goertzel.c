@@ -0,0 +1,125 @@
+/*
+    Goertzel based two tone detector.
+    Source: https://en.wikipedia.org/wiki/Goertzel_algorithm
+
+    For every sample x[n] a bin is updated with:
+        s[n] = x[n] + coeff*s[n-1] - s[n-2]
+    after N samples the power of the bin is:
+        |X[k]|^2 = s[N-1]^2 + s[N-2]^2 - coeff*s[N-1]*s[N-2]
+
+    This costs 1 multiply and 2 additions per sample per bin,
+    compared to the complex FFT that calculates all N bins and their magnitudes.
+*/
+
+#include "fsk_goertzel.h"
+
+//rounds the frequency to the nearest integer bin and returns 2*cos(2*pi*k/N)
+static float32_t goertzel_coeff(uint16_t frequency, uint16_t fs, uint16_t N){
+    uint16_t k = (uint16_t)((((uint32_t)frequency * N) + (fs / 2)) / fs);
+    return 2.0f * arm_cos_f32(2.0f * PI * (float32_t)k / (float32_t)N);
+}
+
+//the strongest tone of a pair if it rises above the noise floor and the noise reference, 0 otherwise
+static uint16_t goertzel_decide(float32_t p0, float32_t p1, float32_t pn, uint16_t f0, uint16_t f1, float32_t noise_floor){
+    float32_t p_max = (p1 > p0) ? p1 : p0;
+
+    //compare in the power domain so no square root is required
+    if (p_max < (noise_floor * noise_floor)){
+        return 0;
+    }
+    //broadband noise (or another light source) is as strong as the tone
+    if (p_max <= pn){
+        return 0;
+    }
+    return (p1 > p0) ? f1 : f0;
+}
+
+void FSK_goertzel_init(FSK_goertzel* g, uint16_t f0, uint16_t f1, uint16_t f_noise, uint16_t fs, uint16_t N){
+    const uint16_t frequencies[GOERTZEL_NUM_OF_BINS] = {f0, f1, f_noise};
+
+    g->N = N;
+    for (int i = 0; i < GOERTZEL_NUM_OF_BINS; i++)
+    {
+        g->bins[i].coeff = goertzel_coeff(frequencies[i], fs, N);
+        g->bins[i].frequency = frequencies[i];
+        g->power[i] = 0.0f;
+    }
+}
+
+void FSK_goertzel_process(FSK_goertzel* g, const float32_t input[]){
+    const float32_t c0 = g->bins[goertzel_bin_f0].coeff;
+    const float32_t c1 = g->bins[goertzel_bin_f1].coeff;
+    const float32_t cn = g->bins[goertzel_bin_noise].coeff;
+
+    //filter states s[n-1] and s[n-2] of the 3 bins
+    float32_t s0_1 = 0, s0_2 = 0;
+    float32_t s1_1 = 0, s1_2 = 0;
+    float32_t sn_1 = 0, sn_2 = 0;
+
+    //all bins are updated in the same loop so every sample is only loaded once
+    for (uint16_t n = 0; n < g->N; n++)
+    {
+        const float32_t x = input[n];
+        float32_t s0 = x + c0 * s0_1 - s0_2;
+        float32_t s1 = x + c1 * s1_1 - s1_2;
+        float32_t sn = x + cn * sn_1 - sn_2;
+        s0_2 = s0_1; s0_1 = s0;
+        s1_2 = s1_1; s1_1 = s1;
+        sn_2 = sn_1; sn_1 = sn;
+    }
+
+    g->power[goertzel_bin_f0] = s0_1 * s0_1 + s0_2 * s0_2 - c0 * s0_1 * s0_2;
+    g->power[goertzel_bin_f1] = s1_1 * s1_1 + s1_2 * s1_2 - c1 * s1_1 * s1_2;
+    g->power[goertzel_bin_noise] = sn_1 * sn_1 + sn_2 * sn_2 - cn * sn_1 * sn_2;
+}
+
+uint16_t FSK_goertzel_detect(FSK_goertzel* g, const float32_t input[], float32_t noise_floor){
+    FSK_goertzel_process(g, input);
+
+    return goertzel_decide(g->power[goertzel_bin_f0], g->power[goertzel_bin_f1], g->power[goertzel_bin_noise],
+                           g->bins[goertzel_bin_f0].frequency, g->bins[goertzel_bin_f1].frequency, noise_floor);
+}
+
+bool FSK_goertzel_bank_init(FSK_goertzel_bank* b, const uint16_t frequencies[], uint8_t num_of_bins, uint16_t fs, uint16_t N){
+    if (num_of_bins > FSK_GOERTZEL_BANK_MAX_BINS){
+        return false;
+    }
+    b->N = N;
+    b->num_of_bins = num_of_bins;
+    for (uint8_t i = 0; i < num_of_bins; i++)
+    {
+        b->bins[i].coeff = goertzel_coeff(frequencies[i], fs, N);
+        b->bins[i].frequency = frequencies[i];
+        b->power[i] = 0.0f;
+    }
+    return true;
+}
+
+void FSK_goertzel_bank_process(FSK_goertzel_bank* b, const float32_t input[]){
+    //filter states s[n-1] and s[n-2] of every bin
+    float32_t s_1[FSK_GOERTZEL_BANK_MAX_BINS] = {0};
+    float32_t s_2[FSK_GOERTZEL_BANK_MAX_BINS] = {0};
+    const uint8_t M = b->num_of_bins;
+
+    //every sample is loaded once and fed to all bins
+    for (uint16_t n = 0; n < b->N; n++)
+    {
+        const float32_t x = input[n];
+        for (uint8_t i = 0; i < M; i++)
+        {
+            float32_t s = x + b->bins[i].coeff * s_1[i] - s_2[i];
+            s_2[i] = s_1[i];
+            s_1[i] = s;
+        }
+    }
+
+    for (uint8_t i = 0; i < M; i++)
+    {
+        b->power[i] = s_1[i] * s_1[i] + s_2[i] * s_2[i] - b->bins[i].coeff * s_1[i] * s_2[i];
+    }
+}
+
+uint16_t FSK_goertzel_bank_detect_pair(const FSK_goertzel_bank* b, uint8_t f0_bin, uint8_t f1_bin, uint8_t noise_bin, float32_t noise_floor){
+    return goertzel_decide(b->power[f0_bin], b->power[f1_bin], b->power[noise_bin],
+                           b->bins[f0_bin].frequency, b->bins[f1_bin].frequency, noise_floor);
+}
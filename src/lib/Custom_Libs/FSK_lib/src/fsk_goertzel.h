@@ -0,0 +1,104 @@
+#ifndef FSK_GOERTZEL_H
+#define FSK_GOERTZEL_H
+
+/*
+    Two tone detector for the FSK link.
+    Instead of running a full FFT over every bin we only evaluate the bins we care about:
+    - the FSK_F0 tone bin
+    - the FSK_F1 tone bin
+    - a noise reference bin that does not contain any of the tones
+    Every bin is a single Goertzel filter (2nd order IIR) that runs on real valued samples.
+
+    The goertzel bank generalizes this to the tone pairs of several channels (frequency division addressing),
+    all bins of the bank are updated in a single pass over the window.
+*/
+
+#include "arm_math.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+//The bins evaluated by the two tone detector
+typedef enum{
+    goertzel_bin_f0 = 0,
+    goertzel_bin_f1 = 1,
+    goertzel_bin_noise = 2,
+    GOERTZEL_NUM_OF_BINS = 3
+}FSK_goertzel_bin_id;
+
+typedef struct FSK_goertzel_bins{
+    //2*cos(2*pi*k/N) of the bin
+    float32_t coeff;
+    //the frequency the bin index k corresponds to
+    uint16_t frequency;
+}FSK_goertzel_bin;
+
+typedef struct FSK_goertzels{
+    FSK_goertzel_bin bins[GOERTZEL_NUM_OF_BINS];
+    //number of samples in a window
+    uint16_t N;
+    //power of the bins of the last processed window (|X[k]|^2)
+    float32_t power[GOERTZEL_NUM_OF_BINS];
+}FSK_goertzel;
+
+//maximum number of bins in a goertzel bank, 4 tone pairs and a noise reference bin
+#define FSK_GOERTZEL_BANK_MAX_BINS 9
+
+typedef struct FSK_goertzel_banks{
+    FSK_goertzel_bin bins[FSK_GOERTZEL_BANK_MAX_BINS];
+    //number of bins in use
+    uint8_t num_of_bins;
+    //number of samples in a window
+    uint16_t N;
+    //power of the bins of the last processed window (|X[k]|^2)
+    float32_t power[FSK_GOERTZEL_BANK_MAX_BINS];
+}FSK_goertzel_bank;
+
+/**
+ * Precomputes the filter coefficients of the tone and noise reference bins.
+ * The frequencies are rounded to the nearest integer bin, this makes the filters
+ * orthogonal to DC so the ADC offset does not have to be removed first.
+ * @param f0 first FSK frequency
+ * @param f1 second FSK frequency
+ * @param f_noise frequency of the noise reference bin (keep away from the tones and their harmonics)
+ * @param fs sampling frequency
+ * @param N number of samples in a window
+ */
+void FSK_goertzel_init(FSK_goertzel* g, uint16_t f0, uint16_t f1, uint16_t f_noise, uint16_t fs, uint16_t N);
+
+/**
+ * Runs all the bins over a window of N real valued samples in a single pass.
+ * The resulting powers are saved in g->power.
+ */
+void FSK_goertzel_process(FSK_goertzel* g, const float32_t input[]);
+
+/**
+ * Processes the window and decides which tone is present.
+ * @param noise_floor minimum magnitude |X[k]| a tone needs to have (same scale as arm_cmplx_mag_f32)
+ * @return the frequency of the strongest tone, 0 if no tone rises above the noise floor or the noise reference bin.
+ */
+uint16_t FSK_goertzel_detect(FSK_goertzel* g, const float32_t input[], float32_t noise_floor);
+
+/**
+ * Precomputes the filter coefficients of all bins of the bank, rounded to the nearest integer bin like FSK_goertzel_init.
+ * @param frequencies the frequency of every bin
+ * @param num_of_bins number of bins, at most FSK_GOERTZEL_BANK_MAX_BINS
+ * @return false if there are too many bins
+ */
+bool FSK_goertzel_bank_init(FSK_goertzel_bank* b, const uint16_t frequencies[], uint8_t num_of_bins, uint16_t fs, uint16_t N);
+
+/**
+ * Runs all the bins of the bank over a window of N real valued samples in a single pass.
+ * The resulting powers are saved in b->power.
+ */
+void FSK_goertzel_bank_process(FSK_goertzel_bank* b, const float32_t input[]);
+
+/**
+ * Decides which tone of a pair is present using the powers of the last processed window,
+ * with the same rules as FSK_goertzel_detect.
+ * @param f0_bin, f1_bin bins of the tone pair
+ * @param noise_bin noise reference bin
+ * @return the frequency of the strongest tone of the pair, 0 if no tone rises above the noise floor or the noise reference bin.
+ */
+uint16_t FSK_goertzel_bank_detect_pair(const FSK_goertzel_bank* b, uint8_t f0_bin, uint8_t f1_bin, uint8_t noise_bin, float32_t noise_floor);
+
+#endif //FSK_GOERTZEL_H
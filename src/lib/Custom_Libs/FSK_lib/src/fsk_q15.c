@@ -0,0 +1,102 @@
+/*
+    Fixed point FSK signal chain, see fsk_q15.h for the scaling.
+
+    Spike rejection and DC removal per sample (q31):
+        mean[n] = mean[n-1] + alpha*(x[n] - mean[n-1])
+        y[n]    = 0                   if |x[n] - mean[n]| > margin (spike, replaced by the mean)
+                  x[n] - mean[n]      otherwise
+    Tone detection per window (q15 x q15 -> 64 bit accumulator):
+        |X[k]|^2 = (sum x[n]*cos(2*pi*k*n/N))^2 + (sum x[n]*sin(2*pi*k*n/N))^2
+*/
+
+#include "fsk_q15.h"
+
+//rounds a float between -1 and 1 to q15
+static q15_t float_to_q15(float32_t value){
+    float32_t scaled = value * 32767.0f;
+    return (q15_t)(scaled + ((scaled >= 0.0f) ? 0.5f : -0.5f));
+}
+
+//ADC counts (relative to mid scale) to q31
+static q31_t counts_to_q31(float32_t counts){
+    return (q31_t)(counts * (float32_t)(1 << FSK_Q15_ADC_TO_Q31_SHIFT));
+}
+
+void FSK_q15_spike_filter_init(FSK_q15_spike_filter* f, float32_t alpha, float32_t margin, float32_t initial_mean){
+    f->alpha = (q31_t)(alpha * 2147483648.0f);
+    f->margin = counts_to_q31(margin);
+    f->mean = counts_to_q31(initial_mean - (float32_t)FSK_Q15_ADC_MID);
+}
+
+q15_t FSK_q15_spike_filter_process(FSK_q15_spike_filter* f, uint16_t adc_value){
+    //a multiply, a left shift of a negative value is undefined
+    const q31_t x = ((q31_t)adc_value - FSK_Q15_ADC_MID) * (1 << FSK_Q15_ADC_TO_Q31_SHIFT);
+
+    //the difference of 2 q31 values needs 33 bits
+    int64_t error = (int64_t)x - (int64_t)f->mean;
+    f->mean = (q31_t)((int64_t)f->mean + ((error * (int64_t)f->alpha) >> 31));
+
+    int64_t deviation = (int64_t)x - (int64_t)f->mean;
+    //removes excessive large spikes caused by the IR beacons of the lighthouse system
+    if ((deviation > f->margin) || (deviation < -(int64_t)f->margin)){
+        return 0;
+    }
+    return clip_q31_to_q15((q31_t)(deviation >> FSK_Q15_Q31_TO_Q15_SHIFT));
+}
+
+void FSK_q15_detector_init(FSK_q15_detector* d, uint16_t f0, uint16_t f1, uint16_t f_noise, uint16_t fs, uint16_t N){
+    const uint16_t frequencies[GOERTZEL_NUM_OF_BINS] = {f0, f1, f_noise};
+
+    if (N > FSK_Q15_MAX_N){
+        N = FSK_Q15_MAX_N;
+    }
+    d->N = N;
+    for (int i = 0; i < GOERTZEL_NUM_OF_BINS; i++)
+    {
+        //round to the nearest integer bin
+        uint16_t k = (uint16_t)((((uint32_t)frequencies[i] * N) + (fs / 2)) / fs);
+        for (uint16_t n = 0; n < N; n++)
+        {
+            //k*n mod N keeps the argument in [0, 2*pi)
+            float32_t w = 2.0f * PI * (float32_t)((k * n) % N) / (float32_t)N;
+            d->cos_table[i][n] = float_to_q15(arm_cos_f32(w));
+            d->sin_table[i][n] = float_to_q15(arm_sin_f32(w));
+        }
+        d->frequency[i] = frequencies[i];
+        d->power[i] = 0;
+    }
+}
+
+void FSK_q15_detector_process(FSK_q15_detector* d, const q15_t input[]){
+    for (int i = 0; i < GOERTZEL_NUM_OF_BINS; i++)
+    {
+        q63_t re, im;
+        arm_dot_prod_q15((q15_t*)input, d->cos_table[i], d->N, &re);
+        arm_dot_prod_q15((q15_t*)input, d->sin_table[i], d->N, &im);
+        re >>= FSK_Q15_DOT_PROD_SHIFT;
+        im >>= FSK_Q15_DOT_PROD_SHIFT;
+        d->power[i] = (re * re) + (im * im);
+    }
+}
+
+uint16_t FSK_q15_detect(FSK_q15_detector* d, const q15_t input[], float32_t noise_floor){
+    FSK_q15_detector_process(d, input);
+
+    const int64_t p0 = d->power[goertzel_bin_f0];
+    const int64_t p1 = d->power[goertzel_bin_f1];
+    const int64_t pn = d->power[goertzel_bin_noise];
+
+    FSK_goertzel_bin_id strongest = (p1 > p0) ? goertzel_bin_f1 : goertzel_bin_f0;
+    int64_t p_max = d->power[strongest];
+
+    //compare in the power domain so no square root is required
+    int64_t floor = (int64_t)(noise_floor * (float32_t)(1 << FSK_Q15_MAGNITUDE_FRACTION_BITS));
+    if (p_max < (floor * floor)){
+        return 0;
+    }
+    //broadband noise (or another light source) is as strong as the tone
+    if (p_max <= pn){
+        return 0;
+    }
+    return d->frequency[strongest];
+}
@@ -0,0 +1,87 @@
+#ifndef FSK_Q15_H
+#define FSK_Q15_H
+
+/*
+    Fixed point (q15/q31) variant of the FSK signal chain.
+    - spike rejection and DC removal: q31 EWMA of the ADC samples, the output is the q15 deviation from the mean.
+    - tone detection: correlation of the q15 window with q15 cos/sin tables of the f0, f1 and noise reference bins
+      using arm_dot_prod_q15. The 64 bit accumulator makes the tone powers exact integers.
+    The float chain (FSK_spike_filter + FSK_goertzel) is the reference, scales are chosen so both
+    compare in ADC counts: 1 ADC count = 16 LSB of a q15 sample.
+*/
+
+#include "arm_math.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+//bin ids are shared with the float goertzel detector
+#include "fsk_goertzel.h"
+
+//maximum number of samples in a window
+#define FSK_Q15_MAX_N 64
+//12 bit ADC, mid scale is the zero of the signed sample
+#define FSK_Q15_ADC_BITS 12
+#define FSK_Q15_ADC_MID (1 << (FSK_Q15_ADC_BITS - 1))
+//ADC counts to q31: 2048 counts is full scale
+#define FSK_Q15_ADC_TO_Q31_SHIFT (31 - (FSK_Q15_ADC_BITS - 1))
+//q31 to q15
+#define FSK_Q15_Q31_TO_Q15_SHIFT 16
+//arm_dot_prod_q15 result to |X[k]| in ADC counts * 2^10:
+//the result is counts*16 * cos*2^15 = counts * 2^19
+#define FSK_Q15_DOT_PROD_SHIFT 9
+#define FSK_Q15_MAGNITUDE_FRACTION_BITS 10
+
+typedef struct FSK_q15_spike_filters{
+    //EWMA of the ADC samples (q31, ADC counts relative to mid scale)
+    q31_t mean;
+    //EWMA factor (q31)
+    q31_t alpha;
+    //maximum deviation from the mean before a sample is seen as a spike (q31)
+    q31_t margin;
+}FSK_q15_spike_filter;
+
+typedef struct FSK_q15_detectors{
+    //e^(-j*2*pi*k*n/N) of the bins
+    q15_t cos_table[GOERTZEL_NUM_OF_BINS][FSK_Q15_MAX_N];
+    q15_t sin_table[GOERTZEL_NUM_OF_BINS][FSK_Q15_MAX_N];
+    //the frequency the bin index k corresponds to
+    uint16_t frequency[GOERTZEL_NUM_OF_BINS];
+    //number of samples in a window
+    uint16_t N;
+    //power of the bins of the last processed window |X[k]|^2 in ADC counts^2 * 2^20
+    int64_t power[GOERTZEL_NUM_OF_BINS];
+}FSK_q15_detector;
+
+/**
+ * @param alpha EWMA factor between 0 and 1 (same as low_pass_EWMA_f32)
+ * @param margin maximum deviation from the mean in ADC counts
+ * @param initial_mean starting value of the mean in ADC counts
+ */
+void FSK_q15_spike_filter_init(FSK_q15_spike_filter* f, float32_t alpha, float32_t margin, float32_t initial_mean);
+
+/**
+ * Updates the mean with a new ADC sample, replaces spikes by the mean and removes the mean.
+ * @return the DC free sample in q15 (16 LSB per ADC count)
+ */
+q15_t FSK_q15_spike_filter_process(FSK_q15_spike_filter* f, uint16_t adc_value);
+
+/**
+ * Precomputes the q15 tables of the tone and noise reference bins.
+ * The frequencies are rounded to the nearest integer bin like FSK_goertzel_init.
+ * @param N number of samples in a window, has to be <= FSK_Q15_MAX_N
+ */
+void FSK_q15_detector_init(FSK_q15_detector* d, uint16_t f0, uint16_t f1, uint16_t f_noise, uint16_t fs, uint16_t N);
+
+/**
+ * Correlates a window of N q15 samples with all bins, the powers are saved in d->power.
+ */
+void FSK_q15_detector_process(FSK_q15_detector* d, const q15_t input[]);
+
+/**
+ * Processes the window and decides which tone is present.
+ * @param noise_floor minimum magnitude |X[k]| a tone needs to have in ADC counts (same as FSK_goertzel_detect)
+ * @return the frequency of the strongest tone, 0 if no tone rises above the noise floor or the noise reference bin.
+ */
+uint16_t FSK_q15_detect(FSK_q15_detector* d, const q15_t input[], float32_t noise_floor);
+
+#endif //FSK_Q15_H
@@ -0,0 +1,145 @@
+/*
+    Streaming FSK demodulator based on a recursive sliding DFT.
+    Source: https://www.dsprelated.com/showarticle/776.php
+
+    Every sample the 2 tone bins are updated with:
+        X_k[n] = r*e^(j*2*pi*k/N) * (X_k[n-1] + x[n] - r^N * x[n-N])
+    which costs a single complex multiply per tone, instead of a full transform every window.
+
+    Bit slicing uses the normalised energy ratio of the tones:
+        d[n] = (|X_f1|^2 - |X_f0|^2) / (|X_f1|^2 + |X_f0|^2)       in [-1, 1]
+
+    Symbol timing (early-late gate):
+    The sliding window is N samples long, so d[n] only reaches its full value once the window
+    lies completely inside a symbol: samples [N-1, samples_per_symbol-1] of the symbol.
+    - early gate: first sample of this plateau
+    - decision:   centre of the plateau
+    - late gate:  last sample of the symbol
+    When the symbol clock runs late the late gate already sees the next symbol, |d| drops and early > late.
+    |d| drops by ~1 for every N/2 samples of misalignment, which gives the timing error in samples.
+*/
+
+#include "fsk_sdft.h"
+
+void FSK_sdft_demod_reset(FSK_sdft_demod* d){
+    for (int i = 0; i < 2; i++)
+    {
+        d->tone[i].re = 0.0f;
+        d->tone[i].im = 0.0f;
+    }
+    for (int i = 0; i < FSK_SDFT_MAX_N; i++)
+    {
+        d->history[i] = 0.0f;
+    }
+    d->history_index = 0;
+    d->phase = 0;
+    d->locked = false;
+    d->below_floor_count = 0;
+    d->early = 0.0f;
+    d->decision = sdft_symbol_none;
+}
+
+void FSK_sdft_demod_init(FSK_sdft_demod* d, uint16_t f0, uint16_t f1, uint16_t fs, uint16_t N, uint16_t samples_per_symbol, float32_t noise_floor){
+    const uint16_t frequencies[2] = {f0, f1};
+
+    if (N > FSK_SDFT_MAX_N){
+        N = FSK_SDFT_MAX_N;
+    }
+    d->N = N;
+    d->samples_per_symbol = samples_per_symbol;
+    d->noise_floor_power = noise_floor * noise_floor;
+    d->timing_error = 0;
+
+    d->damping_N = 1.0f;
+    for (uint16_t i = 0; i < N; i++)
+    {
+        d->damping_N *= FSK_SDFT_DAMPING;
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        //round to the nearest integer bin
+        uint16_t k = (uint16_t)((((uint32_t)frequencies[i] * N) + (fs / 2)) / fs);
+        float32_t w = 2.0f * PI * (float32_t)k / (float32_t)N;
+        d->tone[i].twiddle_re = FSK_SDFT_DAMPING * arm_cos_f32(w);
+        d->tone[i].twiddle_im = FSK_SDFT_DAMPING * arm_sin_f32(w);
+    }
+
+    FSK_sdft_demod_reset(d);
+}
+
+//single sliding DFT step of one tone bin
+static inline float32_t sdft_tone_update(FSK_sdft_tone* t, float32_t delta){
+    float32_t re = t->re + delta;
+    float32_t im = t->im;
+    t->re = re * t->twiddle_re - im * t->twiddle_im;
+    t->im = re * t->twiddle_im + im * t->twiddle_re;
+    return (t->re * t->re) + (t->im * t->im);
+}
+
+FSK_sdft_symbol FSK_sdft_demod_push(FSK_sdft_demod* d, float32_t x){
+    //replace the oldest sample in the window with the new one
+    float32_t x_old = d->history[d->history_index];
+    d->history[d->history_index] = x;
+    d->history_index++;
+    if (d->history_index >= d->N){
+        d->history_index = 0;
+    }
+
+    float32_t delta = x - d->damping_N * x_old;
+    float32_t p0 = sdft_tone_update(&d->tone[0], delta);
+    float32_t p1 = sdft_tone_update(&d->tone[1], delta);
+
+    //no tone above the noise floor
+    //a tone transition briefly splits the energy over both bins, so only give up after a full window
+    if ((p0 < d->noise_floor_power) && (p1 < d->noise_floor_power)){
+        if (!d->locked){
+            return sdft_symbol_none;
+        }
+        d->below_floor_count++;
+        if (d->below_floor_count >= d->N){
+            d->locked = false;
+            return sdft_symbol_lost;
+        }
+    }else{
+        d->below_floor_count = 0;
+    }
+
+    float32_t ratio = 0.0f;
+    if ((p1 + p0) > 0.0f){
+        ratio = (p1 - p0) / (p1 + p0);
+    }
+
+    //signal just appeared: start the symbol clock.
+    //the tone crosses the noise floor roughly when it fills half the window, the early-late gate corrects the rest.
+    if (!d->locked){
+        d->locked = true;
+        d->phase = (int16_t)(d->N / 2);
+        d->decision = sdft_symbol_none;
+        return sdft_symbol_none;
+    }
+
+    d->phase++;
+
+    const int16_t early_gate = (int16_t)(d->N - 1);
+    const int16_t late_gate = (int16_t)(d->samples_per_symbol - 1);
+    const int16_t centre = (early_gate + late_gate) / 2;
+
+    FSK_sdft_symbol output = sdft_symbol_none;
+
+    if (d->phase == early_gate){
+        d->early = fabsf(ratio);
+    }
+    if (d->phase == centre){
+        d->decision = (ratio > 0.0f) ? sdft_symbol_f1 : sdft_symbol_f0;
+        output = d->decision;
+    }
+    if (d->phase >= late_gate){
+        //early > late: the clock runs late and has to move forward
+        float32_t error = d->early - fabsf(ratio);
+        d->timing_error = (int16_t)(error * FSK_SDFT_TIMING_GAIN * (float32_t)(d->N / 2));
+        //next sample is the first sample of the next symbol (plus the correction)
+        d->phase = d->timing_error - 1;
+    }
+    return output;
+}
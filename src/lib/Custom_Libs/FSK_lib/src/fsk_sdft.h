@@ -0,0 +1,89 @@
+#ifndef FSK_SDFT_H
+#define FSK_SDFT_H
+
+/*
+    Streaming FSK demodulator.
+    A recursive sliding DFT tracks the two FSK tone bins over the last N samples and is updated every sample.
+    The energy ratio of the 2 tones is sliced into bits, and an early-late gate keeps the symbol clock aligned
+    with the bit boundaries of the transmitter instead of assuming them.
+*/
+
+#include "arm_math.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+//maximum sliding DFT window length (delay line size)
+#define FSK_SDFT_MAX_N 64
+//damping of the resonators, keeps the recursive DFT stable in float32
+#define FSK_SDFT_DAMPING 0.9999f
+//early-late gate loop gain (0-1], 1 corrects the full measured timing error every symbol
+#define FSK_SDFT_TIMING_GAIN 0.5f
+
+//demodulator output for a single sample
+typedef enum{
+    sdft_symbol_lost = -2,  //the signal dropped below the noise floor
+    sdft_symbol_none = -1,  //no decision this sample
+    sdft_symbol_f0 = 0,     //bit decision: f0
+    sdft_symbol_f1 = 1      //bit decision: f1
+}FSK_sdft_symbol;
+
+typedef struct FSK_sdft_tones{
+    //e^(j*2*pi*k/N) scaled by the damping factor
+    float32_t twiddle_re;
+    float32_t twiddle_im;
+    //current DFT bin value
+    float32_t re;
+    float32_t im;
+}FSK_sdft_tone;
+
+typedef struct FSK_sdft_demods{
+    //sliding DFT on f0 and f1
+    FSK_sdft_tone tone[2];
+    //last N samples, required to remove the oldest sample from the window
+    float32_t history[FSK_SDFT_MAX_N];
+    uint16_t history_index;
+    uint16_t N;
+    //damping^N applied to the sample leaving the window
+    float32_t damping_N;
+
+    //symbol timing
+    uint16_t samples_per_symbol;
+    //index of the current sample within the symbol (can be negative right after a timing correction)
+    int16_t phase;
+    //true while a signal is present and the symbol clock is running
+    bool locked;
+    //consecutive samples without a tone above the noise floor
+    uint16_t below_floor_count;
+    //|energy ratio| at the early gate of the current symbol
+    float32_t early;
+    //bit decided at the centre of the current symbol
+    FSK_sdft_symbol decision;
+    //last measured timing error in samples (for logging)
+    int16_t timing_error;
+
+    //minimum tone power |X[k]|^2
+    float32_t noise_floor_power;
+}FSK_sdft_demod;
+
+/**
+ * @param f0 first FSK frequency
+ * @param f1 second FSK frequency
+ * @param fs sampling frequency
+ * @param N sliding DFT window length, has to be <= FSK_SDFT_MAX_N
+ * @param samples_per_symbol number of samples a single bit is transmitted for
+ * @param noise_floor minimum magnitude |X[k]| of a tone (same scale as arm_cmplx_mag_f32)
+ */
+void FSK_sdft_demod_init(FSK_sdft_demod* d, uint16_t f0, uint16_t f1, uint16_t fs, uint16_t N, uint16_t samples_per_symbol, float32_t noise_floor);
+
+/**
+ * Resets the sliding DFT and the symbol clock
+ */
+void FSK_sdft_demod_reset(FSK_sdft_demod* d);
+
+/**
+ * Pushes a single real valued sample through the demodulator.
+ * @return a bit decision once per symbol, sdft_symbol_lost when the signal disappears, sdft_symbol_none otherwise.
+ */
+FSK_sdft_symbol FSK_sdft_demod_push(FSK_sdft_demod* d, float32_t x);
+
+#endif //FSK_SDFT_H
@@ -0,0 +1,40 @@
+#ifndef FSK_TONES_H
+#define FSK_TONES_H
+
+/*
+    Tone plan of the FSK channels.
+    All tones are on integer bins of a 64 sample window at 2 kHz (31.25 Hz), so a tone does not leak into the other bins.
+    A free bin is left between the channels so a window that straddles two bits does not leak into the next channel.
+
+    The LED driver and the photodiode are not linear, every tone also arrives at 2 and 3 times its frequency,
+    folded around 1 kHz when above the Nyquist frequency. None of these harmonics is on the bin of a tone or of a
+    noise reference, so a strong channel is not decoded as a bit on another channel (the first plan had the 2nd
+    harmonics of 125 and 156 Hz on the f1 of channel 1 and the f0 of channel 2).
+    Rejection margin: with 2nd and 3rd harmonics as strong as the tone itself, the power in the bins of the other
+    channels and the noise reference stays 33 dB below the tone (worst case 531 Hz into 438 Hz, the tones are
+    rounded to whole Hz and sit up to 0.5 Hz off their bin). test_fsk_tones.c checks the plan and this margin.
+*/
+
+#include <stdint.h>
+
+//number of tone pairs in fsk_channel_tones
+#define FSK_MAX_CHANNELS 4
+
+//tones of channel 0, also used by the single channel detectors
+#define FSK_F0 125
+#define FSK_F1 156
+
+//noise reference bin of the single channel goertzel detector, away from the tones and their harmonics
+#define FSK_SINGLE_CHANNEL_NOISE_REF_F 219
+//noise reference bin of the goertzel bank, between the channels and away from the tones and their harmonics
+#define FSK_MULTI_CHANNEL_NOISE_REF_F 438
+
+//tone pairs {f0, f1} of the channels
+static const uint16_t fsk_channel_tones[FSK_MAX_CHANNELS][2] = {
+    {FSK_F0, FSK_F1},   //bins 4, 5
+    {281, 344},         //bins 9, 11
+    {531, 594},         //bins 17, 19
+    {656, 750},         //bins 21, 24
+};
+
+#endif //FSK_TONES_H
@@ -0,0 +1,193 @@
+/*
+    Hamming(7,4) and K=7 convolutional codes of the VLC link, see vlc_fec.h.
+    Hamming source: https://en.wikipedia.org/wiki/Hamming(7,4)
+    Viterbi source: https://en.wikipedia.org/wiki/Viterbi_decoder
+
+    The Viterbi decoder keeps a path metric per state (number of coded bit errors)
+    and one decision bit per state per step, 14 steps x 64 states = 112 bytes.
+*/
+
+#include "vlc_fec.h"
+
+//number of ones modulo 2
+static uint8_t parity(uint32_t x){
+    x ^= x >> 16;
+    x ^= x >> 8;
+    x ^= x >> 4;
+    x ^= x >> 2;
+    x ^= x >> 1;
+    return (uint8_t)(x & 0x01);
+}
+
+uint8_t vlc_fec_hamming74_encode(uint8_t nibble){
+    uint8_t d0 = nibble & 0x01;
+    uint8_t d1 = (nibble >> 1) & 0x01;
+    uint8_t d2 = (nibble >> 2) & 0x01;
+    uint8_t d3 = (nibble >> 3) & 0x01;
+    uint8_t p1 = d0 ^ d1 ^ d3;
+    uint8_t p2 = d0 ^ d2 ^ d3;
+    uint8_t p3 = d1 ^ d2 ^ d3;
+    //codeword positions 1 to 7
+    return (uint8_t)(p1 | (p2 << 1) | (d0 << 2) | (p3 << 3) | (d1 << 4) | (d2 << 5) | (d3 << 6));
+}
+
+uint8_t vlc_fec_hamming74_decode(uint8_t codeword, bool* corrected){
+    //the syndrome is the position (1-7) of the flipped bit, 0 if there is none
+    uint8_t syndrome = 0;
+    for (uint8_t position = 1; position <= VLC_FEC_HAMMING_CODED_BITS; position++)
+    {
+        if ((codeword >> (position - 1)) & 0x01){
+            syndrome ^= position;
+        }
+    }
+    *corrected = (syndrome != 0);
+    if (syndrome != 0){
+        codeword ^= (uint8_t)(1 << (syndrome - 1));
+    }
+    return (uint8_t)(((codeword >> 2) & 0x01) | (((codeword >> 4) & 0x01) << 1) | (((codeword >> 5) & 0x01) << 2) | (((codeword >> 6) & 0x01) << 3));
+}
+
+//the 2 coded bits (g0 in bit 0, g1 in bit 1) of a 7 bit encoder register, the newest bit is the LSB
+static uint8_t conv_output(uint8_t reg){
+    return (uint8_t)(parity(reg & VLC_FEC_CONV_G0) | (parity(reg & VLC_FEC_CONV_G1) << 1));
+}
+
+uint32_t vlc_fec_conv_encode(uint8_t data){
+    uint32_t coded = 0;
+    uint8_t reg = 0;
+    for (uint8_t t = 0; t < VLC_FEC_CONV_STEPS; t++)
+    {
+        //the tail bits are 0 and bring the encoder back to state 0
+        uint8_t bit = (t < VLC_FEC_CONV_DATA_BITS) ? ((data >> t) & 0x01) : 0;
+        reg = (uint8_t)(((reg << 1) | bit) & 0x7F);
+        coded |= (uint32_t)conv_output(reg) << (2 * t);
+    }
+    return coded;
+}
+
+uint8_t vlc_fec_conv_decode(uint32_t coded, uint8_t* errors){
+    uint8_t metric[VLC_FEC_CONV_STATES];
+    uint8_t next_metric[VLC_FEC_CONV_STATES];
+    //bit s of decision[t]: the oldest register bit of the survivor into state s at step t
+    uint64_t decision[VLC_FEC_CONV_STEPS];
+
+    //the encoder starts in state 0
+    for (uint8_t s = 0; s < VLC_FEC_CONV_STATES; s++)
+    {
+        metric[s] = (s == 0) ? 0 : 0x7F;
+    }
+
+    for (uint8_t t = 0; t < VLC_FEC_CONV_STEPS; t++)
+    {
+        const uint8_t recieved = (uint8_t)((coded >> (2 * t)) & 0x03);
+        uint64_t d = 0;
+        for (uint8_t s = 0; s < VLC_FEC_CONV_STATES; s++)
+        {
+            //the register is {oldest bit, state s}, the oldest bit selects one of the 2 predecessors
+            uint8_t reg0 = s;
+            uint8_t reg1 = (uint8_t)(s | 0x40);
+            uint8_t e0 = conv_output(reg0) ^ recieved;
+            uint8_t e1 = conv_output(reg1) ^ recieved;
+            uint8_t m0 = metric[reg0 >> 1] + (e0 & 0x01) + (e0 >> 1);
+            uint8_t m1 = metric[reg1 >> 1] + (e1 & 0x01) + (e1 >> 1);
+            if (m1 < m0){
+                next_metric[s] = m1;
+                d |= (uint64_t)1 << s;
+            }else{
+                next_metric[s] = m0;
+            }
+        }
+        decision[t] = d;
+        for (uint8_t s = 0; s < VLC_FEC_CONV_STATES; s++)
+        {
+            metric[s] = next_metric[s];
+        }
+    }
+
+    //the tail brings the encoder back to state 0, trace the survivor of state 0 back
+    *errors = metric[0];
+    uint8_t state = 0;
+    uint8_t data = 0;
+    for (int8_t t = VLC_FEC_CONV_STEPS - 1; t >= 0; t--)
+    {
+        if (t < VLC_FEC_CONV_DATA_BITS){
+            data |= (uint8_t)((state & 0x01) << t);
+        }
+        uint8_t oldest = (uint8_t)((decision[t] >> state) & 0x01);
+        state = (uint8_t)((state >> 1) | (oldest << (VLC_FEC_CONV_K - 2)));
+    }
+    return data;
+}
+
+uint8_t vlc_fec_data_bits(vlc_fec_mode mode){
+    switch (mode){
+    case vlc_fec_hamming74:
+        return VLC_FEC_HAMMING_DATA_BITS;
+    case vlc_fec_conv_k7:
+        return VLC_FEC_CONV_DATA_BITS;
+    default:
+        return 1;
+    }
+}
+
+//coded bits in a block of the mode
+static uint8_t vlc_fec_coded_bits(vlc_fec_mode mode){
+    switch (mode){
+    case vlc_fec_hamming74:
+        return VLC_FEC_HAMMING_CODED_BITS;
+    case vlc_fec_conv_k7:
+        return VLC_FEC_CONV_CODED_BITS;
+    default:
+        return 1;
+    }
+}
+
+void vlc_fec_decoder_init(vlc_fec_decoder* dec, vlc_fec_mode mode){
+    dec->mode = mode;
+    dec->corrected_bits = 0;
+    vlc_fec_decoder_reset(dec);
+}
+
+void vlc_fec_decoder_reset(vlc_fec_decoder* dec){
+    dec->coded = 0;
+    dec->coded_count = 0;
+}
+
+uint8_t vlc_fec_decoder_push_bit(vlc_fec_decoder* dec, uint8_t bit, uint8_t* data){
+    dec->coded |= (uint32_t)(bit & 0x01) << dec->coded_count;
+    dec->coded_count++;
+    if (dec->coded_count < vlc_fec_coded_bits(dec->mode)){
+        return 0;
+    }
+
+    const uint32_t coded = dec->coded;
+    vlc_fec_decoder_reset(dec);
+    switch (dec->mode){
+    case vlc_fec_hamming74:{
+        bool corrected;
+        *data = vlc_fec_hamming74_decode((uint8_t)coded, &corrected);
+        dec->corrected_bits += corrected ? 1 : 0;
+        return VLC_FEC_HAMMING_DATA_BITS;
+    }
+    case vlc_fec_conv_k7:{
+        uint8_t errors;
+        *data = vlc_fec_conv_decode(coded, &errors);
+        dec->corrected_bits += errors;
+        return VLC_FEC_CONV_DATA_BITS;
+    }
+    default:
+        *data = (uint8_t)coded;
+        return 1;
+    }
+}
+
+uint8_t vlc_fec_decoder_pop_bit(vlc_fec_decoder* dec, uint8_t* bits, uint8_t* bit_count, uint8_t* data){
+    //an invalid bit decision empties the buffer, there is no coded bit to take out
+    if (*bit_count == 0){
+        return 0;
+    }
+    (*bit_count)--;
+    const uint8_t bit = (uint8_t)((*bits >> *bit_count) & 0x01);
+    *bits &= (uint8_t)~(1 << *bit_count);
+    return vlc_fec_decoder_push_bit(dec, bit, data);
+}
@@ -0,0 +1,97 @@
+#ifndef VLC_FEC_H
+#define VLC_FEC_H
+
+/*
+    Forward error correction between the FSK bit decisions and the byte/packet assembly.
+    The coded bits after the preamble are split in blocks that are decoded independently:
+    - hamming74: 4 data bits -> 7 coded bits, corrects a single bit error per block.
+        coded bit order (send first to last): p1 p2 d0 p3 d1 d2 d3, d0 is the LSB of the data nibble.
+    - conv_k7: rate 1/2 convolutional code, K=7, generators 171/133 (octal).
+        8 data bits followed by 6 zero tail bits -> 28 coded bits, (g0, g1) output per input bit.
+        Decoded with a hard decision Viterbi decoder over the 64 states of the terminated block.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum{
+    vlc_fec_none = 0,
+    vlc_fec_hamming74,
+    vlc_fec_conv_k7
+}vlc_fec_mode;
+
+//hamming(7,4) block
+#define VLC_FEC_HAMMING_DATA_BITS 4
+#define VLC_FEC_HAMMING_CODED_BITS 7
+
+//convolutional code
+#define VLC_FEC_CONV_K 7
+#define VLC_FEC_CONV_STATES (1 << (VLC_FEC_CONV_K - 1))
+#define VLC_FEC_CONV_G0 0171
+#define VLC_FEC_CONV_G1 0133
+#define VLC_FEC_CONV_DATA_BITS 8
+#define VLC_FEC_CONV_STEPS (VLC_FEC_CONV_DATA_BITS + VLC_FEC_CONV_K - 1)
+#define VLC_FEC_CONV_CODED_BITS (2 * VLC_FEC_CONV_STEPS)
+
+typedef struct vlc_fec_decoders{
+    vlc_fec_mode mode;
+    //coded bits of the current block, first recieved bit in the LSB
+    uint32_t coded;
+    uint8_t coded_count;
+    //statistics: coded bit errors corrected
+    uint32_t corrected_bits;
+}vlc_fec_decoder;
+
+/**
+ * @return the 7 bit codeword of a data nibble, bit 0 is send first
+ */
+uint8_t vlc_fec_hamming74_encode(uint8_t nibble);
+
+/**
+ * Corrects a single bit error in a codeword.
+ * @param corrected set to true if a bit was flipped
+ * @return the data nibble
+ */
+uint8_t vlc_fec_hamming74_decode(uint8_t codeword, bool* corrected);
+
+/**
+ * @return the 28 coded bits of a data byte including the tail, bit 0 is send first
+ */
+uint32_t vlc_fec_conv_encode(uint8_t data);
+
+/**
+ * Viterbi decoder of a terminated block.
+ * @param errors number of coded bits that differ from the decoded path
+ * @return the data byte
+ */
+uint8_t vlc_fec_conv_decode(uint32_t coded, uint8_t* errors);
+
+/**
+ * @return the number of data bits a block of the mode contains
+ */
+uint8_t vlc_fec_data_bits(vlc_fec_mode mode);
+
+void vlc_fec_decoder_init(vlc_fec_decoder* dec, vlc_fec_mode mode);
+
+/**
+ * Drops the coded bits of an incomplete block
+ */
+void vlc_fec_decoder_reset(vlc_fec_decoder* dec);
+
+/**
+ * Adds a recieved coded bit.
+ * @param data the decoded data bits (LSB first) once a block is complete
+ * @return the number of data bits in data, 0 while the block is incomplete
+ */
+uint8_t vlc_fec_decoder_push_bit(vlc_fec_decoder* dec, uint8_t bit, uint8_t* data);
+
+/**
+ * Takes the newest coded bit out of a bit buffer and adds it to the decoder.
+ * @param bits bit buffer, first recieved bit in the LSB
+ * @param bit_count number of bits in the buffer, nothing is taken out if it is 0
+ * @param data the decoded data bits (LSB first) once a block is complete
+ * @return the number of data bits in data, 0 while the block is incomplete or if the buffer is empty
+ */
+uint8_t vlc_fec_decoder_pop_bit(vlc_fec_decoder* dec, uint8_t* bits, uint8_t* bit_count, uint8_t* data);
+
+#endif //VLC_FEC_H
@@ -0,0 +1,167 @@
+/*
+    Deframer of the VLC packets, see vlc_packet.h for the frame format.
+    The bits are pushed one at a time as they are decided by the FSK demodulator,
+    so no frame buffer is needed besides the packet itself.
+*/
+
+#include "vlc_packet.h"
+
+#include <string.h>
+
+uint16_t vlc_packet_crc(const uint8_t data[], uint16_t len){
+#ifdef CONFIG_VLC_PACKET_CRC8
+    uint8_t crc = 0x00;
+    for (uint16_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (uint8_t b = 0; b < 8; b++)
+        {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+#else
+    uint16_t crc = 0xFFFF;
+    for (uint16_t i = 0; i < len; i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t b = 0; b < 8; b++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+#endif
+}
+
+//the header and payload bytes covered by the crc, in the order they are send
+static uint16_t vlc_packet_crc_of_packet(const vlc_packet_t* packet){
+    uint8_t data[3 + VLC_PACKET_MAX_PAYLOAD];
+    data[0] = packet->length;
+    data[1] = packet->address;
+    data[2] = packet->type;
+    memcpy(&data[3], packet->payload, packet->length);
+    return vlc_packet_crc(data, 3 + packet->length);
+}
+
+uint16_t vlc_packet_encode(const vlc_packet_t* packet, uint8_t out[], uint16_t out_size){
+    if ((packet->length > VLC_PACKET_MAX_PAYLOAD) || (out_size < (VLC_PACKET_OVERHEAD + packet->length))){
+        return 0;
+    }
+    uint16_t n = 0;
+    out[n++] = (uint8_t)(VLC_PACKET_SYNC_WORD & 0xFF);
+    out[n++] = (uint8_t)(VLC_PACKET_SYNC_WORD >> 8);
+    out[n++] = packet->length;
+    out[n++] = packet->address;
+    out[n++] = packet->type;
+    memcpy(&out[n], packet->payload, packet->length);
+    n += packet->length;
+
+    uint16_t crc = vlc_packet_crc_of_packet(packet);
+    for (uint8_t i = 0; i < VLC_PACKET_CRC_SIZE; i++)
+    {
+        out[n++] = (uint8_t)(crc >> (8 * i));
+    }
+    return n;
+}
+
+void vlc_packet_rx_init(vlc_packet_rx* rx){
+    rx->packets_recieved = 0;
+    rx->crc_errors = 0;
+    vlc_packet_rx_reset(rx);
+}
+
+void vlc_packet_rx_reset(vlc_packet_rx* rx){
+    rx->state = vlc_rx_state_sync;
+    rx->shift = 0;
+    rx->hunt_bits = 0;
+    rx->byte = 0;
+    rx->bit_count = 0;
+    rx->index = 0;
+}
+
+//handles a complete byte of the frame
+static vlc_packet_rx_status vlc_packet_rx_push_byte(vlc_packet_rx* rx, uint8_t byte){
+    switch (rx->state){
+    case vlc_rx_state_length:
+        if (byte > VLC_PACKET_MAX_PAYLOAD){
+            vlc_packet_rx_reset(rx);
+            return vlc_rx_error;
+        }
+        rx->packet.length = byte;
+        rx->state = vlc_rx_state_address;
+        break;
+
+    case vlc_rx_state_address:
+        rx->packet.address = byte;
+        rx->state = vlc_rx_state_type;
+        break;
+
+    case vlc_rx_state_type:
+        rx->packet.type = byte;
+        rx->index = 0;
+        rx->state = (rx->packet.length > 0) ? vlc_rx_state_payload : vlc_rx_state_crc;
+        break;
+
+    case vlc_rx_state_payload:
+        rx->packet.payload[rx->index++] = byte;
+        if (rx->index == rx->packet.length){
+            rx->index = 0;
+            rx->state = vlc_rx_state_crc;
+        }
+        break;
+
+    case vlc_rx_state_crc:
+        rx->crc[rx->index++] = byte;
+        if (rx->index == VLC_PACKET_CRC_SIZE){
+            uint16_t crc_recieved = 0;
+            for (uint8_t i = 0; i < VLC_PACKET_CRC_SIZE; i++)
+            {
+                crc_recieved |= (uint16_t)rx->crc[i] << (8 * i);
+            }
+            bool valid = (crc_recieved == vlc_packet_crc_of_packet(&rx->packet));
+            vlc_packet_rx_reset(rx);
+            if (!valid){
+                rx->crc_errors++;
+                return vlc_rx_error;
+            }
+            rx->packets_recieved++;
+            return vlc_rx_packet_ready;
+        }
+        break;
+
+    default:
+        vlc_packet_rx_reset(rx);
+        return vlc_rx_error;
+    }
+    return vlc_rx_busy;
+}
+
+vlc_packet_rx_status vlc_packet_rx_push_bit(vlc_packet_rx* rx, uint8_t bit){
+    bit &= 0x01;
+    if (rx->state == vlc_rx_state_sync){
+        //bits arrive LSB first, so they are shifted in from the top
+        rx->shift = (uint16_t)((rx->shift >> 1) | ((uint16_t)bit << 15));
+        rx->hunt_bits++;
+        if ((rx->hunt_bits >= 16) && (rx->shift == VLC_PACKET_SYNC_WORD)){
+            rx->state = vlc_rx_state_length;
+            rx->byte = 0;
+            rx->bit_count = 0;
+        }
+        else if (rx->hunt_bits >= VLC_PACKET_SYNC_HUNT_BITS){
+            vlc_packet_rx_reset(rx);
+            return vlc_rx_error;
+        }
+        return vlc_rx_busy;
+    }
+
+    rx->byte |= (uint8_t)(bit << rx->bit_count);
+    rx->bit_count++;
+    if (rx->bit_count < 8){
+        return vlc_rx_busy;
+    }
+    uint8_t byte = rx->byte;
+    rx->byte = 0;
+    rx->bit_count = 0;
+    return vlc_packet_rx_push_byte(rx, byte);
+}
@@ -0,0 +1,119 @@
+#ifndef VLC_PACKET_H
+#define VLC_PACKET_H
+
+/*
+    Packet framing on top of the FSK bit stream.
+    A frame is send after the FSK preamble, every byte LSB first:
+
+        | sync (2) | length (1) | address (1) | type (1) | payload (length) | crc (1 or 2) |
+
+    - sync: VLC_PACKET_SYNC_WORD, the reciever hunts for it bit by bit so extra preamble bits do no harm.
+    - length: number of payload bytes (0 up to VLC_PACKET_MAX_PAYLOAD).
+    - address: id of the drone the packet is intended for, VLC_PACKET_BROADCAST_ADDRESS for every drone.
+    - crc: over length, address, type and payload.
+        CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) send low byte first, or CRC-8 (poly 0x07, init 0x00)
+        when CONFIG_VLC_PACKET_CRC8 is set.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//build configuration (CRC selection)
+#include "autoconf.h"
+
+//first byte send is 0x91, second 0xD3
+#define VLC_PACKET_SYNC_WORD 0xD391
+//maximum number of payload bytes
+#define VLC_PACKET_MAX_PAYLOAD 16
+//packets with this address are accepted by every drone
+#define VLC_PACKET_BROADCAST_ADDRESS 0xFF
+//number of bits after the preamble in which the sync word has to be found
+#define VLC_PACKET_SYNC_HUNT_BITS 32
+
+#ifdef CONFIG_VLC_PACKET_CRC8
+#define VLC_PACKET_CRC_SIZE 1
+#else
+#define VLC_PACKET_CRC_SIZE 2
+#endif
+
+//bytes in the frame without the payload
+#define VLC_PACKET_OVERHEAD (2 + 3 + VLC_PACKET_CRC_SIZE)
+
+//content of the payload
+typedef enum{
+    //payload[0] is a FlightCommand
+    vlc_packet_type_command = 0,
+    //payload is a relative setpoint, 3x int16 (x, y, z) in mm little endian
+    vlc_packet_type_goto = 1
+}vlc_packet_type;
+
+typedef struct vlc_packets{
+    uint8_t address;
+    uint8_t type;
+    uint8_t length;
+    uint8_t payload[VLC_PACKET_MAX_PAYLOAD];
+}vlc_packet_t;
+
+//state of the deframer
+typedef enum{
+    vlc_rx_state_sync,
+    vlc_rx_state_length,
+    vlc_rx_state_address,
+    vlc_rx_state_type,
+    vlc_rx_state_payload,
+    vlc_rx_state_crc
+}vlc_packet_rx_state;
+
+//result of pushing a bit into the deframer
+typedef enum{
+    vlc_rx_busy = 0,        //frame not complete yet
+    vlc_rx_packet_ready,    //a valid packet is available in rx->packet
+    vlc_rx_error            //no sync found, invalid length or crc mismatch, the deframer has been reset
+}vlc_packet_rx_status;
+
+typedef struct vlc_packet_rxs{
+    vlc_packet_rx_state state;
+    //last 16 recieved bits, used to find the sync word
+    uint16_t shift;
+    //number of bits pushed while looking for the sync word
+    uint8_t hunt_bits;
+    //byte that is being assembled (LSB first)
+    uint8_t byte;
+    uint8_t bit_count;
+    //index of the next payload or crc byte
+    uint8_t index;
+    uint8_t crc[VLC_PACKET_CRC_SIZE];
+    //the packet that is being recieved, valid after vlc_rx_packet_ready
+    vlc_packet_t packet;
+    //statistics
+    uint32_t packets_recieved;
+    uint32_t crc_errors;
+}vlc_packet_rx;
+
+/**
+ * CRC of the frame (CRC-8 or CRC-16 depending on the build configuration)
+ */
+uint16_t vlc_packet_crc(const uint8_t data[], uint16_t len);
+
+/**
+ * Builds the frame of a packet, excluding the FSK preamble.
+ * @param out buffer of at least VLC_PACKET_OVERHEAD + packet->length bytes
+ * @return number of bytes written, 0 if the packet or buffer is invalid
+ */
+uint16_t vlc_packet_encode(const vlc_packet_t* packet, uint8_t out[], uint16_t out_size);
+
+void vlc_packet_rx_init(vlc_packet_rx* rx);
+
+/**
+ * Drops the frame that is being recieved and starts hunting for the sync word again.
+ * The statistics are kept.
+ */
+void vlc_packet_rx_reset(vlc_packet_rx* rx);
+
+/**
+ * Adds a single recieved bit to the deframer.
+ * @param bit 0 (f0) or 1 (f1)
+ */
+vlc_packet_rx_status vlc_packet_rx_push_bit(vlc_packet_rx* rx, uint8_t bit);
+
+#endif //VLC_PACKET_H
@@ -1,12 +1,15 @@
 #ifndef GEN_NORM_
 #define GEN_NORM_
 
-/* Initialize random number generator */
+#include <stdint.h>
+
+/* Initialize random number generator, seeds the pseudo random number generator once from the true random number generator */
 void init_TRNG();
 
-// Returns a normal rv with mean and standart deviation
-// input: mean, standart_deviation, call by reference to noise 0 and noise 1 (cause Box-Muller returns 2 values)
-void norm2(float mean, float std_dev, float* n0, float* n1);
-void norm1(float mean, float std_dev, float* n0);
+// Fills out with n normal rvs with mean and standart deviation
+void fill_normals(float out[], uint32_t n, float mean, float std_dev);
+
+// Returns a uniform rv in [0, 1) from the seeded pseudo random number generator
+float rand_val();
 
 #endif //GEN_NORM_
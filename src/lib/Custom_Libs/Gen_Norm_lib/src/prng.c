@@ -0,0 +1,124 @@
+/*
+    Seeded pseudo random number generator, see prng.h.
+*/
+
+#include "prng.h"
+
+#include <math.h>
+#include <stdbool.h>
+
+#define ZIGGURAT_LAYERS 128
+//start of the tail of the ziggurat and the area of a layer
+#define ZIGGURAT_R 3.442619855899
+#define ZIGGURAT_V 9.91256303526217e-3
+//the random number is scaled to [-1, 1) by the layer widths
+#define ZIGGURAT_M 2147483648.0
+
+//|value| below kn[i] is inside the rectangle of layer i
+static uint32_t kn[ZIGGURAT_LAYERS];
+//layer width scaled by 1 / ZIGGURAT_M
+static float wn[ZIGGURAT_LAYERS];
+//density at the top of layer i
+static float fn[ZIGGURAT_LAYERS];
+static bool ziggurat_ready = false;
+
+static void ziggurat_init(){
+    double dn = ZIGGURAT_R;
+    double tn = dn;
+    const double q = ZIGGURAT_V / exp(-0.5 * dn * dn);
+
+    kn[0] = (uint32_t)((dn / q) * ZIGGURAT_M);
+    kn[1] = 0;
+    wn[0] = (float)(q / ZIGGURAT_M);
+    wn[ZIGGURAT_LAYERS - 1] = (float)(dn / ZIGGURAT_M);
+    fn[0] = 1.0f;
+    fn[ZIGGURAT_LAYERS - 1] = (float)exp(-0.5 * dn * dn);
+
+    for (uint32_t i = ZIGGURAT_LAYERS - 2; i >= 1; i--)
+    {
+        dn = sqrt(-2.0 * log(ZIGGURAT_V / dn + exp(-0.5 * dn * dn)));
+        kn[i + 1] = (uint32_t)((dn / tn) * ZIGGURAT_M);
+        tn = dn;
+        fn[i] = (float)exp(-0.5 * dn * dn);
+        wn[i] = (float)(dn / ZIGGURAT_M);
+    }
+    ziggurat_ready = true;
+}
+
+//splitmix64, spreads a seed over the state so similar seeds give unrelated sequences
+static uint64_t splitmix64(uint64_t* x){
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+void prng_seed(Prng* g, uint64_t seed){
+    if (!ziggurat_ready){
+        ziggurat_init();
+    }
+    uint64_t a = splitmix64(&seed);
+    uint64_t b = splitmix64(&seed);
+    g->s[0] = (uint32_t)a;
+    g->s[1] = (uint32_t)(a >> 32);
+    g->s[2] = (uint32_t)b;
+    g->s[3] = (uint32_t)(b >> 32);
+    //an all zero state only returns zeros
+    if ((g->s[0] | g->s[1] | g->s[2] | g->s[3]) == 0){
+        g->s[0] = 1;
+    }
+}
+
+//uniform random number in (0, 1], for the logarithms
+static inline float prng_uniform_nonzero(Prng* g){
+    return (float)((prng_next(g) >> 8) + 1) * (1.0f / 16777216.0f);
+}
+
+//the sample fell outside of the rectangle of its layer
+static float ziggurat_slow(Prng* g, int32_t hz, uint32_t iz){
+    for (;;)
+    {
+        float x = (float)hz * wn[iz];
+        if (iz == 0){
+            //tail beyond ZIGGURAT_R
+            float y;
+            do
+            {
+                x = -logf(prng_uniform_nonzero(g)) * (float)(1.0 / ZIGGURAT_R);
+                y = -logf(prng_uniform_nonzero(g));
+            } while (y + y < x * x);
+            return (hz > 0) ? (float)ZIGGURAT_R + x : -(float)ZIGGURAT_R - x;
+        }
+        //wedge between layer iz and the density
+        if (fn[iz] + prng_uniform(g) * (fn[iz - 1] - fn[iz]) < expf(-0.5f * x * x)){
+            return x;
+        }
+
+        uint32_t u = prng_next(g);
+        iz = u & (ZIGGURAT_LAYERS - 1);
+        hz = (int32_t)(u & ~(uint32_t)(ZIGGURAT_LAYERS - 1));
+        uint32_t magnitude = (hz < 0) ? (0u - (uint32_t)hz) : (uint32_t)hz;
+        if (magnitude < kn[iz]){
+            return (float)hz * wn[iz];
+        }
+    }
+}
+
+float prng_normal(Prng* g){
+    //the low bits select the layer, the remaining bits are the signed value
+    uint32_t u = prng_next(g);
+    uint32_t iz = u & (ZIGGURAT_LAYERS - 1);
+    int32_t hz = (int32_t)(u & ~(uint32_t)(ZIGGURAT_LAYERS - 1));
+    uint32_t magnitude = (hz < 0) ? (0u - (uint32_t)hz) : (uint32_t)hz;
+    if (magnitude < kn[iz]){
+        return (float)hz * wn[iz];
+    }
+    return ziggurat_slow(g, hz, iz);
+}
+
+void prng_fill_normals(Prng* g, float out[], uint32_t n, float mean, float std_dev){
+    for (uint32_t i = 0; i < n; i++)
+    {
+        out[i] = prng_normal(g) * std_dev + mean;
+    }
+}
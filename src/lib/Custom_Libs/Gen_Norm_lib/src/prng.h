@@ -0,0 +1,66 @@
+#ifndef PRNG_H_
+#define PRNG_H_
+
+/*
+    Seeded pseudo random number generator for the noise of the particle filter.
+
+    The generator is xoshiro128** (Blackman and Vigna), 4 x 32 bit state and a period of 2^128 - 1.
+    The state is expanded from a 64 bit seed with splitmix64, on the drone the seed is taken once
+    from the true random number generator (see gen_norm.h), in the unit tests a fixed seed makes
+    every run the same.
+
+    Normal samples use the ziggurat method of Marsaglia and Tsang with 128 layers, about 98% of the
+    samples only need a random number, a table lookup, a compare and a multiplication.
+    The layer index and the sample value are taken from different bits of the random number.
+
+    No hardware is used here so this file builds on the host.
+*/
+
+#include <stdint.h>
+
+typedef struct Prngs
+{
+    uint32_t s[4];
+} Prng;
+
+/**
+ * Expands a seed into the state of the generator, the same seed gives the same sequence.
+ */
+void prng_seed(Prng* g, uint64_t seed);
+
+/**
+ * @return the next 32 bit random number
+ */
+static inline uint32_t prng_next(Prng* g){
+    uint32_t* s = g->s;
+    const uint32_t x = s[1] * 5;
+    const uint32_t result = ((x << 7) | (x >> 25)) * 9;
+    const uint32_t t = s[1] << 9;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 11) | (s[3] >> 21);
+    return result;
+}
+
+/**
+ * @return a uniform random number in [0, 1), 24 bits of resolution
+ */
+static inline float prng_uniform(Prng* g){
+    return (float)(prng_next(g) >> 8) * (1.0f / 16777216.0f);
+}
+
+/**
+ * @return a normal random number with mean 0 and standard deviation 1
+ */
+float prng_normal(Prng* g);
+
+/**
+ * Fills out with n normal random numbers with a mean and standard deviation.
+ */
+void prng_fill_normals(Prng* g, float out[], uint32_t n, float mean, float std_dev);
+
+#endif // PRNG_H_
@@ -1,5 +1,7 @@
 #include "KNN.h"
 
+#include <stdbool.h>
+
 int KNNColorIDsUsedMapping[NUMBER_OF_IDS] = {1,2,3,6,7,8,9,0};
 
 /**
@@ -7,7 +9,7 @@ int KNNColorIDsUsedMapping[NUMBER_OF_IDS] = {1,2,3,6,7,8,9,0};
  * This data is generated using the python script in the python folder.
  * It represents the reduced data set of the 8 colors used in the experiment.
 */
-TrainingPoint trainingPoints[NUMBER_OF_TRAINING_POINTS] = {
+const TrainingPoint trainingPoints[NUMBER_OF_TRAINING_POINTS] = {
 {.x_cart = -0.5223, .y_cart = 0.3073, .ID = 4},
 {.x_cart = 0.4596, .y_cart = -0.1211, .ID = 5},
 {.x_cart = -0.1124, .y_cart = -0.3981, .ID = 2},
@@ -69,17 +71,6 @@ TrainingPoint trainingPoints[NUMBER_OF_TRAINING_POINTS] = {
 {.x_cart = 0.0777, .y_cart = -0.3928, .ID = 2},
 {.x_cart = -0.4864, .y_cart = -0.0192, .ID = 1}
 };
-/**
- * @brief distance calculation measurement used.
- * 
- * @param p1 test point 
- * @param p2 TrainingPoint
- * @return float distance euchlidian
- */
-float euchlidianDistance(KNNPoint * p1, TrainingPoint * p2){
-    return sqrtf(powf((p2->x_cart - p1->x_cart), 2.0) + powf((p2->y_cart - p1->y_cart), 2.0));
-}
-
 //Converts polar coordinates to carthesian coordinates such that they match the training data
 void pol2Cart(KNNPoint* p){
     float r = p->sat_polar;  
@@ -94,72 +85,245 @@ void pol2Cart(KNNPoint* p){
     //NOTE MAYBE SWAP THESE POINTS as it needs to be the same for the python code.
     p-> x_cart = r * cosf(theta_rad);
     p-> y_cart= r * sinf(theta_rad);
-//    Serial.print("x_cart"); Serial.println(p->x_cart);
-//    Serial.print("y_cart"); Serial.println(p->y_cart);
+}
 
+//cell of a coordinate, points outside of the grid are in the border cells
+static int32_t gridCell(const KNNIndex* index, float v, float v_min){
+    int32_t c = (int32_t)floorf((v - v_min) * index->inverse_cell_size);
+    if (c < 0){
+        return 0;
+    }
+    if (c >= index->grid_dim){
+        return index->grid_dim - 1;
+    }
+    return c;
 }
 
-void calcDistances(KNNPoint *p0, TrainingPoint arr[]) {
-    for (int j = 0; j < NUMBER_OF_TRAINING_POINTS ; j++)
+int8_t KNNIndexBuild(KNNIndex* index, const TrainingPoint arr[], uint16_t n){
+    if ((n == 0) || (n > KNN_MAX_TRAINING_POINTS)){
+        return 0;
+    }
+
+    float x_max = arr[0].x_cart;
+    float y_max = arr[0].y_cart;
+    index->x_min = arr[0].x_cart;
+    index->y_min = arr[0].y_cart;
+    for (uint16_t i = 1; i < n; i++)
+    {
+        index->x_min = fminf(index->x_min, arr[i].x_cart);
+        index->y_min = fminf(index->y_min, arr[i].y_cart);
+        x_max = fmaxf(x_max, arr[i].x_cart);
+        y_max = fmaxf(y_max, arr[i].y_cart);
+    }
+
+    //about 2 points per cell
+    uint8_t grid_dim = 1;
+    while ((grid_dim < KNN_MAX_GRID_DIM) && (2 * grid_dim * grid_dim < n))
+    {
+        grid_dim++;
+    }
+    index->grid_dim = grid_dim;
+    index->num_of_points = n;
+    //square cells, slightly larger than the bounding box so the maximum is inside the grid
+    float extent = fmaxf(fmaxf(x_max - index->x_min, y_max - index->y_min), 1e-6f);
+    index->cell_size = (extent * 1.0001f) / (float)grid_dim;
+    index->inverse_cell_size = 1.0f / index->cell_size;
+
+    //count the points per cell, then turn the counts into start offsets
+    const uint16_t num_of_cells = grid_dim * grid_dim;
+    uint16_t cell_of_point[KNN_MAX_TRAINING_POINTS];
+    for (uint16_t c = 0; c <= num_of_cells; c++)
+    {
+        index->cell_start[c] = 0;
+    }
+    for (uint16_t i = 0; i < n; i++)
+    {
+        cell_of_point[i] = gridCell(index, arr[i].y_cart, index->y_min) * grid_dim + gridCell(index, arr[i].x_cart, index->x_min);
+        index->cell_start[cell_of_point[i] + 1]++;
+    }
+    for (uint16_t c = 0; c < num_of_cells; c++)
     {
-        arr[j].distanceToSamplePoint = euchlidianDistance(p0, &arr[j]);
-        // Serial.print("distance"); Serial.println(arr[i].distanceToSamplePoint);
+        index->cell_start[c + 1] += index->cell_start[c];
+    }
+
+    //copy the points in cell order, within a cell in training order
+    uint16_t fill[KNN_MAX_GRID_DIM * KNN_MAX_GRID_DIM];
+    for (uint16_t c = 0; c < num_of_cells; c++)
+    {
+        fill[c] = index->cell_start[c];
+    }
+    for (uint16_t i = 0; i < n; i++)
+    {
+        uint16_t j = fill[cell_of_point[i]]++;
+        index->x_cart[j] = arr[i].x_cart;
+        index->y_cart[j] = arr[i].y_cart;
+        index->ID[j] = arr[i].ID;
+        index->point[j] = i;
+    }
+    return 1;
+}
+
+//restores the max-heap property from position i down
+static void heapSiftDown(KNNNeighbours* h, uint8_t size, uint8_t i){
+    for (;;)
+    {
+        uint8_t largest = i;
+        uint8_t l = 2 * i + 1;
+        uint8_t r = 2 * i + 2;
+        if ((l < size) && (h->distance2[l] > h->distance2[largest])){
+            largest = l;
+        }
+        if ((r < size) && (h->distance2[r] > h->distance2[largest])){
+            largest = r;
+        }
+        if (largest == i){
+            return;
+        }
+        float d = h->distance2[i];
+        int8_t id = h->ID[i];
+        uint16_t p = h->point[i];
+        h->distance2[i] = h->distance2[largest];
+        h->ID[i] = h->ID[largest];
+        h->point[i] = h->point[largest];
+        h->distance2[largest] = d;
+        h->ID[largest] = id;
+        h->point[largest] = p;
+        i = largest;
     }
 }
 
-void swap(TrainingPoint* xp, TrainingPoint* yp)
-{
-    TrainingPoint temp = *xp;
-    *xp = *yp;
-    *yp = temp;
+//offers the points of a cell to the heap of the K nearest points
+static void searchCell(const KNNIndex* index, uint16_t cell, float x, float y, int32_t exclude, uint8_t K, KNNNeighbours* h){
+    for (uint16_t j = index->cell_start[cell]; j < index->cell_start[cell + 1]; j++)
+    {
+        if ((int32_t)index->point[j] == exclude){
+            continue;
+        }
+        float dx = index->x_cart[j] - x;
+        float dy = index->y_cart[j] - y;
+        float d2 = dx * dx + dy * dy;
+        if (h->K < K){
+            //fill the heap, sift the new point up
+            uint8_t i = h->K++;
+            while ((i > 0) && (h->distance2[(i - 1) / 2] < d2))
+            {
+                uint8_t parent = (i - 1) / 2;
+                h->distance2[i] = h->distance2[parent];
+                h->ID[i] = h->ID[parent];
+                h->point[i] = h->point[parent];
+                i = parent;
+            }
+            h->distance2[i] = d2;
+            h->ID[i] = index->ID[j];
+            h->point[i] = index->point[j];
+        }else if (d2 < h->distance2[0]){
+            //replace the furthest of the K nearest points
+            h->distance2[0] = d2;
+            h->ID[0] = index->ID[j];
+            h->point[0] = index->point[j];
+            heapSiftDown(h, K, 0);
+        }
+    }
 }
 
+//K nearest training points of (x, y), exclude is the training point that is left out (-1 for none)
+static int8_t searchCart(const KNNIndex* index, float x, float y, uint8_t K, int32_t exclude, KNNNeighbours* neighbours){
+    neighbours->K = 0;
+    uint16_t available = index->num_of_points - ((exclude >= 0) ? 1 : 0);
+    if ((K == 0) || (K > KNN_MAX_K) || (K > available)){
+        return 0;
+    }
+
+    const int32_t dim = index->grid_dim;
+    const int32_t qx = gridCell(index, x, index->x_min);
+    const int32_t qy = gridCell(index, y, index->y_min);
 
-//sorts the list using bubble sort
-void bubbleSort(TrainingPoint arr[]){
-    //simple implementation of bubble sort
-    for(int x=0; x < NUMBER_OF_TRAINING_POINTS; x++)
+    for (int32_t r = 0; r < dim; r++)
     {
-        for(int y=0; y < NUMBER_OF_TRAINING_POINTS-1; y++)
+        //visit the cells at chebyshev distance r of the cell of the point
+        for (int32_t cy = qy - r; cy <= qy + r; cy++)
         {
-            if(arr[y].distanceToSamplePoint > arr[y+1].distanceToSamplePoint)
+            if ((cy < 0) || (cy >= dim)){
+                continue;
+            }
+            bool edge_row = (cy == qy - r) || (cy == qy + r);
+            for (int32_t cx = qx - r; cx <= qx + r; cx += (edge_row || (r == 0)) ? 1 : 2 * r)
             {
-                swap(&arr[y], &arr[y + 1]);
+                if ((cx >= 0) && (cx < dim)){
+                    searchCell(index, (uint16_t)(cy * dim + cx), x, y, exclude, K, neighbours);
+                }
             }
         }
+
+        if (neighbours->K < K){
+            continue;
+        }
+        //distance of the point to the cells that are not visited yet, they are outside of the visited block
+        float bound = INFINITY;
+        if (qx - r > 0){
+            bound = fminf(bound, x - (index->x_min + (float)(qx - r) * index->cell_size));
+        }
+        if (qx + r < dim - 1){
+            bound = fminf(bound, (index->x_min + (float)(qx + r + 1) * index->cell_size) - x);
+        }
+        if (qy - r > 0){
+            bound = fminf(bound, y - (index->y_min + (float)(qy - r) * index->cell_size));
+        }
+        if (qy + r < dim - 1){
+            bound = fminf(bound, (index->y_min + (float)(qy + r + 1) * index->cell_size) - y);
+        }
+        if ((bound >= 0.0f) && (bound * bound >= neighbours->distance2[0])){
+            break;
+        }
     }
-    //debug printing of the sorted array
-    // Serial.println("Sorted array");
-    // for (int i = 0; i < NUMBER_OF_TRAINING_POINTS ; i++)
-    // {
-    //     Serial.print(arr[i].distanceToSamplePoint);Serial.print("-");  Serial.print(arr[i].ID);  Serial.print(", ");
-    // }
-    // Serial.println("");
-    
+
+    //heap sort, nearest neighbour first
+    for (uint8_t size = neighbours->K; size > 1; size--)
+    {
+        uint8_t last = size - 1;
+        float d = neighbours->distance2[0];
+        int8_t id = neighbours->ID[0];
+        uint16_t p = neighbours->point[0];
+        neighbours->distance2[0] = neighbours->distance2[last];
+        neighbours->ID[0] = neighbours->ID[last];
+        neighbours->point[0] = neighbours->point[last];
+        neighbours->distance2[last] = d;
+        neighbours->ID[last] = id;
+        neighbours->point[last] = p;
+        heapSiftDown(neighbours, last, 0);
+    }
+    return 1;
+}
+
+int8_t KNNSearch(KNNPoint* p0, const KNNIndex* index, uint8_t K, KNNNeighbours* neighbours){
+    //ensure that we have carthesian coordinates and not just polar
+    pol2Cart(p0);
+    return searchCart(index, p0->x_cart, p0->y_cart, K, -1, neighbours);
+}
+
+int8_t KNNSearchCartesian(const KNNPoint* p0, const KNNIndex* index, uint8_t K, KNNNeighbours* neighbours){
+    return searchCart(index, p0->x_cart, p0->y_cart, K, -1, neighbours);
+}
+
+int8_t KNNSearchExcluding(const KNNPoint* p0, const KNNIndex* index, uint8_t K, uint16_t exclude, KNNNeighbours* neighbours){
+    return searchCart(index, p0->x_cart, p0->y_cart, K, exclude, neighbours);
 }
 
-//performs the KNN search on a sorted list
-int16_t KNNClassification(KNNPoint * p0, TrainingPoint arr[], uint8_t K) {
-    // Serial.println("p1");
-    if ((K > NUMBER_OF_TRAINING_POINTS) || (K > 254)){
-        return -1;
+int8_t predictLabelOfPoint(const KNNNeighbours* neighbours, uint8_t* buffer, uint8_t K){
+    if ((K == 0) || (K > neighbours->K)){
+        return 0;
     }
 
     //count the id's of the points 
     uint8_t ID_count_array[NUMBER_OF_IDS] = {0};
-
-    // Serial.println("p2");
     for (uint8_t i = 0; i < K; i++)
     {
-        //increment the ID of the zero array of the found points
-        ID_count_array[arr[i].ID] = ID_count_array[arr[i].ID] + 1;
+        ID_count_array[neighbours->ID[i]]++;
     }
-    
-    // Serial.println("p3");
+
+    //pick the id with the most.
     uint8_t predictedID = 0;
     uint8_t valueCount = 0;
-    //pick the id with the most.
-    // Serial.println("p4");
     for (uint8_t i = 0; i < NUMBER_OF_IDS; i++)
     {
         if(ID_count_array[i] > valueCount ){
@@ -167,50 +331,29 @@ int16_t KNNClassification(KNNPoint * p0, TrainingPoint arr[], uint8_t K) {
             predictedID = i;
         }
     }
-    // Serial.println("p5");
-
-    // Serial.println("count array");
-    // for (int i = 0; i < NUMBER_OF_IDS ; i++)
-    // {
-    //     Serial.print(ID_count_array[i]); Serial.print(", ");
-    // }
-    // Serial.println("");
-
-    // Serial.print("predicted ID: ");
-    // Serial.println(predictedID);
-    return predictedID;
+    *buffer = predictedID;
+    return 1;
 }
 
-/**
- * @brief The function that can be called from main to classify a point
- * 
- * @param p0 Pointer to the KNNPoint to classify
- * @param arr Array of training data NOTE that this data will be shuffeled around. Can not contain more than 254 types of data.
- * @param K K neighbors to look at, must be smaller than number of training points
- * @return int16_t Returns 1 if correct and . If -1 and error occured.
- */
-int8_t predictLabelOfPoint(KNNPoint *p0, TrainingPoint arr[], uint8_t* buffer, uint8_t K){
-
-    //ensure that we have carthesian coordinates and not just polar
-    // Serial.println("polarToCartConversion:");
-    pol2Cart(p0); 
-
-    // Serial.println("calc distances:");
-    calcDistances(p0, arr);
-
-    //first sort the array (not as efficient but we are dealing here with a small dataset array.)
-    // Serial.println("Bubblesort");
-    bubbleSort(arr); 
 
-    //KNNClassification
-    int16_t result = KNNClassification(p0, arr, K);
-
-    //return result
-    if (result == -1){
+int8_t KNNPosterior(const KNNNeighbours* neighbours, uint8_t K, float posterior[NUMBER_OF_IDS]){
+    if ((K == 0) || (K > neighbours->K)){
         return 0;
-    }else{
-        *buffer = (uint8_t)result;
-        return 1;
     }
 
+    //one extra vote spread over all IDs
+    const float smoothing = 1.0f / (float)NUMBER_OF_IDS;
+    for (uint8_t i = 0; i < NUMBER_OF_IDS; i++)
+    {
+        posterior[i] = smoothing;
+    }
+    for (uint8_t i = 0; i < K; i++)
+    {
+        posterior[neighbours->ID[i]] += 1.0f;
+    }
+    for (uint8_t i = 0; i < NUMBER_OF_IDS; i++)
+    {
+        posterior[i] = posterior[i] / ((float)K + 1.0f);
+    }
+    return 1;
 }
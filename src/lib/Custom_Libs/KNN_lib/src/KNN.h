@@ -24,13 +24,101 @@ typedef struct TrainingPoints {
     float y_cart;    
 
     int8_t ID; 
-    float distanceToSamplePoint;
 } TrainingPoint;
 
-extern TrainingPoint trainingPoints[NUMBER_OF_TRAINING_POINTS];
+extern const TrainingPoint trainingPoints[NUMBER_OF_TRAINING_POINTS];
 
-int8_t predictLabelOfPoint(KNNPoint * p0, TrainingPoint arr[], uint8_t* buffer, uint8_t K);
+//largest training set and grid of a KNNIndex
+#define KNN_MAX_TRAINING_POINTS NUMBER_OF_TRAINING_POINTS
+#define KNN_MAX_GRID_DIM 16
+//largest number of neighbours of a search
+#define KNN_MAX_K 16
 
+/**
+ * @brief Spatial index over the training points, built once at startup.
+ * The bounding box of the training points is split in a grid of square cells, the points are copied
+ * in cell order so the points of a cell are next to each other (cell c holds cell_start[c] up to cell_start[c + 1]).
+ * A search visits the cells in rings around the cell of the point and stops when the ring is further
+ * away than the K-th nearest point found so far, so the cost does not grow with the whole training set.
+ */
+typedef struct KNNIndexes {
+    uint16_t num_of_points;
+    uint8_t grid_dim;
+    float x_min;
+    float y_min;
+    float cell_size;
+    float inverse_cell_size;
+    uint16_t cell_start[KNN_MAX_GRID_DIM * KNN_MAX_GRID_DIM + 1];
 
-#endif
+    //training points in cell order
+    float x_cart[KNN_MAX_TRAINING_POINTS];
+    float y_cart[KNN_MAX_TRAINING_POINTS];
+    int8_t ID[KNN_MAX_TRAINING_POINTS];
+    //index of the point in the training data
+    uint16_t point[KNN_MAX_TRAINING_POINTS];
+} KNNIndex;
+
+//result of a search, nearest neighbour first
+typedef struct KNNNeighbours {
+    uint8_t K;
+    float distance2[KNN_MAX_K];
+    int8_t ID[KNN_MAX_K];
+    //index of the neighbour in the training data
+    uint16_t point[KNN_MAX_K];
+} KNNNeighbours;
+
+/**
+ * @brief Converts the polar coordinates (hue in degrees, saturation) of a point to carthesian coordinates.
+ */
+void pol2Cart(KNNPoint* p);
+
+/**
+ * @brief Builds the index, the training data is copied and not changed.
+ * 
+ * @return 1 if valid, 0 if there are too many or no training points
+ */
+int8_t KNNIndexBuild(KNNIndex* index, const TrainingPoint arr[], uint16_t n);
+
+/**
+ * @brief Finds the K nearest training points of a point using squared distances.
+ * The polar coordinates of p0 are converted to the carthesian coordinates of the training data.
+ * 
+ * @return 1 if valid, 0 if K is invalid
+ */
+int8_t KNNSearch(KNNPoint* p0, const KNNIndex* index, uint8_t K, KNNNeighbours* neighbours);
+
+/**
+ * @brief Same as KNNSearch for a point that already has carthesian coordinates (x_cart and y_cart).
+ * 
+ * @return 1 if valid, 0 if K is invalid
+ */
+int8_t KNNSearchCartesian(const KNNPoint* p0, const KNNIndex* index, uint8_t K, KNNNeighbours* neighbours);
 
+/**
+ * @brief Same as KNNSearchCartesian with one training point left out, used to classify the training data itself.
+ * 
+ * @param exclude index of the training point that is left out
+ * @return 1 if valid, 0 if K is invalid
+ */
+int8_t KNNSearchExcluding(const KNNPoint* p0, const KNNIndex* index, uint8_t K, uint16_t exclude, KNNNeighbours* neighbours);
+
+/**
+ * @brief Majority vote of the K nearest neighbours of a search.
+ * 
+ * @param buffer the predicted ID
+ * @param K number of neighbours that vote, at most the K of the search
+ * @return 1 if valid, 0 if K is invalid
+ */
+int8_t predictLabelOfPoint(const KNNNeighbours* neighbours, uint8_t* buffer, uint8_t K);
+
+/**
+ * @brief Class posterior of the K nearest neighbours of a search.
+ * The votes of the K nearest training points are Laplace smoothed so no class gets a probability of 0.
+ * 
+ * @param posterior probability of every ID, sums to 1
+ * @return 1 if valid, 0 if K is invalid
+ */
+int8_t KNNPosterior(const KNNNeighbours* neighbours, uint8_t K, float posterior[NUMBER_OF_IDS]);
+
+
+#endif
@@ -0,0 +1,126 @@
+#include "KNN_classifier.h"
+
+#include <stddef.h>
+
+int8_t KNNClassifierInit(KNNClassifier* classifier, const KNNClassifierConfig* config){
+    if ((config->K == 0) || (config->K > KNN_MAX_K) || (config->bandwidth <= 0.0f) || (config->reject_distance <= 0.0f)
+        || (config->prior <= 0.0f) || (config->error_rate <= 0.0f) || (config->error_rate >= 1.0f) || (config->max_samples == 0)){
+        return 0;
+    }
+    classifier->config = *config;
+    classifier->inverse_bandwidth2 = 1.0f / (config->bandwidth * config->bandwidth);
+    //as much as K neighbours at the reject distance
+    classifier->reject_weight = (float)config->K / (1.0f + config->reject_distance * config->reject_distance * classifier->inverse_bandwidth2);
+    classifier->decisions = 0;
+    classifier->restarts = 0;
+    KNNClassifierReset(classifier);
+    return 1;
+}
+
+void KNNClassifierReset(KNNClassifier* classifier){
+    for (uint8_t i = 0; i < NUMBER_OF_IDS; i++)
+    {
+        classifier->belief[i] = 1.0f / (float)NUMBER_OF_IDS;
+    }
+    classifier->num_of_samples = 0;
+}
+
+int8_t KNNClassifierPosterior(const KNNClassifier* classifier, const KNNNeighbours* neighbours, float posterior[NUMBER_OF_IDS]){
+    const uint8_t K = classifier->config.K;
+    if (K > neighbours->K){
+        return 0;
+    }
+
+    const float smoothing = classifier->config.prior / (float)NUMBER_OF_IDS;
+    for (uint8_t i = 0; i < NUMBER_OF_IDS; i++)
+    {
+        posterior[i] = smoothing;
+    }
+    float total = classifier->config.prior + classifier->reject_weight;
+    posterior[KNN_REJECT_ID] += classifier->reject_weight;
+
+    //no square root needed, the weight only depends on the squared distance
+    for (uint8_t i = 0; i < K; i++)
+    {
+        float weight = 1.0f / (1.0f + neighbours->distance2[i] * classifier->inverse_bandwidth2);
+        posterior[neighbours->ID[i]] += weight;
+        total += weight;
+    }
+    for (uint8_t i = 0; i < NUMBER_OF_IDS; i++)
+    {
+        posterior[i] = posterior[i] / total;
+    }
+    return 1;
+}
+
+int8_t KNNClassifierUpdate(KNNClassifier* classifier, const float posterior[NUMBER_OF_IDS], uint8_t* ID, float belief[NUMBER_OF_IDS]){
+    //Bayes update of the beliefs, the posteriors are never 0 so the sum is never 0
+    float sum = 0.0f;
+    for (uint8_t i = 0; i < NUMBER_OF_IDS; i++)
+    {
+        classifier->belief[i] *= posterior[i];
+        sum += classifier->belief[i];
+    }
+    uint8_t best = 0;
+    for (uint8_t i = 0; i < NUMBER_OF_IDS; i++)
+    {
+        classifier->belief[i] = classifier->belief[i] / sum;
+        if (classifier->belief[i] > classifier->belief[best]){
+            best = i;
+        }
+    }
+    classifier->num_of_samples++;
+
+    if (classifier->belief[best] >= 1.0f - classifier->config.error_rate){
+        *ID = best;
+        if (belief != NULL){
+            for (uint8_t i = 0; i < NUMBER_OF_IDS; i++)
+            {
+                belief[i] = classifier->belief[i];
+            }
+        }
+        classifier->decisions++;
+        KNNClassifierReset(classifier);
+        return 1;
+    }
+
+    //truncated test: no decision within max_samples, start over
+    if (classifier->num_of_samples >= classifier->config.max_samples){
+        classifier->restarts++;
+        KNNClassifierReset(classifier);
+    }
+    return 0;
+}
+
+void KNNClassifierConfusionMatrix(const KNNClassifier* classifier, const KNNIndex* index, uint16_t confusion[NUMBER_OF_IDS][NUMBER_OF_IDS]){
+    for (uint8_t t = 0; t < NUMBER_OF_IDS; t++)
+    {
+        for (uint8_t p = 0; p < NUMBER_OF_IDS; p++)
+        {
+            confusion[t][p] = 0;
+        }
+    }
+
+    //a copy, so the statistics and the running test of the classifier are kept
+    KNNClassifier test = *classifier;
+    KNNNeighbours neighbours;
+    float posterior[NUMBER_OF_IDS];
+    for (uint16_t j = 0; j < index->num_of_points; j++)
+    {
+        //leave the point itself out
+        KNNPoint p = {.x_cart = index->x_cart[j], .y_cart = index->y_cart[j]};
+        if ((KNNSearchExcluding(&p, index, test.config.K, index->point[j], &neighbours) == 0)
+            || (KNNClassifierPosterior(&test, &neighbours, posterior) == 0)){
+            return;
+        }
+        KNNClassifierReset(&test);
+        for (uint8_t n = 0; n < test.config.max_samples; n++)
+        {
+            uint8_t accepted;
+            if (KNNClassifierUpdate(&test, posterior, &accepted, NULL) == 1){
+                confusion[index->ID[j]][accepted]++;
+                break;
+            }
+        }
+    }
+}
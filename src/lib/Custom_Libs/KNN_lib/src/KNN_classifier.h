@@ -0,0 +1,93 @@
+#ifndef KNN_CLASSIFIER_H_
+#define KNN_CLASSIFIER_H_
+
+/*
+    Probabilistic colour classifier on top of the KNN search.
+    - posterior: the K nearest training points vote with a weight that falls off with their distance,
+      w = 1 / (1 + d^2 / bandwidth^2). The reject class (ambient/unknown) always gets the weight of K training points
+      at reject_distance, so a sample further away from the training points than that ends up as ambient.
+      A small prior spread over all classes keeps every posterior above 0.
+    - decision: a sequential probability ratio test over consecutive samples. The beliefs of the classes start
+      uniform and are multiplied with the posterior of every sample. A class is accepted as soon as its belief
+      reaches 1 - error_rate, which is a likelihood ratio of (1 - error_rate) / error_rate against all other classes.
+      The test restarts after a decision, so a single confident sample is accepted at once,
+      and after max_samples samples without a decision, so old samples do not hold back a new colour.
+    - confusion matrix: every training point is classified leave-one-out with the posterior and the sequential test,
+      repeating its posterior as the consecutive samples of a sensor that stays on its colour.
+*/
+
+#include <stdint.h>
+
+#include "KNN.h"
+
+//samples far from the training data are classified as ambient
+#define KNN_REJECT_ID (NUMBER_OF_IDS - 1)
+
+typedef struct KNNClassifierConfigs {
+    //number of neighbours that vote, at most the K of the search
+    uint8_t K;
+    //distance at which a neighbour has half the weight of a neighbour at distance 0
+    float bandwidth;
+    //distance beyond which a sample is rejected as ambient, when all K neighbours are this far away
+    float reject_distance;
+    //total weight spread over all classes
+    float prior;
+    //probability of accepting the wrong class
+    float error_rate;
+    //samples without a decision before the test restarts
+    uint8_t max_samples;
+} KNNClassifierConfig;
+
+typedef struct KNNClassifiers {
+    KNNClassifierConfig config;
+    float inverse_bandwidth2;
+    float reject_weight;
+
+    //state of the sequential test
+    float belief[NUMBER_OF_IDS];
+    uint8_t num_of_samples;
+
+    //statistics
+    uint32_t decisions;
+    uint32_t restarts;
+} KNNClassifier;
+
+/**
+ * @brief Checks the configuration and starts the sequential test.
+ * 
+ * @return 1 if valid, 0 if the configuration is invalid
+ */
+int8_t KNNClassifierInit(KNNClassifier* classifier, const KNNClassifierConfig* config);
+
+/**
+ * @brief Restarts the sequential test with uniform beliefs.
+ */
+void KNNClassifierReset(KNNClassifier* classifier);
+
+/**
+ * @brief Class posterior of a sample from the distance weighted votes of its nearest neighbours.
+ * 
+ * @param posterior probability of every ID, sums to 1
+ * @return 1 if valid, 0 if the search found less than K neighbours
+ */
+int8_t KNNClassifierPosterior(const KNNClassifier* classifier, const KNNNeighbours* neighbours, float posterior[NUMBER_OF_IDS]);
+
+/**
+ * @brief Adds the posterior of a sample to the sequential test.
+ * 
+ * @param ID the accepted ID, only set on a decision
+ * @param belief the beliefs at the decision (may be NULL), only set on a decision
+ * @return 1 if a class is accepted, 0 if more samples are needed
+ */
+int8_t KNNClassifierUpdate(KNNClassifier* classifier, const float posterior[NUMBER_OF_IDS], uint8_t* ID, float belief[NUMBER_OF_IDS]);
+
+/**
+ * @brief Leave-one-out confusion matrix of the classifier on the training data.
+ * Every training point is classified with the other training points, the state of the classifier is not changed.
+ * A training point without a decision within max_samples is not counted, it never reaches the particle filter.
+ * 
+ * @param confusion number of training points per [true ID][accepted ID]
+ */
+void KNNClassifierConfusionMatrix(const KNNClassifier* classifier, const KNNIndex* index, uint16_t confusion[NUMBER_OF_IDS][NUMBER_OF_IDS]);
+
+#endif
@@ -13,11 +13,15 @@
 
 //particle filter libraries
 #include "Particle_filter.h"
+#include "Particle_resampling.h"
+#include "Particle_measurement_model.h"
+#include "Particle_projection_map.h"
 #include "gen_norm.h"
 
 //C libraries
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 //crazyflie libraries
 #include "debug.h"
@@ -25,21 +29,47 @@
 //free RTOS
 #include "FreeRTOS.h"
 #include "task.h"
+#include "queue.h"
+#include "static_mem.h"
+
+//CMSIS DSP vector functions for the batch updates of the particles
+#include "arm_math.h"
 
 //IMU sensors:
 #include "sensors.h"
+#include "imu_types.h"
 
 //Digital filtering
 #include "digital_filters.h"
 
-//How big the cells are at the projection side
-#define MAP_CELL_SIZE 0.75
-//Projection lens focal length
-#define LENS_FOCAL_LENGTH 9
-
-//probabilities for the particle filter particle redistribution.
-#define PARTICLE_CORRECT_COLOR_PROBABILITY 80
-#define PARTICLE_WRONG_COLOR_PROBABILITY 5
+#ifdef CONFIG_PARTICLE_FILTER_KALMAN_MEASUREMENT
+#include "estimator.h"
+#endif
+
+#if PROJECTION_MAP_AMBIENT != NUMBER_OF_COLORS
+#error "The ambient color of the projection map has to be the invalid color of the particle filter"
+#endif
+
+//probability the classifier returns the projected color, used until a confusion matrix is set.
+//the other colors share the rest (80:5 odds as before)
+#define PARTICLE_CORRECT_COLOR_PROBABILITY 0.7f
+//count added to every cell of the confusion matrix
+#define PARTICLE_CONFUSION_SMOOTHING 1.0f
+
+//resampling method
+#if defined(CONFIG_PARTICLE_FILTER_RESAMPLE_STRATIFIED)
+#define PARTICLE_FILTER_RESAMPLE_METHOD resample_stratified
+#elif defined(CONFIG_PARTICLE_FILTER_RESAMPLE_RESIDUAL)
+#define PARTICLE_FILTER_RESAMPLE_METHOD resample_residual
+#else
+#define PARTICLE_FILTER_RESAMPLE_METHOD resample_systematic
+#endif
+//only resample when the effective sample size drops below this percentage of the particles
+#ifdef CONFIG_PARTICLE_FILTER_RESAMPLE_ESS_PERCENT
+#define PARTICLE_FILTER_RESAMPLE_ESS_PERCENT CONFIG_PARTICLE_FILTER_RESAMPLE_ESS_PERCENT
+#else
+#define PARTICLE_FILTER_RESAMPLE_ESS_PERCENT 50
+#endif
 
 //the maximum map size in cm
 #define PARTICLE_FILTER_MAX_MAP_SIZE 127 //cm  8 x 0.75 cm  = 127.333 -> 127
@@ -54,12 +84,58 @@
 //If the drone moves to fast we reset the filter.
 #define MAX_VELOCITY_BEFORE_RESET_FILTER 0.4f
 
+//IMU and state estimate samples from the stabilizer loop, 1 per tick (2 ms)
+#define PARTICLE_FILTER_STATE_SAMPLE_RATE RATE_500_HZ
+//room for the samples of a few ticks in case the tick task is delayed
+#define PARTICLE_FILTER_STATE_QUEUE_LENGTH 16
+//longer gaps between samples are not integrated (eg after the queue was full)
+#define PARTICLE_FILTER_MAX_SAMPLE_DT 0.02f //s
+
+#ifdef CONFIG_PARTICLE_FILTER_FULL_STATE
+//IMU samples queued by the tick (every 2 ms) until the next update (every 25 ms)
+#define PARTICLE_FILTER_IMU_QUEUE_LENGTH 32
+//the particles are only moved once this much IMU time has been collected
+#define PARTICLE_FILTER_PREDICT_INTERVAL 0.1f //s
+//the acceleration is in Gs
+#define GRAVITY_CM_S2 981.0f
+//standard deviation of the acceleration noise of a particle, its velocity is a random walk
+#define PARTICLE_FULL_STATE_ACC_STD_DEV 10.0f //cm/s^2
+//standard deviation of the position noise of a particle after 1 s
+#define PARTICLE_FULL_STATE_POS_STD_DEV 1.5f //cm
+#endif
+
+#ifdef CONFIG_PARTICLE_FILTER_KALMAN_MEASUREMENT
+//position of the particle filter origin (bottom left corner of the map at the projector) in the world frame.
+//x is the distance to the projector, y the collums and z the rows of the map, rotated by the yaw around the world z axis.
+#define PARTICLE_FILTER_WORLD_ORIGIN_X (CONFIG_PARTICLE_FILTER_WORLD_ORIGIN_X_MM / 1000.0f) //m
+#define PARTICLE_FILTER_WORLD_ORIGIN_Y (CONFIG_PARTICLE_FILTER_WORLD_ORIGIN_Y_MM / 1000.0f) //m
+#define PARTICLE_FILTER_WORLD_ORIGIN_Z (CONFIG_PARTICLE_FILTER_WORLD_ORIGIN_Z_MM / 1000.0f) //m
+#define PARTICLE_FILTER_WORLD_YAW_DEG CONFIG_PARTICLE_FILTER_WORLD_YAW_DEG
+#if !defined(CONFIG_PARTICLE_FILTER_FULL_STATE) && (PARTICLE_FILTER_WORLD_YAW_DEG % 90 != 0)
+#error "The x axis of the particle filter is not measured, it has to be a world axis (yaw a multiple of 90 degrees)"
+#endif
+//the cloud can converge on a wrong cell first, the first fix is only sent once this many fixes in a row agree
+#define PARTICLE_FILTER_KALMAN_CONSISTENT_FIXES 3
+//two fixes agree when their means are closer than this
+#define PARTICLE_FILTER_KALMAN_CONSISTENT_DISTANCE 10.0f //cm
+//a wider particle cloud is not close enough to a gaussian (likely multiple clusters)
+#define PARTICLE_FILTER_KALMAN_MAX_VARIANCE 400.0f //cm^2
+//added to the variance of the cloud, the particles can collapse into a single cell
+#define PARTICLE_FILTER_KALMAN_MIN_VARIANCE 4.0f //cm^2
+#endif
+
 //colours IDs used for debugging print
 int16_t colorIDMapping[8] = {1,2,3,6,7,8,9,0};
 
 //At beginning of code we are not initialised
 bool particle_filter_inited = false;
 
+//effective sample size after the last color update, for logging
+float particle_filter_ess = 0.0f;
+
+//p(classified color | expected color)
+static ColorMeasurementModel color_measurement_model;
+
 //acceleration data from IMU
 float a_x = 0.0f;
 float a_y = 0.0f;
@@ -68,28 +144,57 @@ float a_z = 0.0f;
 //motion model particle
 MotionModelParticle motion_model_particle;
 
-//The array of particles
-Particle particles[PARTICLE_FILTER_NUM_OF_PARTICLES];
-
-//the map initialize the map (use python script for this)
-const uint8_t COLOR_MAP[MAP_SIZE][MAP_SIZE] ={
-{0, 1, 3, 1, 2, 1, 5, 1},
-{2, 5, 6, 5, 0, 3, 6, 2},
-{4, 3, 1, 4, 2, 1, 0, 3},
-{6, 2, 6, 3, 6, 3, 5, 2},
-{1, 3, 4, 2, 5, 2, 1, 6},
-{0, 6, 5, 1, 0, 4, 3, 2},
-{4, 3, 0, 6, 2, 5, 0, 4},
-{0, 5, 1, 5, 3, 1, 3, 2},
-};
+//The particles, too large for the regular RAM at 1000+ particles
+NO_DMA_CCM_SAFE_ZERO_INIT ParticleStore particles;
+
+//the projected color map (generated from maps/color_map.txt or uploaded, see Particle_projection_map.h)
+static const ProjectionMap* projection_map = &default_projection_map;
+
+//the samples of the stabilizer loop, read by the tick task
+static QueueHandle_t stateSampleQueue;
+STATIC_MEM_QUEUE_ALLOC(stateSampleQueue, PARTICLE_FILTER_STATE_QUEUE_LENGTH, sizeof(stateSample_t));
+static stateSample_t state_samples[PARTICLE_FILTER_STATE_QUEUE_LENGTH];
+//time step of every sample (s)
+static float state_sample_dt[PARTICLE_FILTER_STATE_QUEUE_LENGTH];
+
+#ifdef CONFIG_PARTICLE_FILTER_FULL_STATE
+//IMU sample of the tick for the predict step of the particles
+typedef struct ImuSamples
+{
+    //calibrated acceleration (G)
+    Axis3f acc;
+    //time since the previous sample (s)
+    float dt;
+    //false when no command is executed, the drone hovers
+    bool moving;
+} ImuSample;
+
+//The acceleration is the same for every particle, so the samples reduce to a
+//velocity change dv and a position change dp per axis over the time T:
+//every particle moves v*T + dp and its velocity changes by dv.
+typedef struct ImuBatches
+{
+    float T;
+    Axis3f dv;
+    Axis3f dp;
+    //the particles are stopped while the drone hovers
+    bool stopped;
+} ImuBatch;
+
+static QueueHandle_t imuSampleQueue;
+STATIC_MEM_QUEUE_ALLOC(imuSampleQueue, PARTICLE_FILTER_IMU_QUEUE_LENGTH, sizeof(ImuSample));
+static ImuBatch imu_batch;
+//IMU samples dropped because the queue was full
+uint32_t particle_filter_imu_overruns = 0;
+#endif
 
 
 //Debug print of all particles in the list with some information
-void DEBUG_PARTICLE(Particle* p, int i){
-    DEBUG_PRINT("P%d: Pc: %.2f, %.2f, %.2f, Pn: %.2f, %.2f, %.2f, P: %u, C: %u\n",
-    i, (double)p->x_curr, (double)p->y_curr, (double)p->z_curr, 
-    (double)p->x_new, (double)p->y_new, (double)p->z_new, 
-    p->prob, p->expected_color);
+void DEBUG_PARTICLE(uint32_t i){
+    DEBUG_PRINT("P%lu: Pc: %.2f, %.2f, %.2f, Pn: %.2f, %.2f, %.2f, W: %.5f, C: %u\n",
+    (unsigned long)i, (double)particles.x_curr[i], (double)particles.y_curr[i], (double)particles.z_curr[i], 
+    (double)particles.x_new[i], (double)particles.y_new[i], (double)particles.z_new[i], 
+    (double)particles.weight[i], particles.expected_color[i]);
 }
 
 //Debug print of motion model partice with some information
@@ -125,6 +230,40 @@ float EWMA(float n, float alpha, float n_1){
     return ((alpha*n) + ((1.0f - alpha) * n_1));
 }
 
+/**
+ * Reads the samples the stabilizer loop has published since the last call into state_samples
+ * and calculates their time steps from the time stamps.
+ * @param default_dt time step of the first sample (s)
+ * @return the number of samples
+ */
+uint32_t read_state_samples(MotionModelParticle* p, float default_dt){
+    uint32_t n = stateSubscriberRead(&p->state_subscription, state_samples, PARTICLE_FILTER_STATE_QUEUE_LENGTH);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        float dt = default_dt;
+        if (p->last_sample_timestamp != 0){
+            dt = (float)(state_samples[i].timestamp - p->last_sample_timestamp) / 1000000.0f;
+        }
+        if ((dt < 0.0f) || (dt > PARTICLE_FILTER_MAX_SAMPLE_DT)){
+            dt = default_dt;
+        }
+        state_sample_dt[i] = dt;
+        p->last_sample_timestamp = state_samples[i].timestamp;
+    }
+    if (n > 0){
+        p->roll = state_samples[n - 1].attitude.roll;
+        p->pitch = state_samples[n - 1].attitude.pitch;
+    }
+    return n;
+}
+
+//updates the acceleration offset with an exponential weighted moving average
+void update_acc_calibration(MotionModelParticle* p, const Axis3f* acc){
+    p->a_x_cali = EWMA(acc->x, p->alpha, p->a_x_cali);
+    p->a_y_cali = EWMA(acc->y, p->alpha, p->a_y_cali);
+    p->a_z_cali = EWMA(acc->z, p->alpha, p->a_z_cali);
+}
+
 /**
  * WARNING: this function is not nessesary and output is not used!
  * 
@@ -138,6 +277,9 @@ float EWMA(float n, float alpha, float n_1){
 void calibrate_motion_model_IMU_on_startup(){
     // const TickType_t xDelay = 100 / portTICK_PERIOD_MS;  
 
+    //the queue is emptied even when the samples are not used
+    uint32_t n = read_state_samples(&motion_model_particle, 0.0f);
+
     if ((logGetUint(motion_model_particle.syscanfly)) && (logGetUint(motion_model_particle.lighthouse_status) == 2)){
         // DEBUG_PRINT("can fly");
         const uint16_t do_nothing_delay = 1000; // couple seconds
@@ -146,17 +288,14 @@ void calibrate_motion_model_IMU_on_startup(){
             return;
         }
         if(!motion_model_particle.calibrated){
-            float x_n = logGetFloat(motion_model_particle.id_acc_x);
-            float y_n = logGetFloat(motion_model_particle.id_acc_y);
-            float z_n = logGetFloat(motion_model_particle.id_acc_z);
-
-            //calculate exponential weighted moving average
-            motion_model_particle.a_x_cali = EWMA(x_n, motion_model_particle.alpha, motion_model_particle.a_x_cali);
-            motion_model_particle.a_y_cali = EWMA(y_n, motion_model_particle.alpha, motion_model_particle.a_y_cali);
-            motion_model_particle.a_z_cali = EWMA(z_n, motion_model_particle.alpha, motion_model_particle.a_z_cali);
+            //calculate exponential weighted moving average over every sample
+            for (uint32_t i = 0; i < n; i++)
+            {
+                update_acc_calibration(&motion_model_particle, &state_samples[i].acc);
+            }
 
             //increment counter we would like to take a large amount of samples
-            motion_model_particle.EWMA_counter += 1;
+            motion_model_particle.EWMA_counter += n;
 
             //set calibration to true when we are done.
             if(motion_model_particle.EWMA_counter >= motion_model_particle.EWMA_number_of_calibration_measurements + do_nothing_delay){
@@ -176,41 +315,34 @@ bool particle_filter_is_calibrated(){
     return motion_model_particle.calibrated;
 }
 
-// Calculates the estimated Cell size based on distance estimate of the particle X following a linar expanding formula
-// https://www.notion.so/Week-20-21-5d91501fcd6844448b9e00b5bad383fa?pvs=4#d4aa3bc2a5624236b2a0bd661e46bb4a
-void calc_cell_size_at_particle_distance(Particle * p, float* cell_size){
-    //formula for the cell size over distance is linear
-    *cell_size = ((p->x_curr - (float)LENS_FOCAL_LENGTH)/ (float)LENS_FOCAL_LENGTH) * (float)MAP_CELL_SIZE;
-    // DEBUG_PRINT("Cell size: %f\n ", (double)*cell_size);
-}
-
 //place a particle in every cell of the map
 void set_inital_linspace_particle_distibution(){
     //the counter to itterate over all particles
     uint16_t counter = 0;
 
-    //calculate the cell size to use
-    //NOTE to use this with distance we need adust the cell size to the expected distance.
-    float cell_size = (float)PARTICLE_FILTER_MAX_MAP_SIZE / (float)MAP_SIZE;
-    // calc_cell_size_at_particle_distance(&particles[0], &cell_size);
+    //calculate the cell size to use at the starting distance
+    // https://www.notion.so/Week-20-21-5d91501fcd6844448b9e00b5bad383fa?pvs=4#d4aa3bc2a5624236b2a0bd661e46bb4a
+    const int map_size = projection_map->map_size;
+    float cell_size = projection_map_cell_size(projection_map, (float)PARTICLE_FILTER_STARTING_X);
 
     while(counter < PARTICLE_FILTER_NUM_OF_PARTICLES){
-        for (int row = 0; row < MAP_SIZE; row++)
+        for (int row = 0; row < map_size; row++)
         {
             if (counter >= PARTICLE_FILTER_NUM_OF_PARTICLES){
                 break;
             }
 
-            for(int coll = 0; coll < MAP_SIZE; coll++){
+            for(int coll = 0; coll < map_size; coll++){
                 if (counter < PARTICLE_FILTER_NUM_OF_PARTICLES){
 
-                    particles[counter].y_curr =((float)coll)*cell_size + 0.5f*cell_size;
-                    particles[counter].z_curr =((float)row)*cell_size + 0.5f*cell_size;
-                    particles[counter].x_curr = PARTICLE_FILTER_STARTING_X;
+                    //centre of the cell, the map starts at its origin
+                    particles.y_curr[counter] = projection_map->origin_y + ((float)coll)*cell_size + 0.5f*cell_size;
+                    particles.z_curr[counter] = projection_map->origin_z + ((float)row)*cell_size + 0.5f*cell_size;
+                    particles.x_curr[counter] = PARTICLE_FILTER_STARTING_X;
                     //set new pose to this as well
-                    particles[counter].x_new = particles[counter].x_curr;
-                    particles[counter].y_new = particles[counter].y_curr;
-                    particles[counter].z_new = particles[counter].z_curr;
+                    particles.x_new[counter] = particles.x_curr[counter];
+                    particles.y_new[counter] = particles.y_curr[counter];
+                    particles.z_new[counter] = particles.z_curr[counter];
                     //increment counter
                     counter ++;
                 }else{
@@ -229,146 +361,232 @@ void set_inital_linspace_particle_distibution(){
 //NOTE that this does not guarentee every cell contains a partilce. 
 //We do not want this as some cells might not be containing particles and 
 //the drone can never converge to this cell
-void set_initial_uniform_particle_distribution(Particle * p){
+void set_initial_uniform_particle_distribution(uint32_t i){
 //generate z and y location from uniform distribution
-    p->y_curr = (float)uniform_distribution(0,PARTICLE_FILTER_MAX_MAP_SIZE);
-    p->z_curr = (float)uniform_distribution(0,PARTICLE_FILTER_MAX_MAP_SIZE);
+    particles.y_curr[i] = (float)uniform_distribution(0,PARTICLE_FILTER_MAX_MAP_SIZE);
+    particles.z_curr[i] = (float)uniform_distribution(0,PARTICLE_FILTER_MAX_MAP_SIZE);
 
-    // DEBUG_PRINT("px, py, %f, %f \n", (double)p->x_curr, (double)p->y_curr);
-    
     //set the x to be a fixed distance for now
-    p->x_curr = PARTICLE_FILTER_STARTING_X;
+    particles.x_curr[i] = PARTICLE_FILTER_STARTING_X;
     //new location equals current locations.
-    p->x_new = p->x_curr;
-    p->y_new = p->y_curr;
-    p->z_new = p->z_curr;
+    particles.x_new[i] = particles.x_curr[i];
+    particles.y_new[i] = particles.y_curr[i];
+    particles.z_new[i] = particles.z_curr[i];
 }
 
-//set the particle probability to be all on the false color.
-void set_particle_initial_probability(Particle * p){
-    p->prob = PARTICLE_WRONG_COLOR_PROBABILITY;
+//all particles are equally likely.
+void set_particle_initial_probability(){
+    arm_fill_f32(1.0f / (float)PARTICLE_FILTER_NUM_OF_PARTICLES, particles.weight, PARTICLE_FILTER_NUM_OF_PARTICLES);
+    arm_fill_f32(-logf((float)PARTICLE_FILTER_NUM_OF_PARTICLES), particles.log_weight, PARTICLE_FILTER_NUM_OF_PARTICLES);
 }
 
 
-// Look up Table of the color projection map. 
-// Returns  - the expected color based on the particle X and Y cell location.
-//          - y = row, x = colum
-//          - Number of Colors if not valid ID is found. 
-uint8_t color_map_LUT(int16_t col, int16_t row){
-    //Boundary check if we are inside the map projection
-    if((col>=0) && (col< MAP_SIZE) && (row >= 0) && (row < MAP_SIZE)){
-        //If inside the boundary we would like to return the color
-        return COLOR_MAP[row][col];  
-    }
-    // return ambient ID (we are outside of the map.)
-    return NUMBER_OF_COLORS; 
-}
-
-//Returns the particle color based on its 
-// - Position in space
-// - The estimated Cell size at its estimated distance from the projection source.
-//NOTE: bottom left is [0,0] -> rows increase following z, collums following y
-void find_map_color_for_particle(Particle * p, float* cell_size){
-    //map drone P_z and P_y to the CELL. z,y positions by scaling with the cell size
-    int16_t map_collum = (int16_t)floorf(p->y_curr/ *cell_size);
-    int16_t map_row = (int16_t)(MAP_SIZE-1-(floorf(p->z_curr/ *cell_size)));
-    // DEBUG_PRINT("x,y: %d, %d",map_x, map_y );
-    //Lookup the expected color based on the known map
-    p->expected_color = color_map_LUT(map_collum, map_row);
-}
-
 //This function updates the expected to be recieving color for all particles based on their:
 // - X, Y, Z position in space.
-// We do this process of updating colors in 3 steps.
-    // 1. Caluclate the expected cell size based on z distance and linear projection expanding formula.
-    // 2. Map the drone x, y pose to the x,y positions of all cells.
-    // 3. Find the expected to be recieving color from the Look up table and update the particle state.
+// The projection map looks up the cell size of the distance slab of the particle
+// and the color of the cell it is in (see Particle_projection_map.h).
+//NOTE: bottom left is [0,0] -> rows increase following z, collums following y
 void determine_expected_color_for_all_particles(){
+    const ProjectionMap* m = projection_map;
     for (uint32_t i = 0; i < PARTICLE_FILTER_NUM_OF_PARTICLES; i++)
     {
-        float cell_size = 0;
-        calc_cell_size_at_particle_distance(&particles[i], &cell_size);
-        find_map_color_for_particle(&particles[i], &cell_size);
-        // DEBUG_PARTICLE(&particles[i]);
+        particles.expected_color[i] = projection_map_color(m, particles.x_curr[i], particles.y_curr[i], particles.z_curr[i]);
     }
 }
 
-//Update the particle probability based on the expected color and the recieved color by the color sensor
-//The probability of a particle recieving the correct color is set to a higher value.
-//The probability of a particle receiving the wrong color is set to a lower value.
+//Update the particle weight based on the expected color and the recieved color by the color sensor
+//The log-likelihood of the measurement (see Particle_measurement_model.h) is added to the log-weight of every particle,
+//the weights are normalised afterwards.
 //returns the number of particles with a wrong color
-int set_particle_probability(uint16_t last_recieved_color){
+int set_particle_probability(uint16_t last_recieved_color, const float color_posterior[]){
     uint16_t number_of_particles_with_wrong_color = 0;
     for (uint32_t i = 0; i < PARTICLE_FILTER_NUM_OF_PARTICLES; i++)
     {
-        if((uint16_t)particles[i].expected_color == last_recieved_color){
-            particles[i].prob = PARTICLE_CORRECT_COLOR_PROBABILITY;
-        }else{
-            particles[i].prob = PARTICLE_WRONG_COLOR_PROBABILITY;
+        if((uint16_t)particles.expected_color[i] != last_recieved_color){
             number_of_particles_with_wrong_color++;
         }
-        // DEBUG_PARTICLE(&particles[i]);
-    }  
+    }
+
+    //likelihood per expected color, more sensors can be added here
+    float log_likelihood[COLOR_MODEL_NUM_OF_CLASSES] = {0};
+    color_measurement_add_log_likelihood(&color_measurement_model, color_posterior, (uint8_t)last_recieved_color, log_likelihood);
+
+    add_log_likelihood_to_particles(particles.log_weight, particles.expected_color, PARTICLE_FILTER_NUM_OF_PARTICLES, log_likelihood);
+    normalise_log_weights(particles.log_weight, particles.weight, PARTICLE_FILTER_NUM_OF_PARTICLES);
     return number_of_particles_with_wrong_color;
 }
 
+void particle_filter_set_color_confusion_matrix(const uint16_t confusion[NUMBER_OF_COLORS + 1][NUMBER_OF_COLORS + 1]){
+    color_measurement_model_init_from_confusion(&color_measurement_model, confusion, PARTICLE_CONFUSION_SMOOTHING);
+}
+
 //Set a particle 2 new_location to the current_location of particle 1. (Don't move the particles yet.)
-void set_new_xyz_position(Particle * p1, Particle * p2){
+void set_new_xyz_position(uint32_t p1, uint32_t p2){
     //assign new location to the particle
-    p2->x_new = p1->x_curr;
-    p2->y_new = p1->y_curr;
-    p2->z_new = p1->z_curr;
+    particles.x_new[p2] = particles.x_curr[p1];
+    particles.y_new[p2] = particles.y_curr[p1];
+    particles.z_new[p2] = particles.z_curr[p1];
 }
 
-//itterate over all particles:
-//update a particles location to the new location (Resampling and actually moving the particle)
+//update all particles location to the new location (Resampling and actually moving the particle)
 void place_particles_on_new_location(){
-    Particle *p;
-    
-    // DEBUG_PRINT("Resampling done placing particles at new pose:\n");
-
-    for (uint32_t i = 0; i < PARTICLE_FILTER_NUM_OF_PARTICLES; i++){
-        //update the position
-        p = &particles[i];
-        p->x_curr = p->x_new;
-        p->y_curr = p->y_new;
-        p->z_curr = p->z_new;
-        // DEBUG_PARTICLE(p);
-    }
+    arm_copy_f32(particles.x_new, particles.x_curr, PARTICLE_FILTER_NUM_OF_PARTICLES);
+    arm_copy_f32(particles.y_new, particles.y_curr, PARTICLE_FILTER_NUM_OF_PARTICLES);
+    arm_copy_f32(particles.z_new, particles.z_curr, PARTICLE_FILTER_NUM_OF_PARTICLES);
 }
 
-/*this function syncs the current particle location with the shortend 16 style particle location*/
+/*this function syncs the current particle location with the shortend 16 style particle location of the logged particles*/
 void sync_int16_particle_locations(){
-    Particle *p;
-    for (uint32_t i = 0; i < PARTICLE_FILTER_NUM_OF_PARTICLES; i++){
-        //update the position
-        p = &particles[i];
+    for (uint32_t i = 0; i < PARTICLE_FILTER_NUM_OF_LOGGED_PARTICLES; i++){
+        particles.z_curr_16[i] = (int16_t)particles.z_curr[i];
+        particles.y_curr_16[i] = (int16_t)particles.y_curr[i];
+    }
+}
+
+#ifdef CONFIG_PARTICLE_FILTER_KALMAN_MEASUREMENT
+//number of fixes in a row that agreed with the previous one, and the previous fix (cm)
+static uint8_t consistent_fixes = 0;
+static float previous_fix[3];
+
+//rotation of the particle filter frame around the world z axis, exact for multiples of 90 degrees so an unmeasured axis stays unmeasured
+static void particle_filter_world_rotation(float* c, float* s){
+    switch (PARTICLE_FILTER_WORLD_YAW_DEG){
+    case 0:
+        *c = 1.0f; *s = 0.0f;
+        break;
+    case 90:
+        *c = 0.0f; *s = 1.0f;
+        break;
+    case 180:
+    case -180:
+        *c = -1.0f; *s = 0.0f;
+        break;
+    case -90:
+        *c = 0.0f; *s = -1.0f;
+        break;
+    default:
+        *c = cosf((float)PARTICLE_FILTER_WORLD_YAW_DEG * PI / 180.0f);
+        *s = sinf((float)PARTICLE_FILTER_WORLD_YAW_DEG * PI / 180.0f);
+        break;
+    }
+}
+
+//@return true once enough fixes in a row agree, a jump of the cloud restarts the count
+static bool is_particle_filter_fix_consistent(const MotionModelParticle* mp){
+    const float dx = mp->x_mean - previous_fix[0];
+    const float dy = mp->y_mean - previous_fix[1];
+    const float dz = mp->z_mean - previous_fix[2];
+    const bool agrees = (consistent_fixes > 0) && ((dx * dx + dy * dy + dz * dz) < (PARTICLE_FILTER_KALMAN_CONSISTENT_DISTANCE * PARTICLE_FILTER_KALMAN_CONSISTENT_DISTANCE));
+    if (!agrees){
+        consistent_fixes = 0;
+    }
+    if (consistent_fixes < PARTICLE_FILTER_KALMAN_CONSISTENT_FIXES){
+        consistent_fixes++;
+    }
+    previous_fix[0] = mp->x_mean;
+    previous_fix[1] = mp->y_mean;
+    previous_fix[2] = mp->z_mean;
+    return consistent_fixes >= PARTICLE_FILTER_KALMAN_CONSISTENT_FIXES;
+}
+
+//Sends the mean and covariance of the particles to the state estimator (see mm_particle_filter.c)
+//only call this after a colour update, a motion update adds no new evidence and would make the state estimator count the last colour again
+void enqueue_particle_filter_measurement(const MotionModelParticle* mp){
+    if ((mp->cov[1] > PARTICLE_FILTER_KALMAN_MAX_VARIANCE) || (mp->cov[2] > PARTICLE_FILTER_KALMAN_MAX_VARIANCE)){
+        //the cloud is lost, it has to converge again before it is trusted
+        consistent_fixes = 0;
+        return;
+    }
+    if (!is_particle_filter_fix_consistent(mp)){
+        return;
+    }
+
+    //cm^2 to m^2, in the particle filter frame
+    float cov[6];
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        cov[i] = mp->cov[i] / 10000.0f;
+    }
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        cov[i] += PARTICLE_FILTER_KALMAN_MIN_VARIANCE / 10000.0f;
+    }
+#ifndef CONFIG_PARTICLE_FILTER_FULL_STATE
+    //x is fixed at PARTICLE_FILTER_STARTING_X and not estimated
+    const bool x_measured = false;
+#else
+    const bool x_measured = (mp->cov[0] <= PARTICLE_FILTER_KALMAN_MAX_VARIANCE);
+#endif
+    if (!x_measured){
+        cov[0] = 0.0f;
+        cov[3] = 0.0f;
+        cov[4] = 0.0f;
+    }
 
-        p->z_curr_16 = (int16_t)p->z_curr;
-        p->y_curr_16 = (int16_t)p->y_curr;
+    //rotate into the world frame, cm to m
+    float c, s;
+    particle_filter_world_rotation(&c, &s);
+    const float x = mp->x_mean / 100.0f;
+    const float y = mp->y_mean / 100.0f;
+    particleFilterMeasurement_t m = {
+        .x = PARTICLE_FILTER_WORLD_ORIGIN_X + c * x - s * y,
+        .y = PARTICLE_FILTER_WORLD_ORIGIN_Y + s * x + c * y,
+        .z = PARTICLE_FILTER_WORLD_ORIGIN_Z + mp->z_mean / 100.0f,
+    };
+    //R * cov * R^T
+    m.cov[0] = c * c * cov[0] - 2.0f * c * s * cov[3] + s * s * cov[1];
+    m.cov[1] = s * s * cov[0] + 2.0f * c * s * cov[3] + c * c * cov[1];
+    m.cov[2] = cov[2];
+    m.cov[3] = c * s * (cov[0] - cov[1]) + (c * c - s * s) * cov[3];
+    m.cov[4] = c * cov[4] - s * cov[5];
+    m.cov[5] = s * cov[4] + c * cov[5];
+    //an unmeasured x axis that is not a world axis leaves both horizontal world axes unmeasured
+    if (!x_measured && (c != 0.0f) && (s != 0.0f)){
+        m.cov[0] = 0.0f;
+        m.cov[1] = 0.0f;
     }
+    estimatorEnqueueParticleFilter(&m);
 }
+#endif
 
 /**
- * @brief this function calculates the mean of all particles and saves it in the motion model particle
+ * @brief this function calculates the weighted mean and covariance of all particles and saves it in the motion model particle
+ * Both are calculated in a single pass, the moments are taken around the previous mean so the covariance keeps its precision.
 */
 void calculate_mean_particle_location(MotionModelParticle* mp){
-    mp->x_mean = 0.0f;
-    mp->y_mean = 0.0f;
-    mp->z_mean = 0.0f;
-    
-    Particle * p;
-    for (uint32_t i = 0; i < PARTICLE_FILTER_NUM_OF_PARTICLES; i++){
-        //update the position
-        p = &particles[i];
-        mp->x_mean += p->x_curr;
-        mp->y_mean += p->y_curr;
-        mp->z_mean += p->z_curr;
+    const float kx = mp->x_mean;
+    const float ky = mp->y_mean;
+    const float kz = mp->z_mean;
+    float sx = 0.0f, sy = 0.0f, sz = 0.0f;
+    float sxx = 0.0f, syy = 0.0f, szz = 0.0f, sxy = 0.0f, sxz = 0.0f, syz = 0.0f;
+    //the weights are normalised
+    for (uint32_t i = 0; i < PARTICLE_FILTER_NUM_OF_PARTICLES; i++)
+    {
+        const float w = particles.weight[i];
+        const float dx = particles.x_curr[i] - kx;
+        const float dy = particles.y_curr[i] - ky;
+        const float dz = particles.z_curr[i] - kz;
+        const float wdx = w * dx;
+        const float wdy = w * dy;
+        sx += wdx;
+        sy += wdy;
+        sz += w * dz;
+        sxx += wdx * dx;
+        syy += wdy * dy;
+        szz += w * dz * dz;
+        sxy += wdx * dy;
+        sxz += wdx * dz;
+        syz += wdy * dz;
     }
-    //calculate the average.
-    mp->x_mean = mp->x_mean/(float)PARTICLE_FILTER_NUM_OF_PARTICLES;
-    mp->y_mean = mp->y_mean/(float)PARTICLE_FILTER_NUM_OF_PARTICLES;
-    mp->z_mean = mp->z_mean/(float)PARTICLE_FILTER_NUM_OF_PARTICLES;
+    mp->x_mean = kx + sx;
+    mp->y_mean = ky + sy;
+    mp->z_mean = kz + sz;
+    mp->cov[0] = sxx - sx * sx;
+    mp->cov[1] = syy - sy * sy;
+    mp->cov[2] = szz - sz * sz;
+    mp->cov[3] = sxy - sx * sy;
+    mp->cov[4] = sxz - sx * sz;
+    mp->cov[5] = syz - sy * sz;
 
     //cast to simplified format for logging
     mp->x_mean_16 = (int16_t)mp->x_mean;
@@ -377,61 +595,49 @@ void calculate_mean_particle_location(MotionModelParticle* mp){
     // DEBUG_PRINT("mean x: %.3f, mean y: %.3f, mean z:  %.3f \n", (double)mp->x_mean, (double)mp->y_mean, (double)mp->z_mean );
 }
 
+#ifdef CONFIG_PARTICLE_FILTER_FULL_STATE
+//copies the velocity of the ancestor of every particle, the scratch array holds the new velocities
+static void resample_particle_velocity(__fp16 v[]){
+    for (uint32_t i = 0; i < PARTICLE_FILTER_NUM_OF_PARTICLES; i++)
+    {
+        particles.scratch[i] = (float)v[particles.ancestor[i]];
+    }
+    for (uint32_t i = 0; i < PARTICLE_FILTER_NUM_OF_PARTICLES; i++)
+    {
+        v[i] = (__fp16)particles.scratch[i];
+    }
+}
+#endif
+
 /**
- * Resample all particles acording to the new probability distribution
- * How does the resampling based on probability work:
- * 
- * We have i particle that require a new probability
- * addition we have a local probability counter.
- * Steps: 
- *      1. We keep itterating over the list of particles (j) looking at the probability property of the particles. (loop back to 0 when at end of list)
- *      2. From this p_counter we substract the probability property of every particle.
- *      3. When probability counter <= 0 then we assign the ith particle to the location of the jth particle saving the overflow for the next particle
- *      NOTE that the particles will resample to the higher probability more often over the lower probability.
- * 
- *  EDIT: particles in the correct colour don't resample
+ * Resample all particles acording to their normalised weights (see Particle_resampling.h)
+ * The runtime only depends on the number of particles.
+ * Afterwards all particles are equally likely again.
  * */
 void resample_particles(){
-    //probability counter
-    int16_t p_counter = uniform_distribution(50,200);
-    //this ways we use all the particles instead of only the first few
-    uint32_t j = uniform_distribution(0,(PARTICLE_FILTER_NUM_OF_PARTICLES-1));
-    // DEBUG_PRINT("starting J and P: %lu,  %d\n", j ,p_counter);
-
-    uint16_t overflow = 0;
-
+    resample_particle_indices(PARTICLE_FILTER_RESAMPLE_METHOD, particles.weight, PARTICLE_FILTER_NUM_OF_PARTICLES, particles.ancestor);
     for (uint32_t i = 0; i < PARTICLE_FILTER_NUM_OF_PARTICLES; i++)
     {
-        //only resample the particles thate have a wrong probability
-        if(particles[i].prob != PARTICLE_CORRECT_COLOR_PROBABILITY){
-            //substract overflow from previous particle.
-            p_counter = p_counter - overflow;
-            while (p_counter > 0){
-                p_counter = p_counter - particles[j].prob;
-                //only increment j if there is p left.
-                if (p_counter >= 0){
-                    // //pick a random J
-                    // j = uniform_distribution(0,(PARTICLE_FILTER_NUM_OF_PARTICLES-1));
-                    //TODO figure out if we want to do random or sequential.
-                    //go in sequential order J
-                    j++;
-                    //ensures we don't overflow
-                    j = j%PARTICLE_FILTER_NUM_OF_PARTICLES;
-                }
-            }
-            //reset parameters and save overflow
-            overflow = abs(p_counter);
-            p_counter = uniform_distribution(50,200);
-            //assign new location to the i th particle based on the current j counter.
-            set_new_xyz_position(&particles[j], &particles[i]);
-            // DEBUG_PRINT("j = %lu, p: %d\n", j, p_counter);
-            // DEBUG_PARTICLE(&particles[i], i);
-        }else{
-            //the color is correct we don't resample this particel
-            set_new_xyz_position(&particles[i], &particles[i]);
-        }
+        set_new_xyz_position(particles.ancestor[i], i);
     }
     place_particles_on_new_location();
+#ifdef CONFIG_PARTICLE_FILTER_FULL_STATE
+    resample_particle_velocity(particles.vx);
+    resample_particle_velocity(particles.vy);
+    resample_particle_velocity(particles.vz);
+#endif
+    set_particle_initial_probability();
+}
+
+//Resample only when the weights have degenerated, resampling otherwise throws away particle diversity.
+//returns true if the particles were resampled
+bool resample_particles_if_degenerated(){
+    particle_filter_ess = effective_sample_size(particles.weight, PARTICLE_FILTER_NUM_OF_PARTICLES);
+    if (resampling_needed(particle_filter_ess, PARTICLE_FILTER_NUM_OF_PARTICLES, (float)PARTICLE_FILTER_RESAMPLE_ESS_PERCENT)){
+        resample_particles();
+        return true;
+    }
+    return false;
 }
 
 
@@ -448,8 +654,8 @@ void resample_particles(){
  * - Having to save a lot more parameters per particle eg acceleration and velocity
  * - Reduces the computation required every acceleration time step to one particle and not N particles.
  * */
-void perform_motion_model_step(MotionModelParticle* p, float sampleTimeInS, ActiveFlightAxis current_active_acc_axis){
-    //update acceleration data based on last log parameter avaiable
+void perform_motion_model_step(MotionModelParticle* p, float sampleTimeInS, ActiveFlightAxis current_active_acc_axis, const Axis3f* acc){
+    //update acceleration data based on the IMU sample
 
     //set everything to 0 first
     p->a_x = 0;
@@ -457,14 +663,14 @@ void perform_motion_model_step(MotionModelParticle* p, float sampleTimeInS, Acti
     p->a_z = 0;
 
     //Only use the active fligth axis
-    if(current_active_acc_axis == axis_x){
-        p->a_x = (logGetFloat(p->id_acc_x) - p->a_x_cali);
+    if((current_active_acc_axis == axis_x) || (current_active_acc_axis == axis_all)){
+        p->a_x = (acc->x - p->a_x_cali);
     };
-    if(current_active_acc_axis == axis_y){
-        p->a_y = (logGetFloat(p->id_acc_y)- p->a_y_cali);
+    if((current_active_acc_axis == axis_y) || (current_active_acc_axis == axis_all)){
+        p->a_y = (acc->y - p->a_y_cali);
     }
-    if(current_active_acc_axis == axis_z){
-        p->a_z = (logGetFloat(p->id_acc_z)- p->a_z_cali);
+    if((current_active_acc_axis == axis_z) || (current_active_acc_axis == axis_all)){
+        p->a_z = (acc->z - p->a_z_cali);
     }
 
     //edit incase some acceleration filtering is required
@@ -602,21 +808,16 @@ void init_motion_model_particle(MotionModelParticle* p){
     motion_model_particle.y_delta = 0;
     motion_model_particle.z_delta = 0;
 
-    // ACC log ID
-    motion_model_particle.id_acc_x = logGetVarId("stateEstimate", "ax");
-    motion_model_particle.id_acc_y = logGetVarId("stateEstimate", "ay");
-    motion_model_particle.id_acc_z = logGetVarId("stateEstimate", "az");
+    //the acceleration and attitude are published by the stabilizer loop (see state_subscriber.h)
+    p->last_sample_timestamp = 0;
+    p->roll = 0;
+    p->pitch = 0;
 
     //Cheating with the velocity:
     motion_model_particle.id_vel_x = logGetVarId("stateEstimate", "vx");
     motion_model_particle.id_vel_y = logGetVarId("stateEstimate", "vy");
     motion_model_particle.id_vel_z = logGetVarId("stateEstimate", "vz");
 
-    //geting the pose estimation:
-    motion_model_particle.id_yaw_state_estimate = logGetVarId("stateEstimate", "yaw");
-    motion_model_particle.id_pitch_state_estimate = logGetVarId("stateEstimate", "pitch");
-    motion_model_particle.id_roll_state_estimate = logGetVarId("stateEstimate", "roll");
-
     //get the most recent send command
      //this is here because adding a new parameter crashed the drone.
     motion_model_particle.id_new_command_param = paramGetVarId("ring", "solidBlue");
@@ -652,30 +853,32 @@ void init_motion_model_particle(MotionModelParticle* p){
     motion_model_particle.alpha = 0.001f;
 }
 
-void apply_motion_model_update_to_all_particles(MotionModelParticle* mp){
-    // Call by reference variables for the noise;
-    float noise_z, noise_y;
+//fills an array with normally distributed noise
+void fill_normal_noise(float noise[], uint32_t n, float std_dev){
+    fill_normals(noise, n, 0.0f, std_dev);
+}
 
+void apply_motion_model_update_to_all_particles(MotionModelParticle* mp){
     // TODO optimize the standart deviation on the particle noise;
     // Make the standart deviation number of motion model step dependent to prevent abnormally large noise on small steps
     const float std_dev = 0.7f; 
-    norm2(0,std_dev, &noise_z, &noise_y);
-    // DEBUG_PRINT("NX: %.5f, Ny: %.5f", (double)noise_z, (double)noise_y);
-
-    for (uint16_t i = 0; i < PARTICLE_FILTER_NUM_OF_PARTICLES; i++){
-        //obtain a normally distributed noise
-        norm2(0,std_dev, &noise_z, &noise_y);
-        // Update the particles pose x,y,z
-            // NOTE that it can happen that the motion model is updated while we are updating the particles cause of task switch.
-            // At most this can cause an irregular step in Z and Y if task switch happens in between.
-            //*100 cause we are converting from meters to cm 
-        particles[i].z_curr += mp->z_delta*100 + noise_z;
-        particles[i].y_curr += mp->y_delta*100 + noise_y;
-        //TODO implement the motion model for the X axis
-        particles[i].x_curr = particles[i].x_curr; 
-        // DEBUG_PARTICLE(&particles[i]);
 
-    }
+    // The motion model can be updated while we are updating the particles cause of task switch,
+    // the step is read once so all particles move the same distance.
+    //*100 cause we are converting from meters to cm 
+    const float z_step = mp->z_delta*100;
+    const float y_step = mp->y_delta*100;
+
+    // Update the particles pose z,y: step + normally distributed noise
+    arm_offset_f32(particles.z_curr, z_step, particles.z_curr, PARTICLE_FILTER_NUM_OF_PARTICLES);
+    fill_normal_noise(particles.scratch, PARTICLE_FILTER_NUM_OF_PARTICLES, std_dev);
+    arm_add_f32(particles.z_curr, particles.scratch, particles.z_curr, PARTICLE_FILTER_NUM_OF_PARTICLES);
+
+    arm_offset_f32(particles.y_curr, y_step, particles.y_curr, PARTICLE_FILTER_NUM_OF_PARTICLES);
+    fill_normal_noise(particles.scratch, PARTICLE_FILTER_NUM_OF_PARTICLES, std_dev);
+    arm_add_f32(particles.y_curr, particles.scratch, particles.y_curr, PARTICLE_FILTER_NUM_OF_PARTICLES);
+    //TODO implement the motion model for the X axis
+
     vTaskSuspendAll();
         // Set the motion model particle data to zero.
             // We don't want this to be interrupted otherways some particle steps could be much further than they really are.
@@ -683,16 +886,110 @@ void apply_motion_model_update_to_all_particles(MotionModelParticle* mp){
     xTaskResumeAll();    
 }
 
+#ifdef CONFIG_PARTICLE_FILTER_FULL_STATE
+//Queues an IMU sample for the predict step of the particles, all axes are used.
+//acc is NULL when the drone is not moving
+void queue_imu_sample(MotionModelParticle* p, float sampleTimeInS, const Axis3f* acc){
+    ImuSample sample = {.dt = sampleTimeInS, .moving = (acc != NULL)};
+    if (acc != NULL){
+        sample.acc.x = acc->x - p->a_x_cali;
+        sample.acc.y = acc->y - p->a_y_cali;
+        sample.acc.z = acc->z - p->a_z_cali;
+    }
+    if (xQueueSend(imuSampleQueue, &sample, 0) != pdTRUE){
+        particle_filter_imu_overruns++;
+    }
+}
+
+//moves one axis of all particles, the velocity is only updated while the particles are moving
+static void predict_particle_axis(float pos[], __fp16 v[], const ImuBatch* b, float dp, float dv){
+    fill_normal_noise(particles.scratch, PARTICLE_FILTER_NUM_OF_PARTICLES, PARTICLE_FULL_STATE_POS_STD_DEV * sqrtf(b->T));
+    for (uint32_t i = 0; i < PARTICLE_FILTER_NUM_OF_PARTICLES; i++)
+    {
+        pos[i] += (float)v[i] * b->T + dp + particles.scratch[i];
+    }
+    if (b->stopped){
+        return;
+    }
+    fill_normal_noise(particles.scratch, PARTICLE_FILTER_NUM_OF_PARTICLES, PARTICLE_FULL_STATE_ACC_STD_DEV * b->T);
+    for (uint32_t i = 0; i < PARTICLE_FILTER_NUM_OF_PARTICLES; i++)
+    {
+        v[i] = (__fp16)((float)v[i] + dv + particles.scratch[i]);
+    }
+}
+
+//applies the collected IMU time to all particles and starts a new batch
+static void predict_particles(ImuBatch* b){
+    predict_particle_axis(particles.x_curr, particles.vx, b, b->dp.x, b->dv.x);
+    predict_particle_axis(particles.y_curr, particles.vy, b, b->dp.y, b->dv.y);
+    predict_particle_axis(particles.z_curr, particles.vz, b, b->dp.z, b->dv.z);
+    b->T = 0.0f;
+    b->dv = (Axis3f){0};
+    b->dp = (Axis3f){0};
+}
+
+/**
+ * Predict step of the full state particles, takes all queued IMU samples.
+ * The samples are collected in a batch and the particles are moved once per PARTICLE_FILTER_PREDICT_INTERVAL,
+ * so the cost per sample does not depend on the number of particles.
+ * While the drone hovers the particles are stopped and only the position noise is applied (as the motion model particle does).
+ * @param apply false to drop the samples (during the boot delay)
+ * @return true if the particles have moved
+ * */
+bool predict_full_state_particles(bool apply){
+    ImuBatch* b = &imu_batch;
+    bool moved = false;
+    ImuSample sample;
+    while (xQueueReceive(imuSampleQueue, &sample, 0) == pdTRUE){
+        if (!apply){
+            continue;
+        }
+        if (sample.moving == b->stopped){
+            //finish the batch before the particles start or stop
+            if (b->T > 0.0f){
+                predict_particles(b);
+                moved = true;
+            }
+            if (!sample.moving){
+                memset(particles.vx, 0, sizeof(particles.vx));
+                memset(particles.vy, 0, sizeof(particles.vy));
+                memset(particles.vz, 0, sizeof(particles.vz));
+            }
+            b->stopped = !sample.moving;
+        }
+        if (sample.moving){
+            for (uint8_t k = 0; k < 3; k++)
+            {
+                const float a = sample.acc.axis[k] * GRAVITY_CM_S2;
+                b->dp.axis[k] += b->dv.axis[k] * sample.dt + 0.5f * a * sample.dt * sample.dt;
+                b->dv.axis[k] += a * sample.dt;
+            }
+        }
+        b->T += sample.dt;
+    }
+    if (b->T >= PARTICLE_FILTER_PREDICT_INTERVAL){
+        predict_particles(b);
+        moved = true;
+    }
+    return moved;
+}
+#endif
+
 void reset_probability_and_particle_distribution(){
     //itterate over all particles and initialize the values
     DEBUG_PRINT("Resetting: particels and probability distribution \n");
     //set a linspace distribution
     set_inital_linspace_particle_distibution();
-    for (uint32_t i = 0; i < PARTICLE_FILTER_NUM_OF_PARTICLES; i++)
-        {
-            // set_initial_uniform_particle_distribution(&particles[i]);
-            set_particle_initial_probability(&particles[i]);
-        }
+#ifdef CONFIG_PARTICLE_FILTER_FULL_STATE
+    //the new particles are not moving
+    memset(particles.vx, 0, sizeof(particles.vx));
+    memset(particles.vy, 0, sizeof(particles.vy));
+    memset(particles.vz, 0, sizeof(particles.vz));
+#endif
+    // for (uint32_t i = 0; i < PARTICLE_FILTER_NUM_OF_PARTICLES; i++){
+    //     set_initial_uniform_particle_distribution(i);
+    // }
+    set_particle_initial_probability();
 }
 
 //Runs all the initialization functions of the particle filter.
@@ -704,10 +1001,27 @@ void particle_filter_init(){
     //set the motion model particle parameters to be zero initially
     init_motion_model_particle(&motion_model_particle);
     resetMotionModelParticleToZero(&motion_model_particle);
+
+    //default color measurement model
+    color_measurement_model_init(&color_measurement_model, PARTICLE_CORRECT_COLOR_PROBABILITY);
+
+    //allow a different projection map to be uploaded and load a persisted map
+    projection_map_init();
     
-    //init the true random number generator for the noise generation in the particle filter
+    //seed the noise generator of the particle filter from the true random number generator
     init_TRNG();
 
+#ifdef CONFIG_PARTICLE_FILTER_FULL_STATE
+    imuSampleQueue = STATIC_MEM_QUEUE_CREATE(imuSampleQueue);
+    imu_batch.stopped = true;
+#endif
+
+    //subscribe to the IMU and state estimate samples
+    stateSampleQueue = STATIC_MEM_QUEUE_CREATE(stateSampleQueue);
+    if (!stateSubscriberRegister(&motion_model_particle.state_subscription, stateSampleQueue, PARTICLE_FILTER_STATE_SAMPLE_RATE)){
+        DEBUG_PRINT("ERROR: the particle filter could not subscribe to the state samples\n");
+    }
+
     //itterate over all particles and initialize the values
     reset_probability_and_particle_distribution();
     
@@ -740,6 +1054,10 @@ bool have_we_recieved_new_flight_motion_command(MotionModelParticle* p){
         else if((p->last_recieved_command == c_forward)||(p->last_recieved_command == c_backward)){
             p->current_active_flight_axis = axis_x;
         }
+        else if(p->last_recieved_command == c_goto){
+            p->current_active_flight_axis = axis_all;
+            p->goto_duration_ms = vlc_motion_commander_move_duration_ms();
+        }
         else{
             p->current_active_flight_axis = axis_none;
         }
@@ -761,6 +1079,11 @@ bool do_we_allow_motion_model_updates(MotionModelParticle *p, uint32_t sys_time_
         int AVERAGE_MOTION_MODEL_MOTION_TIME_MS = 2500;
         int MAXIMUM_MOTION_MODEL_MOTION_TIME_MS = 3000;
 
+        //a goto takes as long as the motion commander planned it
+        if ((p->last_recieved_command == c_goto) && (p->goto_duration_ms + MOTION_MODEL_COOLDOWN_TIME_MS > (uint32_t)MAXIMUM_MOTION_MODEL_MOTION_TIME_MS)){
+            MAXIMUM_MOTION_MODEL_MOTION_TIME_MS = (int)(p->goto_duration_ms + MOTION_MODEL_COOLDOWN_TIME_MS);
+        }
+
         //A movement will never take longer than this
         if (p->time_since_last_command + MAXIMUM_MOTION_MODEL_MOTION_TIME_MS < sys_time_ms){
             DEBUG_PRINT("WARNING flight Command big timeout reached\n");
@@ -786,8 +1109,8 @@ bool do_we_allow_motion_model_updates(MotionModelParticle *p, uint32_t sys_time_
             }
         }
         
-        float roll = logGetFloat(motion_model_particle.id_roll_state_estimate);
-        float pitch = logGetFloat(motion_model_particle.id_pitch_state_estimate);
+        float roll = p->roll;
+        float pitch = p->pitch;
 
         switch(p->last_recieved_command){
             case c_left:
@@ -832,6 +1155,15 @@ bool do_we_allow_motion_model_updates(MotionModelParticle *p, uint32_t sys_time_
                     return false;
                 }
             break;
+            //a goto can tilt in any direction, it ends when its planned duration has passed
+            case c_goto:
+                if (p->time_since_last_command + p->goto_duration_ms < sys_time_ms){
+                    p->new_command_has_been_executed = stage_idle;
+                    p->current_active_flight_axis = axis_none;
+                    DEBUG_PRINT("C_goto_ended\n");
+                    return false;
+                }
+            break;
             //the states that we ignore
             case c_idle:
             case c_vlc_link_ENABLE:
@@ -867,6 +1199,9 @@ void particle_filter_tick(int tick_time_in_ms, uint32_t sys_time_ms){
         return;
     }
 
+    //the samples since the last tick, read even when the motion model is not active so they do not pile up
+    const uint32_t num_of_samples = read_state_samples(&motion_model_particle, ((float)tick_time_in_ms)/1000.0f);
+
     //check if we are allowed to do anything on the motion model side
     motion_model_particle.isMotionModelActive = paramGetUint(motion_model_particle.motion_model_status_param);
     //Only do stuff when we activate the motion model
@@ -878,7 +1213,13 @@ void particle_filter_tick(int tick_time_in_ms, uint32_t sys_time_ms){
         }
 
         if(do_we_allow_motion_model_updates(&motion_model_particle, sys_time_ms)){
-            perform_motion_model_step(&motion_model_particle, ((float)tick_time_in_ms)/1000.0f, motion_model_particle.current_active_flight_axis);
+            for (uint32_t i = 0; i < num_of_samples; i++)
+            {
+                perform_motion_model_step(&motion_model_particle, state_sample_dt[i], motion_model_particle.current_active_flight_axis, &state_samples[i].acc);
+#ifdef CONFIG_PARTICLE_FILTER_FULL_STATE
+                queue_imu_sample(&motion_model_particle, state_sample_dt[i], &state_samples[i].acc);
+#endif
+            }
         }
         else{
             motion_model_particle.v_x = 0;
@@ -894,18 +1235,17 @@ void particle_filter_tick(int tick_time_in_ms, uint32_t sys_time_ms){
             motion_model_particle.v_y_f_ = 0;
             motion_model_particle.v_z_f_ = 0;
 
-            //while we are not moving do a moving average calibration (especialy required for the X axis)
-            float x_n = logGetFloat(motion_model_particle.id_acc_x);
-            float y_n = logGetFloat(motion_model_particle.id_acc_y);
-            float z_n = logGetFloat(motion_model_particle.id_acc_z);
-            
-            //calculate exponential weighted moving average
-            motion_model_particle.a_x_cali = EWMA(x_n, motion_model_particle.alpha, motion_model_particle.a_x_cali);
-            motion_model_particle.a_y_cali = EWMA(y_n, motion_model_particle.alpha, motion_model_particle.a_y_cali);
-            motion_model_particle.a_z_cali = EWMA(z_n, motion_model_particle.alpha, motion_model_particle.a_z_cali);
-            //keep increasing steps else a movement may be pushed to the particles verry late
-            //and the random noise will not be apllied 
-            motion_model_particle.motion_model_step_counter++;
+            for (uint32_t i = 0; i < num_of_samples; i++)
+            {
+#ifdef CONFIG_PARTICLE_FILTER_FULL_STATE
+                queue_imu_sample(&motion_model_particle, state_sample_dt[i], NULL);
+#endif
+                //while we are not moving do a moving average calibration (especialy required for the X axis)
+                update_acc_calibration(&motion_model_particle, &state_samples[i].acc);
+                //keep increasing steps else a movement may be pushed to the particles verry late
+                //and the random noise will not be apllied 
+                motion_model_particle.motion_model_step_counter++;
+            }
 
         }
     }
@@ -920,19 +1260,10 @@ void particle_filter_tick(int tick_time_in_ms, uint32_t sys_time_ms){
 bool has_system_converged(MotionModelParticle* p){
     //calculates the variance of all particles
     //if this variance is less than say 10 we have converged
-    uint32_t sum_x = 0;
-    uint32_t sum_y = 0;
-    uint32_t sum_z = 0;
-
-
-    for(int i = 0; i < PARTICLE_FILTER_NUM_OF_PARTICLES; i++){
-        sum_x += (uint32_t)powf(particles[i].x_curr - p->x_mean, 2);
-        sum_y += (uint32_t)powf(particles[i].y_curr - p->y_mean, 2);
-        sum_z += (uint32_t)powf(particles[i].z_curr - p->z_mean, 2);
-    }
-    float varx = (float)sum_x/(float)PARTICLE_FILTER_NUM_OF_PARTICLES;
-    float vary = (float)sum_y/(float)PARTICLE_FILTER_NUM_OF_PARTICLES;
-    float varz = (float)sum_z/(float)PARTICLE_FILTER_NUM_OF_PARTICLES;
+    float varx, vary, varz;
+    arm_var_f32(particles.x_curr, PARTICLE_FILTER_NUM_OF_PARTICLES, &varx);
+    arm_var_f32(particles.y_curr, PARTICLE_FILTER_NUM_OF_PARTICLES, &vary);
+    arm_var_f32(particles.z_curr, PARTICLE_FILTER_NUM_OF_PARTICLES, &varz);
 
     DEBUG_PRINT("VAR: X:%.3f, Y:%.3f ,Z:%3.f \n", (double)varx,(double)vary,(double)varz);
     return false;
@@ -945,9 +1276,12 @@ bool has_system_converged(MotionModelParticle* p){
 2. Position update based on IMU data over time.
 ! WARNING: to prevent Race conditions steps 1 and 2 have to be performed sequentially in the same RTOS task 
 */
-void particle_filter_update(uint8_t recieved_color_ID, uint32_t sys_time_ms){
+void particle_filter_update(uint8_t recieved_color_ID, const float color_posterior[], uint32_t sys_time_ms){
     //Colors 0-("NUMBER_OF_COLORS"-1) are valid colors , "NUMBER_OF_COLORS" is invalid color
     static uint8_t last_recieved_color_ID = NUMBER_OF_COLORS;
+    //the posterior belonging to last_recieved_color_ID
+    static float last_color_posterior[COLOR_MODEL_NUM_OF_CLASSES];
+    static bool last_color_posterior_valid = false;
     static uint8_t all_particles_have_wrong_color_counter = 0;
     
     //Save for logging
@@ -969,6 +1303,14 @@ void particle_filter_update(uint8_t recieved_color_ID, uint32_t sys_time_ms){
         return;
     }
 
+    //pick up an uploaded map, the map is only swapped between updates
+    const ProjectionMap* uploaded_map = projection_map_take_pending();
+    if (uploaded_map != NULL){
+        projection_map = uploaded_map;
+        //the particles were spread over the cells of the old map
+        reset_probability_and_particle_distribution();
+    }
+
     //we only do something when we activate the motion model 
     if(motion_model_particle.isMotionModelActive){
 
@@ -993,12 +1335,12 @@ void particle_filter_update(uint8_t recieved_color_ID, uint32_t sys_time_ms){
         ){
             //perform the resample sequence
             determine_expected_color_for_all_particles();
-            uint16_t particles_with_wrong_color_count =  set_particle_probability(last_recieved_color_ID);
+            uint16_t particles_with_wrong_color_count =  set_particle_probability(last_recieved_color_ID, last_color_posterior_valid ? last_color_posterior : NULL);
 
             //if all particles have the wrong collor scatter the particles to a uniform distibution
             // if not then perform a normal resample procedure
             if (particles_with_wrong_color_count < PARTICLE_FILTER_NUM_OF_PARTICLES){
-                    resample_particles();
+                    resample_particles_if_degenerated();
                     all_particles_have_wrong_color_counter = 0;
             }else{
                 all_particles_have_wrong_color_counter ++;
@@ -1009,16 +1351,35 @@ void particle_filter_update(uint8_t recieved_color_ID, uint32_t sys_time_ms){
             
             //update mean location estimate:
             calculate_mean_particle_location(&motion_model_particle);
+#ifdef CONFIG_PARTICLE_FILTER_KALMAN_MEASUREMENT
+            //the colour reweighted the cloud, a scattered cloud carries no position
+            if (particles_with_wrong_color_count < PARTICLE_FILTER_NUM_OF_PARTICLES){
+                enqueue_particle_filter_measurement(&motion_model_particle);
+            }
+#endif
             //sync the locations such that the visualisation interface can be updated
             sync_int16_particle_locations();
 
             //update conditional parameters
             time_since_last_resample = sys_time_ms;
             last_recieved_color_ID = recieved_color_ID;
+            last_color_posterior_valid = (color_posterior != NULL);
+            if (last_color_posterior_valid){
+                arm_copy_f32((float*)color_posterior, last_color_posterior, COLOR_MODEL_NUM_OF_CLASSES);
+            }
 
             DEBUG_PRINT("performing particle resample to ID: %d \n", colorIDMapping[recieved_color_ID]);
         }
 
+#ifdef CONFIG_PARTICLE_FILTER_FULL_STATE
+        /**
+         * Every particle integrates the IMU samples with its own velocity.
+        */
+        if(predict_full_state_particles((boot_delay + 8000) < sys_time_ms)){
+            calculate_mean_particle_location(&motion_model_particle);
+            sync_int16_particle_locations();
+        }
+#else
         /**
          * After N Motion model steps we would like to update all particles.
         */
@@ -1035,6 +1396,7 @@ void particle_filter_update(uint8_t recieved_color_ID, uint32_t sys_time_ms){
             sync_int16_particle_locations();
 
         }
+#endif
     }
     
 }
@@ -1095,206 +1457,210 @@ LOG_GROUP_STOP(color_status)
 // PARAM_GROUP_STOP(command_to_drone)
 
 LOG_GROUP_START(ParticleFilter)
-LOG_ADD_CORE(LOG_INT16, z0_16, & particles[0].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y0_16, & particles[0].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z1_16, & particles[1].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y1_16, & particles[1].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z2_16, & particles[2].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y2_16, & particles[2].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z3_16, & particles[3].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y3_16, & particles[3].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z4_16, & particles[4].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y4_16, & particles[4].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z5_16, & particles[5].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y5_16, & particles[5].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z6_16, & particles[6].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y6_16, & particles[6].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z7_16, & particles[7].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y7_16, & particles[7].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z8_16, & particles[8].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y8_16, & particles[8].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z9_16, & particles[9].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y9_16, & particles[9].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z10_16, & particles[10].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y10_16, & particles[10].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z11_16, & particles[11].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y11_16, & particles[11].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z12_16, & particles[12].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y12_16, & particles[12].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z13_16, & particles[13].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y13_16, & particles[13].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z14_16, & particles[14].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y14_16, & particles[14].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z15_16, & particles[15].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y15_16, & particles[15].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z16_16, & particles[16].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y16_16, & particles[16].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z17_16, & particles[17].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y17_16, & particles[17].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z18_16, & particles[18].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y18_16, & particles[18].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z19_16, & particles[19].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y19_16, & particles[19].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z20_16, & particles[20].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y20_16, & particles[20].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z21_16, & particles[21].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y21_16, & particles[21].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z22_16, & particles[22].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y22_16, & particles[22].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z23_16, & particles[23].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y23_16, & particles[23].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z24_16, & particles[24].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y24_16, & particles[24].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z25_16, & particles[25].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y25_16, & particles[25].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z26_16, & particles[26].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y26_16, & particles[26].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z27_16, & particles[27].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y27_16, & particles[27].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z28_16, & particles[28].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y28_16, & particles[28].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z29_16, & particles[29].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y29_16, & particles[29].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z30_16, & particles[30].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y30_16, & particles[30].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z31_16, & particles[31].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y31_16, & particles[31].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z32_16, & particles[32].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y32_16, & particles[32].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z33_16, & particles[33].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y33_16, & particles[33].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z34_16, & particles[34].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y34_16, & particles[34].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z35_16, & particles[35].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y35_16, & particles[35].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z36_16, & particles[36].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y36_16, & particles[36].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z37_16, & particles[37].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y37_16, & particles[37].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z38_16, & particles[38].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y38_16, & particles[38].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z39_16, & particles[39].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y39_16, & particles[39].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z40_16, & particles[40].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y40_16, & particles[40].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z41_16, & particles[41].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y41_16, & particles[41].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z42_16, & particles[42].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y42_16, & particles[42].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z43_16, & particles[43].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y43_16, & particles[43].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z44_16, & particles[44].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y44_16, & particles[44].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z45_16, & particles[45].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y45_16, & particles[45].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z46_16, & particles[46].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y46_16, & particles[46].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z47_16, & particles[47].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y47_16, & particles[47].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z48_16, & particles[48].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y48_16, & particles[48].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z49_16, & particles[49].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y49_16, & particles[49].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z50_16, & particles[50].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y50_16, & particles[50].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z51_16, & particles[51].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y51_16, & particles[51].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z52_16, & particles[52].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y52_16, & particles[52].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z53_16, & particles[53].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y53_16, & particles[53].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z54_16, & particles[54].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y54_16, & particles[54].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z55_16, & particles[55].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y55_16, & particles[55].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z56_16, & particles[56].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y56_16, & particles[56].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z57_16, & particles[57].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y57_16, & particles[57].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z58_16, & particles[58].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y58_16, & particles[58].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z59_16, & particles[59].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y59_16, & particles[59].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z60_16, & particles[60].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y60_16, & particles[60].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z61_16, & particles[61].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y61_16, & particles[61].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z62_16, & particles[62].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y62_16, & particles[62].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z63_16, & particles[63].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y63_16, & particles[63].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z64_16, & particles[64].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y64_16, & particles[64].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z65_16, & particles[65].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y65_16, & particles[65].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z66_16, & particles[66].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y66_16, & particles[66].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z67_16, & particles[67].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y67_16, & particles[67].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z68_16, & particles[68].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y68_16, & particles[68].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z69_16, & particles[69].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y69_16, & particles[69].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z70_16, & particles[70].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y70_16, & particles[70].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z71_16, & particles[71].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y71_16, & particles[71].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z72_16, & particles[72].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y72_16, & particles[72].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z73_16, & particles[73].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y73_16, & particles[73].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z74_16, & particles[74].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y74_16, & particles[74].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z75_16, & particles[75].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y75_16, & particles[75].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z76_16, & particles[76].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y76_16, & particles[76].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z77_16, & particles[77].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y77_16, & particles[77].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z78_16, & particles[78].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y78_16, & particles[78].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z79_16, & particles[79].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y79_16, & particles[79].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z80_16, & particles[80].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y80_16, & particles[80].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z81_16, & particles[81].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y81_16, & particles[81].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z82_16, & particles[82].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y82_16, & particles[82].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z83_16, & particles[83].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y83_16, & particles[83].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z84_16, & particles[84].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y84_16, & particles[84].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z85_16, & particles[85].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y85_16, & particles[85].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z86_16, & particles[86].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y86_16, & particles[86].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z87_16, & particles[87].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y87_16, & particles[87].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z88_16, & particles[88].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y88_16, & particles[88].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z89_16, & particles[89].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y89_16, & particles[89].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z90_16, & particles[90].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y90_16, & particles[90].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z91_16, & particles[91].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y91_16, & particles[91].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z92_16, & particles[92].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y92_16, & particles[92].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z93_16, & particles[93].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y93_16, & particles[93].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z94_16, & particles[94].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y94_16, & particles[94].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z95_16, & particles[95].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y95_16, & particles[95].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z96_16, & particles[96].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y96_16, & particles[96].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z97_16, & particles[97].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y97_16, & particles[97].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z98_16, & particles[98].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y98_16, & particles[98].y_curr_16)
-LOG_ADD_CORE(LOG_INT16, z99_16, & particles[99].z_curr_16)
-LOG_ADD_CORE(LOG_INT16, y99_16, & particles[99].y_curr_16)
+LOG_ADD_CORE(LOG_FLOAT, ess, &particle_filter_ess)
+#ifdef CONFIG_PARTICLE_FILTER_FULL_STATE
+LOG_ADD_CORE(LOG_UINT32, imuOverruns, &particle_filter_imu_overruns)
+#endif
+LOG_ADD_CORE(LOG_INT16, z0_16, & particles.z_curr_16[0])
+LOG_ADD_CORE(LOG_INT16, y0_16, & particles.y_curr_16[0])
+LOG_ADD_CORE(LOG_INT16, z1_16, & particles.z_curr_16[1])
+LOG_ADD_CORE(LOG_INT16, y1_16, & particles.y_curr_16[1])
+LOG_ADD_CORE(LOG_INT16, z2_16, & particles.z_curr_16[2])
+LOG_ADD_CORE(LOG_INT16, y2_16, & particles.y_curr_16[2])
+LOG_ADD_CORE(LOG_INT16, z3_16, & particles.z_curr_16[3])
+LOG_ADD_CORE(LOG_INT16, y3_16, & particles.y_curr_16[3])
+LOG_ADD_CORE(LOG_INT16, z4_16, & particles.z_curr_16[4])
+LOG_ADD_CORE(LOG_INT16, y4_16, & particles.y_curr_16[4])
+LOG_ADD_CORE(LOG_INT16, z5_16, & particles.z_curr_16[5])
+LOG_ADD_CORE(LOG_INT16, y5_16, & particles.y_curr_16[5])
+LOG_ADD_CORE(LOG_INT16, z6_16, & particles.z_curr_16[6])
+LOG_ADD_CORE(LOG_INT16, y6_16, & particles.y_curr_16[6])
+LOG_ADD_CORE(LOG_INT16, z7_16, & particles.z_curr_16[7])
+LOG_ADD_CORE(LOG_INT16, y7_16, & particles.y_curr_16[7])
+LOG_ADD_CORE(LOG_INT16, z8_16, & particles.z_curr_16[8])
+LOG_ADD_CORE(LOG_INT16, y8_16, & particles.y_curr_16[8])
+LOG_ADD_CORE(LOG_INT16, z9_16, & particles.z_curr_16[9])
+LOG_ADD_CORE(LOG_INT16, y9_16, & particles.y_curr_16[9])
+LOG_ADD_CORE(LOG_INT16, z10_16, & particles.z_curr_16[10])
+LOG_ADD_CORE(LOG_INT16, y10_16, & particles.y_curr_16[10])
+LOG_ADD_CORE(LOG_INT16, z11_16, & particles.z_curr_16[11])
+LOG_ADD_CORE(LOG_INT16, y11_16, & particles.y_curr_16[11])
+LOG_ADD_CORE(LOG_INT16, z12_16, & particles.z_curr_16[12])
+LOG_ADD_CORE(LOG_INT16, y12_16, & particles.y_curr_16[12])
+LOG_ADD_CORE(LOG_INT16, z13_16, & particles.z_curr_16[13])
+LOG_ADD_CORE(LOG_INT16, y13_16, & particles.y_curr_16[13])
+LOG_ADD_CORE(LOG_INT16, z14_16, & particles.z_curr_16[14])
+LOG_ADD_CORE(LOG_INT16, y14_16, & particles.y_curr_16[14])
+LOG_ADD_CORE(LOG_INT16, z15_16, & particles.z_curr_16[15])
+LOG_ADD_CORE(LOG_INT16, y15_16, & particles.y_curr_16[15])
+LOG_ADD_CORE(LOG_INT16, z16_16, & particles.z_curr_16[16])
+LOG_ADD_CORE(LOG_INT16, y16_16, & particles.y_curr_16[16])
+LOG_ADD_CORE(LOG_INT16, z17_16, & particles.z_curr_16[17])
+LOG_ADD_CORE(LOG_INT16, y17_16, & particles.y_curr_16[17])
+LOG_ADD_CORE(LOG_INT16, z18_16, & particles.z_curr_16[18])
+LOG_ADD_CORE(LOG_INT16, y18_16, & particles.y_curr_16[18])
+LOG_ADD_CORE(LOG_INT16, z19_16, & particles.z_curr_16[19])
+LOG_ADD_CORE(LOG_INT16, y19_16, & particles.y_curr_16[19])
+LOG_ADD_CORE(LOG_INT16, z20_16, & particles.z_curr_16[20])
+LOG_ADD_CORE(LOG_INT16, y20_16, & particles.y_curr_16[20])
+LOG_ADD_CORE(LOG_INT16, z21_16, & particles.z_curr_16[21])
+LOG_ADD_CORE(LOG_INT16, y21_16, & particles.y_curr_16[21])
+LOG_ADD_CORE(LOG_INT16, z22_16, & particles.z_curr_16[22])
+LOG_ADD_CORE(LOG_INT16, y22_16, & particles.y_curr_16[22])
+LOG_ADD_CORE(LOG_INT16, z23_16, & particles.z_curr_16[23])
+LOG_ADD_CORE(LOG_INT16, y23_16, & particles.y_curr_16[23])
+LOG_ADD_CORE(LOG_INT16, z24_16, & particles.z_curr_16[24])
+LOG_ADD_CORE(LOG_INT16, y24_16, & particles.y_curr_16[24])
+LOG_ADD_CORE(LOG_INT16, z25_16, & particles.z_curr_16[25])
+LOG_ADD_CORE(LOG_INT16, y25_16, & particles.y_curr_16[25])
+LOG_ADD_CORE(LOG_INT16, z26_16, & particles.z_curr_16[26])
+LOG_ADD_CORE(LOG_INT16, y26_16, & particles.y_curr_16[26])
+LOG_ADD_CORE(LOG_INT16, z27_16, & particles.z_curr_16[27])
+LOG_ADD_CORE(LOG_INT16, y27_16, & particles.y_curr_16[27])
+LOG_ADD_CORE(LOG_INT16, z28_16, & particles.z_curr_16[28])
+LOG_ADD_CORE(LOG_INT16, y28_16, & particles.y_curr_16[28])
+LOG_ADD_CORE(LOG_INT16, z29_16, & particles.z_curr_16[29])
+LOG_ADD_CORE(LOG_INT16, y29_16, & particles.y_curr_16[29])
+LOG_ADD_CORE(LOG_INT16, z30_16, & particles.z_curr_16[30])
+LOG_ADD_CORE(LOG_INT16, y30_16, & particles.y_curr_16[30])
+LOG_ADD_CORE(LOG_INT16, z31_16, & particles.z_curr_16[31])
+LOG_ADD_CORE(LOG_INT16, y31_16, & particles.y_curr_16[31])
+LOG_ADD_CORE(LOG_INT16, z32_16, & particles.z_curr_16[32])
+LOG_ADD_CORE(LOG_INT16, y32_16, & particles.y_curr_16[32])
+LOG_ADD_CORE(LOG_INT16, z33_16, & particles.z_curr_16[33])
+LOG_ADD_CORE(LOG_INT16, y33_16, & particles.y_curr_16[33])
+LOG_ADD_CORE(LOG_INT16, z34_16, & particles.z_curr_16[34])
+LOG_ADD_CORE(LOG_INT16, y34_16, & particles.y_curr_16[34])
+LOG_ADD_CORE(LOG_INT16, z35_16, & particles.z_curr_16[35])
+LOG_ADD_CORE(LOG_INT16, y35_16, & particles.y_curr_16[35])
+LOG_ADD_CORE(LOG_INT16, z36_16, & particles.z_curr_16[36])
+LOG_ADD_CORE(LOG_INT16, y36_16, & particles.y_curr_16[36])
+LOG_ADD_CORE(LOG_INT16, z37_16, & particles.z_curr_16[37])
+LOG_ADD_CORE(LOG_INT16, y37_16, & particles.y_curr_16[37])
+LOG_ADD_CORE(LOG_INT16, z38_16, & particles.z_curr_16[38])
+LOG_ADD_CORE(LOG_INT16, y38_16, & particles.y_curr_16[38])
+LOG_ADD_CORE(LOG_INT16, z39_16, & particles.z_curr_16[39])
+LOG_ADD_CORE(LOG_INT16, y39_16, & particles.y_curr_16[39])
+LOG_ADD_CORE(LOG_INT16, z40_16, & particles.z_curr_16[40])
+LOG_ADD_CORE(LOG_INT16, y40_16, & particles.y_curr_16[40])
+LOG_ADD_CORE(LOG_INT16, z41_16, & particles.z_curr_16[41])
+LOG_ADD_CORE(LOG_INT16, y41_16, & particles.y_curr_16[41])
+LOG_ADD_CORE(LOG_INT16, z42_16, & particles.z_curr_16[42])
+LOG_ADD_CORE(LOG_INT16, y42_16, & particles.y_curr_16[42])
+LOG_ADD_CORE(LOG_INT16, z43_16, & particles.z_curr_16[43])
+LOG_ADD_CORE(LOG_INT16, y43_16, & particles.y_curr_16[43])
+LOG_ADD_CORE(LOG_INT16, z44_16, & particles.z_curr_16[44])
+LOG_ADD_CORE(LOG_INT16, y44_16, & particles.y_curr_16[44])
+LOG_ADD_CORE(LOG_INT16, z45_16, & particles.z_curr_16[45])
+LOG_ADD_CORE(LOG_INT16, y45_16, & particles.y_curr_16[45])
+LOG_ADD_CORE(LOG_INT16, z46_16, & particles.z_curr_16[46])
+LOG_ADD_CORE(LOG_INT16, y46_16, & particles.y_curr_16[46])
+LOG_ADD_CORE(LOG_INT16, z47_16, & particles.z_curr_16[47])
+LOG_ADD_CORE(LOG_INT16, y47_16, & particles.y_curr_16[47])
+LOG_ADD_CORE(LOG_INT16, z48_16, & particles.z_curr_16[48])
+LOG_ADD_CORE(LOG_INT16, y48_16, & particles.y_curr_16[48])
+LOG_ADD_CORE(LOG_INT16, z49_16, & particles.z_curr_16[49])
+LOG_ADD_CORE(LOG_INT16, y49_16, & particles.y_curr_16[49])
+LOG_ADD_CORE(LOG_INT16, z50_16, & particles.z_curr_16[50])
+LOG_ADD_CORE(LOG_INT16, y50_16, & particles.y_curr_16[50])
+LOG_ADD_CORE(LOG_INT16, z51_16, & particles.z_curr_16[51])
+LOG_ADD_CORE(LOG_INT16, y51_16, & particles.y_curr_16[51])
+LOG_ADD_CORE(LOG_INT16, z52_16, & particles.z_curr_16[52])
+LOG_ADD_CORE(LOG_INT16, y52_16, & particles.y_curr_16[52])
+LOG_ADD_CORE(LOG_INT16, z53_16, & particles.z_curr_16[53])
+LOG_ADD_CORE(LOG_INT16, y53_16, & particles.y_curr_16[53])
+LOG_ADD_CORE(LOG_INT16, z54_16, & particles.z_curr_16[54])
+LOG_ADD_CORE(LOG_INT16, y54_16, & particles.y_curr_16[54])
+LOG_ADD_CORE(LOG_INT16, z55_16, & particles.z_curr_16[55])
+LOG_ADD_CORE(LOG_INT16, y55_16, & particles.y_curr_16[55])
+LOG_ADD_CORE(LOG_INT16, z56_16, & particles.z_curr_16[56])
+LOG_ADD_CORE(LOG_INT16, y56_16, & particles.y_curr_16[56])
+LOG_ADD_CORE(LOG_INT16, z57_16, & particles.z_curr_16[57])
+LOG_ADD_CORE(LOG_INT16, y57_16, & particles.y_curr_16[57])
+LOG_ADD_CORE(LOG_INT16, z58_16, & particles.z_curr_16[58])
+LOG_ADD_CORE(LOG_INT16, y58_16, & particles.y_curr_16[58])
+LOG_ADD_CORE(LOG_INT16, z59_16, & particles.z_curr_16[59])
+LOG_ADD_CORE(LOG_INT16, y59_16, & particles.y_curr_16[59])
+LOG_ADD_CORE(LOG_INT16, z60_16, & particles.z_curr_16[60])
+LOG_ADD_CORE(LOG_INT16, y60_16, & particles.y_curr_16[60])
+LOG_ADD_CORE(LOG_INT16, z61_16, & particles.z_curr_16[61])
+LOG_ADD_CORE(LOG_INT16, y61_16, & particles.y_curr_16[61])
+LOG_ADD_CORE(LOG_INT16, z62_16, & particles.z_curr_16[62])
+LOG_ADD_CORE(LOG_INT16, y62_16, & particles.y_curr_16[62])
+LOG_ADD_CORE(LOG_INT16, z63_16, & particles.z_curr_16[63])
+LOG_ADD_CORE(LOG_INT16, y63_16, & particles.y_curr_16[63])
+LOG_ADD_CORE(LOG_INT16, z64_16, & particles.z_curr_16[64])
+LOG_ADD_CORE(LOG_INT16, y64_16, & particles.y_curr_16[64])
+LOG_ADD_CORE(LOG_INT16, z65_16, & particles.z_curr_16[65])
+LOG_ADD_CORE(LOG_INT16, y65_16, & particles.y_curr_16[65])
+LOG_ADD_CORE(LOG_INT16, z66_16, & particles.z_curr_16[66])
+LOG_ADD_CORE(LOG_INT16, y66_16, & particles.y_curr_16[66])
+LOG_ADD_CORE(LOG_INT16, z67_16, & particles.z_curr_16[67])
+LOG_ADD_CORE(LOG_INT16, y67_16, & particles.y_curr_16[67])
+LOG_ADD_CORE(LOG_INT16, z68_16, & particles.z_curr_16[68])
+LOG_ADD_CORE(LOG_INT16, y68_16, & particles.y_curr_16[68])
+LOG_ADD_CORE(LOG_INT16, z69_16, & particles.z_curr_16[69])
+LOG_ADD_CORE(LOG_INT16, y69_16, & particles.y_curr_16[69])
+LOG_ADD_CORE(LOG_INT16, z70_16, & particles.z_curr_16[70])
+LOG_ADD_CORE(LOG_INT16, y70_16, & particles.y_curr_16[70])
+LOG_ADD_CORE(LOG_INT16, z71_16, & particles.z_curr_16[71])
+LOG_ADD_CORE(LOG_INT16, y71_16, & particles.y_curr_16[71])
+LOG_ADD_CORE(LOG_INT16, z72_16, & particles.z_curr_16[72])
+LOG_ADD_CORE(LOG_INT16, y72_16, & particles.y_curr_16[72])
+LOG_ADD_CORE(LOG_INT16, z73_16, & particles.z_curr_16[73])
+LOG_ADD_CORE(LOG_INT16, y73_16, & particles.y_curr_16[73])
+LOG_ADD_CORE(LOG_INT16, z74_16, & particles.z_curr_16[74])
+LOG_ADD_CORE(LOG_INT16, y74_16, & particles.y_curr_16[74])
+LOG_ADD_CORE(LOG_INT16, z75_16, & particles.z_curr_16[75])
+LOG_ADD_CORE(LOG_INT16, y75_16, & particles.y_curr_16[75])
+LOG_ADD_CORE(LOG_INT16, z76_16, & particles.z_curr_16[76])
+LOG_ADD_CORE(LOG_INT16, y76_16, & particles.y_curr_16[76])
+LOG_ADD_CORE(LOG_INT16, z77_16, & particles.z_curr_16[77])
+LOG_ADD_CORE(LOG_INT16, y77_16, & particles.y_curr_16[77])
+LOG_ADD_CORE(LOG_INT16, z78_16, & particles.z_curr_16[78])
+LOG_ADD_CORE(LOG_INT16, y78_16, & particles.y_curr_16[78])
+LOG_ADD_CORE(LOG_INT16, z79_16, & particles.z_curr_16[79])
+LOG_ADD_CORE(LOG_INT16, y79_16, & particles.y_curr_16[79])
+LOG_ADD_CORE(LOG_INT16, z80_16, & particles.z_curr_16[80])
+LOG_ADD_CORE(LOG_INT16, y80_16, & particles.y_curr_16[80])
+LOG_ADD_CORE(LOG_INT16, z81_16, & particles.z_curr_16[81])
+LOG_ADD_CORE(LOG_INT16, y81_16, & particles.y_curr_16[81])
+LOG_ADD_CORE(LOG_INT16, z82_16, & particles.z_curr_16[82])
+LOG_ADD_CORE(LOG_INT16, y82_16, & particles.y_curr_16[82])
+LOG_ADD_CORE(LOG_INT16, z83_16, & particles.z_curr_16[83])
+LOG_ADD_CORE(LOG_INT16, y83_16, & particles.y_curr_16[83])
+LOG_ADD_CORE(LOG_INT16, z84_16, & particles.z_curr_16[84])
+LOG_ADD_CORE(LOG_INT16, y84_16, & particles.y_curr_16[84])
+LOG_ADD_CORE(LOG_INT16, z85_16, & particles.z_curr_16[85])
+LOG_ADD_CORE(LOG_INT16, y85_16, & particles.y_curr_16[85])
+LOG_ADD_CORE(LOG_INT16, z86_16, & particles.z_curr_16[86])
+LOG_ADD_CORE(LOG_INT16, y86_16, & particles.y_curr_16[86])
+LOG_ADD_CORE(LOG_INT16, z87_16, & particles.z_curr_16[87])
+LOG_ADD_CORE(LOG_INT16, y87_16, & particles.y_curr_16[87])
+LOG_ADD_CORE(LOG_INT16, z88_16, & particles.z_curr_16[88])
+LOG_ADD_CORE(LOG_INT16, y88_16, & particles.y_curr_16[88])
+LOG_ADD_CORE(LOG_INT16, z89_16, & particles.z_curr_16[89])
+LOG_ADD_CORE(LOG_INT16, y89_16, & particles.y_curr_16[89])
+LOG_ADD_CORE(LOG_INT16, z90_16, & particles.z_curr_16[90])
+LOG_ADD_CORE(LOG_INT16, y90_16, & particles.y_curr_16[90])
+LOG_ADD_CORE(LOG_INT16, z91_16, & particles.z_curr_16[91])
+LOG_ADD_CORE(LOG_INT16, y91_16, & particles.y_curr_16[91])
+LOG_ADD_CORE(LOG_INT16, z92_16, & particles.z_curr_16[92])
+LOG_ADD_CORE(LOG_INT16, y92_16, & particles.y_curr_16[92])
+LOG_ADD_CORE(LOG_INT16, z93_16, & particles.z_curr_16[93])
+LOG_ADD_CORE(LOG_INT16, y93_16, & particles.y_curr_16[93])
+LOG_ADD_CORE(LOG_INT16, z94_16, & particles.z_curr_16[94])
+LOG_ADD_CORE(LOG_INT16, y94_16, & particles.y_curr_16[94])
+LOG_ADD_CORE(LOG_INT16, z95_16, & particles.z_curr_16[95])
+LOG_ADD_CORE(LOG_INT16, y95_16, & particles.y_curr_16[95])
+LOG_ADD_CORE(LOG_INT16, z96_16, & particles.z_curr_16[96])
+LOG_ADD_CORE(LOG_INT16, y96_16, & particles.y_curr_16[96])
+LOG_ADD_CORE(LOG_INT16, z97_16, & particles.z_curr_16[97])
+LOG_ADD_CORE(LOG_INT16, y97_16, & particles.y_curr_16[97])
+LOG_ADD_CORE(LOG_INT16, z98_16, & particles.z_curr_16[98])
+LOG_ADD_CORE(LOG_INT16, y98_16, & particles.y_curr_16[98])
+LOG_ADD_CORE(LOG_INT16, z99_16, & particles.z_curr_16[99])
+LOG_ADD_CORE(LOG_INT16, y99_16, & particles.y_curr_16[99])
 LOG_GROUP_STOP(ParticleFilter)
 
 
@@ -3,19 +3,30 @@
 
 #include <stdint.h>
 
+#include "autoconf.h"
+
 //crazyflie libraries
 #include "log.h"
 #include "param.h"
 
 #include "crazyflie_vlc_motion_commander.h"
+#include "state_subscriber.h"
 
 #define UPDATE_TIME_INTERVAL_PARTICLE_POS 2 //ms
-#define PARTICLE_FILTER_NUM_OF_PARTICLES 150
+#ifdef CONFIG_PARTICLE_FILTER_NUM_OF_PARTICLES
+#define PARTICLE_FILTER_NUM_OF_PARTICLES CONFIG_PARTICLE_FILTER_NUM_OF_PARTICLES
+#else
+#define PARTICLE_FILTER_NUM_OF_PARTICLES 1000
+#endif
+//only the first particles are mirrored in int16 for the visualisation over the log
+#define PARTICLE_FILTER_NUM_OF_LOGGED_PARTICLES 100
+
+#if PARTICLE_FILTER_NUM_OF_PARTICLES < PARTICLE_FILTER_NUM_OF_LOGGED_PARTICLES
+#error "PARTICLE_FILTER_NUM_OF_PARTICLES has to be at least PARTICLE_FILTER_NUM_OF_LOGGED_PARTICLES"
+#endif
 
 #define NUMBER_OF_COLORS 7
 
-#define MAP_SIZE 8
-
 typedef enum {
     stage_idle,
     stage_executing,
@@ -26,29 +37,54 @@ typedef enum {
     axis_none,
     axis_x,
     axis_y,
-    axis_z
+    axis_z,
+    //a goto moves along all axes
+    axis_all
 } ActiveFlightAxis;
 
 
-//a particle is a single aporximation of the location of the crazyflie
-typedef struct Particles
+//The particles are single aproximations of the location of the crazyflie.
+//They are stored as a structure of arrays: particle i is index i of every array.
+//This way every pass over the particles reads contiguous memory and can use the CMSIS vector functions.
+typedef struct ParticleStores
 {
-    //the velocity 1 time step back
-    // float v_x_, v_y_, v_z_;
     //the current position before resampling
-    float x_curr, y_curr, z_curr;
+    float x_curr[PARTICLE_FILTER_NUM_OF_PARTICLES] __attribute__((aligned(8)));
+    float y_curr[PARTICLE_FILTER_NUM_OF_PARTICLES] __attribute__((aligned(8)));
+    float z_curr[PARTICLE_FILTER_NUM_OF_PARTICLES] __attribute__((aligned(8)));
     //new possiition after resampling
-    float x_new, y_new, z_new;
+    float x_new[PARTICLE_FILTER_NUM_OF_PARTICLES] __attribute__((aligned(8)));
+    float y_new[PARTICLE_FILTER_NUM_OF_PARTICLES] __attribute__((aligned(8)));
+    float z_new[PARTICLE_FILTER_NUM_OF_PARTICLES] __attribute__((aligned(8)));
+
+#ifdef CONFIG_PARTICLE_FILTER_FULL_STATE
+    //velocity of the particle (cm/s), half precision to save memory
+    __fp16 vx[PARTICLE_FILTER_NUM_OF_PARTICLES] __attribute__((aligned(8)));
+    __fp16 vy[PARTICLE_FILTER_NUM_OF_PARTICLES] __attribute__((aligned(8)));
+    __fp16 vz[PARTICLE_FILTER_NUM_OF_PARTICLES] __attribute__((aligned(8)));
+#endif
+
+    //intermediate results of the batch updates (cell sizes, noise)
+    float scratch[PARTICLE_FILTER_NUM_OF_PARTICLES] __attribute__((aligned(8)));
+
+    //normalised weight of the particle based on the colors measured at its location since the last resample
+    float weight[PARTICLE_FILTER_NUM_OF_PARTICLES] __attribute__((aligned(8)));
+    //the log of the weight, the measurement likelihoods are added to this
+    float log_weight[PARTICLE_FILTER_NUM_OF_PARTICLES] __attribute__((aligned(8)));
+    //the particle a particle is copied from when resampling
+    uint16_t ancestor[PARTICLE_FILTER_NUM_OF_PARTICLES];
+    //expected color based on its location
+    uint8_t expected_color[PARTICLE_FILTER_NUM_OF_PARTICLES];
 
     //position in int_16 to reduce sending overhead
-    int16_t z_curr_16;
-    int16_t y_curr_16;
+    int16_t z_curr_16[PARTICLE_FILTER_NUM_OF_LOGGED_PARTICLES];
+    int16_t y_curr_16[PARTICLE_FILTER_NUM_OF_LOGGED_PARTICLES];
+} ParticleStore;
 
-    //probability of the particle based on its location
-    uint16_t prob;
-    //expected color based on its location
-    uint8_t expected_color;
-} Particle;
+//The particle store shares the 64 KB CCM with the task stacks and queues (STATIC_MEM_*), the Kalman scratch matrices and the log blocks.
+//Check the CCM use in cf2.map (_eccmbss - _sccmbss) before raising this.
+#define PARTICLE_FILTER_CCM_BUDGET (40 * 1024)
+_Static_assert(sizeof(ParticleStore) <= PARTICLE_FILTER_CCM_BUDGET, "The particles do not fit in their CCM budget, lower CONFIG_PARTICLE_FILTER_NUM_OF_PARTICLES");
 
 /**
 // This particle type is intended to be a motion model particle,
@@ -123,21 +159,23 @@ typedef struct MotionModelParticles
     uint32_t time_since_last_command;
     //time to cooldown after roll or pitch has crossed the 0 boundary
     uint32_t time_start_cooldown;
+    //duration of the last goto as planned by the motion commander (ms)
+    uint32_t goto_duration_ms;
 
     
-    //log ID    
-    logVarId_t id_acc_x;
-    logVarId_t id_acc_y;
-    logVarId_t id_acc_z;
+    //IMU and state estimate samples of the stabilizer loop
+    stateSubscription_t state_subscription;
+    //time stamp of the last sample (us), 0 before the first sample
+    uint64_t last_sample_timestamp;
+    //attitude of the last sample (deg)
+    float roll;
+    float pitch;
 
+    //log ID    
     logVarId_t id_vel_x;
     logVarId_t id_vel_y;
     logVarId_t id_vel_z;
 
-    logVarId_t id_roll_state_estimate;
-    logVarId_t id_pitch_state_estimate;
-    logVarId_t id_yaw_state_estimate;
-
 
     logVarId_t syscanfly;
     logVarId_t lighthouse_status;
@@ -167,6 +205,9 @@ typedef struct MotionModelParticles
     float y_mean;
     float z_mean;
 
+    //weighted covariance of the particles (cm^2), xx, yy, zz, xy, xz, yz
+    float cov[6];
+
     //simplified average location
     int16_t x_mean_16;
     int16_t y_mean_16;
@@ -176,13 +217,10 @@ typedef struct MotionModelParticles
 
 
 
-//unititialized array of particles 
+//unititialized particles
 //we statically allocate this before hand.
-extern Particle particles[PARTICLE_FILTER_NUM_OF_PARTICLES];
+extern ParticleStore particles;
 
-//the map
-//TODO make python script for this later to export the map generated by the map algorithm
-extern const uint8_t COLOR_MAP[MAP_SIZE][MAP_SIZE];
  
 
 //we initialize the content of the particle filter
@@ -192,13 +230,19 @@ void particle_filter_init();
 /**
  * This section is dedicated to run every N miliseconds
  * Only run small sections of code here, leave the big code sections to the update function
+ * Every IMU sample since the last tick is integrated with its own time step,
+ * tick_time_in_ms is only used as the time step of the very first sample.
 */
 void particle_filter_tick(int tick_time_in_ms, uint32_t sys_time_ms);
 
 
 //this function needs to be run and will update the particle filter
 //we give it the delta time to estimate the traversed distance.
-void particle_filter_update(uint8_t last_recieved_color_ID, uint32_t sys_time_ms);
+//color_posterior is the class posterior of the classifier belonging to the color ID (NUMBER_OF_COLORS + 1 classes), NULL if there is none.
+void particle_filter_update(uint8_t last_recieved_color_ID, const float color_posterior[], uint32_t sys_time_ms);
+
+//replaces the default color measurement model by one based on the confusion matrix of the classifier, indexed [true ID][classified ID]
+void particle_filter_set_color_confusion_matrix(const uint16_t confusion[NUMBER_OF_COLORS + 1][NUMBER_OF_COLORS + 1]);
 
 void calibrate_motion_model_IMU_on_startup();
 
@@ -0,0 +1,84 @@
+/*
+    Measurement model of the particle filter, see Particle_measurement_model.h.
+*/
+
+#include "Particle_measurement_model.h"
+
+#include <math.h>
+#include <stddef.h>
+
+//CMSIS DSP vector functions
+#include "arm_math.h"
+
+//lower bound of a likelihood, keeps the log finite
+#define COLOR_MODEL_MIN_LIKELIHOOD 1e-6f
+
+void color_measurement_model_init(ColorMeasurementModel* m, float p_correct){
+    const float p_wrong = (1.0f - p_correct) / (float)(COLOR_MODEL_NUM_OF_CLASSES - 1);
+    for (uint8_t c = 0; c < COLOR_MODEL_NUM_OF_CLASSES; c++)
+    {
+        for (uint8_t o = 0; o < COLOR_MODEL_NUM_OF_CLASSES; o++)
+        {
+            m->p[c][o] = (c == o) ? p_correct : p_wrong;
+        }
+    }
+}
+
+void color_measurement_model_init_from_confusion(ColorMeasurementModel* m, const uint16_t confusion[COLOR_MODEL_NUM_OF_CLASSES][COLOR_MODEL_NUM_OF_CLASSES], float smoothing){
+    for (uint8_t c = 0; c < COLOR_MODEL_NUM_OF_CLASSES; c++)
+    {
+        float total = 0.0f;
+        for (uint8_t o = 0; o < COLOR_MODEL_NUM_OF_CLASSES; o++)
+        {
+            total += (float)confusion[c][o] + smoothing;
+        }
+        for (uint8_t o = 0; o < COLOR_MODEL_NUM_OF_CLASSES; o++)
+        {
+            m->p[c][o] = (total > 0.0f) ? (((float)confusion[c][o] + smoothing) / total) : (1.0f / (float)COLOR_MODEL_NUM_OF_CLASSES);
+        }
+    }
+}
+
+void color_measurement_add_log_likelihood(const ColorMeasurementModel* m, const float posterior[], uint8_t color, float log_likelihood[COLOR_MODEL_NUM_OF_CLASSES]){
+    for (uint8_t c = 0; c < COLOR_MODEL_NUM_OF_CLASSES; c++)
+    {
+        float likelihood;
+        if (posterior != NULL){
+            likelihood = 0.0f;
+            for (uint8_t o = 0; o < COLOR_MODEL_NUM_OF_CLASSES; o++)
+            {
+                likelihood += m->p[c][o] * posterior[o];
+            }
+        }else{
+            likelihood = (color < COLOR_MODEL_NUM_OF_CLASSES) ? m->p[c][color] : 1.0f;
+        }
+        if (likelihood < COLOR_MODEL_MIN_LIKELIHOOD){
+            likelihood = COLOR_MODEL_MIN_LIKELIHOOD;
+        }
+        log_likelihood[c] += logf(likelihood);
+    }
+}
+
+void add_log_likelihood_to_particles(float log_weight[], const uint8_t expected_color[], uint32_t n, const float log_likelihood[COLOR_MODEL_NUM_OF_CLASSES]){
+    for (uint32_t i = 0; i < n; i++)
+    {
+        uint8_t c = (expected_color[i] < COLOR_MODEL_NUM_OF_CLASSES) ? expected_color[i] : NUMBER_OF_COLORS;
+        log_weight[i] += log_likelihood[c];
+    }
+}
+
+void normalise_log_weights(float log_weight[], float weight[], uint32_t n){
+    float max;
+    uint32_t max_index;
+    arm_max_f32(log_weight, n, &max, &max_index);
+
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        weight[i] = expf(log_weight[i] - max);
+        sum += weight[i];
+    }
+    //the maximum particle has a weight of 1, so the sum is at least 1
+    arm_scale_f32(weight, 1.0f / sum, weight, n);
+    arm_offset_f32(log_weight, -(max + logf(sum)), log_weight, n);
+}
@@ -0,0 +1,58 @@
+#ifndef PARTICLE_MEASUREMENT_MODEL_H_
+#define PARTICLE_MEASUREMENT_MODEL_H_
+
+/*
+    Measurement model of the particle filter.
+    The colour classifier does not always return the colour that is projected on the drone,
+    p(classified colour | expected colour) is taken from the confusion matrix of the classifier on its training data.
+    A measurement is the class posterior of the classifier, its likelihood given the expected colour c is
+        p(z | c) = sum_o p(o | c) * posterior(o)
+    The likelihood only depends on the expected colour of a particle, so it is calculated once per colour
+    and added to the log-weights of the particles. Independent measurements (eg multiple sensors)
+    are multiplied by adding their log-likelihoods before the weights are normalised.
+*/
+
+#include <stdint.h>
+
+#include "Particle_filter.h"
+
+//the map colours and the ambient colour outside of the map
+#define COLOR_MODEL_NUM_OF_CLASSES (NUMBER_OF_COLORS + 1)
+
+typedef struct ColorMeasurementModels
+{
+    //p(classified colour | expected colour), indexed [expected][classified]
+    float p[COLOR_MODEL_NUM_OF_CLASSES][COLOR_MODEL_NUM_OF_CLASSES];
+} ColorMeasurementModel;
+
+/**
+ * Model without training data: the correct colour is classified with p_correct,
+ * the remaining probability is spread evenly over the other colours.
+ */
+void color_measurement_model_init(ColorMeasurementModel* m, float p_correct);
+
+/**
+ * @param confusion number of training points per [true colour][classified colour]
+ * @param smoothing count added to every cell, keeps unseen confusions possible
+ */
+void color_measurement_model_init_from_confusion(ColorMeasurementModel* m, const uint16_t confusion[COLOR_MODEL_NUM_OF_CLASSES][COLOR_MODEL_NUM_OF_CLASSES], float smoothing);
+
+/**
+ * Adds the log-likelihood of a measurement for every expected colour to log_likelihood.
+ * Start from an array of zeros and call once per measurement to combine measurements.
+ * @param posterior class posterior of the classifier, NULL for a hard decision on color
+ */
+void color_measurement_add_log_likelihood(const ColorMeasurementModel* m, const float posterior[], uint8_t color, float log_likelihood[COLOR_MODEL_NUM_OF_CLASSES]);
+
+/**
+ * Adds the log-likelihood of the expected colour of every particle to its log-weight.
+ */
+void add_log_likelihood_to_particles(float log_weight[], const uint8_t expected_color[], uint32_t n, const float log_likelihood[COLOR_MODEL_NUM_OF_CLASSES]);
+
+/**
+ * Normalises the log-weights so their exponents sum to 1 and stores the exponents in weight.
+ * The maximum is subtracted before exponentiating so the weights do not underflow.
+ */
+void normalise_log_weights(float log_weight[], float weight[], uint32_t n);
+
+#endif // PARTICLE_MEASUREMENT_MODEL_H_
@@ -0,0 +1,200 @@
+/*
+    Runtime upload of the projected colour map, see Particle_projection_map.h.
+
+    The uploaded map is built in the map slot the particle filter is not using,
+    and handed over through a single pointer. A new upload is refused until the
+    particle filter has picked up the previous one, so a slot is never written while it is read.
+    The pointer is published with release and taken with acquire semantics,
+    so the particle filter never sees it before the map it points to is complete.
+*/
+
+#include "Particle_projection_map.h"
+
+#include <string.h>
+#include <stdbool.h>
+
+//crazyflie libraries
+#include "mem.h"
+#include "storage.h"
+#include "static_mem.h"
+#include "debug.h"
+
+//storage key of the persisted map description
+#define PROJECTION_MAP_STORAGE_KEY "cdeck/map"
+//address of the command byte in the memory
+#define PROJECTION_MAP_CMD_ADDR (sizeof(ProjectionMapDescription))
+
+//the description written over the memory subsystem
+static ProjectionMapDescription description;
+static uint8_t command_result = PROJECTION_MAP_RESULT_IDLE;
+
+//the uploaded maps, one can be in use by the particle filter while the other is built
+NO_DMA_CCM_SAFE_ZERO_INIT static ProjectionMap maps[2];
+NO_DMA_CCM_SAFE_ZERO_INIT static float inverse_cell_size_tables[2][PROJECTION_MAP_MAX_SLABS];
+
+//the newest map, in use by the particle filter or pending
+static const ProjectionMap* newest_map = &default_projection_map;
+//set by the memory handler, cleared when the particle filter takes the map
+static const ProjectionMap* volatile pending_map = NULL;
+
+// release: the map is completely written before the particle filter can see the pointer
+static void publish_pending_map(const ProjectionMap* m){
+    __atomic_store_n(&pending_map, m, __ATOMIC_RELEASE);
+}
+
+static uint32_t handleMemGetSize(void) { return PROJECTION_MAP_CMD_ADDR + 1; }
+static bool handleMemRead(const uint32_t memAddr, const uint8_t readLen, uint8_t* buffer);
+static bool handleMemWrite(const uint32_t memAddr, const uint8_t writeLen, const uint8_t* buffer);
+static const MemoryHandlerDef_t memDef = {
+  .type = MEM_TYPE_COLOR_MAP,
+  .getSize = handleMemGetSize,
+  .read = handleMemRead,
+  .write = handleMemWrite,
+};
+
+//builds a map from a description, the slabs are the same as the ones of the default map
+static bool projection_map_build(ProjectionMap* m, float inverse_cell_size[], const ProjectionMapDescription* d){
+    const ProjectionMap* slabs = &default_projection_map;
+    if ((d->map_size == 0) || (d->map_size > PROJECTION_MAP_MAX_SIZE)){
+        return false;
+    }
+    if (!(d->cell_size > 0.0f) || !(d->focal_length > 0.0f) || (slabs->num_of_slabs > PROJECTION_MAP_MAX_SLABS)){
+        return false;
+    }
+    for (uint8_t row = 0; row < d->map_size; row++)
+    {
+        for (uint8_t col = 0; col < d->map_size; col++)
+        {
+            if (d->colors[row * PROJECTION_MAP_MAX_SIZE + col] >= PROJECTION_MAP_AMBIENT){
+                return false;
+            }
+        }
+    }
+
+    m->map_size = d->map_size;
+    m->cell_size = d->cell_size;
+    m->focal_length = d->focal_length;
+    m->origin_y = d->origin_y;
+    m->origin_z = d->origin_z;
+    m->x_min = slabs->x_min;
+    m->slab_shift = slabs->slab_shift;
+    m->num_of_slabs = slabs->num_of_slabs;
+
+    const float slab_width = (float)(1 << slabs->slab_shift);
+    for (uint16_t s = 0; s < slabs->num_of_slabs; s++)
+    {
+        float cell_size = projection_map_cell_size(m, (float)slabs->x_min + ((float)s + 0.5f) * slab_width);
+        //the slabs have to be behind the focal point
+        if (!(cell_size > 0.0f)){
+            return false;
+        }
+        inverse_cell_size[s] = 1.0f / cell_size;
+    }
+    m->inverse_cell_size = inverse_cell_size;
+
+    //bottom row first with a border of ambient cells
+    memset(m->raster, PROJECTION_MAP_AMBIENT, sizeof(m->raster));
+    for (uint8_t row = 0; row < d->map_size; row++)
+    {
+        for (uint8_t col = 0; col < d->map_size; col++)
+        {
+            uint8_t raster_row = d->map_size - row;
+            m->raster[(raster_row << PROJECTION_MAP_RASTER_BITS) | (col + 1)] = d->colors[row * PROJECTION_MAP_MAX_SIZE + col];
+        }
+    }
+    return true;
+}
+
+static uint8_t projection_map_apply(const ProjectionMapDescription* d, bool persist){
+    if (pending_map != NULL){
+        return PROJECTION_MAP_RESULT_BUSY;
+    }
+    //the slot the particle filter is not using
+    uint8_t slot = (newest_map == &maps[0]) ? 1 : 0;
+    if (!projection_map_build(&maps[slot], inverse_cell_size_tables[slot], d)){
+        return PROJECTION_MAP_RESULT_INVALID;
+    }
+    newest_map = &maps[slot];
+    publish_pending_map(newest_map);
+
+    //the map is already handed to the particle filter, only the persisting failed
+    if (persist && !storageStore(PROJECTION_MAP_STORAGE_KEY, d, sizeof(*d))){
+        return PROJECTION_MAP_RESULT_APPLIED_NOT_PERSISTED;
+    }
+    return PROJECTION_MAP_RESULT_OK;
+}
+
+static uint8_t projection_map_reset(){
+    if (pending_map != NULL){
+        return PROJECTION_MAP_RESULT_BUSY;
+    }
+    newest_map = &default_projection_map;
+    publish_pending_map(newest_map);
+    storageDelete(PROJECTION_MAP_STORAGE_KEY);
+    return PROJECTION_MAP_RESULT_OK;
+}
+
+static uint8_t projection_map_execute(uint8_t command){
+    switch (command){
+    case PROJECTION_MAP_CMD_APPLY:
+        return projection_map_apply(&description, false);
+    case PROJECTION_MAP_CMD_APPLY_AND_PERSIST:
+        return projection_map_apply(&description, true);
+    case PROJECTION_MAP_CMD_RESET:
+        return projection_map_reset();
+    default:
+        return PROJECTION_MAP_RESULT_INVALID;
+    }
+}
+
+void projection_map_init(){
+    memoryRegisterHandler(&memDef);
+
+    if (storageFetch(PROJECTION_MAP_STORAGE_KEY, &description, sizeof(description)) == sizeof(description)){
+        if (projection_map_apply(&description, false) == PROJECTION_MAP_RESULT_OK){
+            DEBUG_PRINT("Loaded the persisted projection map\n");
+        }else{
+            DEBUG_PRINT("WARNING: the persisted projection map is invalid, using the default map\n");
+        }
+    }
+}
+
+const ProjectionMap* projection_map_take_pending(){
+    //acquire: the map the pointer points to is complete
+    const ProjectionMap* m = __atomic_load_n(&pending_map, __ATOMIC_ACQUIRE);
+    if (m != NULL){
+        //release: the previous map is not read anymore once the slot can be reused
+        __atomic_store_n(&pending_map, NULL, __ATOMIC_RELEASE);
+    }
+    return m;
+}
+
+static bool handleMemRead(const uint32_t memAddr, const uint8_t readLen, uint8_t* buffer) {
+    if (memAddr + readLen > PROJECTION_MAP_CMD_ADDR + 1){
+        return false;
+    }
+    for (uint8_t i = 0; i < readLen; i++)
+    {
+        uint32_t addr = memAddr + i;
+        buffer[i] = (addr < PROJECTION_MAP_CMD_ADDR) ? ((uint8_t*)&description)[addr] : command_result;
+    }
+    return true;
+}
+
+static bool handleMemWrite(const uint32_t memAddr, const uint8_t writeLen, const uint8_t* buffer) {
+    if (memAddr + writeLen > PROJECTION_MAP_CMD_ADDR + 1){
+        return false;
+    }
+    for (uint8_t i = 0; i < writeLen; i++)
+    {
+        uint32_t addr = memAddr + i;
+        if (addr < PROJECTION_MAP_CMD_ADDR){
+            ((uint8_t*)&description)[addr] = buffer[i];
+            command_result = PROJECTION_MAP_RESULT_IDLE;
+        }else{
+            //the command byte is the last byte, the description is complete
+            command_result = projection_map_execute(buffer[i]);
+        }
+    }
+    return true;
+}
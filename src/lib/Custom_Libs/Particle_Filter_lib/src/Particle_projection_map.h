@@ -0,0 +1,122 @@
+#ifndef PARTICLE_PROJECTION_MAP_H_
+#define PARTICLE_PROJECTION_MAP_H_
+
+/*
+    Colour map projected on the drone, as seen by the particles.
+    The projected cells grow linearly with the distance x to the projector, the x axis is split in slabs
+    of 2^slab_shift cm that store the inverse cell size at their centre.
+    The map itself is stored bottom row first in a raster of 16 x 16 with a border of ambient cells,
+    so the cell of a particle is found with a multiplication and a saturation instead of a division,
+    two floors and a bounds check. Particles outside of the map end in the border.
+
+    default_projection_map is generated at build time from maps/color_map.txt by tools/make/projection_map.py
+
+    A different map can be uploaded at runtime through the memory subsystem (MEM_TYPE_COLOR_MAP):
+    - address 0: a ProjectionMapDescription
+    - address sizeof(ProjectionMapDescription): command byte, writing PROJECTION_MAP_CMD_APPLY or
+      PROJECTION_MAP_CMD_APPLY_AND_PERSIST builds the map from the description, reading it returns the result.
+    The map is built next to the active map and picked up by the particle filter before its next update.
+    A persisted map is stored with storage.c and loaded on boot, PROJECTION_MAP_CMD_RESET returns to the default map.
+*/
+
+#include <stdint.h>
+
+#include "arm_math.h"
+
+//ambient color ID, outside of the map
+#define PROJECTION_MAP_AMBIENT 7
+
+#define PROJECTION_MAP_RASTER_BITS 4
+#define PROJECTION_MAP_RASTER_DIM (1 << PROJECTION_MAP_RASTER_BITS)
+//largest map that fits the raster with its border
+#define PROJECTION_MAP_MAX_SIZE (PROJECTION_MAP_RASTER_DIM - 2)
+//maximum number of slabs of a map (the uploaded maps use the slabs of the default map)
+#define PROJECTION_MAP_MAX_SLABS 512
+
+//memory commands
+#define PROJECTION_MAP_CMD_APPLY 1
+#define PROJECTION_MAP_CMD_APPLY_AND_PERSIST 2
+#define PROJECTION_MAP_CMD_RESET 3
+//memory command results
+#define PROJECTION_MAP_RESULT_IDLE 0
+#define PROJECTION_MAP_RESULT_OK 1
+#define PROJECTION_MAP_RESULT_INVALID 2
+#define PROJECTION_MAP_RESULT_BUSY 3
+//the map is in use but could not be stored, it is lost on the next boot
+#define PROJECTION_MAP_RESULT_APPLIED_NOT_PERSISTED 4
+
+typedef struct ProjectionMaps
+{
+    //number of cells in a row and column of the map
+    uint8_t map_size;
+    //cell size at the lens (cm)
+    float cell_size;
+    //focal length of the projection lens (cm)
+    float focal_length;
+    //position of the bottom left corner of the map (cm)
+    float origin_y;
+    float origin_z;
+    //distance of the first slab (cm)
+    int16_t x_min;
+    //slab width is 2^slab_shift cm
+    uint8_t slab_shift;
+    uint16_t num_of_slabs;
+    //1 / cell size at the centre of every slab (1/cm)
+    const float* inverse_cell_size;
+    //colour IDs [row][collum], row 0 is the border below the bottom row of the map
+    uint8_t raster[PROJECTION_MAP_RASTER_DIM * PROJECTION_MAP_RASTER_DIM];
+} ProjectionMap;
+
+//map as uploaded over the memory subsystem, little endian
+typedef struct __attribute__((packed)) ProjectionMapDescriptions
+{
+    uint8_t map_size;
+    uint8_t reserved[3];
+    float cell_size;
+    float focal_length;
+    float origin_y;
+    float origin_z;
+    //colour IDs, top row first, row i starts at i * PROJECTION_MAP_MAX_SIZE
+    uint8_t colors[PROJECTION_MAP_MAX_SIZE * PROJECTION_MAP_MAX_SIZE];
+} ProjectionMapDescription;
+
+extern const ProjectionMap default_projection_map;
+
+/**
+ * Registers the memory handler and loads a persisted map.
+ */
+void projection_map_init();
+
+/**
+ * @return the map uploaded since the last call, NULL if there is none. 
+ * The map returned by the previous call is not used anymore after this call.
+ */
+const ProjectionMap* projection_map_take_pending();
+
+/**
+ * @return the projected cell size at distance x (cm)
+ */
+static inline float projection_map_cell_size(const ProjectionMap* m, float x){
+    return ((x - m->focal_length) / m->focal_length) * m->cell_size;
+}
+
+/**
+ * @return the colour ID at position x (distance), y (collum) and z (row) in cm, PROJECTION_MAP_AMBIENT outside of the map
+ */
+static inline uint8_t projection_map_color(const ProjectionMap* m, float x, float y, float z){
+    int32_t slab = ((int32_t)x - m->x_min) >> m->slab_shift;
+    if (slab < 0){
+        slab = 0;
+    }
+    if (slab >= m->num_of_slabs){
+        slab = m->num_of_slabs - 1;
+    }
+    const float inverse_cell_size = m->inverse_cell_size[slab];
+
+    //+1 for the border, truncating the positive values is a floor and the negative values saturate to the border
+    int32_t col = __USAT((int32_t)((y - m->origin_y) * inverse_cell_size + 1.0f), PROJECTION_MAP_RASTER_BITS);
+    int32_t row = __USAT((int32_t)((z - m->origin_z) * inverse_cell_size + 1.0f), PROJECTION_MAP_RASTER_BITS);
+    return m->raster[(row << PROJECTION_MAP_RASTER_BITS) | col];
+}
+
+#endif // PARTICLE_PROJECTION_MAP_H_
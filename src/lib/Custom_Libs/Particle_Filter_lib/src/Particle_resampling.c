@@ -0,0 +1,95 @@
+/*
+    Resampling of the particle filter, see Particle_resampling.h.
+    The weights are walked in units of sample points: particle i covers n*w_i sample points
+    (the residual part of it for the residual method), sample point j lies in [j, j+1).
+*/
+
+#include "Particle_resampling.h"
+
+#include <math.h>
+
+//CMSIS DSP vector functions
+#include "arm_math.h"
+
+//uniform random numbers from the true random number generator
+#include "gen_norm.h"
+
+float normalise_particle_weights(float w[], uint32_t n){
+    float mean;
+    arm_mean_f32(w, n, &mean);
+    float sum = mean * (float)n;
+    if (!(sum > 0.0f)){
+        return 0.0f;
+    }
+    arm_scale_f32(w, 1.0f / sum, w, n);
+    return sum;
+}
+
+float effective_sample_size(float w[], uint32_t n){
+    float sum_of_squares;
+    arm_power_f32(w, n, &sum_of_squares);
+    if (!(sum_of_squares > 0.0f)){
+        return 0.0f;
+    }
+    return 1.0f / sum_of_squares;
+}
+
+bool resampling_needed(float ess, uint32_t n, float percent){
+    return ess < ((float)n * percent / 100.0f);
+}
+
+//the number of sample points covered by a particle
+static float sample_points_of_weight(float w, uint32_t n, bool residual){
+    float points = w * (float)n;
+    return residual ? (points - floorf(points)) : points;
+}
+
+//draws count sample points from the (residual) weights, the particle index only moves forward
+static void draw_sample_points(float w[], uint32_t n, bool residual, bool stratified, uint16_t ancestor[], uint32_t count){
+    uint32_t i = 0;
+    float cumulative = sample_points_of_weight(w[0], n, residual);
+    const float offset = stratified ? 0.0f : rand_val();
+
+    for (uint32_t j = 0; j < count; j++)
+    {
+        float point = (float)j + (stratified ? rand_val() : offset);
+        //rounding of the cumulative sum can leave the last point just past the last particle
+        while ((point >= cumulative) && (i < (n - 1))){
+            i++;
+            cumulative += sample_points_of_weight(w[i], n, residual);
+        }
+        ancestor[j] = (uint16_t)i;
+    }
+}
+
+void resample_particle_indices(ResampleMethod method, float w[], uint32_t n, uint16_t ancestor[]){
+    if (n == 0){
+        return;
+    }
+    switch (method){
+    case resample_stratified:
+        draw_sample_points(w, n, false, true, ancestor, n);
+        break;
+
+    case resample_residual:{
+        //the whole part of every weight is copied without drawing
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            uint32_t copies = (uint32_t)(w[i] * (float)n);
+            while ((copies > 0) && (count < n)){
+                ancestor[count++] = (uint16_t)i;
+                copies--;
+            }
+        }
+        //the residual weights sum to the number of particles left
+        draw_sample_points(w, n, true, false, &ancestor[count], n - count);
+        break;
+    }
+
+    case resample_systematic:
+    default:
+        draw_sample_points(w, n, false, false, ancestor, n);
+        break;
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef PARTICLE_RESAMPLING_H_
+#define PARTICLE_RESAMPLING_H_
+
+/*
+    Resampling of the particle filter on a normalised weight array.
+    All methods walk the weights and the sample points once (at most 2N steps),
+    so the runtime only depends on the number of particles and not on the weights.
+    - systematic: one random offset, the N sample points are spaced 1/N apart.
+    - stratified: one random sample point in every 1/N interval.
+    - residual: particle i is copied floor(N*w_i) times, the remaining particles
+      are drawn systematically from the residual weights.
+    Source: Douc, Cappe, "Comparison of resampling schemes for particle filtering" (2005)
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+    resample_systematic,
+    resample_stratified,
+    resample_residual
+} ResampleMethod;
+
+/**
+ * Scales the weights so they sum to 1.
+ * @return the sum of the weights before normalising, 0 if they can not be normalised (they are left untouched)
+ */
+float normalise_particle_weights(float w[], uint32_t n);
+
+/**
+ * @param w normalised weights
+ * @return the effective sample size 1/sum(w^2), between 1 and n
+ */
+float effective_sample_size(float w[], uint32_t n);
+
+/**
+ * @param ess effective sample size of the weights
+ * @param percent threshold in percent of the n particles
+ * @return true if the weights have degenerated and the particles should be resampled
+ */
+bool resampling_needed(float ess, uint32_t n, float percent);
+
+/**
+ * Draws n particles from the normalised weights.
+ * @param ancestor the particle index every new particle is copied from
+ */
+void resample_particle_indices(ResampleMethod method, float w[], uint32_t n, uint16_t ancestor[]);
+
+#endif // PARTICLE_RESAMPLING_H_
@@ -0,0 +1,129 @@
+#include "tca9548a_scheduler.h"
+
+#include "i2cdev.h"
+
+void tca9548a_scheduler_init(tca9548a_scheduler* s, tca9548a_handle_t* tca){
+    s->tca = tca;
+    s->num_of_devices = 0;
+    //the mux driver functions keep track of the channels, the register is only known when one of them was used
+    s->cache_valid = (tca->current_active_channel != 0);
+    s->mux_writes = 0;
+    s->transfers = 0;
+}
+
+int8_t tca9548a_scheduler_add_device(tca9548a_scheduler* s, uint8_t address, tca9548a_channel_t channel){
+    if (s->num_of_devices >= TCA9548A_SCHEDULER_MAX_DEVICES){
+        return -1;
+    }
+    s->devices[s->num_of_devices].address = address;
+    s->devices[s->num_of_devices].channel = channel;
+    return (int8_t)s->num_of_devices++;
+}
+
+//a device can be reached when all its channel bits are enabled
+static bool tca9548a_scheduler_reachable(const tca9548a_scheduler_device* d, uint8_t mask){
+    return ((uint8_t)d->channel & mask) == (uint8_t)d->channel;
+}
+
+//true if no 2 devices that are (partly) enabled by the mask share an address
+static bool tca9548a_scheduler_compatible(const tca9548a_scheduler* s, uint8_t mask){
+    for (uint8_t i = 0; i < s->num_of_devices; i++)
+    {
+        if (((uint8_t)s->devices[i].channel & mask) == 0){
+            continue;
+        }
+        for (uint8_t j = i + 1; j < s->num_of_devices; j++)
+        {
+            if ((((uint8_t)s->devices[j].channel & mask) != 0) && (s->devices[i].address == s->devices[j].address)){
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool tca9548a_scheduler_transfer(tca9548a_scheduler* s, const tca9548a_transfer* t){
+    const uint8_t address = s->devices[t->device].address;
+    s->transfers++;
+    if (t->type == TCA9548A_TRANSFER_READ_REG){
+        return i2cdevReadReg8(I2C1_DEV, address, t->reg, t->len, t->buf);
+    }
+    return i2cdevWrite(I2C1_DEV, address, t->len, t->buf);
+}
+
+uint8_t tca9548a_scheduler_execute(tca9548a_scheduler* s, tca9548a_transfer transfers[], uint8_t n){
+    bool done[TCA9548A_SCHEDULER_MAX_TRANSFERS];
+    uint8_t num_of_done = 0;
+    uint8_t num_of_ok = 0;
+
+    if (n > TCA9548A_SCHEDULER_MAX_TRANSFERS){
+        n = TCA9548A_SCHEDULER_MAX_TRANSFERS;
+    }
+    for (uint8_t i = 0; i < n; i++)
+    {
+        transfers[i].ok = false;
+        //unknown devices are never executed
+        done[i] = (transfers[i].device >= s->num_of_devices);
+        num_of_done += done[i] ? 1 : 0;
+    }
+
+    while (num_of_done < n)
+    {
+        uint8_t mask = (uint8_t)s->tca->current_active_channel;
+
+        //run everything the mux already connects, in the order of the array
+        if (s->cache_valid && tca9548a_scheduler_compatible(s, mask)){
+            for (uint8_t i = 0; i < n; i++)
+            {
+                if (done[i] || !tca9548a_scheduler_reachable(&s->devices[transfers[i].device], mask)){
+                    continue;
+                }
+                transfers[i].ok = tca9548a_scheduler_transfer(s, &transfers[i]);
+                num_of_ok += transfers[i].ok ? 1 : 0;
+                done[i] = true;
+                num_of_done++;
+            }
+            if (num_of_done == n){
+                break;
+            }
+        }
+
+        //the first remaining transfer picks the channel, channels of later transfers are added when their addresses do not collide
+        mask = 0;
+        for (uint8_t i = 0; i < n; i++)
+        {
+            if (done[i]){
+                continue;
+            }
+            uint8_t extended = mask | (uint8_t)s->devices[transfers[i].device].channel;
+            if ((mask == 0) || tca9548a_scheduler_compatible(s, extended)){
+                mask = extended;
+            }
+        }
+
+        //a device whose own channels collide can not be reached, the mux write is skipped
+        bool failed = !tca9548a_scheduler_compatible(s, mask);
+        if (!failed){
+            s->mux_writes++;
+            if (s->tca->iic_write(TCA9548A_BASE_ADDR, &mask, 1) != 0){
+                //the register is unknown
+                s->cache_valid = false;
+                failed = true;
+            }
+        }
+        if (failed){
+            //the transfers that needed this mask fail
+            for (uint8_t i = 0; i < n; i++)
+            {
+                if (!done[i] && tca9548a_scheduler_reachable(&s->devices[transfers[i].device], mask)){
+                    done[i] = true;
+                    num_of_done++;
+                }
+            }
+            continue;
+        }
+        s->tca->current_active_channel = mask;
+        s->cache_valid = true;
+    }
+    return num_of_ok;
+}
@@ -0,0 +1,74 @@
+#ifndef TCA9548A_SCHEDULER_H
+#define TCA9548A_SCHEDULER_H
+
+/*
+    Schedules i2c transfers to devices behind the TCA9548A mux.
+    Every device is registered with its address and mux channel. A batch of transfers is executed with as few
+    writes to the mux control register as possible:
+    - the mux register is cached, transfers to devices on the enabled channels run first without a mux write.
+    - the remaining transfers are grouped per channel, the order of the transfers of a device is kept.
+    - channels are enabled together when no 2 devices on them share an address (multi-channel mode of the mux),
+      so one mux write serves several channels.
+    The cache is the current_active_channel of the mux handle, so it stays valid when the mux driver functions are used.
+    After a failed mux write the cache is invalid and the next batch always writes the mux.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tca9548a.h"
+
+#define TCA9548A_SCHEDULER_MAX_DEVICES 8
+#define TCA9548A_SCHEDULER_MAX_TRANSFERS 16
+
+typedef struct tca9548a_scheduler_devices{
+    uint8_t address;
+    tca9548a_channel_t channel;
+} tca9548a_scheduler_device;
+
+typedef enum{
+    TCA9548A_TRANSFER_READ_REG,  ///< write the register address, then read len bytes
+    TCA9548A_TRANSFER_WRITE,     ///< write len bytes
+} tca9548a_transfer_type_t;
+
+typedef struct tca9548a_transfers{
+    //index of the device returned by tca9548a_scheduler_add_device
+    uint8_t device;
+    tca9548a_transfer_type_t type;
+    uint8_t reg;
+    uint8_t* buf;
+    uint16_t len;
+    //set by tca9548a_scheduler_execute
+    bool ok;
+} tca9548a_transfer;
+
+typedef struct tca9548a_schedulers{
+    tca9548a_handle_t* tca;
+    tca9548a_scheduler_device devices[TCA9548A_SCHEDULER_MAX_DEVICES];
+    uint8_t num_of_devices;
+    //false when the content of the mux register is unknown
+    bool cache_valid;
+    //statistics
+    uint32_t mux_writes;
+    uint32_t transfers;
+} tca9548a_scheduler;
+
+/**
+ * @param tca handle of an initialised mux
+ */
+void tca9548a_scheduler_init(tca9548a_scheduler* s, tca9548a_handle_t* tca);
+
+/**
+ * Registers a device behind the mux.
+ * @return index of the device, -1 if there is no room
+ */
+int8_t tca9548a_scheduler_add_device(tca9548a_scheduler* s, uint8_t address, tca9548a_channel_t channel);
+
+/**
+ * Executes a batch of transfers, the ok flag of every transfer is set.
+ * The transfers of a device are executed in the order of the array, transfers of different devices may be reordered.
+ * @return number of successful transfers
+ */
+uint8_t tca9548a_scheduler_execute(tca9548a_scheduler* s, tca9548a_transfer transfers[], uint8_t n);
+
+#endif //TCA9548A_SCHEDULER_H
@@ -102,6 +102,115 @@ hsv rgb_delta2hsv_delta(rgb_delta in){
 }
 
 
+//sin of a quarter circle in Q15, 256 steps of 90/256 degrees
+static const uint16_t quarter_sine_q15[CHROMA_SINE_STEPS + 1] = {
+    0, 201, 402, 603, 804, 1005, 1206, 1407, 1608, 1809, 2009, 2210,
+    2411, 2611, 2811, 3012, 3212, 3412, 3612, 3812, 4011, 4211, 4410, 4609,
+    4808, 5007, 5205, 5404, 5602, 5800, 5998, 6195, 6393, 6590, 6787, 6983,
+    7180, 7376, 7571, 7767, 7962, 8157, 8351, 8546, 8740, 8933, 9127, 9319,
+    9512, 9704, 9896, 10088, 10279, 10469, 10660, 10850, 11039, 11228, 11417, 11605,
+    11793, 11980, 12167, 12354, 12540, 12725, 12910, 13095, 13279, 13463, 13646, 13828,
+    14010, 14192, 14373, 14553, 14733, 14912, 15091, 15269, 15447, 15624, 15800, 15976,
+    16151, 16326, 16500, 16673, 16846, 17018, 17190, 17361, 17531, 17700, 17869, 18037,
+    18205, 18372, 18538, 18703, 18868, 19032, 19195, 19358, 19520, 19681, 19841, 20001,
+    20160, 20318, 20475, 20632, 20788, 20943, 21097, 21251, 21403, 21555, 21706, 21856,
+    22006, 22154, 22302, 22449, 22595, 22740, 22884, 23028, 23170, 23312, 23453, 23593,
+    23732, 23870, 24008, 24144, 24279, 24414, 24548, 24680, 24812, 24943, 25073, 25202,
+    25330, 25457, 25583, 25708, 25833, 25956, 26078, 26199, 26320, 26439, 26557, 26674,
+    26791, 26906, 27020, 27133, 27246, 27357, 27467, 27576, 27684, 27791, 27897, 28002,
+    28106, 28209, 28311, 28411, 28511, 28610, 28707, 28803, 28899, 28993, 29086, 29178,
+    29269, 29359, 29448, 29535, 29622, 29707, 29792, 29875, 29957, 30038, 30118, 30196,
+    30274, 30350, 30425, 30499, 30572, 30644, 30715, 30784, 30853, 30920, 30986, 31050,
+    31114, 31177, 31238, 31298, 31357, 31415, 31471, 31527, 31581, 31634, 31686, 31737,
+    31786, 31834, 31881, 31927, 31972, 32015, 32058, 32099, 32138, 32177, 32214, 32251,
+    32286, 32319, 32352, 32383, 32413, 32442, 32470, 32496, 32522, 32546, 32568, 32590,
+    32610, 32629, 32647, 32664, 32679, 32693, 32706, 32718, 32729, 32738, 32746, 32753,
+    32758, 32762, 32766, 32767, 32768
+};
+
+//sin of the angle p in [0, CHROMA_QUARTER_TURN], linear interpolation between the table entries
+static int32_t quarterSineQ15(uint32_t p){
+    uint32_t i = p >> CHROMA_SINE_FRACTION_BITS;
+    uint32_t f = p & ((1 << CHROMA_SINE_FRACTION_BITS) - 1);
+    if (f == 0){
+        return quarter_sine_q15[i];
+    }
+    int32_t step = (int32_t)quarter_sine_q15[i + 1] - (int32_t)quarter_sine_q15[i];
+    return quarter_sine_q15[i] + ((step * (int32_t)f + (1 << (CHROMA_SINE_FRACTION_BITS - 1))) >> CHROMA_SINE_FRACTION_BITS);
+}
+
+int32_t sinQ15(uint16_t angle){
+    uint32_t p = angle & (CHROMA_QUARTER_TURN - 1);
+    switch (angle >> 14)
+    {
+    case 0:
+        return quarterSineQ15(p);
+    case 1:
+        return quarterSineQ15(CHROMA_QUARTER_TURN - p);
+    case 2:
+        return -quarterSineQ15(p);
+    default:
+        return -quarterSineQ15(CHROMA_QUARTER_TURN - p);
+    }
+}
+
+int32_t cosQ15(uint16_t angle){
+    return sinQ15((uint16_t)(angle + CHROMA_QUARTER_TURN));
+}
+
+chroma_q15 rgb_raw_delta2chroma_q15(rgb_raw in1, rgb_raw in2){
+    chroma_q15 out = {.x = 0, .y = 0};
+    //the normalisation to 0-1 cancels in the hue and saturation, the raw counts are used as is
+    int32_t r = (int32_t)in1.r - (int32_t)in2.r;
+    int32_t g = (int32_t)in1.g - (int32_t)in2.g;
+    int32_t b = (int32_t)in1.b - (int32_t)in2.b;
+
+    int32_t min = r < g ? r : g;
+    min = min < b ? min : b;
+    int32_t max = r > g ? r : g;
+    max = max > b ? max : b;
+    //at least half of the difference between max and min
+    int32_t abs_max = (max > -min) ? max : -min;
+
+    //same as the float path, a difference below 1 count has no hue
+    int32_t delta = max - min;
+    if (delta == 0){
+        return out;
+    }
+
+    //hue in sixths of a circle in Q14, the same sectors as rgb_delta2hsv_delta
+    //|numerator| <= delta <= 131070, shifted by 14 it still fits in 31 bits
+    int32_t sector;
+    int32_t numerator;
+    if (r >= max){
+        sector = 0;
+        numerator = g - b;
+    }else if (g >= max){
+        sector = 2;
+        numerator = b - r;
+    }else{
+        sector = 4;
+        numerator = r - g;
+    }
+    int32_t hue_sixths_q14 = (sector << 14) + (numerator * (1 << 14)) / delta;
+
+    //a full circle is 6 sectors or 65536 angle steps, the extra circle keeps it positive and wraps in the cast
+    uint32_t hue_positive = (uint32_t)(hue_sixths_q14 + (6 << 14));
+    uint16_t angle = (uint16_t)((hue_positive * 2 + 1) / 3);
+
+    //saturation delta / (2 * abs_max) in Q15
+    int32_t saturation_q15 = (delta << 14) / abs_max;
+
+    out.x = (saturation_q15 * cosQ15(angle) + (1 << 14)) >> 15;
+    out.y = (saturation_q15 * sinQ15(angle) + (1 << 14)) >> 15;
+    return out;
+}
+
+float q15ToFloat(int32_t in){
+    return (float)in * ((float)1.0 / (float)CHROMA_Q15_ONE);
+}
+
+
 rgb hsv2rgb(hsv in)
 {
     float       hh, p, q, t, ff;
@@ -197,6 +306,12 @@ void processDeltaData(tcs34725_Color_data * d1, tcs34725_Color_data * d2){
     d2->hsv_delta_data = d1->hsv_delta_data;
 }
 
+void processDeltaChroma(tcs34725_Color_data * d1, tcs34725_Color_data * d2){
+    d1->chroma_delta_data = rgb_raw_delta2chroma_q15(d1->rgb_raw_data, d2->rgb_raw_data);
+    //save the delta data in both structs
+    d2->chroma_delta_data = d1->chroma_delta_data;
+}
+
 void printLatestMeasurements(void (*debug_print)(const char *const fmt, ...), tcs34725_Color_data * data_struct){
     debug_print("Test printing the measurements");
 }
@@ -41,9 +41,23 @@ typedef struct rgb_raw
 } rgb_raw;
 
 
+//fixed point format of the chroma feature, 32768 = 1.0
+#define CHROMA_Q15_ONE 32768
+//angles are in 1/65536 of a circle
+#define CHROMA_QUARTER_TURN 16384
+#define CHROMA_SINE_STEPS 256
+#define CHROMA_SINE_FRACTION_BITS 6
+
+//the chroma feature used by the KNN classification: the delta hue and saturation in carthesian form, in Q15
+typedef struct chroma_q15s {
+    int32_t x;     // saturation * cos(hue)
+    int32_t y;     // saturation * sin(hue)
+} chroma_q15;
+
 typedef struct tcs34725_Color_datas{
     hsv hsv_data;
     hsv hsv_delta_data;
+    chroma_q15 chroma_delta_data;
     rgb rgb_data;
     rgb_delta rgb_delta_data;
     rgb_raw rgb_raw_data;
@@ -71,6 +85,33 @@ hsv rgb2hsv(rgb in);
 hsv rgb_delta2hsv_delta(rgb_delta in);
 
 
+/**
+ * @brief converts the raw counts of 2 sensors directly to the chroma feature of the delta (in1 - in2).
+ * Same result as the normalisation, calc_rgb_delta, rgb_delta2hsv_delta and the polar to carthesian conversion
+ * of the KNN, in integer maths: the hue stays a fraction of its sector and cos/sin come from a lookup table.
+ * 
+ * @param in1 raw data of sensor 1
+ * @param in2 raw data of sensor 2
+ * @return x and y in Q15, 0 if the delta has no hue
+ */
+chroma_q15 rgb_raw_delta2chroma_q15(rgb_raw in1, rgb_raw in2);
+
+
+/**
+ * @brief sin and cos in Q15 from a lookup table
+ * 
+ * @param angle in 1/65536 of a circle
+ */
+int32_t sinQ15(uint16_t angle);
+int32_t cosQ15(uint16_t angle);
+
+
+/**
+ * @brief converts a Q15 value to float
+ */
+float q15ToFloat(int32_t in);
+
+
 /**
  * @brief converts hsv to rgb color spectrum
  * 
@@ -133,6 +174,16 @@ void calc_rgb_delta(tcs34725_Color_data * d1, tcs34725_Color_data * d2);
 void processDeltaData(tcs34725_Color_data * d1, tcs34725_Color_data * d2);
 
 
+/**
+ * @brief Calculates the delta chroma feature of 2 Color data structs from the raw data only, see rgb_raw_delta2chroma_q15.
+ * It is saved in both structs.
+ * 
+ * @param data_struct number 1
+ * @param data_struct number 2
+ */
+void processDeltaChroma(tcs34725_Color_data * d1, tcs34725_Color_data * d2);
+
+
 
 #ifdef __cplusplus
 }
@@ -47,6 +47,12 @@ extern "C"{
 #define TCS34725_0_INT_GPIO_PIN DECK_GPIO_IO4
 #define TCS34725_1_INT_GPIO_PIN DECK_GPIO_IO3
 
+//external interrupt of the sensor 0 interrupt pin (IO4 = PC12)
+//IO3 (PB4) shares EXTI line 4 with the syslink flow control pin (PA4), so sensor 1 has no external interrupt
+#define TCS34725_0_INT_EXTI_PORT_SOURCE EXTI_PortSourceGPIOC
+#define TCS34725_0_INT_EXTI_PIN_SOURCE EXTI_PinSource12
+#define TCS34725_0_INT_EXTI_LINE EXTI_Line12
+
 /**
  * @defgroup tcs34725_interface_driver tcs34725 interface driver function
  * @brief    tcs34725 interface driver modules
@@ -0,0 +1,262 @@
+#include "tcs34725_acquisition.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+#include "stm32fxxx.h"
+#include "exti.h"
+#include "deck.h"
+#include "i2cdev.h"
+#include "usec_time.h"
+#include "static_mem.h"
+#include "system.h"
+#include "log.h"
+
+#include "driver_tcs34725.h"
+#include "driver_tcs34725_interface.h"
+#include "tca9548a_scheduler.h"
+
+#define TCS34725_ACQUISITION_TASK_STACKSIZE  (2*configMINIMAL_STACK_SIZE)
+#define TCS34725_ACQUISITION_TASK_NAME "TCSACQTASK"
+//above the colour deck task, the i2c transfers only take a few hundred us
+#define TCS34725_ACQUISITION_TASK_PRI 5
+
+#define TCS34725_ACQUISITION_QUEUE_LENGTH 8
+
+//command byte: auto increment from the status register, STATUS, CDATAL ... BDATAH
+#define TCS34725_ACQUISITION_REG_STATUS_AUTO_INC 0xB3
+#define TCS34725_ACQUISITION_BURST_LENGTH 9
+//command byte: clear the RGBC interrupt (special function)
+#define TCS34725_ACQUISITION_CMD_CLEAR_INT 0xE6
+//status register bits
+#define TCS34725_ACQUISITION_STATUS_AVALID (1 << 0)
+#define TCS34725_ACQUISITION_STATUS_AINT (1 << 4)
+//command byte of the enable register and its RGBC enable bit
+#define TCS34725_ACQUISITION_REG_ENABLE 0x80
+#define TCS34725_ACQUISITION_ENABLE_AEN (1 << 1)
+//the sensors are restarted together after this many interrupts of sensor 0 without a sample of sensor 1
+#define TCS34725_ACQUISITION_RESYNC_MISSES 2
+
+//the sensors share an address, the scheduler switches the mux between them
+static tca9548a_scheduler scheduler;
+static int8_t sensor_devices[TCS34725_ACQUISITION_NUM_OF_SENSORS];
+static TaskHandle_t acquisition_task_handle = NULL;
+static uint8_t clear_cmd = TCS34725_ACQUISITION_CMD_CLEAR_INT;
+
+STATIC_MEM_QUEUE_ALLOC(sampleQueue, TCS34725_ACQUISITION_QUEUE_LENGTH, sizeof(tcs34725_sample));
+static QueueHandle_t sampleQueue;
+
+//time of the last interrupt of sensor 0, written by the interrupt, only read in a critical section
+static volatile uint64_t interrupt_timestamp;
+static volatile uint32_t interrupt_tick;
+
+//statistics
+static uint32_t samples_dropped = 0;
+static uint32_t i2c_errors = 0;
+static uint32_t resyncs = 0;
+
+static void tcs34725_acquisition_task(void* arg);
+
+void tcs34725_acquisition_init(tca9548a_handle_t* tca_handle, const tca9548a_channel_t channels[TCS34725_ACQUISITION_NUM_OF_SENSORS]){
+    EXTI_InitTypeDef EXTI_InitStructure;
+
+    tca9548a_scheduler_init(&scheduler, tca_handle);
+    for (uint8_t i = 0; i < TCS34725_ACQUISITION_NUM_OF_SENSORS; i++)
+    {
+        sensor_devices[i] = tca9548a_scheduler_add_device(&scheduler, TCS34725_ADDRESS, channels[i]);
+    }
+    sampleQueue = STATIC_MEM_QUEUE_CREATE(sampleQueue);
+    xTaskCreate(tcs34725_acquisition_task, TCS34725_ACQUISITION_TASK_NAME, TCS34725_ACQUISITION_TASK_STACKSIZE, NULL, TCS34725_ACQUISITION_TASK_PRI, &acquisition_task_handle);
+
+    //the interrupt line of the sensor is open drain and active low
+    pinMode(TCS34725_0_INT_GPIO_PIN, INPUT_PULLUP);
+    pinMode(TCS34725_1_INT_GPIO_PIN, INPUT_PULLUP);
+
+    SYSCFG_EXTILineConfig(TCS34725_0_INT_EXTI_PORT_SOURCE, TCS34725_0_INT_EXTI_PIN_SOURCE);
+    EXTI_InitStructure.EXTI_Line = TCS34725_0_INT_EXTI_LINE;
+    EXTI_InitStructure.EXTI_Mode = EXTI_Mode_Interrupt;
+    EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Falling;
+    EXTI_InitStructure.EXTI_LineCmd = ENABLE;
+    EXTI_Init(&EXTI_InitStructure);
+    EXTI_ClearITPendingBit(TCS34725_0_INT_EXTI_LINE);
+}
+
+bool tcs34725_acquisition_receive(tcs34725_sample* sample, TickType_t timeout){
+    return xQueueReceive(sampleQueue, sample, timeout) == pdTRUE;
+}
+
+/**
+ * Reads the sensors with a low interrupt line in one batch.
+ * Per sensor the status and RGBC registers are burst read and the interrupt is cleared, the line is only low
+ * while the interrupt is set. The scheduler starts with the sensor the mux is connected to,
+ * so the mux only switches once when both sensors are read.
+ */
+static void tcs34725_acquisition_read(const bool pending[TCS34725_ACQUISITION_NUM_OF_SENSORS], const uint64_t timestamp[TCS34725_ACQUISITION_NUM_OF_SENSORS], const uint32_t tick[TCS34725_ACQUISITION_NUM_OF_SENSORS]){
+    static uint8_t buf[TCS34725_ACQUISITION_NUM_OF_SENSORS][TCS34725_ACQUISITION_BURST_LENGTH];
+    tca9548a_transfer transfers[2 * TCS34725_ACQUISITION_NUM_OF_SENSORS];
+    uint8_t read_transfer[TCS34725_ACQUISITION_NUM_OF_SENSORS];
+    uint8_t n = 0;
+
+    for (uint8_t ID = 0; ID < TCS34725_ACQUISITION_NUM_OF_SENSORS; ID++)
+    {
+        if (!pending[ID] || (sensor_devices[ID] < 0)){
+            continue;
+        }
+        read_transfer[ID] = n;
+        transfers[n++] = (tca9548a_transfer){.device = (uint8_t)sensor_devices[ID], .type = TCA9548A_TRANSFER_READ_REG,
+                                             .reg = TCS34725_ACQUISITION_REG_STATUS_AUTO_INC, .buf = buf[ID], .len = TCS34725_ACQUISITION_BURST_LENGTH};
+        transfers[n++] = (tca9548a_transfer){.device = (uint8_t)sensor_devices[ID], .type = TCA9548A_TRANSFER_WRITE,
+                                             .buf = &clear_cmd, .len = 1};
+    }
+    if (n == 0){
+        return;
+    }
+    tca9548a_scheduler_execute(&scheduler, transfers, n);
+
+    for (uint8_t ID = 0; ID < TCS34725_ACQUISITION_NUM_OF_SENSORS; ID++)
+    {
+        if (!pending[ID] || (sensor_devices[ID] < 0)){
+            continue;
+        }
+        const uint8_t* b = buf[ID];
+        if (!transfers[read_transfer[ID]].ok || !transfers[read_transfer[ID] + 1].ok || ((b[0] & TCS34725_ACQUISITION_STATUS_AVALID) == 0)){
+            i2c_errors++;
+            continue;
+        }
+        tcs34725_sample sample;
+        sample.ID = ID;
+        sample.status = b[0];
+        sample.c = ((uint16_t)b[2] << 8) | b[1];
+        sample.r = ((uint16_t)b[4] << 8) | b[3];
+        sample.g = ((uint16_t)b[6] << 8) | b[5];
+        sample.b = ((uint16_t)b[8] << 8) | b[7];
+        sample.timestamp = timestamp[ID];
+        sample.tick = tick[ID];
+        if (xQueueSend(sampleQueue, &sample, 0) != pdTRUE){
+            samples_dropped++;
+        }
+    }
+}
+
+/**
+ * Restarts the RGBC cycle of both sensors at the same time.
+ * The sensors have no trigger input, clearing AEN stops the running cycle and setting it starts a new one.
+ * Sensor 1 is started first, so with the same ATIME and WTIME it finishes just before sensor 0
+ * and its line is already low when the interrupt of sensor 0 wakes the task.
+ * @return true if all transfers succeeded
+ */
+static bool tcs34725_acquisition_sync(){
+    static uint8_t enable[TCS34725_ACQUISITION_NUM_OF_SENSORS];
+    static uint8_t enable_cmd[TCS34725_ACQUISITION_NUM_OF_SENSORS][2];
+    tca9548a_transfer transfers[2 * TCS34725_ACQUISITION_NUM_OF_SENSORS];
+    uint8_t n = 0;
+
+    //the enable register holds the power and wait settings of the init, only AEN is changed
+    for (uint8_t ID = 0; ID < TCS34725_ACQUISITION_NUM_OF_SENSORS; ID++)
+    {
+        transfers[n++] = (tca9548a_transfer){.device = (uint8_t)sensor_devices[ID], .type = TCA9548A_TRANSFER_READ_REG,
+                                             .reg = TCS34725_ACQUISITION_REG_ENABLE, .buf = &enable[ID], .len = 1};
+    }
+    if (tca9548a_scheduler_execute(&scheduler, transfers, n) != n){
+        return false;
+    }
+
+    //stop both sensors and clear the interrupts of the stopped cycles
+    n = 0;
+    for (uint8_t ID = 0; ID < TCS34725_ACQUISITION_NUM_OF_SENSORS; ID++)
+    {
+        enable_cmd[ID][0] = TCS34725_ACQUISITION_REG_ENABLE;
+        enable_cmd[ID][1] = enable[ID] & (uint8_t)~TCS34725_ACQUISITION_ENABLE_AEN;
+        transfers[n++] = (tca9548a_transfer){.device = (uint8_t)sensor_devices[ID], .type = TCA9548A_TRANSFER_WRITE,
+                                             .buf = enable_cmd[ID], .len = 2};
+        transfers[n++] = (tca9548a_transfer){.device = (uint8_t)sensor_devices[ID], .type = TCA9548A_TRANSFER_WRITE,
+                                             .buf = &clear_cmd, .len = 1};
+    }
+    if (tca9548a_scheduler_execute(&scheduler, transfers, n) != n){
+        return false;
+    }
+
+    //start them one after the other, a batch per sensor keeps the order
+    bool ok = true;
+    for (int8_t ID = TCS34725_ACQUISITION_NUM_OF_SENSORS - 1; ID >= 0; ID--)
+    {
+        enable_cmd[ID][1] = enable[ID] | TCS34725_ACQUISITION_ENABLE_AEN;
+        transfers[0] = (tca9548a_transfer){.device = (uint8_t)sensor_devices[ID], .type = TCA9548A_TRANSFER_WRITE,
+                                           .buf = enable_cmd[ID], .len = 2};
+        ok = (tca9548a_scheduler_execute(&scheduler, transfers, 1) == 1) && ok;
+    }
+    resyncs++;
+    return ok;
+}
+
+static void tcs34725_acquisition_task(void* arg){
+    systemWaitStart();
+
+    const deckPin_t int_pins[TCS34725_ACQUISITION_NUM_OF_SENSORS] = {TCS34725_0_INT_GPIO_PIN, TCS34725_1_INT_GPIO_PIN};
+    //interrupts of sensor 0 in a row without a sample of sensor 1
+    uint8_t misses = 0;
+
+    bool synced = (sensor_devices[0] >= 0) && (sensor_devices[1] >= 0) && tcs34725_acquisition_sync();
+
+    while (1) {
+        bool interrupted = ulTaskNotifyTake(pdTRUE, M2T(TCS34725_ACQUISITION_TIMEOUT_MS)) > 0;
+
+        //the 64 bit time is written in 2 halves by the interrupt, copy it with the interrupt masked so it can not tear
+        taskENTER_CRITICAL();
+        const uint64_t last_interrupt_timestamp = interrupt_timestamp;
+        const uint32_t last_interrupt_tick = interrupt_tick;
+        taskEXIT_CRITICAL();
+
+        //time of the sample, a sample found without interrupt gets the time the line was checked
+        uint64_t now = usecTimestamp();
+        uint32_t now_tick = xTaskGetTickCount();
+
+        bool pending[TCS34725_ACQUISITION_NUM_OF_SENSORS];
+        uint64_t timestamp[TCS34725_ACQUISITION_NUM_OF_SENSORS];
+        uint32_t tick[TCS34725_ACQUISITION_NUM_OF_SENSORS];
+        for (uint8_t ID = 0; ID < TCS34725_ACQUISITION_NUM_OF_SENSORS; ID++)
+        {
+            pending[ID] = (digitalRead(int_pins[ID]) == 0);
+        }
+        //synchronised, sensor 1 finished just before the interrupt of sensor 0 and gets its time
+        for (uint8_t ID = 0; ID < TCS34725_ACQUISITION_NUM_OF_SENSORS; ID++)
+        {
+            bool interrupt_time = interrupted && ((ID == 0) || synced);
+            timestamp[ID] = interrupt_time ? last_interrupt_timestamp : now;
+            tick[ID] = interrupt_time ? last_interrupt_tick : now_tick;
+        }
+        tcs34725_acquisition_read(pending, timestamp, tick);
+
+        //the oscillators of the sensors drift apart, restart them together when sensor 1 keeps missing the interrupt
+        if (interrupted && pending[0]){
+            misses = pending[1] ? 0 : misses + 1;
+        }
+        if (misses >= TCS34725_ACQUISITION_RESYNC_MISSES){
+            synced = tcs34725_acquisition_sync();
+            misses = 0;
+        }
+    }
+}
+
+void __attribute__((used)) EXTI12_Callback(void)
+{
+    portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+
+    interrupt_timestamp = usecTimestamp();
+    interrupt_tick = xTaskGetTickCountFromISR();
+    if (acquisition_task_handle != NULL){
+        vTaskNotifyGiveFromISR(acquisition_task_handle, &xHigherPriorityTaskWoken);
+    }
+
+    if (xHigherPriorityTaskWoken) {
+        portYIELD();
+    }
+}
+
+LOG_GROUP_START(TCSACQ)
+    LOG_ADD_CORE(LOG_UINT32, dropped, &samples_dropped)
+    LOG_ADD_CORE(LOG_UINT32, i2cErrors, &i2c_errors)
+    LOG_ADD_CORE(LOG_UINT32, muxWrites, &scheduler.mux_writes)
+    LOG_ADD_CORE(LOG_UINT32, resyncs, &resyncs)
+LOG_GROUP_STOP(TCSACQ)
@@ -0,0 +1,64 @@
+#ifndef TCS34725_ACQUISITION_H
+#define TCS34725_ACQUISITION_H
+
+/*
+    Interrupt driven acquisition of the 2 TCS34725 colour sensors behind the TCA9548A mux.
+    The sensors pull their interrupt line low after every RGBC cycle:
+    - the external interrupt of sensor 0 saves the time of the sample and wakes the acquisition task.
+    - the acquisition task reads every sensor with a low interrupt line in one chain of I2C transfers:
+      select the mux channel, burst read STATUS up to BDATAH (the i2c driver reads it with DMA)
+      and clear the sensor interrupt.
+    - the samples are timestamped and put in a queue for the colour deck task.
+    The I2C driver blocks the task on a semaphore during a transfer, so no CPU time is spent polling.
+
+    Sensor 1 has no external interrupt (see driver_tcs34725_interface.h), its line is checked every time the task
+    wakes up. Both sensors run with the same integration and wait time, so it is checked once per RGBC cycle.
+    At the start the task restarts the RGBC cycle of both sensors together (sensor 1 just before sensor 0),
+    while they stay synchronised sensor 1 gets the time of the interrupt of sensor 0. When sensor 1 is missing
+    at TCS34725_ACQUISITION_RESYNC_MISSES interrupts in a row the sensors have drifted apart and are restarted.
+    When no interrupt arrives within TCS34725_ACQUISITION_TIMEOUT_MS both lines are checked as well,
+    this also clears a sensor that kept its line low from before the acquisition started.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+
+//TCA9548a mux
+#include "driver_tca9548a_basic.h"
+
+#define TCS34725_ACQUISITION_NUM_OF_SENSORS 2
+//the interrupt lines are checked after this time without an interrupt
+#define TCS34725_ACQUISITION_TIMEOUT_MS 50
+
+typedef struct tcs34725_samples{
+    //ID of the sensor, 0 or 1
+    uint8_t ID;
+    //status register of the sensor
+    uint8_t status;
+    //time of the interrupt (us and ticks)
+    uint64_t timestamp;
+    uint32_t tick;
+    uint16_t r;
+    uint16_t g;
+    uint16_t b;
+    uint16_t c;
+} tcs34725_sample;
+
+/**
+ * Configures the external interrupt and starts the acquisition task.
+ * The sensors have to be initialised in interrupt mode, from now on only the acquisition task uses the I2C mux.
+ * @param tca_handle handle of the mux
+ * @param channels mux channel of every sensor
+ */
+void tcs34725_acquisition_init(tca9548a_handle_t* tca_handle, const tca9548a_channel_t channels[TCS34725_ACQUISITION_NUM_OF_SENSORS]);
+
+/**
+ * Blocks until a sample is available.
+ * @param timeout maximum time to wait in ticks
+ * @return false on a timeout
+ */
+bool tcs34725_acquisition_receive(tcs34725_sample* sample, TickType_t timeout);
+
+#endif //TCS34725_ACQUISITION_H
@@ -0,0 +1,76 @@
+#include "tcs34725_alignment.h"
+
+void tcs34725_alignment_init(tcs34725_alignment* a, uint64_t max_gap_us){
+    for (uint8_t ID = 0; ID < TCS34725_ACQUISITION_NUM_OF_SENSORS; ID++)
+    {
+        a->count[ID] = 0;
+    }
+    a->last_aligned = 0;
+    a->max_gap_us = max_gap_us;
+}
+
+//linear interpolation of a channel, dt <= span, rounded half away from zero for both slopes
+static uint16_t tcs34725_alignment_interpolate(uint16_t from, uint16_t to, uint32_t dt, uint32_t span){
+    const int64_t delta = ((int64_t)to - (int64_t)from) * dt;
+    const int64_t half = (int64_t)(span / 2);
+    const int64_t step = (delta >= 0) ? ((delta + half) / span) : -((-delta + half) / span);
+    return (uint16_t)((int64_t)from + step);
+}
+
+static void tcs34725_alignment_copy(rgb_raw* raw, const tcs34725_sample* sample){
+    raw->r = sample->r;
+    raw->g = sample->g;
+    raw->b = sample->b;
+    raw->c = sample->c;
+}
+
+bool tcs34725_alignment_add(tcs34725_alignment* a, const tcs34725_sample* sample, tcs34725_aligned_sample* aligned){
+    if (sample->ID >= TCS34725_ACQUISITION_NUM_OF_SENSORS){
+        return false;
+    }
+    a->previous[sample->ID] = a->latest[sample->ID];
+    a->latest[sample->ID] = *sample;
+    if (a->count[sample->ID] < 2){
+        a->count[sample->ID]++;
+    }
+
+    //the common instant is the oldest of the latest samples
+    uint8_t oldest = 0;
+    for (uint8_t ID = 0; ID < TCS34725_ACQUISITION_NUM_OF_SENSORS; ID++)
+    {
+        if (a->count[ID] == 0){
+            return false;
+        }
+        if (a->latest[ID].timestamp < a->latest[oldest].timestamp){
+            oldest = ID;
+        }
+    }
+    const uint64_t t = a->latest[oldest].timestamp;
+    if (t <= a->last_aligned){
+        return false;
+    }
+
+    for (uint8_t ID = 0; ID < TCS34725_ACQUISITION_NUM_OF_SENSORS; ID++)
+    {
+        const tcs34725_sample* latest = &a->latest[ID];
+        if (latest->timestamp == t){
+            tcs34725_alignment_copy(&aligned->raw[ID], latest);
+            continue;
+        }
+        //the latest sample is newer, the previous one has to be older
+        const tcs34725_sample* previous = &a->previous[ID];
+        if ((a->count[ID] < 2) || (previous->timestamp > t) || ((latest->timestamp - previous->timestamp) > a->max_gap_us)){
+            return false;
+        }
+        const uint32_t span = (uint32_t)(latest->timestamp - previous->timestamp);
+        const uint32_t dt = (uint32_t)(t - previous->timestamp);
+        aligned->raw[ID].r = tcs34725_alignment_interpolate(previous->r, latest->r, dt, span);
+        aligned->raw[ID].g = tcs34725_alignment_interpolate(previous->g, latest->g, dt, span);
+        aligned->raw[ID].b = tcs34725_alignment_interpolate(previous->b, latest->b, dt, span);
+        aligned->raw[ID].c = tcs34725_alignment_interpolate(previous->c, latest->c, dt, span);
+    }
+    aligned->timestamp = t;
+    aligned->tick = a->latest[oldest].tick;
+    a->last_aligned = t;
+    return true;
+}
@@ -0,0 +1,51 @@
+#ifndef TCS34725_ALIGNMENT_H
+#define TCS34725_ALIGNMENT_H
+
+/*
+    Aligns the samples of the 2 colour sensors to a common instant before the delta is calculated.
+    The last 2 samples of every sensor are kept. For every new sample the common instant is the time of the
+    oldest of the latest samples of both sensors:
+    - a sensor with a sample at that time uses it as is (the sensors are synchronised, see tcs34725_acquisition.h).
+    - otherwise its raw values are interpolated linearly between its previous and latest sample,
+      the 2 samples may be at most max_gap_us apart.
+    Every instant is only aligned once, when the sensors are not synchronised a cycle gives 2 aligned samples.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "color.h"
+#include "tcs34725_acquisition.h"
+
+typedef struct tcs34725_aligned_samples{
+    //common time of the samples (us and ticks)
+    uint64_t timestamp;
+    uint32_t tick;
+    //raw values of every sensor at that time
+    rgb_raw raw[TCS34725_ACQUISITION_NUM_OF_SENSORS];
+} tcs34725_aligned_sample;
+
+typedef struct tcs34725_alignments{
+    tcs34725_sample previous[TCS34725_ACQUISITION_NUM_OF_SENSORS];
+    tcs34725_sample latest[TCS34725_ACQUISITION_NUM_OF_SENSORS];
+    //number of samples received per sensor, saturates at 2
+    uint8_t count[TCS34725_ACQUISITION_NUM_OF_SENSORS];
+    //time of the last aligned sample
+    uint64_t last_aligned;
+    //samples further apart are not interpolated
+    uint64_t max_gap_us;
+} tcs34725_alignment;
+
+/**
+ * @param max_gap_us maximum time between 2 samples of a sensor to interpolate between, a bit more than an RGBC cycle
+ */
+void tcs34725_alignment_init(tcs34725_alignment* a, uint64_t max_gap_us);
+
+/**
+ * Adds a sample of the acquisition.
+ * @param aligned filled when the function returns true
+ * @return true if a new aligned sample is available
+ */
+bool tcs34725_alignment_add(tcs34725_alignment* a, const tcs34725_sample* sample, tcs34725_aligned_sample* aligned);
+
+#endif //TCS34725_ALIGNMENT_H
@@ -19,9 +19,15 @@
 //we want acces to the parameter framework for system state parameters
 #include "param.h"
 #include "log.h"
+//packet queue from the FSK task
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "static_mem.h"
 
 
 #define VLC_COMMAND_DURATION 1000 //duration of a command in ms
+#define VLC_MINIMUM_MOVE_DISTANCE 0.001f //moves shorter than the goto resolution (1 mm) are rejected, in m
+#define VLC_MINIMUM_MOVE_DURATION 0.5f //the high level commander needs time to plan a move, in s
 
 static setpoint_t setpoint;
 
@@ -38,6 +44,8 @@ static float move_dist = 0.1f;
 static float take_off_height = 0;
 //here such that we can debug it :)
 static uint8_t last_recieved_command = 128;
+//duration of the last move sent to the high level commander, in ms
+static uint32_t move_duration_ms = VLC_COMMAND_DURATION;
 // 
 
 //Circular buffer to save the recieved commands colors:
@@ -46,6 +54,13 @@ uint16_t buffer_command[COMMAND_BUFFER_SIZE]  = {0};
 circular_buf_t cbufCOMM;
 cbuf_handle_t cbuf_commands = &cbufCOMM;
 
+//Queue with the recieved VLC packets, filled by the FSK task
+#define PACKET_QUEUE_SIZE 8
+static QueueHandle_t packetQueue;
+STATIC_MEM_QUEUE_ALLOC(packetQueue, PACKET_QUEUE_SIZE, sizeof(vlc_packet_t));
+//packets dropped because the queue was full
+static uint32_t dropped_packets = 0;
+
 /**
  * format that is required by the high level commander
 */
@@ -74,15 +89,60 @@ static State state = s_uninited;
 static const float velMax = 0.2f;
 
 
-void VLC_motion_command_velocity_move(float move_dist_x, float move_dist_y, float move_dist_z){
-    if(state != s_locked){
-        DEBUG_PRINT("Execute velocity setpoint command \n");
-        float t_dist = (fabs(move_dist_x) + fabs(move_dist_y) + fabs(move_dist_z));
-        const float move_vel = 0.2;
+/**
+ * Moves relative to the current position at a constant velocity
+ * @return false if the system is locked or the move is too short to execute
+*/
+bool VLC_motion_command_velocity_move(float move_dist_x, float move_dist_y, float move_dist_z){
+    if(state == s_locked){
+        return false;
+    }
+    float t_dist = (fabsf(move_dist_x) + fabsf(move_dist_y) + fabsf(move_dist_z));
+    //a zero length move would give the high level commander a zero duration
+    if(t_dist < VLC_MINIMUM_MOVE_DISTANCE){
+        DEBUG_PRINT("Move too short, ignored \n");
+        return false;
+    }
+    DEBUG_PRINT("Execute velocity setpoint command \n");
+    const float move_vel = 0.2;
+    float duration = t_dist/move_vel;
+    if(duration < VLC_MINIMUM_MOVE_DURATION){
+        duration = VLC_MINIMUM_MOVE_DURATION;
+    }
 
-        crtpCommanderHighLevelGoTo(move_dist_x, move_dist_y, move_dist_z, 0, t_dist/move_vel, true);
+    move_duration_ms = (uint32_t)(duration * 1000.0f);
+    crtpCommanderHighLevelGoTo(move_dist_x, move_dist_y, move_dist_z, 0, duration, true);
+    return true;
+}
+
+uint32_t vlc_motion_commander_move_duration_ms(){
+    return move_duration_ms;
+}
 
+/**
+ * Moves relative to the current position with the setpoint in a goto packet
+ * @param packet vlc_packet_type_goto packet: x, y, z int16 in mm
+ * @return true if the move was sent to the high level commander
+*/
+bool VLC_motion_command_goto(const vlc_packet_t* packet){
+    if(packet->length < 6){
+        DEBUG_PRINT("Goto packet too short \n");
+        return false;
+    }
+    float setpoint_mm[3];
+    for (int i = 0; i < 3; i++)
+    {
+        int16_t value = (int16_t)((uint16_t)packet->payload[2*i] | ((uint16_t)packet->payload[(2*i) + 1] << 8));
+        setpoint_mm[i] = (float)value;
+    }
+    DEBUG_PRINT("Goto x:%d y:%d z:%d mm \n", (int)setpoint_mm[0], (int)setpoint_mm[1], (int)setpoint_mm[2]);
+    if(VLC_motion_command_velocity_move(setpoint_mm[0] / 1000.0f, setpoint_mm[1] / 1000.0f, setpoint_mm[2] / 1000.0f)){
+        //set the last recieved motion command param.
+        //this will be used by the particle filter motion model
+        paramSetInt(id_new_command_param, c_goto);
+        return true;
     }
+    return false;
 }
 
 void VLC_motion_command_take_off(float move_dist_z){
@@ -289,9 +349,48 @@ void vlc_motion_commander_parce_command_byte(uint8_t command){
     last_recieved_command = command;
 }
 
+bool vlc_motion_commander_enqueue_packet(const vlc_packet_t* packet){
+    if(packetQueue == NULL){
+        return false;
+    }
+    if(xQueueSend(packetQueue, packet, 0) != pdTRUE){
+        dropped_packets++;
+        return false;
+    }
+    if(packet->type == vlc_packet_type_command && packet->length > 0){
+        last_recieved_command = packet->payload[0];
+    }
+    return true;
+}
+
+/**
+ * Starts executing a command taken from the command buffer or a packet
+*/
+static void VLC_motion_commander_start_command(FlightCommand command, FlightCommand* current_command, uint32_t* command_start_time, uint32_t* command_duration, uint32_t sys_time_ms){
+    //if we recieve the end motion controll command we lock the sytem and return
+    if(command == c_VLC_FLIGHT_DISABLE){
+        lock_VLC_motion_command();
+        return;
+    }
+    //save the current command
+    *current_command = command;
+    //save the start time of the command
+    *command_start_time = sys_time_ms;
+    *command_duration = VLC_COMMAND_DURATION;
+    //update the system state
+    if (command == c_idle){
+        state = s_idle;
+    }else{
+        state = s_moving;
+    }
+    //start executing this command;
+    _VLC_flight_commander(command);
+}
+
 void VLC_motion_commander_init(){
     //initialise buffer
     cbuf_commands = circular_buf_init(buffer_command, COMMAND_BUFFER_SIZE, cbuf_commands);
+    packetQueue = STATIC_MEM_QUEUE_CREATE(packetQueue);
     //link the last recieved command param 
     id_new_command_param = paramGetVarId("ring", "solidBlue");
     //we set it right away because default is like 20 or something
@@ -334,15 +433,20 @@ void VLC_motion_commander_update(uint32_t sys_time_ms){
         */
 
         static uint32_t command_start_time = 0;
+        static uint32_t command_duration = VLC_COMMAND_DURATION;
         static FlightCommand current_command = c_idle;
+        vlc_packet_t packet;
 
         if(state != s_locked){ //not locked
 
             //we are executing a command if this is the case
             //for fixed duration and if we are moving. non moving commands can overwrite this statement
-            if((command_start_time + VLC_COMMAND_DURATION > sys_time_ms) && (state == s_moving)){
-                _VLC_flight_commander(current_command);
-                DEBUG_PRINT("Continuing executing current command: ");
+            if((command_start_time + command_duration > sys_time_ms) && (state == s_moving)){
+                //a goto is sent once, the high level commander is still flying it
+                if(current_command != c_goto){
+                    _VLC_flight_commander(current_command);
+                    DEBUG_PRINT("Continuing executing current command: ");
+                }
                 return;
             }
             //recieve new command from buffer if there is a new command
@@ -351,26 +455,28 @@ void VLC_motion_commander_update(uint32_t sys_time_ms){
                 //read from the ciruclar buffer
                 uint16_t temp;
                 circular_buf_get(cbuf_commands, &temp);
-
-                //if we recieve the end motion controll command we lock the sytem and return
-                if((FlightCommand)temp == c_VLC_FLIGHT_DISABLE){
-                    lock_VLC_motion_command();
-                    return;
-                }
-                //save the current command
-                current_command = (FlightCommand)temp;
-                //save the start time of the command
-                command_start_time = sys_time_ms;
-                //update the system state
-                if (current_command == c_idle){
-                    state = s_idle;
-                
+                VLC_motion_commander_start_command((FlightCommand)temp, &current_command, &command_start_time, &command_duration, sys_time_ms);
+                //end of this cycle
+                return;
+            }
+            //recieve new packet from the queue if there is one
+            else if(xQueueReceive(packetQueue, &packet, 0) == pdTRUE){
+                if(packet.type == vlc_packet_type_command && packet.length > 0){
+                    VLC_motion_commander_start_command((FlightCommand)packet.payload[0], &current_command, &command_start_time, &command_duration, sys_time_ms);
+                }else if(packet.type == vlc_packet_type_goto){
+                    //the high level commander moves to the setpoint, we only send it once and are busy until it has arrived
+                    if(VLC_motion_command_goto(&packet)){
+                        current_command = c_goto;
+                        command_start_time = sys_time_ms;
+                        command_duration = move_duration_ms;
+                        state = s_moving;
+                    }else{
+                        current_command = c_idle;
+                        state = s_idle;
+                    }
                 }else{
-                    state = s_moving;
+                    DEBUG_PRINT("Packet type not in use \n");
                 }
-                //start executing this command;
-                _VLC_flight_commander(current_command);
-                //end of this cycle
                 return;
             //no new command we remain idle
             }else{
@@ -390,10 +496,20 @@ void VLC_motion_commander_update(uint32_t sys_time_ms){
                 }
                 DEBUG_PRINT("Removing command form command buffer cause system is locked. \n");
             }
+            //same for the packets, only the enable command is executed
+            while(xQueueReceive(packetQueue, &packet, 0) == pdTRUE){
+                if(packet.type == vlc_packet_type_command && packet.length > 0 && (FlightCommand)packet.payload[0] == c_VLC_FLIGHT_ENABLE){
+                    unlock_VLC_motion_command();
+                    return;
+                }
+                DEBUG_PRINT("Removing packet form packet queue cause system is locked. \n");
+            }
         }
     }
 }
 
 LOG_GROUP_START(vlc_cmd)
                 LOG_ADD_CORE(LOG_UINT8, lrc, &last_recieved_command)
+                //packets dropped because the packet queue was full
+                LOG_ADD_CORE(LOG_UINT32, pktDrop, &dropped_packets)
 LOG_GROUP_STOP(vlc_cmd)
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <string.h>
 #include <stdbool.h>
 
+//framed VLC packets
+#include "vlc_packet.h"
 
 /*
     TAKE_OFF = 1 #this is enable vlc in vlc mode
@@ -32,7 +34,9 @@ typedef enum {
     c_PF_ENABLE = 11,
     c_PF_DISABLE = 12,
     c_VLC_FLIGHT_ENABLE = 1,
-    c_VLC_FLIGHT_DISABLE = 2
+    c_VLC_FLIGHT_DISABLE = 2,
+    //relative move from a goto packet, only published to the motion model
+    c_goto = 15
 
 } FlightCommand;
 
@@ -40,6 +44,18 @@ typedef enum {
 
 void vlc_motion_commander_parce_command_byte(uint8_t command);
 
+/**
+ * Places a recieved VLC packet in the packet queue, the packets are executed in order by VLC_motion_commander_update.
+ * Can be called from another task.
+ * @return false if the queue is full and the packet has been dropped
+ */
+bool vlc_motion_commander_enqueue_packet(const vlc_packet_t* packet);
+
+/**
+ * @return the duration of the last move sent to the high level commander (ms)
+ */
+uint32_t vlc_motion_commander_move_duration_ms();
+
 
 void VLC_motion_commander_update(uint32_t sys_time_ms);
 void VLC_motion_commander_init();
@@ -56,6 +56,7 @@ typedef enum {
   MeasurementTypeGyroscope,
   MeasurementTypeAcceleration,
   MeasurementTypeBarometer,
+  MeasurementTypeParticleFilter,
 } MeasurementType;
 
 typedef struct
@@ -75,6 +76,7 @@ typedef struct
     gyroscopeMeasurement_t gyroscope;
     accelerationMeasurement_t acceleration;
     barometerMeasurement_t barometer;
+    particleFilterMeasurement_t particleFilter;
   } data;
 } measurement_t;
 
@@ -161,6 +163,14 @@ static inline void estimatorEnqueueSweepAngles(const sweepAngleMeasurement_t *sw
   estimatorEnqueue(&m);
 }
 
+static inline void estimatorEnqueueParticleFilter(const particleFilterMeasurement_t *particleFilter)
+{
+  measurement_t m;
+  m.type = MeasurementTypeParticleFilter;
+  m.data.particleFilter = *particleFilter;
+  estimatorEnqueue(&m);
+}
+
 // Helper function for state estimators
 bool estimatorDequeue(measurement_t *measurement);
 
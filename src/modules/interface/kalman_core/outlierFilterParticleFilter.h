@@ -0,0 +1,45 @@
+/**
+ *    ||          ____  _ __
+ * +------+      / __ )(_) /_______________ _____  ___
+ * | 0xBC |     / __  / / __/ ___/ ___/ __ `/_  / / _ \
+ * +------+    / /_/ / / /_/ /__/ /  / /_/ / / /_/  __/
+ *  ||  ||    /_____/_/\__/\___/_/   \__,_/ /___/\___/
+ *
+ * Copyright (C) 2011-2023 Bitcraze AB
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, in version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Outlier rejection filter for the particle filter position measurements
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    uint32_t openingTimeMs;
+    int32_t openingWindowMs;
+} OutlierFilterPfState_t;
+
+/**
+ * @brief Validate a particle filter position against the state estimate
+ *
+ * @param this  The filter state
+ * @param mahalanobisSquared  Squared Mahalanobis distance of the innovation, using the innovation covariance
+ * @param dimensions  Number of measured axes (1 - 3)
+ * @param nowMs  Current time
+ * @return true if the measurement should be used
+ */
+bool outlierFilterParticleFilterValidate(OutlierFilterPfState_t* this, const float mahalanobisSquared, const int dimensions, const uint32_t nowMs);
+void outlierFilterParticleFilterReset(OutlierFilterPfState_t* this, const uint32_t nowMs);
@@ -42,6 +42,7 @@ typedef enum {
   MEM_TYPE_LEDMEM   = 0x17,
   MEM_TYPE_APP      = 0x18,
   MEM_TYPE_DECK_MEM = 0x19,
+  MEM_TYPE_COLOR_MAP = 0x1A,
 } MemoryType_t;
 
 #define MEMORY_SERIAL_LENGTH 8
@@ -352,6 +352,20 @@ typedef struct
   baro_t baro; // for legacy reasons
 } barometerMeasurement_t;
 
+/** Position estimate of a particle filter */
+typedef struct particleFilterMeasurement_s {
+  union {
+    struct {
+      float x;
+      float y;
+      float z;
+    };
+    float pos[3];           // m
+  };
+  // m^2, covariance of the particle cloud, in the order xx, yy, zz, xy, xz, yz. Axes with a variance <= 0 are not measured
+  float cov[6];
+} particleFilterMeasurement_t;
+
 
 // Frequencies to bo used with the RATE_DO_EXECUTE_HZ macro. Do NOT use an arbitrary number.
 #define RATE_1000_HZ 1000
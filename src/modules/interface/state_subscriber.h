@@ -0,0 +1,90 @@
+/**
+ * ,---------,       ____  _ __
+ * |  ,-^-,  |      / __ )(_) /_______________ _____  ___
+ * | (  O  ) |     / __  / / __/ ___/ ___/ __ `/_  / / _ \
+ * | / ,--´  |    / /_/ / / /_/ /__/ /  / /_/ / / /_/  __/
+ *    +------`   /_____/_/\__/\___/_/   \__,_/ /___/\___/
+ *
+ * Crazyflie control firmware
+ *
+ * Copyright (C) 2023 Bitcraze AB
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, in version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * state_subscriber.h - Delivers the IMU and state estimate samples of the
+ * stabilizer loop to other tasks.
+ *
+ * A subscriber registers a queue and a rate, the stabilizer loop pushes a
+ * time stamped sample on the queue every 1000/rate ticks after the state
+ * estimate has been updated. The subscriber reads the samples in batches at its
+ * own pace, so no sample is missed or read twice as happens when a log
+ * variable is polled. When the queue is full the sample is dropped and counted.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+
+#include "imu_types.h"
+#include "stabilizer_types.h"
+
+#define STATE_SUBSCRIBER_MAX_SUBSCRIBERS 4
+
+typedef struct {
+  uint64_t timestamp;       // usec, interrupt time of the IMU sample
+  Axis3f gyro;              // deg/s, body frame
+  Axis3f acc;               // Gs, state estimate (same as stateEstimate.ax/ay/az)
+  attitude_t attitude;      // deg (same as stateEstimate.roll/pitch/yaw)
+} stateSample_t;
+
+typedef struct {
+  QueueHandle_t queue;
+  uint16_t rate;            // Hz, has to be one of the RATE_x_HZ of stabilizer_types.h
+  uint32_t droppedCount;
+} stateSubscription_t;
+
+/**
+ * @brief Register a subscription. The subscription has to stay valid, there is no unregister.
+ *
+ * @param subscription  Subscription, its queue has to hold stateSample_t items
+ * @param queue  Queue the samples are pushed on
+ * @param rate  Sample rate (Hz)
+ * @return true if the subscription was registered
+ */
+bool stateSubscriberRegister(stateSubscription_t* subscription, QueueHandle_t queue, uint16_t rate);
+
+/**
+ * @brief Called by the stabilizer loop after the state estimate is updated
+ */
+void stateSubscriberPublish(const sensorData_t* sensorData, const state_t* state, uint32_t tick);
+
+/**
+ * @brief Read the queued samples, oldest first, without blocking
+ *
+ * @param subscription  The subscription
+ * @param samples  Buffer for the samples
+ * @param maxCount  Size of the buffer
+ * @return uint32_t  Number of samples read
+ */
+uint32_t stateSubscriberRead(stateSubscription_t* subscription, stateSample_t* samples, uint32_t maxCount);
+
+#ifdef UNIT_TEST_MODE
+/**
+ * @brief Reset function for unit testing
+ */
+void stateSubscriberReset();
+#endif
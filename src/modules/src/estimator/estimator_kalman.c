@@ -88,6 +88,7 @@
 #include "mm_tof.h"
 #include "mm_yaw_error.h"
 #include "mm_sweep_angles.h"
+#include "mm_particle_filter.h"
 
 #include "mm_tdoa_robust.h"
 #include "mm_distance_robust.h"
@@ -148,6 +149,7 @@ static Axis3f gyroLatest;
 
 static OutlierFilterTdoaState_t outlierFilterTdoaState;
 static OutlierFilterLhState_t sweepOutlierFilterState;
+static OutlierFilterPfState_t particleFilterOutlierFilterState;
 
 
 // Indicates that the internal state is corrupt and should be reset
@@ -347,6 +349,9 @@ static void updateQueuedMeasurements(const uint32_t nowMs, const bool quadIsFlyi
           kalmanCoreUpdateWithBaro(&coreData, &coreParams, m.data.barometer.baro.asl, quadIsFlying);
         }
         break;
+      case MeasurementTypeParticleFilter:
+        kalmanCoreUpdateWithParticleFilter(&coreData, &m.data.particleFilter, nowMs, &particleFilterOutlierFilterState);
+        break;
       default:
         break;
     }
@@ -361,6 +366,7 @@ void estimatorKalmanInit(void)
 
   outlierFilterTdoaReset(&outlierFilterTdoaState);
   outlierFilterLighthouseReset(&sweepOutlierFilterState, 0);
+  outlierFilterParticleFilterReset(&particleFilterOutlierFilterState, 0);
 
   uint32_t nowMs = T2M(xTaskGetTickCount());
   kalmanCoreInit(&coreData, &coreParams, nowMs);
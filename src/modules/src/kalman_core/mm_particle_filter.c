@@ -0,0 +1,135 @@
+/**
+ * ,---------,       ____  _ __
+ * |  ,-^-,  |      / __ )(_) /_______________ _____  ___
+ * | (  O  ) |     / __  / / __/ ___/ ___/ __ `/_  / / _ \
+ * | / ,--'  |    / /_/ / / /_/ /__/ /  / /_/ / / /_/  __/
+ *    +------`   /_____/_/\__/\___/_/   \__,_/ /___/\___/
+ *
+ * Crazyflie control firmware
+ *
+ * Copyright (C) 2021 Bitcraze AB
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, in version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "mm_particle_filter.h"
+
+// Index of the covariance entry of two axes in particleFilterMeasurement_t.cov
+static const uint8_t covIndex[3][3] = {
+  {0, 3, 4},
+  {3, 1, 5},
+  {4, 5, 2},
+};
+
+// Cholesky decomposition A = L * L^T of a symmetric positive definite n x n matrix (n <= 3)
+static bool cholesky(const float A[3][3], float L[3][3], const int n) {
+  for (int r = 0; r < n; r++) {
+    for (int c = 0; c <= r; c++) {
+      float sum = A[r][c];
+      for (int k = 0; k < c; k++) {
+        sum -= L[r][k] * L[c][k];
+      }
+      if (r == c) {
+        if (sum <= 0.0f) {
+          return false;
+        }
+        L[r][r] = arm_sqrt(sum);
+      } else {
+        L[r][c] = sum / L[c][c];
+      }
+    }
+  }
+  return true;
+}
+
+// Solves L * x = b for a lower triangular L
+static void forwardSubstitution(const float L[3][3], const float b[3], float x[3], const int n) {
+  for (int r = 0; r < n; r++) {
+    float sum = b[r];
+    for (int k = 0; k < r; k++) {
+      sum -= L[r][k] * x[k];
+    }
+    x[r] = sum / L[r][r];
+  }
+}
+
+void kalmanCoreUpdateWithParticleFilter(kalmanCoreData_t* this, const particleFilterMeasurement_t* pf, const uint32_t nowMs, OutlierFilterPfState_t* outlierFilterState)
+{
+  // The measured axes
+  int axes[3];
+  int n = 0;
+  for (int i = 0; i < 3; i++) {
+    if (pf->cov[i] > 0.0f) {
+      axes[n++] = i;
+    }
+  }
+  if (n == 0) {
+    return;
+  }
+
+  float R[3][3] = {0};
+  float S[3][3] = {0};
+  float error[3];
+  for (int r = 0; r < n; r++) {
+    for (int c = 0; c < n; c++) {
+      R[r][c] = pf->cov[covIndex[axes[r]][axes[c]]];
+      S[r][c] = R[r][c] + this->P[KC_STATE_X + axes[r]][KC_STATE_X + axes[c]];
+    }
+    error[r] = pf->pos[axes[r]] - this->S[KC_STATE_X + axes[r]];
+  }
+
+  // Gate on the Mahalanobis distance of the innovation, e^T * S^-1 * e = |Ls^-1 * e|^2 with S = Ls * Ls^T
+  float Ls[3][3] = {0};
+  if (!cholesky(S, Ls, n)) {
+    return;
+  }
+  float w[3];
+  forwardSubstitution(Ls, error, w, n);
+  float mahalanobisSquared = 0.0f;
+  for (int i = 0; i < n; i++) {
+    mahalanobisSquared += w[i] * w[i];
+  }
+  if (!outlierFilterParticleFilterValidate(outlierFilterState, mahalanobisSquared, n, nowMs)) {
+    return;
+  }
+
+  // The axes of the particle cloud are correlated. With R = Lr * Lr^T the whitened measurement Lr^-1 * pos
+  // has independent axes with unit variance, so every axis can be a scalar update
+  float Lr[3][3] = {0};
+  if (!cholesky(R, Lr, n)) {
+    return;
+  }
+  float LrInv[3][3] = {0};
+  for (int c = 0; c < n; c++) {
+    float unit[3] = {0};
+    float column[3];
+    unit[c] = 1.0f;
+    forwardSubstitution(Lr, unit, column, n);
+    for (int r = 0; r < n; r++) {
+      LrInv[r][c] = column[r];
+    }
+  }
+
+  for (int i = 0; i < n; i++) {
+    float h[KC_STATE_DIM] = {0};
+    arm_matrix_instance_f32 H = {1, KC_STATE_DIM, h};
+    float whitenedError = 0.0f;
+    for (int j = 0; j <= i; j++) {
+      h[KC_STATE_X + axes[j]] = LrInv[i][j];
+      // the state has changed by the previous updates
+      whitenedError += LrInv[i][j] * (pf->pos[axes[j]] - this->S[KC_STATE_X + axes[j]]);
+    }
+    kalmanCoreScalarUpdate(this, &H, whitenedError, 1.0f);
+  }
+}
@@ -0,0 +1,73 @@
+/**
+ *    ||          ____  _ __
+ * +------+      / __ )(_) /_______________ _____  ___
+ * | 0xBC |     / __  / / __/ ___/ ___/ __ `/_  / / _ \
+ * +------+    / /_/ / / /_/ /__/ /  / /_/ / / /_/  __/
+ *  ||  ||    /_____/_/\__/\___/_/   \__,_/ /___/\___/
+ *
+ * Crazyflie control firmware
+ *
+ * Copyright (C) 2011-2023 Bitcraze AB
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, in version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * outlierFilterParticleFilter.c: Outlier rejection filter for the particle filter
+ * position measurements. Uses the same opening window as the Lighthouse filter,
+ * but a sample is good when its innovation is inside a chi-square gate.
+ */
+
+#include "outlierFilterParticleFilter.h"
+
+// The particle filter publishes its position about every 200 ms
+#define PF_MS_PER_UPDATE 200
+static const int32_t pfMinWindowTimeMs = -2 * PF_MS_PER_UPDATE;
+static const int32_t pfMaxWindowTimeMs = 5 * PF_MS_PER_UPDATE;
+static const int32_t pfBadSampleWindowChangeMs = -PF_MS_PER_UPDATE;
+static const int32_t pfGoodSampleWindowChangeMs = PF_MS_PER_UPDATE / 2;
+
+// 99.9% quantile of the chi-square distribution with 1, 2 and 3 degrees of freedom
+static const float pfMaxMahalanobisSquared[3] = {10.83f, 13.82f, 16.27f};
+
+void outlierFilterParticleFilterReset(OutlierFilterPfState_t* this, const uint32_t nowMs) {
+  this->openingTimeMs = nowMs;
+  this->openingWindowMs = pfMinWindowTimeMs;
+}
+
+bool outlierFilterParticleFilterValidate(OutlierFilterPfState_t* this, const float mahalanobisSquared, const int dimensions, const uint32_t nowMs) {
+  if (dimensions < 1 || dimensions > 3) {
+    return false;
+  }
+
+  bool isGoodSample = (mahalanobisSquared < pfMaxMahalanobisSquared[dimensions - 1]);
+  if (isGoodSample) {
+    this->openingWindowMs += pfGoodSampleWindowChangeMs;
+    if (this->openingWindowMs > pfMaxWindowTimeMs) {
+      this->openingWindowMs = pfMaxWindowTimeMs;
+    }
+  } else {
+    this->openingWindowMs += pfBadSampleWindowChangeMs;
+    if (this->openingWindowMs < pfMinWindowTimeMs) {
+      this->openingWindowMs = pfMinWindowTimeMs;
+    }
+  }
+
+  bool result = true;
+  bool isFilterClosed = (nowMs < this->openingTimeMs);
+  if (isFilterClosed) {
+    result = isGoodSample;
+  }
+
+  this->openingTimeMs = nowMs + this->openingWindowMs;
+
+  return result;
+}
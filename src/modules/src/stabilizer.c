@@ -51,6 +51,7 @@
 #include "supervisor.h"
 
 #include "estimator.h"
+#include "state_subscriber.h"
 #include "usddeck.h"
 #include "quatcompress.h"
 #include "statsCnt.h"
@@ -283,6 +284,7 @@ static void stabilizerTask(void* param)
 
       stateEstimator(&state, tick);
       compressState();
+      stateSubscriberPublish(&sensorData, &state, tick);
 
       if (crtpCommanderHighLevelGetSetpoint(&tempSetpoint, &state, tick)) {
         commanderSetSetpoint(&tempSetpoint, COMMANDER_PRIORITY_HIGHLEVEL);
@@ -0,0 +1,98 @@
+/**
+ * ,---------,       ____  _ __
+ * |  ,-^-,  |      / __ )(_) /_______________ _____  ___
+ * | (  O  ) |     / __  / / __/ ___/ ___/ __ `/_  / / _ \
+ * | / ,--´  |    / /_/ / / /_/ /__/ /  / /_/ / / /_/  __/
+ *    +------`   /_____/_/\__/\___/_/   \__,_/ /___/\___/
+ *
+ * Crazyflie control firmware
+ *
+ * Copyright (C) 2023 Bitcraze AB
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, in version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * state_subscriber.c - Delivers the IMU and state estimate samples of the
+ * stabilizer loop to other tasks.
+ */
+
+#include <stddef.h>
+
+#include "state_subscriber.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "stabilizer_types.h"
+
+static stateSubscription_t* subscriptions[STATE_SUBSCRIBER_MAX_SUBSCRIBERS];
+static volatile uint32_t subscriptionCount = 0;
+
+#ifdef UNIT_TEST_MODE
+void stateSubscriberReset() {
+  subscriptionCount = 0;
+}
+#endif
+
+bool stateSubscriberRegister(stateSubscription_t* subscription, QueueHandle_t queue, uint16_t rate) {
+  if (queue == NULL || rate == 0 || rate > RATE_MAIN_LOOP) {
+    return false;
+  }
+
+  subscription->queue = queue;
+  subscription->rate = rate;
+  subscription->droppedCount = 0;
+
+  // Tasks registering at the same time must not get the same slot
+  taskENTER_CRITICAL();
+  const uint32_t count = subscriptionCount;
+  if (count >= STATE_SUBSCRIBER_MAX_SUBSCRIBERS) {
+    taskEXIT_CRITICAL();
+    return false;
+  }
+  // The stabilizer loop only reads the subscriptions below the count, fill the slot before it is counted
+  subscriptions[count] = subscription;
+  __atomic_store_n(&subscriptionCount, count + 1, __ATOMIC_RELEASE);
+  taskEXIT_CRITICAL();
+  return true;
+}
+
+void stateSubscriberPublish(const sensorData_t* sensorData, const state_t* state, uint32_t tick) {
+  const uint32_t count = __atomic_load_n(&subscriptionCount, __ATOMIC_ACQUIRE);
+  if (count == 0) {
+    return;
+  }
+
+  const stateSample_t sample = {
+    .timestamp = sensorData->interruptTimestamp,
+    .gyro = sensorData->gyro,
+    .acc = {.x = state->acc.x, .y = state->acc.y, .z = state->acc.z},
+    .attitude = state->attitude,
+  };
+
+  for (uint32_t i = 0; i < count; i++) {
+    stateSubscription_t* subscription = subscriptions[i];
+    if (RATE_DO_EXECUTE(subscription->rate, tick)) {
+      if (xQueueSend(subscription->queue, &sample, 0) != pdTRUE) {
+        subscription->droppedCount++;
+      }
+    }
+  }
+}
+
+uint32_t stateSubscriberRead(stateSubscription_t* subscription, stateSample_t* samples, uint32_t maxCount) {
+  uint32_t count = 0;
+  while (count < maxCount && xQueueReceive(subscription->queue, &samples[count], 0) == pdTRUE) {
+    count++;
+  }
+  return count;
+}
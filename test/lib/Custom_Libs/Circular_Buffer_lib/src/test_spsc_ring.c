@@ -0,0 +1,223 @@
+// File under test spsc_ring.c
+#include "spsc_ring.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sched.h>
+#include "unity.h"
+
+#define RING_SIZE 8
+#define NUM_OF_STREAMED_SAMPLES 200000
+
+static float buffer[RING_SIZE];
+static spsc_ring_f32_t ring;
+
+static void fill(uint32_t n, float first) {
+  for (uint32_t i = 0; i < n; i++) {
+    TEST_ASSERT_TRUE(spsc_ring_put(&ring, first + (float)i));
+  }
+}
+
+static void assertRead(uint32_t n, float first) {
+  float actual[RING_SIZE];
+  TEST_ASSERT_EQUAL_UINT32(n, spsc_ring_read(&ring, actual, n));
+  for (uint32_t i = 0; i < n; i++) {
+    TEST_ASSERT_EQUAL_FLOAT(first + (float)i, actual[i]);
+  }
+}
+
+void setUp(void) {
+  TEST_ASSERT_TRUE(spsc_ring_init(&ring, buffer, RING_SIZE));
+}
+
+void testThatInitRejectsASizeThatIsNotAPowerOf2() {
+  // Fixture
+  spsc_ring_f32_t other;
+
+  // Test
+  // Assert
+  TEST_ASSERT_FALSE(spsc_ring_init(&other, buffer, 6));
+  TEST_ASSERT_FALSE(spsc_ring_init(&other, buffer, 0));
+  TEST_ASSERT_FALSE(spsc_ring_init(&other, NULL, RING_SIZE));
+}
+
+void testThatAnEmptyRingReadsNothing() {
+  // Fixture
+  float actual[RING_SIZE];
+
+  // Test
+  uint32_t n = spsc_ring_read(&ring, actual, RING_SIZE);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT32(0, n);
+  TEST_ASSERT_EQUAL_UINT32(0, spsc_ring_count(&ring));
+}
+
+void testThatReadReturnsTheSamplesInOrder() {
+  // Fixture
+  fill(5, 1.0f);
+
+  // Test
+  // Assert
+  TEST_ASSERT_EQUAL_UINT32(5, spsc_ring_count(&ring));
+  assertRead(3, 1.0f);
+  TEST_ASSERT_EQUAL_UINT32(2, spsc_ring_count(&ring));
+  assertRead(2, 4.0f);
+  TEST_ASSERT_EQUAL_UINT32(0, spsc_ring_count(&ring));
+}
+
+void testThatReadIsLimitedToTheAvailableSamples() {
+  // Fixture
+  fill(3, 10.0f);
+  float actual[RING_SIZE];
+
+  // Test
+  uint32_t n = spsc_ring_read(&ring, actual, RING_SIZE);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT32(3, n);
+  TEST_ASSERT_EQUAL_FLOAT(12.0f, actual[2]);
+}
+
+void testThatAFullRingDropsAndCountsNewSamples() {
+  // Fixture
+  fill(RING_SIZE, 0.0f);
+
+  // Test
+  bool put = spsc_ring_put(&ring, 100.0f);
+  bool putAgain = spsc_ring_put(&ring, 101.0f);
+
+  // Assert
+  TEST_ASSERT_FALSE(put);
+  TEST_ASSERT_FALSE(putAgain);
+  TEST_ASSERT_EQUAL_UINT32(2, spsc_ring_overrun_count(&ring));
+  TEST_ASSERT_EQUAL_UINT32(RING_SIZE, ring.max_fill);
+  // the samples of the consumer are not overwritten
+  assertRead(RING_SIZE, 0.0f);
+}
+
+void testThatReadFreesSpaceForTheProducer() {
+  // Fixture
+  fill(RING_SIZE, 0.0f);
+  assertRead(2, 0.0f);
+
+  // Test
+  fill(2, 8.0f);
+
+  // Assert
+  TEST_ASSERT_FALSE(spsc_ring_put(&ring, 10.0f));
+  assertRead(RING_SIZE, 2.0f);
+}
+
+void testThatSamplesWrapAroundTheEndOfTheBuffer() {
+  for (uint32_t offset = 1; offset < RING_SIZE; offset++) {
+    // Fixture
+    spsc_ring_reset(&ring);
+    fill(offset, 0.0f);
+    assertRead(offset, 0.0f);
+
+    // Test
+    fill(RING_SIZE, 50.0f);
+
+    // Assert
+    assertRead(RING_SIZE, 50.0f);
+  }
+}
+
+void testThatTheFreeRunningIndicesWrapAround() {
+  // Fixture
+  // head and tail just below the overflow of the 32 bit counters
+  ring.head = UINT32_MAX - 2;
+  ring.tail = UINT32_MAX - 2;
+
+  // Test
+  fill(RING_SIZE, 20.0f);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT32(RING_SIZE, spsc_ring_count(&ring));
+  TEST_ASSERT_FALSE(spsc_ring_put(&ring, 0.0f));
+  assertRead(RING_SIZE, 20.0f);
+  TEST_ASSERT_EQUAL_UINT32(0, spsc_ring_count(&ring));
+}
+
+void testThatResetEmptiesTheRingAndTheCounters() {
+  // Fixture
+  fill(RING_SIZE, 0.0f);
+  spsc_ring_put(&ring, 0.0f);
+
+  // Test
+  spsc_ring_reset(&ring);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT32(0, spsc_ring_count(&ring));
+  TEST_ASSERT_EQUAL_UINT32(0, spsc_ring_overrun_count(&ring));
+  TEST_ASSERT_EQUAL_UINT32(0, ring.max_fill);
+}
+
+// The producer only publishes head after the sample is written (release) and the consumer only reads
+// the samples after it loaded head (acquire), a missing barrier shows up as a sample out of sequence
+static void* producer(void* arg) {
+  (void)arg;
+  for (uint32_t i = 0; i < NUM_OF_STREAMED_SAMPLES; i++) {
+    // a full ring waits for the consumer
+    while (!spsc_ring_put(&ring, (float)i)) {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+void testThatAConcurrentConsumerSeesEverySampleInOrder() {
+  // Fixture
+  pthread_t thread;
+  TEST_ASSERT_EQUAL_INT(0, pthread_create(&thread, NULL, producer, NULL));
+  uint32_t expected = 0;
+  bool inOrder = true;
+
+  // Test
+  while (expected < NUM_OF_STREAMED_SAMPLES) {
+    float samples[RING_SIZE];
+    uint32_t n = spsc_ring_read(&ring, samples, RING_SIZE);
+    if (n == 0) {
+      sched_yield();
+    }
+    for (uint32_t i = 0; i < n; i++) {
+      inOrder = inOrder && (samples[i] == (float)expected);
+      expected++;
+    }
+  }
+  pthread_join(thread, NULL);
+
+  // Assert
+  TEST_ASSERT_TRUE(inOrder);
+  TEST_ASSERT_EQUAL_UINT32(0, spsc_ring_count(&ring));
+  TEST_ASSERT_TRUE(ring.max_fill <= RING_SIZE);
+}
+
+void testThatThe16BitRingWrapsAndDropsLikeTheFloatRing() {
+  // Fixture
+  int16_t buffer16[RING_SIZE];
+  spsc_ring_i16_t ring16;
+  TEST_ASSERT_TRUE(spsc_ring_i16_init(&ring16, buffer16, RING_SIZE));
+  int16_t actual[RING_SIZE];
+  for (int16_t i = 0; i < 3; i++) {
+    spsc_ring_i16_put(&ring16, i);
+  }
+  spsc_ring_i16_read(&ring16, actual, 3);
+
+  // Test
+  for (int16_t i = 0; i < RING_SIZE + 1; i++) {
+    spsc_ring_i16_put(&ring16, (int16_t)(4095 - i));
+  }
+  uint32_t n = spsc_ring_i16_read(&ring16, actual, RING_SIZE);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT32(RING_SIZE, n);
+  TEST_ASSERT_EQUAL_UINT32(1, spsc_ring_i16_overrun_count(&ring16));
+  TEST_ASSERT_EQUAL_UINT32(RING_SIZE, ring16.max_fill);
+  for (int16_t i = 0; i < RING_SIZE; i++) {
+    TEST_ASSERT_EQUAL_INT16(4095 - i, actual[i]);
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, spsc_ring_i16_count(&ring16));
+}
@@ -0,0 +1,209 @@
+// File under test fsk_agc.c
+#include "fsk_agc.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "unity.h"
+
+#include "digital_filters.h"
+
+// Build the arm dsp math lib and use the "real thing" instead of mocking calls to it
+// @BUILD_LIB ARM_DSP_MATH
+
+#define N 64
+#define ALPHA 0.015f
+#define MARGIN 650.0f
+#define K 6.0f
+#define MIN_MARGIN 100.0f
+#define ADC_MEAN 2000.0f
+
+#define AGC_ALPHA 0.1f
+#define AGC_TARGET 256.0f
+#define AGC_MAX_GAIN 8.0f
+
+#define CFAR_RATIO 8.0f
+#define CFAR_MIN_POWER 1000.0f
+
+static FSK_spike_filter spikeFilter;
+static FSK_adaptive_spike_filter adaptiveFilter;
+static FSK_agc agc;
+static FSK_cfar cfar;
+
+// A 125 Hz tone at 2 kHz around the mean ADC value
+static float32_t tone(int i, float32_t amplitude) {
+  return ADC_MEAN + amplitude * sinf(2.0f * (float32_t)M_PI * 125.0f * (float32_t)i / 2000.0f);
+}
+
+static void settleAdaptiveFilter(float32_t amplitude) {
+  for (int i = 0; i < 4000; i++) {
+    FSK_adaptive_spike_filter_process(&adaptiveFilter, tone(i, amplitude));
+  }
+}
+
+void setUp(void) {
+  FSK_spike_filter_init(&spikeFilter, ALPHA, MARGIN, ADC_MEAN);
+  FSK_adaptive_spike_filter_init(&adaptiveFilter, ALPHA, K, MIN_MARGIN, MARGIN);
+  FSK_agc_init(&agc, AGC_ALPHA, AGC_TARGET, AGC_MAX_GAIN);
+  FSK_cfar_init(&cfar, 3, 0.5f, CFAR_RATIO, CFAR_MIN_POWER);
+}
+
+void testThatSpikeFilterPassesSamplesWithinTheMargin() {
+  // Fixture
+  const float32_t x = ADC_MEAN + 300.0f;
+
+  // Test
+  float32_t actual = FSK_spike_filter_process(&spikeFilter, x);
+
+  // Assert
+  TEST_ASSERT_EQUAL_FLOAT(x, actual);
+  TEST_ASSERT_EQUAL_FLOAT(low_pass_EWMA_f32(x, ADC_MEAN, ALPHA), spikeFilter.mean);
+}
+
+void testThatSpikeFilterReplacesASpikeByTheMean() {
+  // Fixture
+  const float32_t x = ADC_MEAN + 1500.0f;
+
+  // Test
+  float32_t actual = FSK_spike_filter_process(&spikeFilter, x);
+
+  // Assert
+  // the mean already includes the spike
+  TEST_ASSERT_EQUAL_FLOAT(spikeFilter.mean, actual);
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, ADC_MEAN + ALPHA * 1500.0f, actual);
+}
+
+void testThatAdaptiveMarginFollowsTheDeviationOfTheSignal() {
+  // Fixture
+  // the mean absolute deviation of a sine is 2/pi of its amplitude
+  const float32_t amplitude = 100.0f;
+  const float32_t expected = K * amplitude * 2.0f / (float32_t)M_PI;
+
+  // Test
+  settleAdaptiveFilter(amplitude);
+
+  // Assert
+  TEST_ASSERT_FLOAT_WITHIN(0.1f * expected, expected, FSK_adaptive_spike_filter_margin(&adaptiveFilter));
+  TEST_ASSERT_FLOAT_WITHIN(5.0f, ADC_MEAN, adaptiveFilter.spike.mean);
+}
+
+void testThatAdaptiveMarginDoesNotDropBelowTheMinimum() {
+  // Fixture
+  const float32_t amplitude = 1.0f;
+
+  // Test
+  settleAdaptiveFilter(amplitude);
+
+  // Assert
+  TEST_ASSERT_EQUAL_FLOAT(MIN_MARGIN, FSK_adaptive_spike_filter_margin(&adaptiveFilter));
+}
+
+void testThatAdaptiveFilterRemovesSpikesWithoutWideningTheMargin() {
+  // Fixture
+  settleAdaptiveFilter(100.0f);
+  const float32_t margin = FSK_adaptive_spike_filter_margin(&adaptiveFilter);
+  int removed = 0;
+
+  // Test
+  // a spike of 1000 counts every 64 samples, the mean still follows the spikes like the fixed filter
+  for (int i = 0; i < 64 * 50; i++) {
+    float32_t x = tone(i, 100.0f) + ((i % 64 == 0) ? 1000.0f : 0.0f);
+    float32_t y = FSK_adaptive_spike_filter_process(&adaptiveFilter, x);
+    if ((i % 64 == 0) && (y < ADC_MEAN + 200.0f)) {
+      removed++;
+    }
+  }
+
+  // Assert
+  TEST_ASSERT_EQUAL_INT(50, removed);
+  TEST_ASSERT_FLOAT_WITHIN(0.1f * margin, margin, FSK_adaptive_spike_filter_margin(&adaptiveFilter));
+}
+
+void testThatAgcScalesWindowsToTheTarget() {
+  // Fixture
+  float32_t window[N];
+  const float32_t amplitude = 50.0f;
+
+  // Test
+  for (int w = 0; w < 100; w++) {
+    for (int i = 0; i < N; i++) {
+      window[i] = tone(i, amplitude);
+    }
+    FSK_agc_process(&agc, window, N);
+  }
+
+  // Assert
+  float32_t std;
+  arm_std_f32(window, N, &std);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f * AGC_TARGET, AGC_TARGET, std);
+}
+
+void testThatAgcGainIsLimited() {
+  // Fixture
+  float32_t window[N];
+
+  // Test
+  for (int w = 0; w < 100; w++) {
+    for (int i = 0; i < N; i++) {
+      window[i] = tone(i, 1.0f);
+    }
+    FSK_agc_process(&agc, window, N);
+  }
+
+  // Assert
+  TEST_ASSERT_EQUAL_FLOAT(AGC_MAX_GAIN, agc.gain);
+}
+
+void testThatCfarDetectsAToneAboveTheNoiseOfItsBin() {
+  // Fixture
+  // bins: f0, f1, noise reference
+  const float32_t power[] = {CFAR_RATIO * CFAR_MIN_POWER, 10.0f, 10.0f};
+  uint16_t detected = 0;
+
+  // Test
+  uint16_t actual = FSK_cfar_detect_pair(&cfar, power, 0, 1, 2, 125, 156, &detected);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT16(125, actual);
+  TEST_ASSERT_EQUAL_UINT16(0x01, detected);
+}
+
+void testThatCfarRejectsAToneBelowTheRatio() {
+  // Fixture
+  const float32_t power[] = {10.0f, 0.9f * CFAR_RATIO * CFAR_MIN_POWER, 10.0f};
+  uint16_t detected = 0;
+
+  // Test
+  uint16_t actual = FSK_cfar_detect_pair(&cfar, power, 0, 1, 2, 125, 156, &detected);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT16(0, actual);
+  TEST_ASSERT_EQUAL_UINT16(0, detected);
+}
+
+void testThatCfarRejectsAToneAsStrongAsTheNoiseReference() {
+  // Fixture
+  const float32_t power[] = {10.0f, 20000.0f, 20000.0f};
+  uint16_t detected = 0;
+
+  // Test
+  uint16_t actual = FSK_cfar_detect_pair(&cfar, power, 0, 1, 2, 125, 156, &detected);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT16(0, actual);
+}
+
+void testThatCfarNoiseOnlyFollowsBinsWithoutATone() {
+  // Fixture
+  const float32_t power[] = {50000.0f, 3000.0f, 3000.0f};
+  uint16_t detected = 0;
+  FSK_cfar_detect_pair(&cfar, power, 0, 1, 2, 125, 156, &detected);
+
+  // Test
+  FSK_cfar_update(&cfar, power, detected);
+
+  // Assert
+  TEST_ASSERT_EQUAL_FLOAT(CFAR_MIN_POWER, cfar.noise[0]);
+  TEST_ASSERT_EQUAL_FLOAT(low_pass_EWMA_f32(3000.0f, CFAR_MIN_POWER, 0.5f), cfar.noise[1]);
+  TEST_ASSERT_EQUAL_FLOAT(low_pass_EWMA_f32(3000.0f, CFAR_MIN_POWER, 0.5f), cfar.noise[2]);
+}
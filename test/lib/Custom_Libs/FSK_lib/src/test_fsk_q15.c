@@ -0,0 +1,150 @@
+// File under test fsk_q15.c
+#include "fsk_q15.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "unity.h"
+
+// The float spike filter and goertzel detector of the FSK task are the reference
+#include "fsk_goertzel.h"
+#include "fsk_agc.h"
+#include "digital_filters.h"
+
+// Build the arm dsp math lib and use the "real thing" instead of mocking calls to it
+// @BUILD_LIB ARM_DSP_MATH
+
+#define N 64
+#define FS 2000
+#define F0 125
+#define F1 156
+#define F_NOISE 219
+#define NOISE_FLOOR 400.0f
+#define ALPHA 0.015f
+#define MARGIN 650.0f
+
+// 1 ADC count is 16 LSB of a q15 sample
+#define COUNTS_TO_Q15 16.0f
+
+static FSK_q15_spike_filter filter;
+static FSK_q15_detector detector;
+static FSK_goertzel goertzel;
+static FSK_spike_filter reference;
+
+// The float chain removes the spikes by replacing them with the mean, the q15 chain also removes the mean
+static float32_t referenceFilter(float32_t x) {
+  float32_t filtered = FSK_spike_filter_process(&reference, x);
+  return filtered - reference.mean;
+}
+
+static uint32_t seed;
+static int32_t noise(int32_t amplitude) {
+  seed = seed * 1664525u + 1013904223u;
+  return (int32_t)((seed >> 16) % (2 * amplitude + 1)) - amplitude;
+}
+
+static uint16_t adcSample(uint32_t n, uint16_t frequency, float32_t amplitude, int32_t noiseAmplitude) {
+  float32_t tone = amplitude * sinf(2.0f * PI * frequency * n / FS + 0.3f);
+  return (uint16_t)(2048 + (int32_t)tone + noise(noiseAmplitude));
+}
+
+// Runs a window through both chains
+static void filterWindow(uint32_t start, uint16_t frequency, float32_t amplitude, int32_t noiseAmplitude,
+                         q15_t fixedOut[], float32_t floatOut[]) {
+  for (uint32_t i = 0; i < N; i++) {
+    uint16_t adc = adcSample(start + i, frequency, amplitude, noiseAmplitude);
+    fixedOut[i] = FSK_q15_spike_filter_process(&filter, adc);
+    floatOut[i] = referenceFilter((float32_t)adc);
+  }
+}
+
+void setUp(void) {
+  seed = 12345;
+  FSK_spike_filter_init(&reference, ALPHA, MARGIN, 2048.0f);
+  FSK_q15_spike_filter_init(&filter, ALPHA, MARGIN, 2048.0f);
+  FSK_q15_detector_init(&detector, F0, F1, F_NOISE, FS, N);
+  FSK_goertzel_init(&goertzel, F0, F1, F_NOISE, FS, N);
+}
+
+void testThatSpikeFilterOutputIsZeroAtTheMean() {
+  // Fixture
+  // Test
+  q15_t actual = FSK_q15_spike_filter_process(&filter, 2048);
+
+  // Assert
+  TEST_ASSERT_EQUAL_INT16(0, actual);
+}
+
+void testThatSpikeFilterRemovesSpikes() {
+  // Fixture
+  for (int i = 0; i < 100; i++) {
+    FSK_q15_spike_filter_process(&filter, 2048);
+  }
+
+  // Test
+  q15_t actual = FSK_q15_spike_filter_process(&filter, 2048 + 1000);
+
+  // Assert
+  TEST_ASSERT_EQUAL_INT16(0, actual);
+}
+
+void testThatSpikeFilterMatchesFloatReference() {
+  // Fixture
+  q15_t fixedOut[N];
+  float32_t floatOut[N];
+
+  for (uint32_t window = 0; window < 8; window++) {
+    // Test
+    filterWindow(window * N, F0, 300.0f, 50, fixedOut, floatOut);
+
+    // Assert
+    for (uint32_t i = 0; i < N; i++) {
+      TEST_ASSERT_FLOAT_WITHIN(2.0f, floatOut[i] * COUNTS_TO_Q15, (float32_t)fixedOut[i]);
+    }
+  }
+}
+
+void testThatTonePowersMatchFloatReference() {
+  // Fixture
+  q15_t fixedOut[N];
+  float32_t floatOut[N];
+  const uint16_t frequencies[] = {F0, F1, F_NOISE};
+
+  for (uint32_t f = 0; f < 3; f++) {
+    filterWindow(f * N, frequencies[f], 300.0f, 20, fixedOut, floatOut);
+
+    // Test
+    FSK_q15_detector_process(&detector, fixedOut);
+    FSK_goertzel_process(&goertzel, floatOut);
+
+    // Assert
+    for (int bin = 0; bin < GOERTZEL_NUM_OF_BINS; bin++) {
+      float32_t expected = goertzel.power[bin];
+      float32_t actual = (float32_t)detector.power[bin] / (float32_t)(1 << (2 * FSK_Q15_MAGNITUDE_FRACTION_BITS));
+      // quantization of the tables and samples, relative to the strongest bin
+      TEST_ASSERT_FLOAT_WITHIN(0.01f * goertzel.power[f], expected, actual);
+    }
+  }
+}
+
+void testThatDetectedToneIsBitExactWithFloatReference() {
+  // Fixture
+  q15_t fixedOut[N];
+  float32_t floatOut[N];
+  // strong tones, a tone below the noise floor, a tone in the noise reference bin and noise only
+  const uint16_t frequencies[] = {F0, F1, F0, F1, F_NOISE, F0};
+  const float32_t amplitudes[] = {300.0f, 300.0f, 8.0f, 8.0f, 300.0f, 0.0f};
+  const uint16_t expected[] = {F0, F1, 0, 0, 0, 0};
+
+  for (uint32_t w = 0; w < 6; w++) {
+    filterWindow(w * N, frequencies[w], amplitudes[w], 20, fixedOut, floatOut);
+
+    // Test
+    uint16_t actual = FSK_q15_detect(&detector, fixedOut, NOISE_FLOOR);
+    uint16_t reference = FSK_goertzel_detect(&goertzel, floatOut, NOISE_FLOOR);
+
+    // Assert
+    TEST_ASSERT_EQUAL_UINT16(reference, actual);
+    TEST_ASSERT_EQUAL_UINT16(expected[w], actual);
+  }
+}
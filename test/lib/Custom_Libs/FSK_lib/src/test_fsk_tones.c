@@ -0,0 +1,165 @@
+// File under test fsk_tones.h
+#include "fsk_tones.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "unity.h"
+
+#include "fsk_goertzel.h"
+
+// Build the arm dsp math lib and use the "real thing" instead of mocking calls to it
+// @BUILD_LIB ARM_DSP_MATH
+
+// The window of the FSK detectors
+#define N 64
+#define FS 2000
+#define NUM_OF_TONES (2 * FSK_MAX_CHANNELS)
+#define NOISE_BIN NUM_OF_TONES
+// Rejection margin of fsk_tones.h: 33 dB in power
+#define MIN_REJECTION 2000.0f
+
+static FSK_goertzel_bank bank;
+static float32_t window[N];
+
+static uint16_t toneOf(int i) {
+  return fsk_channel_tones[i / 2][i % 2];
+}
+
+static int binOf(uint16_t frequency) {
+  return (int)(((uint32_t)frequency * N + FS / 2) / FS);
+}
+
+// Bin of the harmonic of a bin, folded around the Nyquist frequency
+static int harmonicBinOf(int bin, int harmonic) {
+  int h = (bin * harmonic) % N;
+  return (h > N / 2) ? N - h : h;
+}
+
+static bool isToneBin(int bin) {
+  for (int i = 0; i < NUM_OF_TONES; i++) {
+    if (binOf(toneOf(i)) == bin) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// A distorted tone, the 2nd and 3rd harmonics are as strong as the tone itself
+static void fixtureDistortedTone(uint16_t frequency) {
+  for (int n = 0; n < N; n++) {
+    window[n] = 0.0f;
+    for (int harmonic = 1; harmonic <= 3; harmonic++) {
+      window[n] += 100.0f * sinf(2.0f * (float32_t)M_PI * harmonic * frequency * n / FS);
+    }
+  }
+}
+
+void setUp(void) {
+  uint16_t frequencies[NUM_OF_TONES + 1];
+  for (int i = 0; i < NUM_OF_TONES; i++) {
+    frequencies[i] = toneOf(i);
+  }
+  frequencies[NOISE_BIN] = FSK_MULTI_CHANNEL_NOISE_REF_F;
+  FSK_goertzel_bank_init(&bank, frequencies, NUM_OF_TONES + 1, FS, N);
+}
+
+void testThatTheFirstChannelUsesTheSingleChannelTones() {
+  // Fixture
+  // Test
+  // Assert
+  TEST_ASSERT_EQUAL_UINT16(FSK_F0, fsk_channel_tones[0][0]);
+  TEST_ASSERT_EQUAL_UINT16(FSK_F1, fsk_channel_tones[0][1]);
+}
+
+void testThatEveryToneIsWithinHalfAHertzOfItsBin() {
+  // Fixture
+  // Test
+  // Assert
+  for (int i = 0; i < NUM_OF_TONES; i++) {
+    const float32_t binFrequency = (float32_t)binOf(toneOf(i)) * FS / N;
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, binFrequency, (float32_t)toneOf(i));
+  }
+}
+
+void testThatAFreeBinIsLeftBetweenTheChannels() {
+  // Fixture
+  // Test
+  // Assert
+  for (int c = 0; c < FSK_MAX_CHANNELS; c++) {
+    TEST_ASSERT_TRUE(binOf(fsk_channel_tones[c][0]) < binOf(fsk_channel_tones[c][1]));
+    if (c > 0) {
+      TEST_ASSERT_TRUE(binOf(fsk_channel_tones[c - 1][1]) + 1 < binOf(fsk_channel_tones[c][0]));
+    }
+  }
+  TEST_ASSERT_TRUE(binOf(fsk_channel_tones[FSK_MAX_CHANNELS - 1][1]) < N / 2);
+}
+
+void testThatNoHarmonicOfAToneIsOnAToneOrNoiseReferenceBin() {
+  // Fixture
+  const int noiseBin = binOf(FSK_MULTI_CHANNEL_NOISE_REF_F);
+
+  // Test
+  // Assert
+  for (int i = 0; i < NUM_OF_TONES; i++) {
+    for (int harmonic = 2; harmonic <= 3; harmonic++) {
+      const int h = harmonicBinOf(binOf(toneOf(i)), harmonic);
+      TEST_ASSERT_FALSE(isToneBin(h));
+      TEST_ASSERT_NOT_EQUAL(noiseBin, h);
+    }
+  }
+}
+
+void testThatTheNoiseReferencesAreNotOnAToneOrHarmonicBin() {
+  // Fixture
+  const int singleNoiseBin = binOf(FSK_SINGLE_CHANNEL_NOISE_REF_F);
+  const int multiNoiseBin = binOf(FSK_MULTI_CHANNEL_NOISE_REF_F);
+
+  // Test
+  // Assert
+  TEST_ASSERT_FALSE(isToneBin(multiNoiseBin));
+  TEST_ASSERT_NOT_EQUAL(binOf(FSK_F0), singleNoiseBin);
+  TEST_ASSERT_NOT_EQUAL(binOf(FSK_F1), singleNoiseBin);
+  for (int harmonic = 2; harmonic <= 3; harmonic++) {
+    TEST_ASSERT_NOT_EQUAL(harmonicBinOf(binOf(FSK_F0), harmonic), singleNoiseBin);
+    TEST_ASSERT_NOT_EQUAL(harmonicBinOf(binOf(FSK_F1), harmonic), singleNoiseBin);
+  }
+}
+
+void testThatADistortedToneIsRejectedByTheOtherChannels() {
+  for (int i = 0; i < NUM_OF_TONES; i++) {
+    // Fixture
+    fixtureDistortedTone(toneOf(i));
+
+    // Test
+    FSK_goertzel_bank_process(&bank, window);
+
+    // Assert
+    const float32_t tonePower = bank.power[i];
+    for (int j = 0; j <= NUM_OF_TONES; j++) {
+      // every bin of the other channels and the noise reference
+      if (j / 2 != i / 2) {
+        TEST_ASSERT_TRUE(bank.power[j] * MIN_REJECTION < tonePower);
+      }
+    }
+  }
+}
+
+void testThatADistortedToneIsOnlyDetectedOnItsOwnChannel() {
+  for (int i = 0; i < NUM_OF_TONES; i++) {
+    // Fixture
+    fixtureDistortedTone(toneOf(i));
+    // 10 dB below the tone, as set by the CFAR
+    const float32_t noiseFloor = 100.0f * N / 2 / sqrtf(10.0f);
+
+    // Test
+    FSK_goertzel_bank_process(&bank, window);
+
+    // Assert
+    for (int c = 0; c < FSK_MAX_CHANNELS; c++) {
+      uint16_t actual = FSK_goertzel_bank_detect_pair(&bank, 2 * c, 2 * c + 1, NOISE_BIN, noiseFloor);
+      uint16_t expected = (c == i / 2) ? toneOf(i) : 0;
+      TEST_ASSERT_EQUAL_UINT16(expected, actual);
+    }
+  }
+}
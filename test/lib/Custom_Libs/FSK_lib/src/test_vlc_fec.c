@@ -0,0 +1,180 @@
+// File under test vlc_fec.c
+#include "vlc_fec.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "unity.h"
+
+static vlc_fec_decoder decoder;
+
+// Pushes the coded bits of a block, first send bit first
+static uint8_t pushBlock(uint32_t coded, uint8_t numOfBits, uint8_t* data) {
+  uint8_t numOfDataBits = 0;
+  for (uint8_t i = 0; i < numOfBits; i++) {
+    numOfDataBits = vlc_fec_decoder_push_bit(&decoder, (uint8_t)((coded >> i) & 0x01), data);
+  }
+  return numOfDataBits;
+}
+
+void setUp(void) {
+  vlc_fec_decoder_init(&decoder, vlc_fec_hamming74);
+}
+
+void testThatHammingDecodesEveryNibble() {
+  for (uint8_t nibble = 0; nibble < 16; nibble++) {
+    // Fixture
+    bool corrected = true;
+
+    // Test
+    uint8_t actual = vlc_fec_hamming74_decode(vlc_fec_hamming74_encode(nibble), &corrected);
+
+    // Assert
+    TEST_ASSERT_EQUAL_UINT8(nibble, actual);
+    TEST_ASSERT_FALSE(corrected);
+  }
+}
+
+void testThatHammingCorrectsASingleBitError() {
+  for (uint8_t nibble = 0; nibble < 16; nibble++) {
+    for (uint8_t position = 0; position < VLC_FEC_HAMMING_CODED_BITS; position++) {
+      // Fixture
+      uint8_t codeword = vlc_fec_hamming74_encode(nibble) ^ (uint8_t)(1 << position);
+      bool corrected = false;
+
+      // Test
+      uint8_t actual = vlc_fec_hamming74_decode(codeword, &corrected);
+
+      // Assert
+      TEST_ASSERT_EQUAL_UINT8(nibble, actual);
+      TEST_ASSERT_TRUE(corrected);
+    }
+  }
+}
+
+void testThatConvolutionalCodeDecodesEveryByte() {
+  for (uint16_t data = 0; data < 256; data++) {
+    // Fixture
+    uint8_t errors = 0xFF;
+
+    // Test
+    uint8_t actual = vlc_fec_conv_decode(vlc_fec_conv_encode((uint8_t)data), &errors);
+
+    // Assert
+    TEST_ASSERT_EQUAL_UINT8(data, actual);
+    TEST_ASSERT_EQUAL_UINT8(0, errors);
+  }
+}
+
+void testThatConvolutionalCodeCorrectsSpreadBitErrors() {
+  for (uint16_t data = 0; data < 256; data++) {
+    // Fixture
+    uint32_t coded = vlc_fec_conv_encode((uint8_t)data) ^ (1u << 3) ^ (1u << 14) ^ (1u << 25);
+    uint8_t errors = 0;
+
+    // Test
+    uint8_t actual = vlc_fec_conv_decode(coded, &errors);
+
+    // Assert
+    TEST_ASSERT_EQUAL_UINT8(data, actual);
+    TEST_ASSERT_EQUAL_UINT8(3, errors);
+  }
+}
+
+void testThatDecoderReturnsTheDataBitsOnceTheBlockIsComplete() {
+  // Fixture
+  uint8_t codeword = vlc_fec_hamming74_encode(0x0B);
+  uint8_t data = 0;
+
+  // Test
+  uint8_t incomplete = pushBlock(codeword, VLC_FEC_HAMMING_CODED_BITS - 1, &data);
+  uint8_t actual = vlc_fec_decoder_push_bit(&decoder, (codeword >> (VLC_FEC_HAMMING_CODED_BITS - 1)) & 0x01, &data);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT8(0, incomplete);
+  TEST_ASSERT_EQUAL_UINT8(VLC_FEC_HAMMING_DATA_BITS, actual);
+  TEST_ASSERT_EQUAL_UINT8(0x0B, data);
+}
+
+void testThatDecoderCountsTheCorrectedBits() {
+  // Fixture
+  vlc_fec_decoder_init(&decoder, vlc_fec_conv_k7);
+  uint32_t coded = vlc_fec_conv_encode(0xA5) ^ (1u << 7) ^ (1u << 20);
+  uint8_t data = 0;
+
+  // Test
+  uint8_t actual = pushBlock(coded, VLC_FEC_CONV_CODED_BITS, &data);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT8(VLC_FEC_CONV_DATA_BITS, actual);
+  TEST_ASSERT_EQUAL_UINT8(0xA5, data);
+  TEST_ASSERT_EQUAL_UINT32(2, decoder.corrected_bits);
+}
+
+void testThatResetDropsAnIncompleteBlock() {
+  // Fixture
+  uint8_t data = 0;
+  pushBlock(0x7F, 3, &data);
+
+  // Test
+  vlc_fec_decoder_reset(&decoder);
+  uint8_t actual = pushBlock(vlc_fec_hamming74_encode(0x06), VLC_FEC_HAMMING_CODED_BITS, &data);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT8(VLC_FEC_HAMMING_DATA_BITS, actual);
+  TEST_ASSERT_EQUAL_UINT8(0x06, data);
+}
+
+void testThatPopTakesTheNewestBitOutOfTheBuffer() {
+  // Fixture
+  uint8_t bits = 0x05;
+  uint8_t bitCount = 3;
+  uint8_t data = 0;
+
+  // Test
+  uint8_t actual = vlc_fec_decoder_pop_bit(&decoder, &bits, &bitCount, &data);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT8(0, actual);
+  TEST_ASSERT_EQUAL_UINT8(2, bitCount);
+  TEST_ASSERT_EQUAL_UINT8(0x01, bits);
+  TEST_ASSERT_EQUAL_UINT8(1, decoder.coded_count);
+  TEST_ASSERT_EQUAL_UINT32(0x01, decoder.coded);
+}
+
+void testThatPopOfAnEmptyBufferAfterAnInvalidBitDoesNothing() {
+  // Fixture
+  uint8_t data = 0;
+  pushBlock(0x03, 2, &data);
+  // an invalid bit decision resets the bit buffer
+  uint8_t bits = 0;
+  uint8_t bitCount = 0;
+
+  // Test
+  uint8_t actual = vlc_fec_decoder_pop_bit(&decoder, &bits, &bitCount, &data);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT8(0, actual);
+  TEST_ASSERT_EQUAL_UINT8(0, bitCount);
+  TEST_ASSERT_EQUAL_UINT8(0, bits);
+  TEST_ASSERT_EQUAL_UINT8(2, decoder.coded_count);
+  TEST_ASSERT_EQUAL_UINT32(0x03, decoder.coded);
+}
+
+void testThatPoppedBitsDecodeToTheSendNibble() {
+  // Fixture
+  uint8_t codeword = vlc_fec_hamming74_encode(0x09) ^ (1 << 4);
+  uint8_t data = 0;
+  uint8_t actual = 0;
+
+  // Test
+  for (uint8_t i = 0; i < VLC_FEC_HAMMING_CODED_BITS; i++) {
+    uint8_t bits = (uint8_t)((codeword >> i) & 0x01);
+    uint8_t bitCount = 1;
+    actual = vlc_fec_decoder_pop_bit(&decoder, &bits, &bitCount, &data);
+  }
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT8(VLC_FEC_HAMMING_DATA_BITS, actual);
+  TEST_ASSERT_EQUAL_UINT8(0x09, data);
+  TEST_ASSERT_EQUAL_UINT32(1, decoder.corrected_bits);
+}
@@ -0,0 +1,254 @@
+// File under test vlc_packet.c
+#include "vlc_packet.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "unity.h"
+
+#define FRAME_SIZE (VLC_PACKET_OVERHEAD + VLC_PACKET_MAX_PAYLOAD)
+
+static vlc_packet_rx rx;
+static uint8_t frame[FRAME_SIZE];
+
+// Pushes the bits of the bytes LSB first, returns the status of the last bit and counts the ready packets
+static vlc_packet_rx_status pushBytes(const uint8_t bytes[], uint16_t n, int* numOfPackets) {
+  vlc_packet_rx_status status = vlc_rx_busy;
+  for (uint16_t i = 0; i < n; i++) {
+    for (uint8_t b = 0; b < 8; b++) {
+      status = vlc_packet_rx_push_bit(&rx, (uint8_t)((bytes[i] >> b) & 0x01));
+      if ((status == vlc_rx_packet_ready) && (numOfPackets != NULL)) {
+        (*numOfPackets)++;
+      }
+    }
+  }
+  return status;
+}
+
+static vlc_packet_t gotoPacket(int16_t x, int16_t y, int16_t z) {
+  vlc_packet_t packet = {.address = 0x12, .type = vlc_packet_type_goto, .length = 6};
+  const int16_t setpoint[3] = {x, y, z};
+  for (int i = 0; i < 3; i++) {
+    packet.payload[2 * i] = (uint8_t)((uint16_t)setpoint[i] & 0xFF);
+    packet.payload[2 * i + 1] = (uint8_t)((uint16_t)setpoint[i] >> 8);
+  }
+  return packet;
+}
+
+static void assertPacketsEqual(const vlc_packet_t* expected, const vlc_packet_t* actual) {
+  TEST_ASSERT_EQUAL_UINT8(expected->address, actual->address);
+  TEST_ASSERT_EQUAL_UINT8(expected->type, actual->type);
+  TEST_ASSERT_EQUAL_UINT8(expected->length, actual->length);
+  for (uint8_t i = 0; i < expected->length; i++) {
+    TEST_ASSERT_EQUAL_UINT8(expected->payload[i], actual->payload[i]);
+  }
+}
+
+void setUp(void) {
+  vlc_packet_rx_init(&rx);
+  memset(frame, 0, sizeof(frame));
+}
+
+void testThatCrcMatchesTheReferenceCheckValue() {
+  // Fixture
+  const uint8_t data[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+#ifdef CONFIG_VLC_PACKET_CRC8
+  const uint16_t expected = 0xF4;
+#else
+  const uint16_t expected = 0x29B1;
+#endif
+
+  // Test
+  uint16_t actual = vlc_packet_crc(data, sizeof(data));
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT16(expected, actual);
+}
+
+void testThatEncodeBuildsTheFrame() {
+  // Fixture
+  vlc_packet_t packet = {.address = 0x34, .type = vlc_packet_type_command, .length = 1, .payload = {3}};
+
+  // Test
+  uint16_t n = vlc_packet_encode(&packet, frame, sizeof(frame));
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT16(VLC_PACKET_OVERHEAD + 1, n);
+  TEST_ASSERT_EQUAL_UINT8(0x91, frame[0]);
+  TEST_ASSERT_EQUAL_UINT8(0xD3, frame[1]);
+  TEST_ASSERT_EQUAL_UINT8(1, frame[2]);
+  TEST_ASSERT_EQUAL_UINT8(0x34, frame[3]);
+  TEST_ASSERT_EQUAL_UINT8(vlc_packet_type_command, frame[4]);
+  TEST_ASSERT_EQUAL_UINT8(3, frame[5]);
+  // the crc covers length, address, type and payload, low byte first
+  uint16_t crc = vlc_packet_crc(&frame[2], 4);
+  TEST_ASSERT_EQUAL_UINT8((uint8_t)(crc & 0xFF), frame[6]);
+}
+
+void testThatEveryPayloadLengthRoundTrips() {
+  for (uint8_t length = 0; length <= VLC_PACKET_MAX_PAYLOAD; length++) {
+    // Fixture
+    vlc_packet_t packet = {.address = VLC_PACKET_BROADCAST_ADDRESS, .type = 7, .length = length};
+    for (uint8_t i = 0; i < length; i++) {
+      packet.payload[i] = (uint8_t)(0xA5 ^ (i * 37));
+    }
+    uint16_t n = vlc_packet_encode(&packet, frame, sizeof(frame));
+    int numOfPackets = 0;
+
+    // Test
+    vlc_packet_rx_status status = pushBytes(frame, n, &numOfPackets);
+
+    // Assert
+    TEST_ASSERT_EQUAL_UINT16(VLC_PACKET_OVERHEAD + length, n);
+    TEST_ASSERT_EQUAL_INT(vlc_rx_packet_ready, status);
+    TEST_ASSERT_EQUAL_INT(1, numOfPackets);
+    assertPacketsEqual(&packet, &rx.packet);
+  }
+  TEST_ASSERT_EQUAL_UINT32(VLC_PACKET_MAX_PAYLOAD + 1, rx.packets_recieved);
+  TEST_ASSERT_EQUAL_UINT32(0, rx.crc_errors);
+}
+
+void testThatAGotoSetpointRoundTrips() {
+  // Fixture
+  vlc_packet_t packet = gotoPacket(-1500, 32767, -32768);
+  uint16_t n = vlc_packet_encode(&packet, frame, sizeof(frame));
+
+  // Test
+  vlc_packet_rx_status status = pushBytes(frame, n, NULL);
+
+  // Assert
+  TEST_ASSERT_EQUAL_INT(vlc_rx_packet_ready, status);
+  assertPacketsEqual(&packet, &rx.packet);
+  int16_t x = (int16_t)((uint16_t)rx.packet.payload[0] | ((uint16_t)rx.packet.payload[1] << 8));
+  int16_t z = (int16_t)((uint16_t)rx.packet.payload[4] | ((uint16_t)rx.packet.payload[5] << 8));
+  TEST_ASSERT_EQUAL_INT16(-1500, x);
+  TEST_ASSERT_EQUAL_INT16(-32768, z);
+}
+
+void testThatExtraPreambleBitsBeforeTheSyncWordAreIgnored() {
+  // Fixture
+  vlc_packet_t packet = gotoPacket(10, 20, 30);
+  uint16_t n = vlc_packet_encode(&packet, frame, sizeof(frame));
+  // alternating preamble bits
+  for (int i = 0; i < 13; i++) {
+    vlc_packet_rx_push_bit(&rx, (uint8_t)(i & 0x01));
+  }
+
+  // Test
+  vlc_packet_rx_status status = pushBytes(frame, n, NULL);
+
+  // Assert
+  TEST_ASSERT_EQUAL_INT(vlc_rx_packet_ready, status);
+  assertPacketsEqual(&packet, &rx.packet);
+}
+
+void testThatBackToBackFramesAreAllReceived() {
+  // Fixture
+  uint8_t stream[3 * FRAME_SIZE];
+  uint16_t n = 0;
+  for (int16_t i = 0; i < 3; i++) {
+    vlc_packet_t packet = gotoPacket(i, i, i);
+    n += vlc_packet_encode(&packet, &stream[n], (uint16_t)(sizeof(stream) - n));
+  }
+  int numOfPackets = 0;
+
+  // Test
+  pushBytes(stream, n, &numOfPackets);
+
+  // Assert
+  TEST_ASSERT_EQUAL_INT(3, numOfPackets);
+  TEST_ASSERT_EQUAL_UINT8(2, rx.packet.payload[0]);
+}
+
+void testThatEncodeRejectsAPayloadThatIsTooLong() {
+  // Fixture
+  vlc_packet_t packet = {.address = 1, .type = vlc_packet_type_command, .length = VLC_PACKET_MAX_PAYLOAD + 1};
+
+  // Test
+  uint16_t n = vlc_packet_encode(&packet, frame, sizeof(frame));
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT16(0, n);
+}
+
+void testThatEncodeRejectsABufferThatIsTooShort() {
+  // Fixture
+  vlc_packet_t packet = gotoPacket(1, 2, 3);
+
+  // Test
+  uint16_t n = vlc_packet_encode(&packet, frame, VLC_PACKET_OVERHEAD + 5);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT16(0, n);
+}
+
+void testThatAFrameWithAnInvalidLengthIsRejected() {
+  // Fixture
+  vlc_packet_t packet = gotoPacket(1, 2, 3);
+  uint16_t n = vlc_packet_encode(&packet, frame, sizeof(frame));
+  frame[2] = VLC_PACKET_MAX_PAYLOAD + 1;
+  int numOfPackets = 0;
+
+  // Test
+  // the error is reported as soon as the length byte is complete
+  vlc_packet_rx_status status = pushBytes(frame, 3, &numOfPackets);
+  pushBytes(&frame[3], (uint16_t)(n - 3), &numOfPackets);
+
+  // Assert
+  TEST_ASSERT_EQUAL_INT(vlc_rx_error, status);
+  TEST_ASSERT_EQUAL_INT(0, numOfPackets);
+  TEST_ASSERT_EQUAL_UINT32(0, rx.packets_recieved);
+}
+
+void testThatAFrameWithAShorterLengthFailsTheCrc() {
+  // Fixture
+  vlc_packet_t packet = gotoPacket(1, 2, 3);
+  uint16_t n = vlc_packet_encode(&packet, frame, sizeof(frame));
+  frame[2] = 4;
+  int numOfPackets = 0;
+
+  // Test
+  pushBytes(frame, n, &numOfPackets);
+
+  // Assert
+  TEST_ASSERT_EQUAL_INT(0, numOfPackets);
+  TEST_ASSERT_EQUAL_UINT32(1, rx.crc_errors);
+}
+
+void testThatEverySingleBitErrorIsDetected() {
+  // Fixture
+  vlc_packet_t packet = gotoPacket(-7, 300, 5000);
+  uint16_t n = vlc_packet_encode(&packet, frame, sizeof(frame));
+
+  // the sync word itself is not covered by the crc
+  for (uint16_t bit = 16; bit < 8 * n; bit++) {
+    uint8_t corrupted[FRAME_SIZE];
+    memcpy(corrupted, frame, n);
+    corrupted[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+    vlc_packet_rx_reset(&rx);
+    int numOfPackets = 0;
+
+    // Test
+    pushBytes(corrupted, n, &numOfPackets);
+
+    // Assert
+    TEST_ASSERT_EQUAL_INT(0, numOfPackets);
+  }
+}
+
+void testThatTheHuntForTheSyncWordGivesUp() {
+  // Fixture
+  vlc_packet_rx_status status = vlc_rx_busy;
+  int bits = 0;
+
+  // Test
+  while ((status == vlc_rx_busy) && (bits < 100)) {
+    status = vlc_packet_rx_push_bit(&rx, 0);
+    bits++;
+  }
+
+  // Assert
+  TEST_ASSERT_EQUAL_INT(vlc_rx_error, status);
+  TEST_ASSERT_EQUAL_INT(VLC_PACKET_SYNC_HUNT_BITS, bits);
+  TEST_ASSERT_EQUAL_INT(vlc_rx_state_sync, rx.state);
+}
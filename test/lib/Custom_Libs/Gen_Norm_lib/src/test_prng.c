@@ -0,0 +1,145 @@
+// File under test prng.c
+#include "prng.h"
+
+#include <stdint.h>
+#include <math.h>
+#include "unity.h"
+
+#define SEED 0x1234ABCDull
+#define NUM_OF_SAMPLES 100000
+
+static Prng prng;
+
+void setUp(void) {
+  prng_seed(&prng, SEED);
+}
+
+void testThatGeneratorMatchesReferenceSequence() {
+  // Fixture
+  // state from the xoshiro128** reference test
+  prng.s[0] = 1;
+  prng.s[1] = 2;
+  prng.s[2] = 3;
+  prng.s[3] = 4;
+  const uint32_t expected[] = {11520, 0, 5927040, 70819200};
+
+  for (int i = 0; i < 4; i++) {
+    // Test
+    uint32_t actual = prng_next(&prng);
+
+    // Assert
+    TEST_ASSERT_EQUAL_UINT32(expected[i], actual);
+  }
+}
+
+void testThatSameSeedGivesSameNormals() {
+  // Fixture
+  Prng other;
+  prng_seed(&other, SEED);
+
+  for (int i = 0; i < 1000; i++) {
+    // Test
+    float expected = prng_normal(&prng);
+    float actual = prng_normal(&other);
+
+    // Assert
+    TEST_ASSERT_EQUAL_FLOAT(expected, actual);
+  }
+}
+
+void testThatDifferentSeedsGiveDifferentSequences() {
+  // Fixture
+  Prng other;
+  prng_seed(&other, SEED + 1);
+  int equal = 0;
+
+  // Test
+  for (int i = 0; i < 100; i++) {
+    if (prng_next(&prng) == prng_next(&other)) {
+      equal++;
+    }
+  }
+
+  // Assert
+  TEST_ASSERT_EQUAL_INT(0, equal);
+}
+
+void testThatUniformIsInRangeWithMeanOfOneHalf() {
+  // Fixture
+  double sum = 0.0;
+
+  // Test
+  for (int i = 0; i < NUM_OF_SAMPLES; i++) {
+    float u = prng_uniform(&prng);
+    TEST_ASSERT_TRUE(u >= 0.0f && u < 1.0f);
+    sum += u;
+  }
+
+  // Assert
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, 0.5f, (float)(sum / NUM_OF_SAMPLES));
+}
+
+void testThatNormalsHaveMeanZeroAndVarianceOne() {
+  // Fixture
+  double sum = 0.0;
+  double sumOfSquares = 0.0;
+
+  // Test
+  for (int i = 0; i < NUM_OF_SAMPLES; i++) {
+    double x = prng_normal(&prng);
+    sum += x;
+    sumOfSquares += x * x;
+  }
+
+  // Assert
+  double mean = sum / NUM_OF_SAMPLES;
+  double variance = sumOfSquares / NUM_OF_SAMPLES - mean * mean;
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, (float)mean);
+  TEST_ASSERT_FLOAT_WITHIN(0.02f, 1.0f, (float)variance);
+}
+
+void testThatNormalsFollowTheNormalDistribution() {
+  // Fixture
+  // P(|x| < k) for k = 0.5, 1, 2, 3
+  const double k[] = {0.5, 1.0, 2.0, 3.0};
+  const double expected[] = {0.382925, 0.682689, 0.954500, 0.997300};
+  int count[4] = {0};
+  int inTail = 0;
+
+  // Test
+  for (int i = 0; i < NUM_OF_SAMPLES; i++) {
+    float x = prng_normal(&prng);
+    for (int j = 0; j < 4; j++) {
+      if (fabsf(x) < k[j]) {
+        count[j]++;
+      }
+    }
+    // beyond the base layer of the ziggurat
+    if (fabsf(x) > 3.442620f) {
+      inTail++;
+    }
+  }
+
+  // Assert
+  for (int j = 0; j < 4; j++) {
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, (float)expected[j], (float)count[j] / NUM_OF_SAMPLES);
+  }
+  // P(|x| > 3.44) = 0.000576
+  TEST_ASSERT_INT_WITHIN(30, 58, inTail);
+}
+
+void testThatFillNormalsScalesAndShifts() {
+  // Fixture
+  Prng other;
+  prng_seed(&other, SEED);
+  float actual[64];
+
+  // Test
+  prng_fill_normals(&prng, actual, 64, 3.0f, 0.5f);
+
+  // Assert
+  for (int i = 0; i < 64; i++) {
+    float expected = prng_normal(&other) * 0.5f + 3.0f;
+    TEST_ASSERT_EQUAL_FLOAT(expected, actual[i]);
+  }
+}
@@ -0,0 +1,214 @@
+// File under test KNN.c
+#include "KNN.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "unity.h"
+
+#define NUM_OF_QUERIES 200
+#define NO_EXCLUDE -1
+
+static KNNIndex knnIndex;
+static TrainingPoint points[KNN_MAX_TRAINING_POINTS];
+static uint32_t seed;
+
+static float uniform(float min, float max) {
+  seed = seed * 1664525u + 1013904223u;
+  return min + (max - min) * (float)(seed >> 8) / (float)(1u << 24);
+}
+
+static void randomPoints(uint16_t n) {
+  for (uint16_t i = 0; i < n; i++) {
+    points[i].x_cart = uniform(-1.0f, 1.0f);
+    points[i].y_cart = uniform(-0.5f, 0.5f);
+    points[i].ID = (int8_t)(i % NUMBER_OF_IDS);
+  }
+}
+
+// Points on a lattice, many of them are at the same distance of a lattice point
+static void latticePoints(uint16_t n) {
+  for (uint16_t i = 0; i < n; i++) {
+    points[i].x_cart = 0.1f * (float)(i % 8);
+    points[i].y_cart = 0.1f * (float)(i / 8);
+    points[i].ID = (int8_t)(i % NUMBER_OF_IDS);
+  }
+}
+
+// Same expression as the search, so the distances are bit exact
+static float distance2(const TrainingPoint* p, float x, float y) {
+  float dx = p->x_cart - x;
+  float dy = p->y_cart - y;
+  return dx * dx + dy * dy;
+}
+
+// Brute force K nearest distances, nearest first
+static void bruteForce(uint16_t n, float x, float y, int32_t exclude, float sorted[]) {
+  uint16_t count = 0;
+  for (uint16_t i = 0; i < n; i++) {
+    if ((int32_t)i == exclude) {
+      continue;
+    }
+    float d2 = distance2(&points[i], x, y);
+    uint16_t j = count++;
+    while (j > 0 && sorted[j - 1] > d2) {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = d2;
+  }
+}
+
+// With ties the points at the K-th distance can differ, the distances can not
+static void assertMatchesBruteForce(uint16_t n, float x, float y, uint8_t K, int32_t exclude, const KNNNeighbours* actual) {
+  float expected[KNN_MAX_TRAINING_POINTS];
+  bruteForce(n, x, y, exclude, expected);
+
+  TEST_ASSERT_EQUAL_UINT8(K, actual->K);
+  for (uint8_t i = 0; i < K; i++) {
+    uint16_t point = actual->point[i];
+    TEST_ASSERT_TRUE(point < n);
+    TEST_ASSERT_TRUE((int32_t)point != exclude);
+    TEST_ASSERT_EQUAL_FLOAT(expected[i], actual->distance2[i]);
+    TEST_ASSERT_EQUAL_FLOAT(distance2(&points[point], x, y), actual->distance2[i]);
+    TEST_ASSERT_EQUAL_INT(points[point].ID, actual->ID[i]);
+    for (uint8_t j = 0; j < i; j++) {
+      TEST_ASSERT_TRUE(actual->point[j] != point);
+    }
+  }
+}
+
+static void search(uint16_t n, float x, float y, uint8_t K, int32_t exclude) {
+  KNNPoint p = {.x_cart = x, .y_cart = y};
+  KNNNeighbours actual;
+  int8_t valid;
+  if (exclude == NO_EXCLUDE) {
+    valid = KNNSearchCartesian(&p, &knnIndex, K, &actual);
+  } else {
+    valid = KNNSearchExcluding(&p, &knnIndex, K, (uint16_t)exclude, &actual);
+  }
+  TEST_ASSERT_EQUAL_INT(1, valid);
+  assertMatchesBruteForce(n, x, y, K, exclude, &actual);
+}
+
+void setUp(void) {
+  seed = 12345;
+  memset(&knnIndex, 0, sizeof(knnIndex));
+}
+
+void testThatSearchMatchesBruteForceOnRandomPoints() {
+  // Fixture
+  const uint8_t Ks[] = {1, 3, 5, KNN_MAX_K};
+  randomPoints(KNN_MAX_TRAINING_POINTS);
+  TEST_ASSERT_EQUAL_INT(1, KNNIndexBuild(&knnIndex, points, KNN_MAX_TRAINING_POINTS));
+
+  for (int q = 0; q < NUM_OF_QUERIES; q++) {
+    // queries inside and outside of the bounding box of the points
+    float x = uniform(-1.5f, 1.5f);
+    float y = uniform(-1.0f, 1.0f);
+    for (uint8_t k = 0; k < sizeof(Ks); k++) {
+      // Test
+      // Assert
+      search(KNN_MAX_TRAINING_POINTS, x, y, Ks[k], NO_EXCLUDE);
+    }
+  }
+}
+
+void testThatSearchMatchesBruteForceWithFewPoints() {
+  for (uint16_t n = 1; n <= 8; n++) {
+    // Fixture
+    randomPoints(n);
+    TEST_ASSERT_EQUAL_INT(1, KNNIndexBuild(&knnIndex, points, n));
+
+    for (uint8_t K = 1; K <= n; K++) {
+      // Test
+      // Assert
+      search(n, uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), K, NO_EXCLUDE);
+    }
+  }
+}
+
+void testThatSearchMatchesBruteForceWithTies() {
+  // Fixture
+  const uint16_t n = 56;
+  latticePoints(n);
+  TEST_ASSERT_EQUAL_INT(1, KNNIndexBuild(&knnIndex, points, n));
+
+  for (uint16_t i = 0; i < n; i++) {
+    for (uint8_t K = 1; K <= 9; K += 2) {
+      // Test
+      // Assert
+      // on a lattice point, and in the middle of 4 lattice points
+      search(n, points[i].x_cart, points[i].y_cart, K, NO_EXCLUDE);
+      search(n, points[i].x_cart + 0.05f, points[i].y_cart + 0.05f, K, NO_EXCLUDE);
+    }
+  }
+}
+
+void testThatSearchMatchesBruteForceOnCellBorders() {
+  // Fixture
+  randomPoints(KNN_MAX_TRAINING_POINTS);
+  TEST_ASSERT_EQUAL_INT(1, KNNIndexBuild(&knnIndex, points, KNN_MAX_TRAINING_POINTS));
+
+  for (int32_t cx = -1; cx <= knnIndex.grid_dim + 1; cx++) {
+    for (int32_t cy = -1; cy <= knnIndex.grid_dim + 1; cy++) {
+      float x = knnIndex.x_min + (float)cx * knnIndex.cell_size;
+      float y = knnIndex.y_min + (float)cy * knnIndex.cell_size;
+      for (uint8_t K = 1; K <= 7; K += 3) {
+        // Test
+        // Assert
+        // on the corner of the cell and on the middle of its bottom and left border
+        search(KNN_MAX_TRAINING_POINTS, x, y, K, NO_EXCLUDE);
+        search(KNN_MAX_TRAINING_POINTS, x + 0.5f * knnIndex.cell_size, y, K, NO_EXCLUDE);
+        search(KNN_MAX_TRAINING_POINTS, x, y + 0.5f * knnIndex.cell_size, K, NO_EXCLUDE);
+      }
+    }
+  }
+}
+
+void testThatExcludedPointIsLeftOut() {
+  // Fixture
+  randomPoints(KNN_MAX_TRAINING_POINTS);
+  TEST_ASSERT_EQUAL_INT(1, KNNIndexBuild(&knnIndex, points, KNN_MAX_TRAINING_POINTS));
+
+  for (uint16_t i = 0; i < KNN_MAX_TRAINING_POINTS; i++) {
+    for (uint8_t K = 1; K <= 5; K += 2) {
+      // Test
+      // Assert
+      search(KNN_MAX_TRAINING_POINTS, points[i].x_cart, points[i].y_cart, K, i);
+    }
+  }
+}
+
+void testThatExcludedPointIsLeftOutWithTies() {
+  // Fixture
+  const uint16_t n = 56;
+  latticePoints(n);
+  TEST_ASSERT_EQUAL_INT(1, KNNIndexBuild(&knnIndex, points, n));
+
+  for (uint16_t i = 0; i < n; i++) {
+    // Test
+    // Assert
+    search(n, points[i].x_cart, points[i].y_cart, 4, i);
+  }
+}
+
+void testThatSearchRejectsMoreNeighboursThanPoints() {
+  // Fixture
+  randomPoints(4);
+  TEST_ASSERT_EQUAL_INT(1, KNNIndexBuild(&knnIndex, points, 4));
+  KNNPoint p = {.x_cart = 0.0f, .y_cart = 0.0f};
+  KNNNeighbours neighbours;
+
+  // Test
+  int8_t all = KNNSearchCartesian(&p, &knnIndex, 4, &neighbours);
+  int8_t tooMany = KNNSearchCartesian(&p, &knnIndex, 5, &neighbours);
+  int8_t allButExcluded = KNNSearchExcluding(&p, &knnIndex, 3, 0, &neighbours);
+  int8_t tooManyExcluded = KNNSearchExcluding(&p, &knnIndex, 4, 0, &neighbours);
+
+  // Assert
+  TEST_ASSERT_EQUAL_INT(1, all);
+  TEST_ASSERT_EQUAL_INT(0, tooMany);
+  TEST_ASSERT_EQUAL_INT(1, allButExcluded);
+  TEST_ASSERT_EQUAL_INT(0, tooManyExcluded);
+}
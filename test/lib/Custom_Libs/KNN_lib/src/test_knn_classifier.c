@@ -0,0 +1,115 @@
+// File under test KNN_classifier.c
+#include "KNN_classifier.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "unity.h"
+
+#define NUM_OF_CLUSTER_POINTS 8
+
+static KNNIndex knnIndex;
+static KNNClassifier classifier;
+static TrainingPoint clusterPoints[NUM_OF_CLUSTER_POINTS];
+
+static const KNNClassifierConfig config = {
+  .K = 3,
+  .bandwidth = 0.05f,
+  .reject_distance = 0.3f,
+  .prior = 0.05f,
+  .error_rate = 0.05f,
+  .max_samples = 8,
+};
+
+// Two clusters of 4 points, one point of the ID 1 cluster has ID 2
+static void clusters() {
+  for (uint16_t i = 0; i < NUM_OF_CLUSTER_POINTS; i++) {
+    clusterPoints[i].x_cart = (i < 4 ? 0.0f : 0.5f) + 0.01f * (float)(i % 2);
+    clusterPoints[i].y_cart = 0.01f * (float)((i % 4) / 2);
+    clusterPoints[i].ID = (int8_t)(i < 4 ? 1 : 3);
+  }
+  clusterPoints[3].ID = 2;
+}
+
+// Leave-one-out classification of a training point by hand, the sensor stays on the point
+static int8_t classify(const TrainingPoint* point, uint16_t i, uint8_t* ID) {
+  KNNPoint p = {.x_cart = point->x_cart, .y_cart = point->y_cart};
+  KNNNeighbours neighbours;
+  float posterior[NUMBER_OF_IDS];
+  TEST_ASSERT_EQUAL_INT(1, KNNSearchExcluding(&p, &knnIndex, config.K, i, &neighbours));
+  TEST_ASSERT_EQUAL_INT(1, KNNClassifierPosterior(&classifier, &neighbours, posterior));
+  KNNClassifierReset(&classifier);
+  for (uint8_t n = 0; n < config.max_samples; n++) {
+    if (KNNClassifierUpdate(&classifier, posterior, ID, NULL) == 1) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+void setUp(void) {
+  memset(&knnIndex, 0, sizeof(knnIndex));
+  TEST_ASSERT_EQUAL_INT(1, KNNClassifierInit(&classifier, &config));
+}
+
+void testThatConfusionMatrixLeavesTheClassifiedPointOut() {
+  // Fixture
+  clusters();
+  TEST_ASSERT_EQUAL_INT(1, KNNIndexBuild(&knnIndex, clusterPoints, NUM_OF_CLUSTER_POINTS));
+  uint16_t actual[NUMBER_OF_IDS][NUMBER_OF_IDS];
+
+  // Test
+  KNNClassifierConfusionMatrix(&classifier, &knnIndex, actual);
+
+  // Assert
+  // the ID 2 point only has ID 1 neighbours once it is left out
+  TEST_ASSERT_EQUAL_UINT16(1, actual[2][1]);
+  TEST_ASSERT_EQUAL_UINT16(0, actual[2][2]);
+  TEST_ASSERT_EQUAL_UINT16(3, actual[1][1]);
+  TEST_ASSERT_EQUAL_UINT16(4, actual[3][3]);
+}
+
+void testThatConfusionMatrixKeepsTheStateOfTheClassifier() {
+  // Fixture
+  clusters();
+  TEST_ASSERT_EQUAL_INT(1, KNNIndexBuild(&knnIndex, clusterPoints, NUM_OF_CLUSTER_POINTS));
+  float posterior[NUMBER_OF_IDS] = {0.1f, 0.3f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f};
+  uint8_t ID;
+  KNNClassifierUpdate(&classifier, posterior, &ID, NULL);
+  KNNClassifier expected = classifier;
+  uint16_t actual[NUMBER_OF_IDS][NUMBER_OF_IDS];
+
+  // Test
+  KNNClassifierConfusionMatrix(&classifier, &knnIndex, actual);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT8(expected.num_of_samples, classifier.num_of_samples);
+  TEST_ASSERT_EQUAL_UINT32(expected.decisions, classifier.decisions);
+  TEST_ASSERT_EQUAL_UINT32(expected.restarts, classifier.restarts);
+  for (uint8_t i = 0; i < NUMBER_OF_IDS; i++) {
+    TEST_ASSERT_EQUAL_FLOAT(expected.belief[i], classifier.belief[i]);
+  }
+}
+
+void testThatConfusionMatrixMatchesTheClassifierOnTheTrainingData() {
+  // Fixture
+  TEST_ASSERT_EQUAL_INT(1, KNNIndexBuild(&knnIndex, trainingPoints, NUMBER_OF_TRAINING_POINTS));
+  uint16_t actual[NUMBER_OF_IDS][NUMBER_OF_IDS];
+
+  // Test
+  KNNClassifierConfusionMatrix(&classifier, &knnIndex, actual);
+
+  // Assert
+  uint16_t expected[NUMBER_OF_IDS][NUMBER_OF_IDS] = {{0}};
+  for (uint16_t i = 0; i < NUMBER_OF_TRAINING_POINTS; i++) {
+    uint8_t ID;
+    if (classify(&trainingPoints[i], i, &ID) == 1) {
+      expected[trainingPoints[i].ID][ID]++;
+    }
+  }
+  for (uint8_t t = 0; t < NUMBER_OF_IDS; t++) {
+    for (uint8_t p = 0; p < NUMBER_OF_IDS; p++) {
+      TEST_ASSERT_EQUAL_UINT16(expected[t][p], actual[t][p]);
+    }
+  }
+}
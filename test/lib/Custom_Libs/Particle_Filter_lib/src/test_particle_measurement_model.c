@@ -0,0 +1,217 @@
+// File under test Particle_measurement_model.c
+#include "Particle_measurement_model.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "unity.h"
+
+// Build the arm dsp math lib and use the "real thing" instead of mocking calls to it
+// @BUILD_LIB ARM_DSP_MATH
+
+#define C COLOR_MODEL_NUM_OF_CLASSES
+#define AMBIENT NUMBER_OF_COLORS
+#define N 6
+
+static ColorMeasurementModel model;
+static float logLikelihood[C];
+
+static float sum(const float x[], int n) {
+  float s = 0.0f;
+  for (int i = 0; i < n; i++) {
+    s += x[i];
+  }
+  return s;
+}
+
+void setUp(void) {
+  color_measurement_model_init(&model, 0.9f);
+  for (int c = 0; c < C; c++) {
+    logLikelihood[c] = 0.0f;
+  }
+}
+
+void testThatEveryRowOfTheDefaultModelIsADistribution() {
+  // Fixture
+  // Test
+  // Assert
+  for (int c = 0; c < C; c++) {
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f, sum(model.p[c], C));
+    TEST_ASSERT_EQUAL_FLOAT(0.9f, model.p[c][c]);
+  }
+}
+
+void testThatEveryRowOfTheConfusionModelIsADistribution() {
+  // Fixture
+  uint16_t confusion[C][C] = {{0}};
+  for (int c = 0; c < C - 1; c++) {
+    confusion[c][c] = 90;
+    confusion[c][c + 1] = 10;
+  }
+  // the last row has no training data
+
+  // Test
+  color_measurement_model_init_from_confusion(&model, confusion, 1.0f);
+
+  // Assert
+  for (int c = 0; c < C; c++) {
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f, sum(model.p[c], C));
+  }
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 91.0f / (100.0f + C), model.p[0][0]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 11.0f / (100.0f + C), model.p[0][1]);
+  // smoothing keeps unseen confusions possible
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f / (100.0f + C), model.p[0][2]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f / C, model.p[C - 1][0]);
+}
+
+void testThatAConfusionRowWithoutCountsOrSmoothingIsUniform() {
+  // Fixture
+  uint16_t confusion[C][C] = {{0}};
+
+  // Test
+  color_measurement_model_init_from_confusion(&model, confusion, 0.0f);
+
+  // Assert
+  for (int o = 0; o < C; o++) {
+    TEST_ASSERT_EQUAL_FLOAT(1.0f / C, model.p[2][o]);
+  }
+}
+
+void testThatTheLikelihoodOfAPosteriorIsTheWeightedConfusion() {
+  // Fixture
+  float posterior[C] = {0};
+  posterior[1] = 0.75f;
+  posterior[3] = 0.25f;
+  const float pWrong = 0.1f / (C - 1);
+
+  // Test
+  color_measurement_add_log_likelihood(&model, posterior, 0, logLikelihood);
+
+  // Assert
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, logf(0.75f * 0.9f + 0.25f * pWrong), logLikelihood[1]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, logf(0.25f * 0.9f + 0.75f * pWrong), logLikelihood[3]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, logf(pWrong), logLikelihood[0]);
+}
+
+void testThatAHardDecisionUsesTheConfusionOfTheColor() {
+  // Fixture
+  const float pWrong = 0.1f / (C - 1);
+
+  // Test
+  color_measurement_add_log_likelihood(&model, NULL, 2, logLikelihood);
+
+  // Assert
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, logf(0.9f), logLikelihood[2]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, logf(pWrong), logLikelihood[AMBIENT]);
+}
+
+void testThatIndependentMeasurementsAreMultiplied() {
+  // Fixture
+  float posterior[C] = {0};
+  posterior[4] = 1.0f;
+
+  // Test
+  color_measurement_add_log_likelihood(&model, posterior, 0, logLikelihood);
+  color_measurement_add_log_likelihood(&model, NULL, 4, logLikelihood);
+
+  // Assert
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, 2.0f * logf(0.9f), logLikelihood[4]);
+}
+
+void testThatAnImpossibleColorKeepsAFiniteLogLikelihood() {
+  // Fixture
+  uint16_t confusion[C][C] = {{0}};
+  for (int c = 0; c < C; c++) {
+    confusion[c][c] = 100;
+  }
+  color_measurement_model_init_from_confusion(&model, confusion, 0.0f);
+
+  // Test
+  color_measurement_add_log_likelihood(&model, NULL, 1, logLikelihood);
+
+  // Assert
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, logLikelihood[1]);
+  TEST_ASSERT_TRUE(isfinite(logLikelihood[0]));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, logf(1e-6f), logLikelihood[0]);
+}
+
+void testThatParticlesOutsideOfTheMapGetTheAmbientLikelihood() {
+  // Fixture
+  for (int c = 0; c < C; c++) {
+    logLikelihood[c] = -(float)c;
+  }
+  float logWeight[3] = {1.0f, 1.0f, 1.0f};
+  const uint8_t expectedColor[3] = {2, AMBIENT, 200};
+
+  // Test
+  add_log_likelihood_to_particles(logWeight, expectedColor, 3, logLikelihood);
+
+  // Assert
+  TEST_ASSERT_EQUAL_FLOAT(-1.0f, logWeight[0]);
+  TEST_ASSERT_EQUAL_FLOAT(1.0f - AMBIENT, logWeight[1]);
+  TEST_ASSERT_EQUAL_FLOAT(1.0f - AMBIENT, logWeight[2]);
+}
+
+void testThatNormalisedWeightsSumToOne() {
+  // Fixture
+  float logWeight[N] = {0.0f, -1.0f, -2.0f, 0.5f, -0.3f, -4.0f};
+  float weight[N];
+
+  // Test
+  normalise_log_weights(logWeight, weight, N);
+
+  // Assert
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f, sum(weight, N));
+  for (int i = 0; i < N; i++) {
+    // the log-weights are normalised as well
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, weight[i], expf(logWeight[i]));
+  }
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, expf(-1.0f), weight[1] / weight[0]);
+}
+
+void testThatWeightsOfUnderflowingLogWeightsStayFinite() {
+  // Fixture
+  // expf of any of these underflows to 0, without subtracting the maximum the sum is 0
+  float logWeight[N] = {-2000.0f, -2001.0f, -2000.0f, -2003.0f, -1e6f, -2000.5f};
+  float weight[N];
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, expf(logWeight[0]));
+
+  // Test
+  normalise_log_weights(logWeight, weight, N);
+
+  // Assert
+  for (int i = 0; i < N; i++) {
+    TEST_ASSERT_TRUE(isfinite(weight[i]));
+    TEST_ASSERT_TRUE(isfinite(logWeight[i]));
+  }
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f, sum(weight, N));
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, expf(-1.0f), weight[1] / weight[0]);
+  TEST_ASSERT_EQUAL_FLOAT(weight[0], weight[2]);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, weight[4]);
+}
+
+void testThatRepeatedUpdatesDoNotDrift() {
+  // Fixture
+  float logWeight[N] = {0};
+  float weight[N];
+  const uint8_t expectedColor[N] = {0, 1, 1, 2, 0, AMBIENT};
+  float posterior[C] = {0};
+  posterior[1] = 1.0f;
+
+  // Test
+  // many unlikely measurements, the log-weights are renormalised every time
+  for (int k = 0; k < 1000; k++) {
+    for (int c = 0; c < C; c++) {
+      logLikelihood[c] = 0.0f;
+    }
+    color_measurement_add_log_likelihood(&model, posterior, 0, logLikelihood);
+    add_log_likelihood_to_particles(logWeight, expectedColor, N, logLikelihood);
+    normalise_log_weights(logWeight, weight, N);
+  }
+
+  // Assert
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f, sum(weight, N));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.5f, weight[1]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.5f, weight[2]);
+  TEST_ASSERT_TRUE(isfinite(logWeight[0]));
+}
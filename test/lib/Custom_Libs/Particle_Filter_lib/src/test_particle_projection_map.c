@@ -0,0 +1,155 @@
+// File under test Particle_projection_map.c
+#include "Particle_projection_map.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "unity.h"
+
+#include "mock_mem.h"
+#include "mock_storage.h"
+
+#define CELL_SIZE 1.0f
+#define FOCAL_LENGTH 10.0f
+#define X_MIN 20
+#define SLAB_SHIFT 2
+#define NUM_OF_SLABS 3
+// the projected cell at the centre of the middle slab is 1.6 cm
+#define X_MIDDLE 26.0f
+#define CELL_MIDDLE 1.6f
+#define ORIGIN_Y 5.0f
+#define ORIGIN_Z -5.0f
+
+// The generated map is not part of the test build, the lookup uses the maps built by the fixture
+const ProjectionMap default_projection_map = {0};
+
+static ProjectionMap map;
+static float inverseCellSize[NUM_OF_SLABS];
+
+// Builds a map like tools/make/projection_map.py, colour (row + col) % 7 with the top row first
+static void fixtureMap(uint8_t size) {
+  map.map_size = size;
+  map.cell_size = CELL_SIZE;
+  map.focal_length = FOCAL_LENGTH;
+  map.origin_y = ORIGIN_Y;
+  map.origin_z = ORIGIN_Z;
+  map.x_min = X_MIN;
+  map.slab_shift = SLAB_SHIFT;
+  map.num_of_slabs = NUM_OF_SLABS;
+  for (int s = 0; s < NUM_OF_SLABS; s++) {
+    inverseCellSize[s] = 1.0f / projection_map_cell_size(&map, X_MIN + (s + 0.5f) * (1 << SLAB_SHIFT));
+  }
+  map.inverse_cell_size = inverseCellSize;
+
+  memset(map.raster, PROJECTION_MAP_AMBIENT, sizeof(map.raster));
+  for (int row = 0; row < size; row++) {
+    for (int col = 0; col < size; col++) {
+      map.raster[((size - row) << PROJECTION_MAP_RASTER_BITS) | (col + 1)] = (uint8_t)((row + col) % 7);
+    }
+  }
+}
+
+// The expected colour of the centre of a cell of the map, row 0 is the top row
+static uint8_t colorOfCell(int row, int col) {
+  return (uint8_t)((row + col) % 7);
+}
+
+static uint8_t colorAt(float col, float rowFromBottom) {
+  return projection_map_color(&map, X_MIDDLE, ORIGIN_Y + col * CELL_MIDDLE, ORIGIN_Z + rowFromBottom * CELL_MIDDLE);
+}
+
+void setUp(void) {
+  fixtureMap(3);
+}
+
+void testThatTheCentreOfEveryCellHasTheColourOfTheCell() {
+  // Fixture
+  // Test
+  // Assert
+  for (int row = 0; row < 3; row++) {
+    for (int col = 0; col < 3; col++) {
+      TEST_ASSERT_EQUAL_UINT8(colorOfCell(row, col), colorAt(col + 0.5f, 2 - row + 0.5f));
+    }
+  }
+}
+
+void testThatTheOriginIsTheBottomLeftCorner() {
+  // Fixture
+  // Test
+  // Assert
+  TEST_ASSERT_EQUAL_UINT8(colorOfCell(2, 0), colorAt(0.01f, 0.01f));
+  TEST_ASSERT_EQUAL_UINT8(PROJECTION_MAP_AMBIENT, colorAt(-0.01f, 0.01f));
+  TEST_ASSERT_EQUAL_UINT8(PROJECTION_MAP_AMBIENT, colorAt(0.01f, -0.01f));
+}
+
+void testThatPositionsJustOutsideOfTheMapAreAmbient() {
+  // Fixture
+  // Test
+  // Assert
+  for (int i = 0; i < 3; i++) {
+    const float centre = i + 0.5f;
+    TEST_ASSERT_EQUAL_UINT8(PROJECTION_MAP_AMBIENT, colorAt(-0.5f, centre));
+    TEST_ASSERT_EQUAL_UINT8(PROJECTION_MAP_AMBIENT, colorAt(3.5f, centre));
+    TEST_ASSERT_EQUAL_UINT8(PROJECTION_MAP_AMBIENT, colorAt(centre, -0.5f));
+    TEST_ASSERT_EQUAL_UINT8(PROJECTION_MAP_AMBIENT, colorAt(centre, 3.5f));
+  }
+}
+
+void testThatNegativePositionsFarOutsideOfTheMapSaturateToTheBorder() {
+  // Fixture
+  // Test
+  // Assert
+  // more than a cell below the origin is negative before the saturation
+  TEST_ASSERT_EQUAL_UINT8(PROJECTION_MAP_AMBIENT, colorAt(-1.5f, 1.5f));
+  TEST_ASSERT_EQUAL_UINT8(PROJECTION_MAP_AMBIENT, colorAt(1.5f, -1.5f));
+  TEST_ASSERT_EQUAL_UINT8(PROJECTION_MAP_AMBIENT, colorAt(-1000.0f, -1000.0f));
+}
+
+void testThatAFullSizeMapEndsInTheBorderOfTheRaster() {
+  // Fixture
+  fixtureMap(PROJECTION_MAP_MAX_SIZE);
+  const float last = PROJECTION_MAP_MAX_SIZE - 0.5f;
+
+  // Test
+  // Assert
+  // the top right cell of the map is next to the last raster row and column
+  TEST_ASSERT_EQUAL_UINT8(colorOfCell(0, PROJECTION_MAP_MAX_SIZE - 1), colorAt(last, last));
+  TEST_ASSERT_EQUAL_UINT8(PROJECTION_MAP_AMBIENT, colorAt(last + 1.0f, last));
+  TEST_ASSERT_EQUAL_UINT8(PROJECTION_MAP_AMBIENT, colorAt(last, last + 1.0f));
+}
+
+void testThatPositiveValuesFarOutsideOfAFullSizeMapSaturateToTheBorder() {
+  // Fixture
+  fixtureMap(PROJECTION_MAP_MAX_SIZE);
+  const float centre = PROJECTION_MAP_MAX_SIZE / 2 + 0.5f;
+
+  // Test
+  // Assert
+  // beyond the raster, without the saturation these would read the next rows or out of the raster
+  TEST_ASSERT_EQUAL_UINT8(PROJECTION_MAP_AMBIENT, colorAt(PROJECTION_MAP_RASTER_DIM + 0.5f, centre));
+  TEST_ASSERT_EQUAL_UINT8(PROJECTION_MAP_AMBIENT, colorAt(centre, PROJECTION_MAP_RASTER_DIM + 0.5f));
+  TEST_ASSERT_EQUAL_UINT8(PROJECTION_MAP_AMBIENT, colorAt(1000.0f, 1000.0f));
+}
+
+void testThatTheCellsGrowWithTheDistance() {
+  // Fixture
+  // 1.5 cm is in the second cell at the first slab (1.2 cm cells) and in the first cell at the last slab (2 cm cells)
+  const float y = ORIGIN_Y + 1.5f;
+  const float z = ORIGIN_Z + 0.5f;
+
+  // Test
+  // Assert
+  TEST_ASSERT_EQUAL_UINT8(colorOfCell(2, 1), projection_map_color(&map, X_MIN + 2.0f, y, z));
+  TEST_ASSERT_EQUAL_UINT8(colorOfCell(2, 0), projection_map_color(&map, X_MIN + 10.0f, y, z));
+}
+
+void testThatDistancesOutsideOfTheSlabsUseTheNearestSlab() {
+  // Fixture
+  const float y = ORIGIN_Y + 1.5f;
+  const float z = ORIGIN_Z + 0.5f;
+
+  // Test
+  // Assert
+  TEST_ASSERT_EQUAL_UINT8(colorOfCell(2, 1), projection_map_color(&map, X_MIN - 15.0f, y, z));
+  TEST_ASSERT_EQUAL_UINT8(colorOfCell(2, 0), projection_map_color(&map, X_MIN + 500.0f, y, z));
+}
@@ -0,0 +1,274 @@
+// File under test Particle_resampling.c
+#include "Particle_resampling.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "unity.h"
+
+#include "mock_gen_norm.h"
+
+// Build the arm dsp math lib and use the "real thing" instead of mocking calls to it
+// @BUILD_LIB ARM_DSP_MATH
+
+#define N 8
+#define MAX_RANDOM_VALUES (N + 1)
+
+// n * w = {2.5, 1.5, 4, 0, 0, 0, 0, 0} sample points
+static const float weights[N] = {0.3125f, 0.1875f, 0.5f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+static float w[N];
+static uint16_t ancestor[N];
+static float randomValues[MAX_RANDOM_VALUES];
+static int numOfRandomValues;
+static int numOfRandomCalls;
+
+// Returns the fixture values of the random generator in order
+static float mockRandVal(int cmock_num_calls) {
+  TEST_ASSERT_TRUE(numOfRandomCalls < numOfRandomValues);
+  return randomValues[numOfRandomCalls++];
+}
+
+static void fixtureRandomValues(const float values[], int n) {
+  for (int i = 0; i < n; i++) {
+    randomValues[i] = values[i];
+  }
+  numOfRandomValues = n;
+}
+
+static void countCopies(uint16_t copies[N]) {
+  for (int i = 0; i < N; i++) {
+    copies[i] = 0;
+  }
+  for (int j = 0; j < N; j++) {
+    TEST_ASSERT_TRUE(ancestor[j] < N);
+    copies[ancestor[j]]++;
+  }
+}
+
+static void assertCopies(const uint16_t expected[N]) {
+  uint16_t copies[N];
+  countCopies(copies);
+  for (int i = 0; i < N; i++) {
+    TEST_ASSERT_EQUAL_UINT16(expected[i], copies[i]);
+  }
+}
+
+// The particle index of the walk only moves forward: at most N - 1 steps over the weights and N sample points
+static void assertNonDecreasing(int from, int to) {
+  for (int j = from + 1; j < to; j++) {
+    TEST_ASSERT_TRUE(ancestor[j - 1] <= ancestor[j]);
+  }
+}
+
+void setUp(void) {
+  for (int i = 0; i < N; i++) {
+    w[i] = weights[i];
+    ancestor[i] = 0xFFFF;
+  }
+  numOfRandomValues = 0;
+  numOfRandomCalls = 0;
+  rand_val_StubWithCallback(mockRandVal);
+}
+
+void testThatSystematicResamplingCopiesTheExpectedMultiplicities() {
+  // Fixture
+  const float offset[] = {0.25f};
+  fixtureRandomValues(offset, 1);
+  // sample points 0.25, 1.25, ... 7.25
+  const uint16_t expected[N] = {3, 1, 4, 0, 0, 0, 0, 0};
+
+  // Test
+  resample_particle_indices(resample_systematic, w, N, ancestor);
+
+  // Assert
+  assertCopies(expected);
+  assertNonDecreasing(0, N);
+  TEST_ASSERT_EQUAL_INT(1, numOfRandomCalls);
+}
+
+void testThatSystematicResamplingStaysWithinOneCopyOfTheWeight() {
+  const float offsets[] = {0.0f, 0.49f, 0.5f, 0.51f, 0.999f};
+  for (int k = 0; k < 5; k++) {
+    // Fixture
+    numOfRandomCalls = 0;
+    fixtureRandomValues(&offsets[k], 1);
+
+    // Test
+    resample_particle_indices(resample_systematic, w, N, ancestor);
+
+    // Assert
+    uint16_t copies[N];
+    countCopies(copies);
+    for (int i = 0; i < N; i++) {
+      const float points = weights[i] * N;
+      TEST_ASSERT_TRUE(copies[i] >= (uint16_t)floorf(points));
+      TEST_ASSERT_TRUE(copies[i] <= (uint16_t)ceilf(points));
+    }
+  }
+}
+
+void testThatStratifiedResamplingDrawsOnePointPerInterval() {
+  // Fixture
+  // sample points 0.9, 1.9, 2.6, 3.1, 4.5, 5.5, 6.5, 7.5
+  const float values[N] = {0.9f, 0.9f, 0.6f, 0.1f, 0.5f, 0.5f, 0.5f, 0.5f};
+  fixtureRandomValues(values, N);
+  const uint16_t expected[N] = {2, 2, 4, 0, 0, 0, 0, 0};
+
+  // Test
+  resample_particle_indices(resample_stratified, w, N, ancestor);
+
+  // Assert
+  assertCopies(expected);
+  assertNonDecreasing(0, N);
+  TEST_ASSERT_EQUAL_INT(N, numOfRandomCalls);
+}
+
+void testThatResidualResamplingCopiesTheWholePartWithoutDrawing() {
+  // Fixture
+  // the residuals 0.5, 0.5 cover one sample point, the offset picks particle 0 or 1
+  const float lowOffset[] = {0.25f};
+  const float highOffset[] = {0.75f};
+  const uint16_t expectedLow[N] = {3, 1, 4, 0, 0, 0, 0, 0};
+  const uint16_t expectedHigh[N] = {2, 2, 4, 0, 0, 0, 0, 0};
+
+  // Test
+  fixtureRandomValues(lowOffset, 1);
+  resample_particle_indices(resample_residual, w, N, ancestor);
+
+  // Assert
+  assertCopies(expectedLow);
+  // 7 whole copies first, then the drawn particle
+  assertNonDecreasing(0, 7);
+  TEST_ASSERT_EQUAL_UINT16(0, ancestor[7]);
+
+  // Test
+  numOfRandomCalls = 0;
+  fixtureRandomValues(highOffset, 1);
+  resample_particle_indices(resample_residual, w, N, ancestor);
+
+  // Assert
+  assertCopies(expectedHigh);
+  TEST_ASSERT_EQUAL_UINT16(1, ancestor[7]);
+}
+
+void testThatResidualResamplingOfWholeWeightsIsDeterministic() {
+  // Fixture
+  const float uniform = 1.0f / N;
+  for (int i = 0; i < N; i++) {
+    w[i] = uniform;
+  }
+  const float offset[] = {0.5f};
+  fixtureRandomValues(offset, 1);
+
+  // Test
+  resample_particle_indices(resample_residual, w, N, ancestor);
+
+  // Assert
+  for (int j = 0; j < N; j++) {
+    TEST_ASSERT_EQUAL_UINT16(j, ancestor[j]);
+  }
+}
+
+void testThatAllMethodsReachTheLastParticle() {
+  // Fixture
+  // worst case for the walk, every sample point is past N - 1 particles without weight
+  for (int i = 0; i < N; i++) {
+    w[i] = 0.0f;
+  }
+  w[N - 1] = 1.0f;
+  const float values[MAX_RANDOM_VALUES] = {0.999f, 0.999f, 0.999f, 0.999f, 0.999f, 0.999f, 0.999f, 0.999f, 0.999f};
+  const ResampleMethod methods[] = {resample_systematic, resample_stratified, resample_residual};
+
+  for (int k = 0; k < 3; k++) {
+    numOfRandomCalls = 0;
+    fixtureRandomValues(values, MAX_RANDOM_VALUES);
+
+    // Test
+    resample_particle_indices(methods[k], w, N, ancestor);
+
+    // Assert
+    for (int j = 0; j < N; j++) {
+      TEST_ASSERT_EQUAL_UINT16(N - 1, ancestor[j]);
+    }
+  }
+}
+
+void testThatRoundingOfTheWeightsDoesNotWalkPastTheLastParticle() {
+  // Fixture
+  // the weights sum to just below 1
+  for (int i = 0; i < N; i++) {
+    w[i] = 0.1249999f;
+  }
+  // the last sample point rounds to 8.0
+  const float offset[] = {0.9999999f};
+  fixtureRandomValues(offset, 1);
+
+  // Test
+  resample_particle_indices(resample_systematic, w, N, ancestor);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT16(N - 1, ancestor[N - 1]);
+  assertNonDecreasing(0, N);
+}
+
+void testThatEffectiveSampleSizeRangesFromOneToN() {
+  // Fixture
+  float uniform[N];
+  float single[N] = {0};
+  float two[N] = {0};
+  for (int i = 0; i < N; i++) {
+    uniform[i] = 1.0f / N;
+  }
+  single[3] = 1.0f;
+  two[1] = 0.5f;
+  two[6] = 0.5f;
+
+  // Test
+  // Assert
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, (float)N, effective_sample_size(uniform, N));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f, effective_sample_size(single, N));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 2.0f, effective_sample_size(two, N));
+  // 1 / (2.5^2 + 1.5^2 + 4^2) * 64
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 64.0f / 24.5f, effective_sample_size(w, N));
+}
+
+void testThatResamplingIsOnlyNeededBelowTheThreshold() {
+  // Fixture
+  const float percent = 50.0f;
+
+  // Test
+  // Assert
+  TEST_ASSERT_FALSE(resampling_needed((float)N, N, percent));
+  TEST_ASSERT_FALSE(resampling_needed(N * 0.5f, N, percent));
+  TEST_ASSERT_TRUE(resampling_needed(N * 0.5f - 0.01f, N, percent));
+  TEST_ASSERT_TRUE(resampling_needed(1.0f, N, percent));
+  TEST_ASSERT_FALSE(resampling_needed(1.0f, N, 0.0f));
+  TEST_ASSERT_TRUE(resampling_needed((float)N - 0.01f, N, 100.0f));
+}
+
+void testThatNormalisingScalesTheWeightsToOne() {
+  // Fixture
+  float unnormalised[N] = {1.0f, 3.0f, 0.0f, 4.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+  // Test
+  float sum = normalise_particle_weights(unnormalised, N);
+
+  // Assert
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, 8.0f, sum);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.125f, unnormalised[0]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.375f, unnormalised[1]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.5f, unnormalised[3]);
+}
+
+void testThatZeroWeightsAreNotNormalised() {
+  // Fixture
+  float zero[N] = {0};
+
+  // Test
+  float sum = normalise_particle_weights(zero, N);
+
+  // Assert
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, sum);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, zero[0]);
+}
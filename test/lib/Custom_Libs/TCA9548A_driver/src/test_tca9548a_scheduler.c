@@ -0,0 +1,311 @@
+// File under test tca9548a_scheduler.c
+#include "tca9548a_scheduler.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "unity.h"
+
+#include "mock_i2cdev.h"
+
+#define COLOR_SENSOR_ADDRESS 0x29
+#define OTHER_ADDRESS 0x44
+#define MAX_EVENTS 32
+#define NO_FAILURE 0xFF
+
+// The fake bus: the mux register and a trace of every mux write and device transfer
+typedef struct {
+  bool isMuxWrite;
+  uint8_t mask;
+  uint8_t address;
+} BusEvent;
+
+I2cDrv deckBus;
+
+static tca9548a_handle_t tca;
+static tca9548a_scheduler scheduler;
+static uint8_t muxRegister;
+static bool transferInFlight;
+static BusEvent events[MAX_EVENTS];
+static uint8_t numOfEvents;
+// index of the mux write or device transfer that times out
+static uint8_t failingMuxWrite;
+static uint8_t failingTransfer;
+static uint8_t numOfMuxWrites;
+static uint8_t numOfTransfers;
+static uint8_t buf[4];
+
+// A device transfer is only started when the mux connects the device and no other device with the same address
+static bool fakeDeviceTransfer(uint8_t address) {
+  TEST_ASSERT_FALSE(transferInFlight);
+  transferInFlight = true;
+
+  uint8_t responding = 0;
+  for (uint8_t i = 0; i < scheduler.num_of_devices; i++) {
+    const tca9548a_scheduler_device* d = &scheduler.devices[i];
+    if ((d->address == address) && (((uint8_t)d->channel & muxRegister) == (uint8_t)d->channel)) {
+      responding++;
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT8(1, responding);
+
+  TEST_ASSERT_TRUE(numOfEvents < MAX_EVENTS);
+  events[numOfEvents++] = (BusEvent){.isMuxWrite = false, .mask = muxRegister, .address = address};
+  bool ok = (numOfTransfers++ != failingTransfer);
+
+  transferInFlight = false;
+  return ok;
+}
+
+static bool fakeReadReg8(I2C_Dev *dev, uint8_t devAddress, uint8_t memAddress, uint16_t len, uint8_t *data, int cmock_num_calls) {
+  return fakeDeviceTransfer(devAddress);
+}
+
+static bool fakeWrite(I2C_Dev *dev, uint8_t devAddress, uint16_t len, const uint8_t *data, int cmock_num_calls) {
+  return fakeDeviceTransfer(devAddress);
+}
+
+// The mux control register is never written while a device transfer is in flight
+static uint8_t fakeMuxWrite(uint8_t addr, uint8_t *data, uint16_t len) {
+  TEST_ASSERT_FALSE(transferInFlight);
+  TEST_ASSERT_EQUAL_UINT8(TCA9548A_BASE_ADDR, addr);
+  TEST_ASSERT_EQUAL_UINT16(1, len);
+
+  TEST_ASSERT_TRUE(numOfEvents < MAX_EVENTS);
+  events[numOfEvents++] = (BusEvent){.isMuxWrite = true, .mask = data[0], .address = addr};
+  if (numOfMuxWrites++ == failingMuxWrite) {
+    // the register content is unknown after a timeout
+    muxRegister = 0xFF;
+    return 1;
+  }
+  muxRegister = data[0];
+  return 0;
+}
+
+static tca9548a_transfer readReg(int8_t device) {
+  tca9548a_transfer t = {.device = (uint8_t)device, .type = TCA9548A_TRANSFER_READ_REG, .reg = 0x14, .buf = buf, .len = sizeof(buf), .ok = false};
+  return t;
+}
+
+static void assertMuxWrite(uint8_t event, uint8_t mask) {
+  TEST_ASSERT_TRUE(event < numOfEvents);
+  TEST_ASSERT_TRUE(events[event].isMuxWrite);
+  TEST_ASSERT_EQUAL_UINT8(mask, events[event].mask);
+}
+
+static void assertTransfer(uint8_t event, uint8_t address, uint8_t mask) {
+  TEST_ASSERT_TRUE(event < numOfEvents);
+  TEST_ASSERT_FALSE(events[event].isMuxWrite);
+  TEST_ASSERT_EQUAL_UINT8(address, events[event].address);
+  TEST_ASSERT_EQUAL_UINT8(mask, events[event].mask);
+}
+
+void setUp(void) {
+  memset(&tca, 0, sizeof(tca));
+  tca.iic_write = fakeMuxWrite;
+  muxRegister = 0;
+  transferInFlight = false;
+  numOfEvents = 0;
+  failingMuxWrite = NO_FAILURE;
+  failingTransfer = NO_FAILURE;
+  numOfMuxWrites = 0;
+  numOfTransfers = 0;
+
+  i2cdevReadReg8_StubWithCallback(fakeReadReg8);
+  i2cdevWrite_StubWithCallback(fakeWrite);
+
+  tca9548a_scheduler_init(&scheduler, &tca);
+}
+
+void testThatTransfersAreGroupedPerChannelAndKeepTheOrderOfADevice() {
+  // Fixture
+  // three colour sensors with the same address on their own channels
+  int8_t s0 = tca9548a_scheduler_add_device(&scheduler, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL0);
+  int8_t s1 = tca9548a_scheduler_add_device(&scheduler, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL1);
+  int8_t s2 = tca9548a_scheduler_add_device(&scheduler, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL2);
+  tca9548a_transfer transfers[] = {readReg(s0), readReg(s1), readReg(s2), readReg(s0), readReg(s1)};
+
+  // Test
+  uint8_t ok = tca9548a_scheduler_execute(&scheduler, transfers, 5);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT8(5, ok);
+  TEST_ASSERT_EQUAL_UINT8(8, numOfEvents);
+  assertMuxWrite(0, TCA9548A_CHANNEL0);
+  assertTransfer(1, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL0);
+  assertTransfer(2, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL0);
+  assertMuxWrite(3, TCA9548A_CHANNEL1);
+  assertTransfer(4, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL1);
+  assertTransfer(5, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL1);
+  assertMuxWrite(6, TCA9548A_CHANNEL2);
+  assertTransfer(7, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL2);
+  TEST_ASSERT_EQUAL_UINT32(3, scheduler.mux_writes);
+  TEST_ASSERT_EQUAL_UINT32(5, scheduler.transfers);
+}
+
+void testThatTheEnabledChannelIsServedFirstWithoutAMuxWrite() {
+  // Fixture
+  int8_t s0 = tca9548a_scheduler_add_device(&scheduler, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL0);
+  int8_t s1 = tca9548a_scheduler_add_device(&scheduler, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL1);
+  tca9548a_transfer first[] = {readReg(s1)};
+  tca9548a_scheduler_execute(&scheduler, first, 1);
+  numOfEvents = 0;
+  tca9548a_transfer transfers[] = {readReg(s0), readReg(s1)};
+
+  // Test
+  uint8_t ok = tca9548a_scheduler_execute(&scheduler, transfers, 2);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT8(2, ok);
+  TEST_ASSERT_EQUAL_UINT8(3, numOfEvents);
+  assertTransfer(0, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL1);
+  assertMuxWrite(1, TCA9548A_CHANNEL0);
+  assertTransfer(2, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL0);
+}
+
+void testThatChannelsWithoutSharedAddressesAreEnabledTogether() {
+  // Fixture
+  int8_t sensor = tca9548a_scheduler_add_device(&scheduler, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL0);
+  int8_t other = tca9548a_scheduler_add_device(&scheduler, OTHER_ADDRESS, TCA9548A_CHANNEL3);
+  tca9548a_transfer transfers[] = {readReg(sensor), readReg(other)};
+
+  // Test
+  uint8_t ok = tca9548a_scheduler_execute(&scheduler, transfers, 2);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT8(2, ok);
+  TEST_ASSERT_EQUAL_UINT8(3, numOfEvents);
+  assertMuxWrite(0, TCA9548A_CHANNEL0 | TCA9548A_CHANNEL3);
+  assertTransfer(1, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL0 | TCA9548A_CHANNEL3);
+  assertTransfer(2, OTHER_ADDRESS, TCA9548A_CHANNEL0 | TCA9548A_CHANNEL3);
+}
+
+void testThatWritesAreScheduledLikeReads() {
+  // Fixture
+  int8_t s0 = tca9548a_scheduler_add_device(&scheduler, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL0);
+  int8_t s1 = tca9548a_scheduler_add_device(&scheduler, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL1);
+  tca9548a_transfer transfers[] = {readReg(s1), readReg(s0)};
+  transfers[1].type = TCA9548A_TRANSFER_WRITE;
+
+  // Test
+  uint8_t ok = tca9548a_scheduler_execute(&scheduler, transfers, 2);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT8(2, ok);
+  assertMuxWrite(0, TCA9548A_CHANNEL1);
+  assertMuxWrite(2, TCA9548A_CHANNEL0);
+  assertTransfer(3, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL0);
+}
+
+void testThatAMuxTimeoutFailsTheTransfersOfThatChannelOnly() {
+  // Fixture
+  int8_t s0 = tca9548a_scheduler_add_device(&scheduler, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL0);
+  int8_t s1 = tca9548a_scheduler_add_device(&scheduler, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL1);
+  tca9548a_transfer transfers[] = {readReg(s0), readReg(s1)};
+  failingMuxWrite = 0;
+
+  // Test
+  uint8_t ok = tca9548a_scheduler_execute(&scheduler, transfers, 2);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT8(1, ok);
+  TEST_ASSERT_FALSE(transfers[0].ok);
+  TEST_ASSERT_TRUE(transfers[1].ok);
+  TEST_ASSERT_EQUAL_UINT8(3, numOfEvents);
+  assertMuxWrite(0, TCA9548A_CHANNEL0);
+  assertMuxWrite(1, TCA9548A_CHANNEL1);
+  assertTransfer(2, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL1);
+}
+
+void testThatTheMuxIsWrittenAgainAfterATimeout() {
+  // Fixture
+  int8_t s0 = tca9548a_scheduler_add_device(&scheduler, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL0);
+  tca9548a_transfer first[] = {readReg(s0)};
+  tca9548a_scheduler_execute(&scheduler, first, 1);
+  // the second write of the same channel times out, the register content is unknown
+  failingMuxWrite = 1;
+  tca.current_active_channel = 0;
+  tca9548a_transfer failing[] = {readReg(s0)};
+  tca9548a_scheduler_execute(&scheduler, failing, 1);
+  numOfEvents = 0;
+  tca9548a_transfer transfers[] = {readReg(s0)};
+
+  // Test
+  uint8_t ok = tca9548a_scheduler_execute(&scheduler, transfers, 1);
+
+  // Assert
+  TEST_ASSERT_FALSE(failing[0].ok);
+  TEST_ASSERT_EQUAL_UINT8(1, ok);
+  TEST_ASSERT_EQUAL_UINT8(2, numOfEvents);
+  assertMuxWrite(0, TCA9548A_CHANNEL0);
+  assertTransfer(1, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL0);
+  TEST_ASSERT_TRUE(scheduler.cache_valid);
+}
+
+void testThatAMuxTimeoutDoesNotTrustTheCachedChannel() {
+  // Fixture
+  int8_t s0 = tca9548a_scheduler_add_device(&scheduler, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL0);
+  int8_t s1 = tca9548a_scheduler_add_device(&scheduler, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL1);
+  tca9548a_transfer first[] = {readReg(s0)};
+  tca9548a_scheduler_execute(&scheduler, first, 1);
+  // switching to channel 1 times out, the handle still says channel 0
+  failingMuxWrite = 1;
+  tca9548a_transfer failing[] = {readReg(s1)};
+  tca9548a_scheduler_execute(&scheduler, failing, 1);
+  numOfEvents = 0;
+  tca9548a_transfer transfers[] = {readReg(s0)};
+
+  // Test
+  uint8_t ok = tca9548a_scheduler_execute(&scheduler, transfers, 1);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT8(1, ok);
+  assertMuxWrite(0, TCA9548A_CHANNEL0);
+  assertTransfer(1, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL0);
+}
+
+void testThatADeviceTimeoutOnlyFailsItsOwnTransfer() {
+  // Fixture
+  int8_t s0 = tca9548a_scheduler_add_device(&scheduler, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL0);
+  int8_t s1 = tca9548a_scheduler_add_device(&scheduler, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL1);
+  tca9548a_transfer transfers[] = {readReg(s0), readReg(s0), readReg(s1)};
+  failingTransfer = 0;
+
+  // Test
+  uint8_t ok = tca9548a_scheduler_execute(&scheduler, transfers, 3);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT8(2, ok);
+  TEST_ASSERT_FALSE(transfers[0].ok);
+  TEST_ASSERT_TRUE(transfers[1].ok);
+  TEST_ASSERT_TRUE(transfers[2].ok);
+  // the mux register is still known, no extra write
+  TEST_ASSERT_EQUAL_UINT32(2, scheduler.mux_writes);
+}
+
+void testThatTransfersToUnknownDevicesAreNotExecuted() {
+  // Fixture
+  int8_t s0 = tca9548a_scheduler_add_device(&scheduler, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL0);
+  tca9548a_transfer transfers[] = {readReg(5), readReg(s0)};
+
+  // Test
+  uint8_t ok = tca9548a_scheduler_execute(&scheduler, transfers, 2);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT8(1, ok);
+  TEST_ASSERT_FALSE(transfers[0].ok);
+  TEST_ASSERT_EQUAL_UINT32(1, scheduler.transfers);
+}
+
+void testThatAddDeviceFailsWhenFull() {
+  // Fixture
+  for (int i = 0; i < TCA9548A_SCHEDULER_MAX_DEVICES; i++) {
+    tca9548a_scheduler_add_device(&scheduler, (uint8_t)(0x10 + i), TCA9548A_CHANNEL0);
+  }
+
+  // Test
+  int8_t actual = tca9548a_scheduler_add_device(&scheduler, COLOR_SENSOR_ADDRESS, TCA9548A_CHANNEL1);
+
+  // Assert
+  TEST_ASSERT_EQUAL_INT8(-1, actual);
+}
@@ -0,0 +1,183 @@
+// File under test color.c
+#include "color.h"
+
+#include <stdint.h>
+#include <math.h>
+#include "unity.h"
+
+// The float path of the colour deck is the reference
+#include "KNN.h"
+
+#define NUM_OF_SAMPLES 100000
+// Q15 chroma, hue steps of 60/16384 degrees and the lookup table stay below this
+#define CHROMA_TOLERANCE 0.0002f
+#define PI 3.14159265358979
+
+static uint32_t lcg_state;
+
+void setUp(void) {
+  lcg_state = 12345;
+}
+
+static uint16_t randomCount(uint16_t range) {
+  lcg_state = lcg_state * 1664525u + 1013904223u;
+  return (uint16_t)((lcg_state >> 8) % ((uint32_t)range + 1));
+}
+
+static rgb_raw randomRaw(uint16_t range) {
+  rgb_raw raw = {.r = randomCount(range), .g = randomCount(range), .b = randomCount(range), .c = randomCount(range)};
+  return raw;
+}
+
+// normalisation, delta, hsv and the polar to carthesian conversion of the KNN
+static KNNPoint floatChroma(rgb_raw in1, rgb_raw in2) {
+  tcs34725_Color_data d1 = {.rgb_raw_data = in1};
+  tcs34725_Color_data d2 = {.rgb_raw_data = in2};
+  processRawData(&d1);
+  processRawData(&d2);
+  processDeltaData(&d1, &d2);
+  KNNPoint p = {.hue_polar = d1.hsv_delta_data.h, .sat_polar = d1.hsv_delta_data.s, .x_cart = 0, .y_cart = 0, .ID = -1};
+  pol2Cart(&p);
+  return p;
+}
+
+// the same hexcone hue and saturation in double, exact for small deltas where the float path rounds
+static void doubleChroma(rgb_raw in1, rgb_raw in2, double* x, double* y) {
+  double r = (double)in1.r - in2.r;
+  double g = (double)in1.g - in2.g;
+  double b = (double)in1.b - in2.b;
+  double max = fmax(r, fmax(g, b));
+  double min = fmin(r, fmin(g, b));
+  double absMax = fmax(fabs(r), fmax(fabs(g), fabs(b)));
+  double delta = max - min;
+  *x = 0.0;
+  *y = 0.0;
+  if (delta == 0.0) {
+    return;
+  }
+  double h;
+  if (r >= max) {
+    h = (g - b) / delta;
+  } else if (g >= max) {
+    h = 2.0 + (b - r) / delta;
+  } else {
+    h = 4.0 + (r - g) / delta;
+  }
+  h *= PI / 3.0;
+  double s = delta / (2.0 * absMax);
+  *x = s * cos(h);
+  *y = s * sin(h);
+}
+
+static void assertChromaMatchesFloatPath(rgb_raw in1, rgb_raw in2) {
+  // Fixture
+  KNNPoint expected = floatChroma(in1, in2);
+
+  // Test
+  chroma_q15 actual = rgb_raw_delta2chroma_q15(in1, in2);
+
+  // Assert
+  TEST_ASSERT_FLOAT_WITHIN(CHROMA_TOLERANCE, expected.x_cart, q15ToFloat(actual.x));
+  TEST_ASSERT_FLOAT_WITHIN(CHROMA_TOLERANCE, expected.y_cart, q15ToFloat(actual.y));
+}
+
+void testThatChromaMatchesFloatPathForFullRangeSamples() {
+  for (int i = 0; i < NUM_OF_SAMPLES; i++) {
+    assertChromaMatchesFloatPath(randomRaw(UINT16_MAX), randomRaw(UINT16_MAX));
+  }
+}
+
+void testThatChromaIsExactForSmallDeltas() {
+  // the float path normalises before the delta and loses the last counts, double is the reference here
+  for (int i = 0; i < NUM_OF_SAMPLES; i++) {
+    // Fixture
+    rgb_raw in1 = randomRaw(UINT16_MAX - 8);
+    rgb_raw in2 = in1;
+    in2.r += randomCount(8);
+    in2.g += randomCount(8);
+    in2.b += randomCount(8);
+    double expectedX;
+    double expectedY;
+    doubleChroma(in1, in2, &expectedX, &expectedY);
+
+    // Test
+    chroma_q15 actual = rgb_raw_delta2chroma_q15(in1, in2);
+
+    // Assert
+    TEST_ASSERT_FLOAT_WITHIN(CHROMA_TOLERANCE, (float)expectedX, q15ToFloat(actual.x));
+    TEST_ASSERT_FLOAT_WITHIN(CHROMA_TOLERANCE, (float)expectedY, q15ToFloat(actual.y));
+  }
+}
+
+void testThatChromaMatchesFloatPathForExtremeDeltas() {
+  const rgb_raw zero = {0, 0, 0, 0};
+  const rgb_raw extremes[] = {
+    {UINT16_MAX, 0, 0, 0},
+    {0, UINT16_MAX, 0, 0},
+    {0, 0, UINT16_MAX, 0},
+    {UINT16_MAX, UINT16_MAX, 0, 0},
+    {UINT16_MAX, 0, UINT16_MAX, 0},
+    {0, UINT16_MAX, UINT16_MAX, 0},
+    {UINT16_MAX, 1, 0, 0},
+    {1, 0, UINT16_MAX, 0},
+  };
+
+  for (unsigned i = 0; i < sizeof(extremes) / sizeof(extremes[0]); i++) {
+    assertChromaMatchesFloatPath(extremes[i], zero);
+    assertChromaMatchesFloatPath(zero, extremes[i]);
+  }
+}
+
+void testThatEqualSamplesHaveNoChroma() {
+  // Fixture
+  rgb_raw in = {.r = 1000, .g = 2000, .b = 3000, .c = 6000};
+
+  // Test
+  chroma_q15 actual = rgb_raw_delta2chroma_q15(in, in);
+
+  // Assert
+  TEST_ASSERT_EQUAL_INT(0, actual.x);
+  TEST_ASSERT_EQUAL_INT(0, actual.y);
+}
+
+void testThatEqualDeltaOnAllChannelsHasNoChroma() {
+  // Fixture
+  rgb_raw in1 = {.r = 1500, .g = 2500, .b = 3500, .c = 0};
+  rgb_raw in2 = {.r = 1000, .g = 2000, .b = 3000, .c = 0};
+
+  // Test
+  chroma_q15 actual = rgb_raw_delta2chroma_q15(in1, in2);
+
+  // Assert
+  TEST_ASSERT_EQUAL_INT(0, actual.x);
+  TEST_ASSERT_EQUAL_INT(0, actual.y);
+}
+
+void testThatRedDeltaIsOnThePositiveXAxis() {
+  // Fixture
+  rgb_raw in1 = {.r = 3000, .g = 1000, .b = 1000, .c = 0};
+  rgb_raw in2 = {.r = 1000, .g = 1000, .b = 1000, .c = 0};
+
+  // Test
+  chroma_q15 actual = rgb_raw_delta2chroma_q15(in1, in2);
+
+  // Assert
+  // hue 0, saturation (2000 - 0) / (2 * 2000)
+  TEST_ASSERT_EQUAL_INT(CHROMA_Q15_ONE / 2, actual.x);
+  TEST_ASSERT_EQUAL_INT(0, actual.y);
+}
+
+void testThatLookupTableMatchesSinAndCos() {
+  for (uint32_t angle = 0; angle <= UINT16_MAX; angle++) {
+    // Fixture
+    float radians = (float)(angle * (2.0 * PI / 65536.0));
+
+    // Test
+    float actualSin = q15ToFloat(sinQ15((uint16_t)angle));
+    float actualCos = q15ToFloat(cosQ15((uint16_t)angle));
+
+    // Assert
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, sinf(radians), actualSin);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, cosf(radians), actualCos);
+  }
+}
@@ -0,0 +1,219 @@
+// File under test tcs34725_alignment.c
+#include "tcs34725_alignment.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "unity.h"
+
+// RGBC cycle of the sensors
+#define CYCLE_US 24000
+#define MAX_GAP_US 30000
+#define START_US 1000000
+
+static tcs34725_alignment alignment;
+static tcs34725_aligned_sample aligned;
+
+static tcs34725_sample sample(uint8_t ID, uint64_t timestamp, uint16_t value) {
+  tcs34725_sample s = {
+    .ID = ID,
+    .status = 0x11,
+    .timestamp = timestamp,
+    .tick = (uint32_t)(timestamp / 1000),
+    .r = value,
+    .g = (uint16_t)(2 * value),
+    .b = (uint16_t)(3 * value),
+    .c = (uint16_t)(4 * value),
+  };
+  return s;
+}
+
+static bool add(uint8_t ID, uint64_t timestamp, uint16_t value) {
+  tcs34725_sample s = sample(ID, timestamp, value);
+  return tcs34725_alignment_add(&alignment, &s, &aligned);
+}
+
+static void assertRaw(uint8_t ID, uint16_t value) {
+  TEST_ASSERT_EQUAL_UINT16(value, aligned.raw[ID].r);
+  TEST_ASSERT_EQUAL_UINT16(2 * value, aligned.raw[ID].g);
+  TEST_ASSERT_EQUAL_UINT16(3 * value, aligned.raw[ID].b);
+  TEST_ASSERT_EQUAL_UINT16(4 * value, aligned.raw[ID].c);
+}
+
+void setUp(void) {
+  tcs34725_alignment_init(&alignment, MAX_GAP_US);
+}
+
+void testThatNothingIsAlignedBeforeBothSensorsHaveASample() {
+  // Fixture
+  // Test
+  bool actual = add(0, START_US, 100);
+
+  // Assert
+  TEST_ASSERT_FALSE(actual);
+}
+
+void testThatSynchronisedSamplesAreUsedAsTheyAre() {
+  // Fixture
+  add(0, START_US, 100);
+
+  // Test
+  bool actual = add(1, START_US, 200);
+
+  // Assert
+  TEST_ASSERT_TRUE(actual);
+  TEST_ASSERT_EQUAL_UINT64(START_US, aligned.timestamp);
+  TEST_ASSERT_EQUAL_UINT32(START_US / 1000, aligned.tick);
+  assertRaw(0, 100);
+  assertRaw(1, 200);
+}
+
+void testThatEverySynchronisedCycleIsAlignedOnce() {
+  // Fixture
+  int numOfAligned = 0;
+
+  // Test
+  for (int k = 0; k < 10; k++) {
+    const uint64_t t = START_US + (uint64_t)k * CYCLE_US;
+    numOfAligned += add(0, t, (uint16_t)(100 + k)) ? 1 : 0;
+    numOfAligned += add(1, t, (uint16_t)(200 + k)) ? 1 : 0;
+  }
+
+  // Assert
+  TEST_ASSERT_EQUAL_INT(10, numOfAligned);
+  assertRaw(0, 109);
+  assertRaw(1, 209);
+}
+
+void testThatTheNewerSensorIsInterpolatedToTheOlderSample() {
+  // Fixture
+  // sensor 1 runs 6 ms behind sensor 0
+  add(1, START_US - CYCLE_US + 6000, 100);
+  add(0, START_US, 1000);
+
+  // Test
+  // sensor 0 at START_US lies a quarter of the way between the samples of sensor 1
+  bool actual = add(1, START_US + 6000, 196);
+
+  // Assert
+  TEST_ASSERT_TRUE(actual);
+  TEST_ASSERT_EQUAL_UINT64(START_US, aligned.timestamp);
+  assertRaw(0, 1000);
+  assertRaw(1, 172);
+}
+
+void testThatInterpolationRoundsToTheNearestCount() {
+  // Fixture
+  add(1, START_US, 0);
+  add(0, START_US + 1000, 50);
+
+  // Test
+  // 1/3 of 10 counts
+  bool actual = add(1, START_US + 3000, 10);
+
+  // Assert
+  TEST_ASSERT_TRUE(actual);
+  TEST_ASSERT_EQUAL_UINT16(3, aligned.raw[1].r);
+  // 2/3 of 20 counts
+  TEST_ASSERT_EQUAL_UINT16(7, aligned.raw[1].g);
+}
+
+void testThatInterpolationFollowsADecreasingValue() {
+  // Fixture
+  add(1, START_US, 1000);
+  add(0, START_US + 12000, 50);
+
+  // Test
+  bool actual = add(1, START_US + CYCLE_US, 0);
+
+  // Assert
+  TEST_ASSERT_TRUE(actual);
+  assertRaw(1, 500);
+}
+
+void testThatUnsynchronisedSensorsAlignEveryInstantOnce() {
+  // Fixture
+  int numOfAligned = 0;
+  uint64_t lastTimestamp = 0;
+  bool increasing = true;
+
+  // Test
+  for (int k = 0; k < 10; k++) {
+    const uint64_t t = START_US + (uint64_t)k * CYCLE_US;
+    if (add(0, t, 100)) {
+      numOfAligned++;
+      increasing = increasing && (aligned.timestamp > lastTimestamp);
+      lastTimestamp = aligned.timestamp;
+    }
+    if (add(1, t + 10000, 200)) {
+      numOfAligned++;
+      increasing = increasing && (aligned.timestamp > lastTimestamp);
+      lastTimestamp = aligned.timestamp;
+    }
+  }
+
+  // Assert
+  // the first cycle has no previous samples to interpolate from
+  TEST_ASSERT_EQUAL_INT(18, numOfAligned);
+  TEST_ASSERT_TRUE(increasing);
+}
+
+void testThatAStaleSensorIsNotAligned() {
+  // Fixture
+  add(0, START_US, 100);
+  add(1, START_US, 200);
+
+  // Test
+  // sensor 1 stops, sensor 0 keeps sampling
+  bool actual = false;
+  for (int k = 1; k < 10; k++) {
+    actual = actual || add(0, START_US + (uint64_t)k * CYCLE_US, 100);
+  }
+
+  // Assert
+  TEST_ASSERT_FALSE(actual);
+}
+
+void testThatSamplesTooFarApartAreNotInterpolated() {
+  // Fixture
+  // sensor 1 missed cycles, its samples are more than the maximum gap apart
+  add(1, START_US, 100);
+  add(0, START_US + 10000, 100);
+
+  // Test
+  bool actual = add(1, START_US + MAX_GAP_US + 1, 200);
+
+  // Assert
+  TEST_ASSERT_FALSE(actual);
+}
+
+void testThatAlignmentRecoversWhenAStaleSensorReturns() {
+  // Fixture
+  add(0, START_US, 100);
+  add(1, START_US, 200);
+  for (int k = 1; k < 5; k++) {
+    add(0, START_US + (uint64_t)k * CYCLE_US, 100);
+  }
+  const uint64_t t = START_US + 5 * CYCLE_US;
+
+  // Test
+  add(0, t, 150);
+  bool actual = add(1, t, 250);
+
+  // Assert
+  TEST_ASSERT_TRUE(actual);
+  TEST_ASSERT_EQUAL_UINT64(t, aligned.timestamp);
+  assertRaw(0, 150);
+  assertRaw(1, 250);
+}
+
+void testThatASampleOfAnUnknownSensorIsIgnored() {
+  // Fixture
+  add(0, START_US, 100);
+
+  // Test
+  bool actual = add(TCS34725_ACQUISITION_NUM_OF_SENSORS, START_US, 100);
+
+  // Assert
+  TEST_ASSERT_FALSE(actual);
+  TEST_ASSERT_EQUAL_UINT8(0, alignment.count[1]);
+}
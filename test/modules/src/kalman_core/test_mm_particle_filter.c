@@ -0,0 +1,291 @@
+// File under test mm_particle_filter.c
+#include "mm_particle_filter.h"
+
+#include <string.h>
+#include "unity.h"
+
+#include "mock_kalman_core.h"
+#include "mock_outlierFilterParticleFilter.h"
+
+// Default data initialized in setup()
+static kalmanCoreData_t this;
+static OutlierFilterPfState_t outlierFilterPfState;
+
+static int scalarUpdateCount;
+static int validateCount;
+static bool validateResult;
+static float validateMahalanobisSquared;
+static int validateDimensions;
+
+// Helpers
+static void mockScalarUpdate(kalmanCoreData_t* actualThis, arm_matrix_instance_f32* Hm, float error, float stdMeasNoise, int cmock_num_calls);
+static bool mockValidate(OutlierFilterPfState_t* state, const float mahalanobisSquared, const int dimensions, const uint32_t nowMs, int cmock_num_calls);
+static void fixtureCorrelatedState();
+static void directUpdate(const particleFilterMeasurement_t* pf, double expectedS[KC_STATE_DIM], double expectedP[KC_STATE_DIM][KC_STATE_DIM], double* expectedMahalanobisSquared);
+static void invert(double A[3][3], const int n);
+
+
+void setUp(void) {
+  memset(&this, 0, sizeof(this));
+  memset(&outlierFilterPfState, 0, sizeof(outlierFilterPfState));
+
+  scalarUpdateCount = 0;
+  validateCount = 0;
+  validateResult = true;
+  validateMahalanobisSquared = -1.0f;
+  validateDimensions = -1;
+
+  kalmanCoreScalarUpdate_StubWithCallback(mockScalarUpdate);
+  outlierFilterParticleFilterValidate_StubWithCallback(mockValidate);
+}
+
+void tearDown(void) {
+  // Empty
+}
+
+void testThatWhitenedScalarUpdatesEqualADirectUpdateWithTheFullCovariance() {
+  // Fixture
+  fixtureCorrelatedState();
+  particleFilterMeasurement_t measurement = {
+    .x = 1.3f, .y = 1.9f, .z = 0.2f,
+    // xx, yy, zz, xy, xz, yz
+    .cov = {0.04f, 0.09f, 0.02f, 0.03f, -0.01f, 0.02f},
+  };
+
+  double expectedS[KC_STATE_DIM];
+  double expectedP[KC_STATE_DIM][KC_STATE_DIM];
+  double expectedMahalanobisSquared;
+  directUpdate(&measurement, expectedS, expectedP, &expectedMahalanobisSquared);
+
+  // Test
+  kalmanCoreUpdateWithParticleFilter(&this, &measurement, 1000, &outlierFilterPfState);
+
+  // Assert
+  TEST_ASSERT_EQUAL_INT(3, scalarUpdateCount);
+  TEST_ASSERT_EQUAL_INT(3, validateDimensions);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3, expectedMahalanobisSquared, validateMahalanobisSquared);
+  for (int i = 0; i < KC_STATE_DIM; i++) {
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, expectedS[i], this.S[i]);
+    for (int j = 0; j < KC_STATE_DIM; j++) {
+      TEST_ASSERT_FLOAT_WITHIN(1e-4, expectedP[i][j], this.P[i][j]);
+    }
+  }
+}
+
+void testThatAnAxisWithoutVarianceIsNotMeasured() {
+  // Fixture
+  fixtureCorrelatedState();
+  const float xBefore = this.S[KC_STATE_X];
+  particleFilterMeasurement_t measurement = {
+    .x = 5.0f, .y = 1.9f, .z = 0.2f,
+    // x is not measured, the covariances of x are ignored
+    .cov = {0.0f, 0.09f, 0.02f, 0.03f, -0.01f, 0.02f},
+  };
+
+  double expectedS[KC_STATE_DIM];
+  double expectedP[KC_STATE_DIM][KC_STATE_DIM];
+  double expectedMahalanobisSquared;
+  directUpdate(&measurement, expectedS, expectedP, &expectedMahalanobisSquared);
+
+  // Test
+  kalmanCoreUpdateWithParticleFilter(&this, &measurement, 1000, &outlierFilterPfState);
+
+  // Assert
+  TEST_ASSERT_EQUAL_INT(2, scalarUpdateCount);
+  TEST_ASSERT_EQUAL_INT(2, validateDimensions);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3, expectedMahalanobisSquared, validateMahalanobisSquared);
+  // x only moves through its correlation with y and z, not towards the x of the measurement
+  TEST_ASSERT_TRUE(this.S[KC_STATE_X] - xBefore < 0.5f);
+  for (int i = 0; i < KC_STATE_DIM; i++) {
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, expectedS[i], this.S[i]);
+    for (int j = 0; j < KC_STATE_DIM; j++) {
+      TEST_ASSERT_FLOAT_WITHIN(1e-4, expectedP[i][j], this.P[i][j]);
+    }
+  }
+}
+
+void testThatMeasurementIsNotUsedWhenTheOutlierFilterRejectsIt() {
+  // Fixture
+  fixtureCorrelatedState();
+  validateResult = false;
+  particleFilterMeasurement_t measurement = {
+    .x = 1.3f, .y = 1.9f, .z = 0.2f,
+    .cov = {0.04f, 0.09f, 0.02f, 0.0f, 0.0f, 0.0f},
+  };
+
+  // Test
+  kalmanCoreUpdateWithParticleFilter(&this, &measurement, 1000, &outlierFilterPfState);
+
+  // Assert
+  TEST_ASSERT_EQUAL_INT(1, validateCount);
+  TEST_ASSERT_EQUAL_INT(0, scalarUpdateCount);
+}
+
+void testThatMeasurementWithoutMeasuredAxesIsIgnored() {
+  // Fixture
+  fixtureCorrelatedState();
+  particleFilterMeasurement_t measurement = {
+    .x = 1.3f, .y = 1.9f, .z = 0.2f,
+    .cov = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f},
+  };
+
+  // Test
+  kalmanCoreUpdateWithParticleFilter(&this, &measurement, 1000, &outlierFilterPfState);
+
+  // Assert
+  TEST_ASSERT_EQUAL_INT(0, validateCount);
+  TEST_ASSERT_EQUAL_INT(0, scalarUpdateCount);
+}
+
+void testThatMeasurementWithANonPositiveDefiniteCovarianceIsIgnored() {
+  // Fixture
+  fixtureCorrelatedState();
+  particleFilterMeasurement_t measurement = {
+    .x = 1.3f, .y = 1.9f, .z = 0.2f,
+    // |xy| > sqrt(xx * yy)
+    .cov = {0.04f, 0.09f, 0.02f, 0.5f, 0.0f, 0.0f},
+  };
+
+  // Test
+  kalmanCoreUpdateWithParticleFilter(&this, &measurement, 1000, &outlierFilterPfState);
+
+  // Assert
+  TEST_ASSERT_EQUAL_INT(0, scalarUpdateCount);
+}
+
+
+// Helpers /////////////////////////////////////////////////////////////////////////////////
+
+// A scalar Kalman update of the state and covariance, like kalmanCoreScalarUpdate() without the bounds
+static void mockScalarUpdate(kalmanCoreData_t* actualThis, arm_matrix_instance_f32* Hm, float error, float stdMeasNoise, int cmock_num_calls) {
+  scalarUpdateCount++;
+  TEST_ASSERT_EQUAL_PTR(&this, actualThis);
+  TEST_ASSERT_EQUAL_UINT16(1, Hm->numRows);
+  TEST_ASSERT_EQUAL_UINT16(KC_STATE_DIM, Hm->numCols);
+
+  const float* h = Hm->pData;
+  double PHt[KC_STATE_DIM];
+  double HPHt = 0.0;
+  for (int i = 0; i < KC_STATE_DIM; i++) {
+    PHt[i] = 0.0;
+    for (int j = 0; j < KC_STATE_DIM; j++) {
+      PHt[i] += (double)actualThis->P[i][j] * h[j];
+    }
+    HPHt += h[i] * PHt[i];
+  }
+  const double innovationVariance = HPHt + (double)stdMeasNoise * stdMeasNoise;
+
+  for (int i = 0; i < KC_STATE_DIM; i++) {
+    actualThis->S[i] += (float)(PHt[i] / innovationVariance * error);
+  }
+  for (int i = 0; i < KC_STATE_DIM; i++) {
+    for (int j = 0; j < KC_STATE_DIM; j++) {
+      actualThis->P[i][j] -= (float)(PHt[i] * PHt[j] / innovationVariance);
+    }
+  }
+}
+
+static bool mockValidate(OutlierFilterPfState_t* state, const float mahalanobisSquared, const int dimensions, const uint32_t nowMs, int cmock_num_calls) {
+  validateCount++;
+  TEST_ASSERT_EQUAL_PTR(&outlierFilterPfState, state);
+  validateMahalanobisSquared = mahalanobisSquared;
+  validateDimensions = dimensions;
+  return validateResult;
+}
+
+// Position and velocity with correlated uncertainties
+static void fixtureCorrelatedState() {
+  const float S[KC_STATE_DIM] = {1.0f, 2.0f, 0.5f, 0.1f, -0.2f, 0.0f, 0.0f, 0.0f, 0.0f};
+  memcpy(this.S, S, sizeof(S));
+
+  const float P[6][6] = {
+    {0.10f, 0.02f, 0.01f, 0.03f, 0.00f, 0.00f},
+    {0.02f, 0.20f, 0.00f, 0.00f, 0.04f, 0.00f},
+    {0.01f, 0.00f, 0.05f, 0.00f, 0.00f, 0.01f},
+    {0.03f, 0.00f, 0.00f, 0.30f, 0.00f, 0.00f},
+    {0.00f, 0.04f, 0.00f, 0.00f, 0.30f, 0.00f},
+    {0.00f, 0.00f, 0.01f, 0.00f, 0.00f, 0.30f},
+  };
+  for (int i = 0; i < KC_STATE_DIM; i++) {
+    for (int j = 0; j < KC_STATE_DIM; j++) {
+      this.P[i][j] = (i < 6 && j < 6) ? P[i][j] : ((i == j) ? 0.01f : 0.0f);
+    }
+  }
+}
+
+// K = P * H^T * (H * P * H^T + R)^-1, S = S + K * e, P = P - K * H * P in one step with the full covariance
+static void directUpdate(const particleFilterMeasurement_t* pf, double expectedS[KC_STATE_DIM], double expectedP[KC_STATE_DIM][KC_STATE_DIM], double* expectedMahalanobisSquared) {
+  static const int covIndex[3][3] = {{0, 3, 4}, {3, 1, 5}, {4, 5, 2}};
+  int axes[3];
+  int n = 0;
+  for (int i = 0; i < 3; i++) {
+    if (pf->cov[i] > 0.0f) {
+      axes[n++] = i;
+    }
+  }
+
+  double Sinv[3][3] = {{0}};
+  double error[3];
+  for (int r = 0; r < n; r++) {
+    for (int c = 0; c < n; c++) {
+      Sinv[r][c] = (double)pf->cov[covIndex[axes[r]][axes[c]]] + this.P[KC_STATE_X + axes[r]][KC_STATE_X + axes[c]];
+    }
+    error[r] = (double)pf->pos[axes[r]] - this.S[KC_STATE_X + axes[r]];
+  }
+  invert(Sinv, n);
+
+  *expectedMahalanobisSquared = 0.0;
+  for (int r = 0; r < n; r++) {
+    for (int c = 0; c < n; c++) {
+      *expectedMahalanobisSquared += error[r] * Sinv[r][c] * error[c];
+    }
+  }
+
+  double K[KC_STATE_DIM][3];
+  for (int i = 0; i < KC_STATE_DIM; i++) {
+    for (int c = 0; c < n; c++) {
+      K[i][c] = 0.0;
+      for (int k = 0; k < n; k++) {
+        K[i][c] += this.P[i][KC_STATE_X + axes[k]] * Sinv[k][c];
+      }
+    }
+  }
+
+  for (int i = 0; i < KC_STATE_DIM; i++) {
+    expectedS[i] = this.S[i];
+    for (int c = 0; c < n; c++) {
+      expectedS[i] += K[i][c] * error[c];
+    }
+    for (int j = 0; j < KC_STATE_DIM; j++) {
+      expectedP[i][j] = this.P[i][j];
+      for (int c = 0; c < n; c++) {
+        expectedP[i][j] -= K[i][c] * this.P[KC_STATE_X + axes[c]][j];
+      }
+    }
+  }
+}
+
+// Gauss-Jordan inversion in place of a small symmetric positive definite matrix
+static void invert(double A[3][3], const int n) {
+  double I[3][3] = {{0}};
+  for (int i = 0; i < n; i++) {
+    I[i][i] = 1.0;
+  }
+  for (int p = 0; p < n; p++) {
+    const double pivot = A[p][p];
+    for (int c = 0; c < n; c++) {
+      A[p][c] /= pivot;
+      I[p][c] /= pivot;
+    }
+    for (int r = 0; r < n; r++) {
+      if (r != p) {
+        const double f = A[r][p];
+        for (int c = 0; c < n; c++) {
+          A[r][c] -= f * A[p][c];
+          I[r][c] -= f * I[p][c];
+        }
+      }
+    }
+  }
+  memcpy(A, I, sizeof(I));
+}
@@ -0,0 +1,226 @@
+// File under test outlierFilterParticleFilter.c
+#include "outlierFilterParticleFilter.h"
+
+#include "unity.h"
+
+// Helpers
+uint32_t fixtureClosePfFilter(OutlierFilterPfState_t* this);
+uint32_t fixtureOpenPfFilter(OutlierFilterPfState_t* this);
+
+
+void setUp(void) {
+  // Empty
+}
+
+void tearDown(void) {
+  // Empty
+}
+
+
+#define PF_DIMENSIONS 2
+// inside and outside of the chi-square gate of 2 dimensions (13.82)
+#define PF_GOOD_DISTANCE 1.0f
+#define PF_BAD_DISTANCE 20.0f
+#define PF_TIME_STEP 200
+
+void testThatPfFilterLetsGoodSampleThroughWhenOpen() {
+  // Fixture
+  OutlierFilterPfState_t this;
+  uint32_t time = fixtureOpenPfFilter(&this);
+  bool expected = true;
+
+  // Test
+  bool actual = outlierFilterParticleFilterValidate(&this, PF_GOOD_DISTANCE, PF_DIMENSIONS, time);
+
+  // Assert
+  TEST_ASSERT_EQUAL(expected, actual);
+}
+
+void testThatPfFilterLetsBadSampleThroughWhenOpen() {
+  // Fixture
+  OutlierFilterPfState_t this;
+  uint32_t time = fixtureOpenPfFilter(&this);
+  bool expected = true;
+
+  // Test
+  bool actual = outlierFilterParticleFilterValidate(&this, PF_BAD_DISTANCE, PF_DIMENSIONS, time);
+
+  // Assert
+  TEST_ASSERT_EQUAL(expected, actual);
+}
+
+void testThatPfFilterLetsGoodSampleThroughWhenClosed() {
+  // Fixture
+  OutlierFilterPfState_t this;
+  uint32_t time = fixtureClosePfFilter(&this);
+  bool expected = true;
+
+  // Test
+  bool actual = outlierFilterParticleFilterValidate(&this, PF_GOOD_DISTANCE, PF_DIMENSIONS, time);
+
+  // Assert
+  TEST_ASSERT_EQUAL(expected, actual);
+}
+
+void testThatPfFilterBlocksBadSampleWhenClosed() {
+  // Fixture
+  OutlierFilterPfState_t this;
+  uint32_t time = fixtureClosePfFilter(&this);
+  bool expected = false;
+
+  // Test
+  bool actual = outlierFilterParticleFilterValidate(&this, PF_BAD_DISTANCE, PF_DIMENSIONS, time);
+
+  // Assert
+  TEST_ASSERT_EQUAL(expected, actual);
+}
+
+void testThatPfFilterGateDependsOnTheNumberOfMeasuredAxes() {
+  // Fixture
+  // between the gates of 1 (10.83) and 2 (13.82) dimensions
+  const float distance = 12.0f;
+  OutlierFilterPfState_t oneAxis;
+  OutlierFilterPfState_t twoAxes;
+  OutlierFilterPfState_t threeAxes;
+  uint32_t time = fixtureClosePfFilter(&oneAxis);
+  fixtureClosePfFilter(&twoAxes);
+  fixtureClosePfFilter(&threeAxes);
+
+  // Test
+  bool actualOneAxis = outlierFilterParticleFilterValidate(&oneAxis, distance, 1, time);
+  bool actualTwoAxes = outlierFilterParticleFilterValidate(&twoAxes, distance, 2, time);
+  bool actualThreeAxes = outlierFilterParticleFilterValidate(&threeAxes, distance, 3, time);
+
+  // Assert
+  TEST_ASSERT_FALSE(actualOneAxis);
+  TEST_ASSERT_TRUE(actualTwoAxes);
+  TEST_ASSERT_TRUE(actualThreeAxes);
+}
+
+void testThatPfFilterRejectsAnInvalidNumberOfAxesWhenOpen() {
+  // Fixture
+  OutlierFilterPfState_t this;
+  uint32_t time = fixtureOpenPfFilter(&this);
+
+  // Test
+  bool actualNoAxis = outlierFilterParticleFilterValidate(&this, PF_GOOD_DISTANCE, 0, time);
+  bool actualFourAxes = outlierFilterParticleFilterValidate(&this, PF_GOOD_DISTANCE, 4, time);
+
+  // Assert
+  TEST_ASSERT_FALSE(actualNoAxis);
+  TEST_ASSERT_FALSE(actualFourAxes);
+}
+
+void testThatPfFilterOpensForManyBadSamples() {
+  // Fixture
+  OutlierFilterPfState_t this;
+  uint32_t time = fixtureClosePfFilter(&this);
+
+  // Test, Assert
+  for (int i = 0; i < 10; i++) {
+    bool actual = outlierFilterParticleFilterValidate(&this, PF_BAD_DISTANCE, PF_DIMENSIONS, time);
+    time += PF_TIME_STEP;
+
+    // Should block the first 4 samples and let the rest through
+    bool expected = (i >= 4);
+    TEST_ASSERT_EQUAL(expected, actual);
+  }
+}
+
+void testThatPfFilterOpensAfterInactivity() {
+  // Fixture
+  OutlierFilterPfState_t this;
+  uint32_t time = fixtureClosePfFilter(&this);
+  uint32_t newTime = time + PF_TIME_STEP * 10;
+  bool expected = true;
+
+  // Test
+  bool actual = outlierFilterParticleFilterValidate(&this, PF_BAD_DISTANCE, PF_DIMENSIONS, newTime);
+
+  // Assert
+  TEST_ASSERT_EQUAL(expected, actual);
+}
+
+void testThatPfFilterClosesAfterManyGoodSamples() {
+  // Fixture
+  OutlierFilterPfState_t this;
+  uint32_t time = fixtureOpenPfFilter(&this);
+
+  // Test
+  for (int i = 0; i < 7; i++) {
+    outlierFilterParticleFilterValidate(&this, PF_GOOD_DISTANCE, PF_DIMENSIONS, time);
+    time += PF_TIME_STEP;
+  }
+
+  // Assert
+  bool expected = false;
+  bool actual = outlierFilterParticleFilterValidate(&this, PF_BAD_DISTANCE, PF_DIMENSIONS, time);
+  TEST_ASSERT_EQUAL(expected, actual);
+}
+
+void testThatPfFilterStaysOpenWithOneGoodSampleLess() {
+  // Fixture
+  OutlierFilterPfState_t this;
+  uint32_t time = fixtureOpenPfFilter(&this);
+
+  // Test
+  for (int i = 0; i < 6; i++) {
+    outlierFilterParticleFilterValidate(&this, PF_GOOD_DISTANCE, PF_DIMENSIONS, time);
+    time += PF_TIME_STEP;
+  }
+
+  // Assert
+  bool expected = true;
+  bool actual = outlierFilterParticleFilterValidate(&this, PF_BAD_DISTANCE, PF_DIMENSIONS, time);
+  TEST_ASSERT_EQUAL(expected, actual);
+}
+
+void testThatPfFilterReopensAfterTheCloudJumps() {
+  // Fixture
+  OutlierFilterPfState_t this;
+  uint32_t time = fixtureClosePfFilter(&this);
+
+  // Test
+  // the particle filter relocates, the new position is consistently far from the state estimate
+  for (int i = 0; i < 4; i++) {
+    outlierFilterParticleFilterValidate(&this, PF_BAD_DISTANCE, PF_DIMENSIONS, time);
+    time += PF_TIME_STEP;
+  }
+  bool reopened = outlierFilterParticleFilterValidate(&this, PF_BAD_DISTANCE, PF_DIMENSIONS, time);
+  time += PF_TIME_STEP;
+  // once the state estimate has followed, good samples close the filter again
+  for (int i = 0; i < 20; i++) {
+    outlierFilterParticleFilterValidate(&this, PF_GOOD_DISTANCE, PF_DIMENSIONS, time);
+    time += PF_TIME_STEP;
+  }
+  bool closedAgain = !outlierFilterParticleFilterValidate(&this, PF_BAD_DISTANCE, PF_DIMENSIONS, time);
+
+  // Assert
+  TEST_ASSERT_TRUE(reopened);
+  TEST_ASSERT_TRUE(closedAgain);
+}
+
+
+// Helpers /////////////////////////////////////////////////////////////////////////////////
+uint32_t fixtureClosePfFilter(OutlierFilterPfState_t* this) {
+  uint32_t time = 1000;
+
+  outlierFilterParticleFilterReset(this, time);
+  time += PF_TIME_STEP;
+
+  for (int i = 0; i < 20; i++) {
+    outlierFilterParticleFilterValidate(this, PF_GOOD_DISTANCE, PF_DIMENSIONS, time);
+    time += PF_TIME_STEP;
+  }
+
+  return time;
+}
+
+uint32_t fixtureOpenPfFilter(OutlierFilterPfState_t* this) {
+  uint32_t time = 1000;
+
+  outlierFilterParticleFilterReset(this, time);
+  time += PF_TIME_STEP;
+
+  return time;
+}
@@ -0,0 +1,271 @@
+// File under test state_subscriber.c
+#include "state_subscriber.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "unity.h"
+
+#define QUEUE_LENGTH 4
+#define NUM_OF_QUEUES (STATE_SUBSCRIBER_MAX_SUBSCRIBERS + 1)
+
+// Fake FreeRTOS queues of stateSample_t
+typedef struct {
+  stateSample_t items[QUEUE_LENGTH];
+  uint32_t head;
+  uint32_t count;
+} fakeQueue_t;
+
+static fakeQueue_t fakeQueues[NUM_OF_QUEUES];
+static stateSubscription_t subscriptions[NUM_OF_QUEUES];
+static int criticalNesting;
+static int numOfCriticalSections;
+
+static sensorData_t sensorData;
+static state_t state;
+static stateSample_t samples[QUEUE_LENGTH + 1];
+
+static QueueHandle_t queue(int i) {
+  return (QueueHandle_t)&fakeQueues[i];
+}
+
+static void fixtureState(uint64_t timestamp) {
+  sensorData.interruptTimestamp = timestamp;
+  sensorData.gyro.x = 1.0f;
+  sensorData.gyro.y = -2.0f;
+  sensorData.gyro.z = 3.0f;
+  state.acc.x = 0.1f;
+  state.acc.y = 0.2f;
+  state.acc.z = -0.3f;
+  state.attitude.roll = 10.0f;
+  state.attitude.pitch = -20.0f;
+  state.attitude.yaw = 30.0f;
+}
+
+// Publishes one sample per tick, the timestamp of a sample is its tick
+static void publishTicks(uint32_t from, uint32_t to) {
+  for (uint32_t tick = from; tick < to; tick++) {
+    fixtureState(tick);
+    stateSubscriberPublish(&sensorData, &state, tick);
+  }
+}
+
+void setUp(void) {
+  stateSubscriberReset();
+  memset(fakeQueues, 0, sizeof(fakeQueues));
+  memset(subscriptions, 0, sizeof(subscriptions));
+  memset(samples, 0, sizeof(samples));
+  criticalNesting = 0;
+  numOfCriticalSections = 0;
+  fixtureState(0);
+}
+
+void tearDown(void) {
+  // Empty
+}
+
+void testThatASubscriptionIsRegistered() {
+  // Fixture
+  subscriptions[0].droppedCount = 17;
+
+  // Test
+  bool actual = stateSubscriberRegister(&subscriptions[0], queue(0), RATE_100_HZ);
+
+  // Assert
+  TEST_ASSERT_TRUE(actual);
+  TEST_ASSERT_EQUAL_PTR(queue(0), subscriptions[0].queue);
+  TEST_ASSERT_EQUAL_UINT16(RATE_100_HZ, subscriptions[0].rate);
+  TEST_ASSERT_EQUAL_UINT32(0, subscriptions[0].droppedCount);
+}
+
+void testThatAnInvalidSubscriptionIsRejected() {
+  // Fixture
+  // Test
+  // Assert
+  TEST_ASSERT_FALSE(stateSubscriberRegister(&subscriptions[0], NULL, RATE_100_HZ));
+  TEST_ASSERT_FALSE(stateSubscriberRegister(&subscriptions[0], queue(0), 0));
+  TEST_ASSERT_FALSE(stateSubscriberRegister(&subscriptions[0], queue(0), RATE_MAIN_LOOP + 1));
+}
+
+void testThatTheNumberOfSubscriptionsIsLimited() {
+  // Fixture
+  for (int i = 0; i < STATE_SUBSCRIBER_MAX_SUBSCRIBERS; i++) {
+    TEST_ASSERT_TRUE(stateSubscriberRegister(&subscriptions[i], queue(i), RATE_MAIN_LOOP));
+  }
+
+  // Test
+  bool actual = stateSubscriberRegister(&subscriptions[STATE_SUBSCRIBER_MAX_SUBSCRIBERS], queue(STATE_SUBSCRIBER_MAX_SUBSCRIBERS), RATE_MAIN_LOOP);
+
+  // Assert
+  TEST_ASSERT_FALSE(actual);
+  publishTicks(0, 1);
+  TEST_ASSERT_EQUAL_UINT32(0, fakeQueues[STATE_SUBSCRIBER_MAX_SUBSCRIBERS].count);
+}
+
+void testThatRegistrationClaimsTheSlotInACriticalSection() {
+  // Fixture
+  for (int i = 0; i < STATE_SUBSCRIBER_MAX_SUBSCRIBERS; i++) {
+    stateSubscriberRegister(&subscriptions[i], queue(i), RATE_MAIN_LOOP);
+  }
+
+  // Test
+  stateSubscriberRegister(&subscriptions[STATE_SUBSCRIBER_MAX_SUBSCRIBERS], queue(STATE_SUBSCRIBER_MAX_SUBSCRIBERS), RATE_MAIN_LOOP);
+
+  // Assert
+  // the critical section is left on the rejected registration as well
+  TEST_ASSERT_EQUAL_INT(STATE_SUBSCRIBER_MAX_SUBSCRIBERS + 1, numOfCriticalSections);
+  TEST_ASSERT_EQUAL_INT(0, criticalNesting);
+}
+
+void testThatPublishingWithoutSubscribersDoesNothing() {
+  // Fixture
+  // Test
+  publishTicks(0, 10);
+
+  // Assert
+  for (int i = 0; i < NUM_OF_QUEUES; i++) {
+    TEST_ASSERT_EQUAL_UINT32(0, fakeQueues[i].count);
+  }
+}
+
+void testThatThePublishedSampleHoldsTheSensorDataAndState() {
+  // Fixture
+  stateSubscriberRegister(&subscriptions[0], queue(0), RATE_MAIN_LOOP);
+  fixtureState(123456789012ULL);
+
+  // Test
+  stateSubscriberPublish(&sensorData, &state, 7);
+  uint32_t actual = stateSubscriberRead(&subscriptions[0], samples, QUEUE_LENGTH);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT32(1, actual);
+  TEST_ASSERT_TRUE(123456789012ULL == samples[0].timestamp);
+  TEST_ASSERT_EQUAL_FLOAT(1.0f, samples[0].gyro.x);
+  TEST_ASSERT_EQUAL_FLOAT(-2.0f, samples[0].gyro.y);
+  TEST_ASSERT_EQUAL_FLOAT(3.0f, samples[0].gyro.z);
+  TEST_ASSERT_EQUAL_FLOAT(0.1f, samples[0].acc.x);
+  TEST_ASSERT_EQUAL_FLOAT(0.2f, samples[0].acc.y);
+  TEST_ASSERT_EQUAL_FLOAT(-0.3f, samples[0].acc.z);
+  TEST_ASSERT_EQUAL_FLOAT(10.0f, samples[0].attitude.roll);
+  TEST_ASSERT_EQUAL_FLOAT(-20.0f, samples[0].attitude.pitch);
+  TEST_ASSERT_EQUAL_FLOAT(30.0f, samples[0].attitude.yaw);
+}
+
+void testThatSamplesArePublishedAtTheRateOfTheSubscription() {
+  // Fixture
+  stateSubscriberRegister(&subscriptions[0], queue(0), RATE_250_HZ);
+  stateSubscriberRegister(&subscriptions[1], queue(1), RATE_500_HZ);
+
+  // Test
+  publishTicks(1, 9);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT32(2, stateSubscriberRead(&subscriptions[0], samples, QUEUE_LENGTH));
+  TEST_ASSERT_TRUE(4 == samples[0].timestamp);
+  TEST_ASSERT_TRUE(8 == samples[1].timestamp);
+  TEST_ASSERT_EQUAL_UINT32(4, stateSubscriberRead(&subscriptions[1], samples, QUEUE_LENGTH));
+  TEST_ASSERT_TRUE(2 == samples[0].timestamp);
+  TEST_ASSERT_TRUE(8 == samples[3].timestamp);
+}
+
+void testThatSamplesAreReadOldestFirstInBatches() {
+  // Fixture
+  stateSubscriberRegister(&subscriptions[0], queue(0), RATE_MAIN_LOOP);
+  publishTicks(0, 3);
+
+  // Test
+  uint32_t first = stateSubscriberRead(&subscriptions[0], samples, 2);
+  uint32_t second = stateSubscriberRead(&subscriptions[0], &samples[2], QUEUE_LENGTH);
+  uint32_t third = stateSubscriberRead(&subscriptions[0], samples, QUEUE_LENGTH);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT32(2, first);
+  TEST_ASSERT_EQUAL_UINT32(1, second);
+  TEST_ASSERT_EQUAL_UINT32(0, third);
+  TEST_ASSERT_TRUE(0 == samples[0].timestamp);
+  TEST_ASSERT_TRUE(1 == samples[1].timestamp);
+  TEST_ASSERT_TRUE(2 == samples[2].timestamp);
+}
+
+void testThatSamplesAreDroppedAndCountedWhenTheQueueIsFull() {
+  // Fixture
+  stateSubscriberRegister(&subscriptions[0], queue(0), RATE_MAIN_LOOP);
+
+  // Test
+  publishTicks(0, QUEUE_LENGTH + 3);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT32(3, subscriptions[0].droppedCount);
+  // the queued samples are kept, the newest samples are dropped
+  TEST_ASSERT_EQUAL_UINT32(QUEUE_LENGTH, stateSubscriberRead(&subscriptions[0], samples, QUEUE_LENGTH + 1));
+  TEST_ASSERT_TRUE(0 == samples[0].timestamp);
+  TEST_ASSERT_TRUE((QUEUE_LENGTH - 1) == samples[QUEUE_LENGTH - 1].timestamp);
+}
+
+void testThatPublishingResumesWhenTheQueueIsRead() {
+  // Fixture
+  stateSubscriberRegister(&subscriptions[0], queue(0), RATE_MAIN_LOOP);
+  publishTicks(0, QUEUE_LENGTH + 1);
+  stateSubscriberRead(&subscriptions[0], samples, QUEUE_LENGTH);
+
+  // Test
+  publishTicks(10, 11);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT32(1, subscriptions[0].droppedCount);
+  TEST_ASSERT_EQUAL_UINT32(1, stateSubscriberRead(&subscriptions[0], samples, QUEUE_LENGTH));
+  TEST_ASSERT_TRUE(10 == samples[0].timestamp);
+}
+
+void testThatAFullQueueDoesNotAffectOtherSubscriptions() {
+  // Fixture
+  stateSubscriberRegister(&subscriptions[0], queue(0), RATE_MAIN_LOOP);
+  stateSubscriberRegister(&subscriptions[1], queue(1), RATE_500_HZ);
+
+  // Test
+  publishTicks(0, 2 * QUEUE_LENGTH);
+
+  // Assert
+  TEST_ASSERT_EQUAL_UINT32(QUEUE_LENGTH, subscriptions[0].droppedCount);
+  TEST_ASSERT_EQUAL_UINT32(0, subscriptions[1].droppedCount);
+  TEST_ASSERT_EQUAL_UINT32(QUEUE_LENGTH, stateSubscriberRead(&subscriptions[1], samples, QUEUE_LENGTH));
+}
+
+// Fakes ---------------------------------------------
+
+BaseType_t xQueueGenericSend(QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait, const BaseType_t xCopyPosition) {
+  // The stabilizer loop never blocks
+  TEST_ASSERT_EQUAL_UINT32(0, xTicksToWait);
+  TEST_ASSERT_EQUAL_INT(queueSEND_TO_BACK, xCopyPosition);
+
+  fakeQueue_t* q = (fakeQueue_t*)xQueue;
+  if (q->count == QUEUE_LENGTH) {
+    return errQUEUE_FULL;
+  }
+  memcpy(&q->items[(q->head + q->count) % QUEUE_LENGTH], pvItemToQueue, sizeof(stateSample_t));
+  q->count++;
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait) {
+  TEST_ASSERT_EQUAL_UINT32(0, xTicksToWait);
+
+  fakeQueue_t* q = (fakeQueue_t*)xQueue;
+  if (q->count == 0) {
+    return pdFALSE;
+  }
+  memcpy(pvBuffer, &q->items[q->head], sizeof(stateSample_t));
+  q->head = (q->head + 1) % QUEUE_LENGTH;
+  q->count--;
+  return pdTRUE;
+}
+
+void vPortEnterCritical(void) {
+  criticalNesting++;
+  numOfCriticalSections++;
+}
+
+void vPortExitCritical(void) {
+  TEST_ASSERT_TRUE(criticalNesting > 0);
+  criticalNesting--;
+}
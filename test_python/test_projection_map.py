@@ -0,0 +1,170 @@
+#!/usr/bin/env python
+
+import os
+import re
+import subprocess
+import sys
+
+import pytest
+
+GENERATOR = os.path.join(os.path.dirname(__file__), '..', 'tools', 'make', 'projection_map.py')
+
+# 3 x 3 map, slabs of 4 cm centred at 22, 26 and 30 cm
+SETTINGS = """cell_size 1.0
+focal_length 10
+origin_y 5
+origin_z -5
+x_min 20
+x_max 30
+slab_shift 2
+"""
+
+MAP = """map
+0 1 2
+3 4 5
+6 0 1
+"""
+
+
+def generate(tmp_path, description):
+    source = tmp_path / 'map.txt'
+    source.write_text(description)
+    output = tmp_path / 'map_gen.c'
+    result = subprocess.run([sys.executable, GENERATOR, str(source), str(output)],
+                            stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+    return result, output
+
+
+def field(generated, name):
+    return re.search(r'\.{} = ([^,]+),'.format(name), generated).group(1)
+
+
+def inverse_cell_sizes(generated):
+    table = re.search(r'projection_map_inverse_cell_size\[\d+\] = \{(.*?)\};', generated, re.S).group(1)
+    return [float(v.rstrip('f')) for v in re.findall(r'[-0-9.e+]+f', table)]
+
+
+def raster(generated):
+    rows = re.search(r'\.raster = \{(.*?)\},\n\};', generated, re.S).group(1)
+    return [[v.strip() for v in line.strip().rstrip(',').split(',')] for line in rows.strip().splitlines()]
+
+
+def test_that_the_map_description_is_generated(tmp_path):
+    # Fixture
+    # Test
+    result, output = generate(tmp_path, SETTINGS + MAP)
+
+    # Assert
+    assert result.returncode == 0
+    generated = output.read_text()
+    assert field(generated, 'map_size') == '3'
+    assert field(generated, 'cell_size') == '1.0f'
+    assert field(generated, 'focal_length') == '10.0f'
+    assert field(generated, 'origin_y') == '5.0f'
+    assert field(generated, 'origin_z') == '-5.0f'
+    assert field(generated, 'x_min') == '20'
+    assert field(generated, 'slab_shift') == '2'
+
+
+def test_that_the_slabs_cover_x_max(tmp_path):
+    # Fixture
+    # Test
+    result, output = generate(tmp_path, SETTINGS + MAP)
+
+    # Assert
+    generated = output.read_text()
+    # 10 cm in slabs of 4 cm
+    assert field(generated, 'num_of_slabs') == '3'
+    assert len(inverse_cell_sizes(generated)) == 3
+
+
+def test_that_every_slab_stores_the_inverse_cell_size_at_its_centre(tmp_path):
+    # Fixture
+    # cell(x) = ((x - 10) / 10) * 1.0
+    expected = [1.0 / 1.2, 1.0 / 1.6, 1.0 / 2.0]
+
+    # Test
+    result, output = generate(tmp_path, SETTINGS + MAP)
+
+    # Assert
+    assert inverse_cell_sizes(output.read_text()) == pytest.approx(expected, rel=1e-6)
+
+
+def test_that_the_raster_is_stored_bottom_row_first_with_an_ambient_border(tmp_path):
+    # Fixture
+    expected = [['AMB'] * 16 for _ in range(16)]
+    expected[1][1:4] = ['6', '0', '1']
+    expected[2][1:4] = ['3', '4', '5']
+    expected[3][1:4] = ['0', '1', '2']
+
+    # Test
+    result, output = generate(tmp_path, SETTINGS + MAP)
+
+    # Assert
+    assert raster(output.read_text()) == expected
+
+
+def test_that_the_origin_is_optional(tmp_path):
+    # Fixture
+    settings = '\n'.join(line for line in SETTINGS.splitlines() if not line.startswith('origin')) + '\n'
+
+    # Test
+    result, output = generate(tmp_path, settings + MAP)
+
+    # Assert
+    assert result.returncode == 0
+    generated = output.read_text()
+    assert field(generated, 'origin_y') == '0.0f'
+    assert field(generated, 'origin_z') == '0.0f'
+
+
+def test_that_a_full_size_map_fills_the_raster_up_to_the_border(tmp_path):
+    # Fixture
+    size = 14
+    rows = '\n'.join(' '.join(str((r + c) % 7) for c in range(size)) for r in range(size))
+
+    # Test
+    result, output = generate(tmp_path, SETTINGS + 'map\n' + rows + '\n')
+
+    # Assert
+    assert result.returncode == 0
+    actual = raster(output.read_text())
+    assert actual[0] == ['AMB'] * 16
+    assert actual[15] == ['AMB'] * 16
+    assert all(row[0] == 'AMB' and row[15] == 'AMB' for row in actual)
+    # top row of the map right below the top border
+    assert actual[14][1:15] == [str(c % 7) for c in range(size)]
+
+
+@pytest.mark.parametrize('description', [
+    SETTINGS + 'map\n0 1\n2 3 4\n',
+    SETTINGS + 'map\n0 7\n1 2\n',
+    SETTINGS + 'map\n' + '\n'.join(['0 ' * 15] * 15) + '\n',
+    SETTINGS.replace('x_min 20', 'x_min 10') + MAP,
+    SETTINGS.replace('x_max 30', 'x_max 20') + MAP,
+    SETTINGS.replace('cell_size 1.0\n', '') + MAP,
+    SETTINGS.replace('slab_shift 2', 'slab_shift 0').replace('x_max 30', 'x_max 600') + MAP,
+    SETTINGS,
+])
+def test_that_an_invalid_map_is_rejected(tmp_path, description):
+    # Fixture
+    # Test
+    result, output = generate(tmp_path, description)
+
+    # Assert
+    assert result.returncode == 1
+    assert 'projection_map.py' in result.stderr
+    assert not output.exists()
+
+
+def test_that_an_unchanged_map_does_not_touch_the_output(tmp_path):
+    # Fixture
+    result, output = generate(tmp_path, SETTINGS + MAP)
+    os.utime(str(output), (0, 0))
+
+    # Test
+    result, output = generate(tmp_path, SETTINGS + MAP)
+
+    # Assert
+    assert result.returncode == 0
+    assert os.stat(str(output)).st_mtime == 0
@@ -0,0 +1,134 @@
+#!/usr/bin/env python
+"""
+Generates the colour projection map of the particle filter from a map description file.
+
+The projected cells grow linearly with the distance x to the projector:
+    cell(x) = ((x - focal_length) / focal_length) * cell_size
+The x axis is split in slabs, every slab stores 1 / cell at its centre so the firmware
+finds the cell of a particle with a multiplication instead of a division.
+The map is stored bottom row first in a raster with a border of ambient cells, see
+Particle_projection_map.h.
+"""
+
+import argparse
+import os
+import sys
+
+RASTER_BITS = 4
+RASTER_DIM = 1 << RASTER_BITS
+MAX_MAP_SIZE = RASTER_DIM - 2
+NUMBER_OF_COLORS = 7
+# size of the slab tables of the maps uploaded at runtime
+MAX_SLABS = 512
+
+header = """/* This file is automatically generated by {0} from {1}!
+ * Do not edit manually, any manual change will be overwritten.
+ */
+"""
+
+
+def fail(msg):
+    sys.stderr.write("projection_map.py: {}\n".format(msg))
+    sys.exit(1)
+
+
+def parse(path):
+    settings = {}
+    rows = []
+    in_map = False
+    with open(path) as f:
+        for line in f:
+            line = line.split('#', 1)[0].strip()
+            if not line:
+                continue
+            if in_map:
+                rows.append([int(v) for v in line.split()])
+            elif line == 'map':
+                in_map = True
+            else:
+                key, value = line.split()
+                settings[key] = float(value)
+
+    for key in ('cell_size', 'focal_length', 'x_min', 'x_max', 'slab_shift'):
+        if key not in settings:
+            fail("missing '{}'".format(key))
+    size = len(rows)
+    if size == 0 or size > MAX_MAP_SIZE:
+        fail("the map has to have 1 to {} rows".format(MAX_MAP_SIZE))
+    for row in rows:
+        if len(row) != size:
+            fail("the map has to be square")
+        for color in row:
+            if color < 0 or color >= NUMBER_OF_COLORS:
+                fail("colour {} is not a map colour".format(color))
+    if settings['x_min'] <= settings['focal_length']:
+        fail("x_min has to be larger than the focal length")
+    if settings['x_max'] <= settings['x_min']:
+        fail("x_max has to be larger than x_min")
+    settings.setdefault('origin_y', 0.0)
+    settings.setdefault('origin_z', 0.0)
+    return settings, rows
+
+
+def generate(settings, rows, source):
+    size = len(rows)
+    cell_size = settings['cell_size']
+    focal_length = settings['focal_length']
+    x_min = int(settings['x_min'])
+    slab_shift = int(settings['slab_shift'])
+    slab_width = 1 << slab_shift
+    num_of_slabs = (int(settings['x_max']) - x_min + slab_width - 1) // slab_width
+    if num_of_slabs > MAX_SLABS:
+        fail("more than {} slabs, increase slab_shift".format(MAX_SLABS))
+
+    inverse = []
+    for s in range(num_of_slabs):
+        x = x_min + (s + 0.5) * slab_width
+        inverse.append(1.0 / (((x - focal_length) / focal_length) * cell_size))
+
+    # bottom row first, shifted by the ambient border
+    raster = [['AMB'] * RASTER_DIM for _ in range(RASTER_DIM)]
+    for r, row in enumerate(reversed(rows)):
+        for c, color in enumerate(row):
+            raster[r + 1][c + 1] = str(color)
+
+    out = header.format(os.path.basename(__file__), source)
+    out += '\n#include "Particle_projection_map.h"\n\n'
+    out += '#define AMB PROJECTION_MAP_AMBIENT\n\n'
+    out += 'static const float projection_map_inverse_cell_size[{}] = {{\n'.format(num_of_slabs)
+    for i in range(0, num_of_slabs, 8):
+        out += '    ' + ', '.join('{:.7e}f'.format(v) for v in inverse[i:i + 8]) + ',\n'
+    out += '};\n\n'
+    out += 'const ProjectionMap default_projection_map = {\n'
+    out += '    .map_size = {},\n'.format(size)
+    out += '    .cell_size = {}f,\n'.format(cell_size)
+    out += '    .focal_length = {}f,\n'.format(focal_length)
+    out += '    .origin_y = {}f,\n'.format(settings['origin_y'])
+    out += '    .origin_z = {}f,\n'.format(settings['origin_z'])
+    out += '    .x_min = {},\n'.format(x_min)
+    out += '    .slab_shift = {},\n'.format(slab_shift)
+    out += '    .num_of_slabs = {},\n'.format(num_of_slabs)
+    out += '    .inverse_cell_size = projection_map_inverse_cell_size,\n'
+    out += '    .raster = {\n'
+    for row in raster:
+        out += '        ' + ', '.join(row) + ',\n'
+    out += '    },\n'
+    out += '};\n'
+    return out
+
+
+parser = argparse.ArgumentParser(description='Generates the colour projection map of the particle filter')
+parser.add_argument('map', help='map description file')
+parser.add_argument('output', help='generated C file')
+args = parser.parse_args()
+
+settings, rows = parse(args.map)
+result = generate(settings, rows, os.path.basename(args.map))
+
+# only touch the output when it changes, saves a rebuild of the particle filter
+if os.path.exists(args.output):
+    with open(args.output) as f:
+        if f.read() == result:
+            sys.exit(0)
+with open(args.output, 'w') as f:
+    f.write(result)